@@ -4,6 +4,12 @@ DEPENDPATH += $$PWD
 QT += core gui gui-private
 !build_xlsx_lib:DEFINES += XLSX_NO_LIB
 
+qtConfig(system-zlib) {
+    QMAKE_USE_PRIVATE += zlib
+} else {
+    QT_PRIVATE += zlib-private
+}
+
 HEADERS += $$PWD/xlsxdocpropscore_p.h \
     $$PWD/xlsxdocpropsapp_p.h \
     $$PWD/xlsxrelationships_p.h \
@@ -48,7 +54,15 @@ HEADERS += $$PWD/xlsxdocpropscore_p.h \
     $$PWD/xlsxchart_p.h \
     $$PWD/xlsxsimpleooxmlfile_p.h \
     $$PWD/xlsxcellformula.h \
-    $$PWD/xlsxcellformula_p.h
+    $$PWD/xlsxcellformula_p.h \
+    $$PWD/xlsxformulaexpression_p.h \
+    $$PWD/xlsxformulaengine_p.h \
+    $$PWD/xlsxcelltable_p.h \
+    $$PWD/xlsxsharedformula_p.h \
+    $$PWD/xlsxsheetdatareader_p.h \
+    $$PWD/xlsxsheetdatawriter_p.h \
+    $$PWD/xlsxsheetreader.h \
+    $$PWD/xlsxsheetreader_p.h
 
 SOURCES += $$PWD/xlsxdocpropscore.cpp \
     $$PWD/xlsxdocpropsapp.cpp \
@@ -80,5 +94,12 @@ SOURCES += $$PWD/xlsxdocpropscore.cpp \
     $$PWD/xlsxabstractooxmlfile.cpp \
     $$PWD/xlsxchart.cpp \
     $$PWD/xlsxsimpleooxmlfile.cpp \
-    $$PWD/xlsxcellformula.cpp
+    $$PWD/xlsxcellformula.cpp \
+    $$PWD/xlsxformulaexpression.cpp \
+    $$PWD/xlsxformulaengine.cpp \
+    $$PWD/xlsxcelltable.cpp \
+    $$PWD/xlsxsharedformula.cpp \
+    $$PWD/xlsxsheetdatareader.cpp \
+    $$PWD/xlsxsheetdatawriter.cpp \
+    $$PWD/xlsxsheetreader.cpp
 
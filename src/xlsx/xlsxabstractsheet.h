@@ -56,6 +56,7 @@ public:
 
 protected:
     friend class Workbook;
+    friend class DocumentPrivate;
     AbstractSheet(const QString &sheetName, int sheetId, Workbook *book, AbstractSheetPrivate *d);
     virtual AbstractSheet *copy(const QString &distName, int distId) const = 0;
     void setSheetName(const QString &sheetName);
@@ -27,6 +27,7 @@
 #include "xlsxformat.h"
 #include "xlsxformat_p.h"
 #include "xlsxutility_p.h"
+#include "xlsxstyles_p.h"
 #include "xlsxworksheet.h"
 #include "xlsxworkbook.h"
 #include <QDateTime>
@@ -34,7 +35,9 @@
 QT_BEGIN_NAMESPACE_XLSX
 
 CellPrivate::CellPrivate(Cell *p)
-    : q_ptr(p)
+    : styles(0)
+    , styleIndex(-1)
+    , q_ptr(p)
 {
 }
 
@@ -43,6 +46,8 @@ CellPrivate::CellPrivate(const CellPrivate *const cp)
     , formula(cp->formula)
     , cellType(cp->cellType)
     , format(cp->format)
+    , styles(cp->styles)
+    , styleIndex(cp->styleIndex)
     , richString(cp->richString)
     , parent(cp->parent)
 {
@@ -119,6 +124,8 @@ QVariant Cell::value() const
 Format Cell::format() const
 {
     Q_D(const Cell);
+    if (d->styles)
+        return d->styles->xfFormat(d->styleIndex);
     return d->format;
 }
 
@@ -146,11 +153,11 @@ CellFormula Cell::formula() const
 bool Cell::isDateTime() const
 {
     Q_D(const Cell);
-    if (d->cellType == NumberType && d->value.toDouble() >= 0 && d->format.isValid()
-        && d->format.isDateTimeFormat()) {
-        return true;
-    }
-    return false;
+    if (d->cellType != NumberType || d->value.toDouble() < 0)
+        return false;
+    if (d->styles)
+        return d->styles->isDateTimeXf(d->styleIndex);
+    return d->format.isValid() && d->format.isDateTimeFormat();
 }
 
 /*!
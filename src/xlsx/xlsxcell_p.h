@@ -46,6 +46,8 @@
 
 QT_BEGIN_NAMESPACE_XLSX
 
+class Styles;
+
 class CellPrivate
 {
     Q_DECLARE_PUBLIC(Cell)
@@ -57,6 +59,10 @@ public:
     CellFormula formula;
     Cell::CellType cellType;
     Format format;
+    // Cells created from the cell table keep the xf index instead of the
+    // format, which is looked up in the styles when it is asked for.
+    Styles *styles;
+    int styleIndex;
 
     RichString richString;
 
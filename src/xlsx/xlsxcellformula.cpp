@@ -38,6 +38,7 @@ CellFormulaPrivate::CellFormulaPrivate(const QString &formula_, const CellRange
     , reference(ref_)
     , ca(false)
     , si(0)
+    , expressionParsed(false)
 {
     // Remove the formula '=' sign if exists
     if (formula.startsWith(QLatin1String("=")))
@@ -53,6 +54,8 @@ CellFormulaPrivate::CellFormulaPrivate(const CellFormulaPrivate &other)
     , reference(other.reference)
     , ca(other.ca)
     , si(other.si)
+    , parsedExpression(other.parsedExpression)
+    , expressionParsed(other.expressionParsed)
 {
 }
 
@@ -60,6 +63,20 @@ CellFormulaPrivate::~CellFormulaPrivate()
 {
 }
 
+/*
+ * The formula parsed into tokens. It is parsed on the first call
+ * only, which is not thread safe: call it once before the formula is
+ * shared between threads.
+ */
+const FormulaExpression &CellFormulaPrivate::expression() const
+{
+    if (!expressionParsed) {
+        parsedExpression = FormulaExpression::parse(formula);
+        expressionParsed = true;
+    }
+    return parsedExpression;
+}
+
 /*!
   \class CellFormula
   \inmodule QtXlsx
@@ -225,10 +242,8 @@ bool CellFormula::loadFromXml(QXmlStreamReader &reader)
     else
         d->type = NormalType;
 
-    if (attributes.hasAttribute(QLatin1String("ref"))) {
-        QString refString = attributes.value(QLatin1String("ref")).toString();
-        d->reference = CellRange(refString);
-    }
+    if (attributes.hasAttribute(QLatin1String("ref")))
+        d->reference = CellRange(attributes.value(QLatin1String("ref")));
 
     QString ca = attributes.value(QLatin1String("si")).toString();
     d->ca = parseXsdBoolean(ca, false);
@@ -237,6 +252,7 @@ bool CellFormula::loadFromXml(QXmlStreamReader &reader)
         d->si = attributes.value(QLatin1String("si")).toString().toInt();
 
     d->formula = reader.readElementText();
+    d->expressionParsed = false;
     return true;
 }
 
@@ -66,6 +66,7 @@ public:
 private:
     friend class Worksheet;
     friend class WorksheetPrivate;
+    friend class FormulaEngine;
     QExplicitlySharedDataPointer<CellFormulaPrivate> d;
 };
 
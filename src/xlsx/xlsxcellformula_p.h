@@ -39,6 +39,7 @@
 #include "xlsxglobal.h"
 #include "xlsxcellformula.h"
 #include "xlsxcellrange.h"
+#include "xlsxformulaexpression_p.h"
 
 #include <QSharedData>
 #include <QString>
@@ -53,11 +54,17 @@ public:
     CellFormulaPrivate(const CellFormulaPrivate &other);
     ~CellFormulaPrivate();
 
+    const FormulaExpression &expression() const;
+
     QString formula; // formula contents
     CellFormula::FormulaType type;
     CellRange reference;
     bool ca; // Calculate Cell
     int si; // Shared group index
+
+    // Parsed on first use, and dropped whenever formula changes
+    mutable FormulaExpression parsedExpression;
+    mutable bool expressionParsed;
 };
 
 QT_END_NAMESPACE_XLSX
@@ -28,6 +28,8 @@
 #include <QPoint>
 #include <QStringList>
 
+#include <string.h>
+
 QT_BEGIN_NAMESPACE_XLSX
 
 /*!
@@ -78,8 +80,18 @@ CellRange::CellRange(const CellReference &topLeft, const CellReference &bottomRi
     Constructs the range form the given \a range string.
 */
 CellRange::CellRange(const QString &range)
+    : CellRange(QStringView(range))
 {
-    init(range);
+}
+
+/*!
+    \overload
+    Constructs the range form the given \a range string.
+*/
+CellRange::CellRange(QStringView range)
+{
+    const char16_t *begin = range.utf16();
+    init(begin, begin + range.size());
 }
 
 /*!
@@ -88,26 +100,69 @@ CellRange::CellRange(const QString &range)
 */
 CellRange::CellRange(const char *range)
 {
-    init(QString::fromLatin1(range));
-}
-
-void CellRange::init(const QString &range)
-{
-    QStringList rs = range.split(QLatin1Char(':'));
-    if (rs.size() == 2) {
-        CellReference start(rs[0]);
-        CellReference end(rs[1]);
-        top = start.row();
-        left = start.column();
-        bottom = end.row();
-        right = end.column();
-    } else {
-        CellReference p(rs[0]);
-        top = p.row();
-        left = p.column();
-        bottom = p.row();
-        right = p.column();
-    }
+    init(range, range ? range + strlen(range) : range);
+}
+
+/*!
+    Returns the range for the \a range string, such as "A1:B5"
+    or "C3". The range is invalid if \a range is not one.
+*/
+CellRange CellRange::fromString(QStringView range)
+{
+    return CellRange(range);
+}
+
+/*!
+    Returns the range for the UTF-8 \a range string, such as
+    "A1:B5" or "C3". The range is invalid if \a range is not one.
+*/
+CellRange CellRange::fromUtf8(QByteArrayView range)
+{
+    CellRange result;
+    result.init(range.data(), range.data() + range.size());
+    return result;
+}
+
+static CellReference parseCellReference(const char16_t *begin, const char16_t *end)
+{
+    return CellReference::fromString(QStringView(begin, end - begin));
+}
+
+static CellReference parseCellReference(const char *begin, const char *end)
+{
+    return CellReference::fromUtf8(QByteArrayView(begin, end - begin));
+}
+
+/*
+ * Parse "A1" or "A1:B2" in [begin, end). Anything else gives an
+ * empty range.
+ */
+template <typename Char>
+static CellRange parseCellRange(const Char *begin, const Char *end)
+{
+    const Char *colon = begin;
+    while (colon != end && *colon != ':')
+        ++colon;
+
+    const CellReference topLeft = parseCellReference(begin, colon);
+    if (!topLeft.isValid())
+        return CellRange();
+    if (colon == end)
+        return CellRange(topLeft, topLeft);
+    const CellReference bottomRight = parseCellReference(colon + 1, end);
+    if (!bottomRight.isValid())
+        return CellRange();
+    return CellRange(topLeft, bottomRight);
+}
+
+void CellRange::init(const char16_t *begin, const char16_t *end)
+{
+    *this = parseCellRange(begin, end);
+}
+
+void CellRange::init(const char *begin, const char *end)
+{
+    *this = parseCellRange(begin, end);
 }
 
 /*!
@@ -36,11 +36,14 @@ public:
     CellRange(int firstRow, int firstColumn, int lastRow, int lastColumn);
     CellRange(const CellReference &topLeft, const CellReference &bottomRight);
     CellRange(const QString &range);
+    CellRange(QStringView range);
     CellRange(const char *range);
     CellRange(const CellRange &other);
     ~CellRange();
 
     QString toString(bool row_abs = false, bool col_abs = false) const;
+    static CellRange fromString(QStringView range);
+    static CellRange fromUtf8(QByteArrayView range);
     bool isValid() const;
     inline void setFirstRow(int row) { top = row; }
     inline void setLastRow(int row) { bottom = row; }
@@ -69,7 +72,8 @@ public:
     }
 
 private:
-    void init(const QString &range);
+    void init(const char16_t *begin, const char16_t *end);
+    void init(const char *begin, const char *end);
     int top, left, bottom, right;
 };
 
@@ -23,58 +23,139 @@
 **
 ****************************************************************************/
 #include "xlsxcellreference.h"
-#include <QStringList>
-#include <QMap>
-#include <QRegularExpression>
+#include <QString>
+
+#include <charconv>
+#include <limits.h>
+#include <string.h>
 
 QT_BEGIN_NAMESPACE_XLSX
 
 namespace {
 
-int intPow(int x, int p)
+/*
+ * Names of the columns "A" to "ZZ", built at compile time. Longer
+ * names are a letter in front of one of these.
+ */
+struct ColumnName
 {
-    if (p == 0)
-        return 1;
-    if (p == 1)
-        return x;
+    char text[2] = {};
+    int size = 0;
+};
 
-    int tmp = intPow(x, p / 2);
-    if (p % 2 == 0)
-        return tmp * tmp;
-    else
-        return x * tmp * tmp;
-}
+const int TwoLetterColumns = 26 + 26 * 26;
 
-QString col_to_name(int col_num)
+struct ColumnNameTable
 {
-    static QMap<int, QString> col_cache;
-
-    if (!col_cache.contains(col_num)) {
-        QString col_str;
-        int remainder;
-        while (col_num) {
-            remainder = col_num % 26;
-            if (remainder == 0)
-                remainder = 26;
-            col_str.prepend(QChar('A' + remainder - 1));
-            col_num = (col_num - 1) / 26;
+    constexpr ColumnNameTable()
+        : names()
+    {
+        for (int col = 1; col <= TwoLetterColumns; ++col) {
+            ColumnName &name = names[col];
+            if (col <= 26) {
+                name.text[0] = char('A' + col - 1);
+                name.size = 1;
+            } else {
+                name.text[0] = char('A' + (col - 27) / 26);
+                name.text[1] = char('A' + (col - 27) % 26);
+                name.size = 2;
+            }
         }
-        col_cache.insert(col_num, col_str);
     }
 
-    return col_cache[col_num];
+    ColumnName names[TwoLetterColumns + 1];
+};
+
+constexpr ColumnNameTable columnNames;
+
+static_assert(columnNames.names[26].text[0] == 'Z', "Z is column 26");
+static_assert(columnNames.names[27].text[1] == 'A', "AA is column 27");
+static_assert(columnNames.names[TwoLetterColumns].text[0] == 'Z'
+                  && columnNames.names[TwoLetterColumns].text[1] == 'Z',
+              "ZZ is column 702");
+
+/*
+ * Write the name of column \a col_num to \a out, which has room for
+ * at least 7 chars, and return its length. No cache here: sheets are
+ * loaded and saved from several threads.
+ */
+int col_to_name(int col_num, char *out)
+{
+    if (col_num <= TwoLetterColumns) {
+        const ColumnName &name = columnNames.names[col_num];
+        out[0] = name.text[0];
+        out[1] = name.text[1];
+        return name.size;
+    }
+    if (col_num <= TwoLetterColumns + 26 * 26 * 26) {
+        const int rest = col_num - TwoLetterColumns - 1;
+        const ColumnName &name = columnNames.names[27 + rest % (26 * 26)];
+        out[0] = char('A' + rest / (26 * 26));
+        out[1] = name.text[0];
+        out[2] = name.text[1];
+        return 3;
+    }
+
+    // Far outside of what a worksheet can hold.
+    char reversed[7];
+    int size = 0;
+    while (col_num) {
+        int remainder = col_num % 26;
+        if (remainder == 0)
+            remainder = 26;
+        reversed[size++] = char('A' + remainder - 1);
+        col_num = (col_num - 1) / 26;
+    }
+    for (int i = 0; i < size; ++i)
+        out[i] = reversed[size - 1 - i];
+    return size;
 }
 
-int col_from_name(const QString &col_str)
+template <typename Char>
+constexpr int col_from_name(const Char *begin, const Char *end)
 {
     int col = 0;
-    int expn = 0;
-    for (int i = col_str.size() - 1; i > -1; --i) {
-        col += (col_str[i].unicode() - 'A' + 1) * intPow(26, expn);
-        expn++;
+    for (const Char *p = begin; p != end; ++p)
+        col = col * 26 + (*p - 'A' + 1);
+    return col;
+}
+
+static_assert(col_from_name("XFD", "XFD" + 3) == 16384, "XFD is column 16384");
+
+/*
+ * Parse "$?[A-Z]{1,3}$?[0-9]+" in [begin, end). Rows that do not
+ * fit in an int are rejected. \a row and \a column are only
+ * written on success.
+ */
+template <typename Char>
+bool parseCellReference(const Char *begin, const Char *end, int *row, int *column)
+{
+    const Char *p = begin;
+    if (p != end && *p == '$')
+        ++p;
+    const Char *letters = p;
+    while (p != end && *p >= 'A' && *p <= 'Z' && p - letters < 3)
+        ++p;
+    if (p == letters)
+        return false;
+    const int col = col_from_name(letters, p);
+    if (p != end && *p == '$')
+        ++p;
+
+    const Char *digits = p;
+    int r = 0;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+        const int digit = *p - '0';
+        if (r > (INT_MAX - digit) / 10)
+            return false;
+        r = r * 10 + digit;
     }
+    if (p == digits || p != end)
+        return false;
 
-    return col;
+    *row = r;
+    *column = col;
+    return true;
 }
 } // namespace
 
@@ -109,8 +190,20 @@ CellReference::CellReference(int row, int column)
     Constructs the Reference form the given \a cell string.
 */
 CellReference::CellReference(const QString &cell)
+    : CellReference(QStringView(cell))
+{
+}
+
+/*!
+    \overload
+    Constructs the Reference form the given \a cell string.
+*/
+CellReference::CellReference(QStringView cell)
+    : _row(-1)
+    , _column(-1)
 {
-    init(cell);
+    const char16_t *begin = cell.utf16();
+    parseCellReference(begin, begin + cell.size(), &_row, &_column);
 }
 
 /*!
@@ -118,20 +211,32 @@ CellReference::CellReference(const QString &cell)
     Constructs the Reference form the given \a cell string.
 */
 CellReference::CellReference(const char *cell)
+    : _row(-1)
+    , _column(-1)
 {
-    init(QString::fromLatin1(cell));
+    if (cell)
+        parseCellReference(cell, cell + strlen(cell), &_row, &_column);
 }
 
-void CellReference::init(const QString &cell_str)
+/*!
+    Returns the Reference for the \a cell string, such as "B3"
+    or "$B$3". The Reference is invalid if \a cell is not one.
+*/
+CellReference CellReference::fromString(QStringView cell)
 {
-    static QRegularExpression re(QStringLiteral("^\\$?([A-Z]{1,3})\\$?(\\d+)$"));
-    QRegularExpressionMatch match = re.match(cell_str);
-    if (match.hasMatch()) {
-        const QString col_str = match.captured(1);
-        const QString row_str = match.captured(2);
-        _row = row_str.toInt();
-        _column = col_from_name(col_str);
-    }
+    return CellReference(cell);
+}
+
+/*!
+    Returns the Reference for the UTF-8 \a cell string, such as
+    "B3" or "$B$3". The Reference is invalid if \a cell is not one.
+*/
+CellReference CellReference::fromUtf8(QByteArrayView cell)
+{
+    CellReference ref;
+    const char *begin = cell.data();
+    parseCellReference(begin, begin + cell.size(), &ref._row, &ref._column);
+    return ref;
 }
 
 /*!
@@ -160,14 +265,15 @@ QString CellReference::toString(bool row_abs, bool col_abs) const
     if (!isValid())
         return QString();
 
-    QString cell_str;
+    char cell_str[20];
+    char *p = cell_str;
     if (col_abs)
-        cell_str.append(QLatin1Char('$'));
-    cell_str.append(col_to_name(_column));
+        *p++ = '$';
+    p += col_to_name(_column, p);
     if (row_abs)
-        cell_str.append(QLatin1Char('$'));
-    cell_str.append(QString::number(_row));
-    return cell_str;
+        *p++ = '$';
+    p = std::to_chars(p, cell_str + sizeof(cell_str), _row).ptr;
+    return QString::fromLatin1(cell_str, int(p - cell_str));
 }
 
 /*!
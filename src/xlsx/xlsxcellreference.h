@@ -25,6 +25,8 @@
 #ifndef QXLSX_XLSXCELLREFERENCE_H
 #define QXLSX_XLSXCELLREFERENCE_H
 #include "xlsxglobal.h"
+#include <QByteArrayView>
+#include <QStringView>
 
 QT_BEGIN_NAMESPACE_XLSX
 
@@ -34,12 +36,14 @@ public:
     CellReference();
     CellReference(int row, int column);
     CellReference(const QString &cell);
+    CellReference(QStringView cell);
     CellReference(const char *cell);
     CellReference(const CellReference &other);
     ~CellReference();
 
     QString toString(bool row_abs = false, bool col_abs = false) const;
-    static CellReference fromString(const QString &cell);
+    static CellReference fromString(QStringView cell);
+    static CellReference fromUtf8(QByteArrayView cell);
     bool isValid() const;
     inline void setRow(int row) { _row = row; }
     inline void setColumn(int col) { _column = col; }
@@ -56,7 +60,6 @@ public:
     }
 
 private:
-    void init(const QString &cell);
     int _row, _column;
 };
 
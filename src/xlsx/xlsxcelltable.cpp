@@ -0,0 +1,544 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#include "xlsxcelltable_p.h"
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+CellTable::Tile::Tile()
+{
+    memset(columnMask, 0, sizeof(columnMask));
+    memset(kinds, 0, sizeof(kinds));
+    memset(styles, 0xff, sizeof(styles)); // -1, no style
+    memset(values, 0, sizeof(values));
+}
+
+CellTable::CellTable()
+{
+}
+
+/*
+ * Only the cell data is copied, the cached Cell objects belong
+ * to the sheet of \a other.
+ */
+CellTable::CellTable(const CellTable &other)
+    : m_tiles(other.m_tiles)
+    , m_extras(other.m_extras)
+{
+}
+
+CellTable &CellTable::operator=(const CellTable &other)
+{
+    m_tiles = other.m_tiles;
+    m_extras = other.m_extras;
+    m_cellCache.clear();
+    return *this;
+}
+
+Cell::CellType CellTable::cellType(Kind kind)
+{
+    switch (kind) {
+    case K_Boolean:
+        return Cell::BooleanType;
+    case K_SharedString:
+        return Cell::SharedStringType;
+    case K_String:
+        return Cell::StringType;
+    case K_InlineString:
+        return Cell::InlineStringType;
+    case K_Error:
+        return Cell::ErrorType;
+    default:
+        return Cell::NumberType;
+    }
+}
+
+void CellTable::clear()
+{
+    m_tiles.clear();
+    m_extras.clear();
+    m_cellCache.clear();
+}
+
+/*
+ * Remove all the cells of the rows before \a row.
+ */
+void CellTable::removeRowsBefore(int row)
+{
+    if (row <= 1)
+        return;
+
+    // Tile rows before this one are removed as a whole.
+    const int tileRow = (row - 1) / TileRows;
+    const int rowsInTile = (row - 1) % TileRows;
+
+    QMap<quint64, Tile>::iterator it = m_tiles.begin();
+    while (it != m_tiles.end() && int(it.key() >> 32) < tileRow) {
+        if (!m_extras.isEmpty()) {
+            for (int r = 0; r < TileRows; ++r)
+                clearTileRow(it.value(), it.key(), r);
+        }
+        it = m_tiles.erase(it);
+    }
+
+    while (rowsInTile && it != m_tiles.end() && int(it.key() >> 32) == tileRow) {
+        bool empty = true;
+        for (int r = 0; r < TileRows; ++r) {
+            if (r < rowsInTile)
+                clearTileRow(it.value(), it.key(), r);
+            else if (it.value().columnMask[r])
+                empty = false;
+        }
+        if (empty)
+            it = m_tiles.erase(it);
+        else
+            ++it;
+    }
+
+    m_cellCache.clear();
+}
+
+void CellTable::clearTileRow(Tile &tile, quint64 tileKey, int r)
+{
+    const int row = int(tileKey >> 32) * TileRows + r + 1;
+    const int colBase = int(quint32(tileKey)) * TileColumns + 1;
+    quint32 mask = tile.columnMask[r];
+    while (mask) {
+        const int c = int(qCountTrailingZeroBits(mask));
+        mask &= mask - 1;
+        const int idx = r * TileColumns + c;
+        if (tile.kinds[idx] & K_HasExtra)
+            m_extras.remove(cellKey(row, colBase + c));
+        tile.kinds[idx] = K_Empty;
+        tile.styles[idx] = -1;
+        tile.values[idx].number = 0;
+    }
+    tile.columnMask[r] = 0;
+}
+
+CellTable::Tile *CellTable::tileFor(int row, int col, bool create)
+{
+    const quint64 key = tileKey((row - 1) / TileRows, (col - 1) / TileColumns);
+    QMap<quint64, Tile>::iterator it = m_tiles.find(key);
+    if (it == m_tiles.end()) {
+        if (!create)
+            return 0;
+        it = m_tiles.insert(key, Tile());
+    }
+    return &it.value();
+}
+
+const CellTable::Tile *CellTable::constTileFor(int row, int col) const
+{
+    if (row < 1 || col < 1)
+        return 0;
+    const quint64 key = tileKey((row - 1) / TileRows, (col - 1) / TileColumns);
+    QMap<quint64, Tile>::const_iterator it = m_tiles.constFind(key);
+    if (it == m_tiles.constEnd())
+        return 0;
+    return &it.value();
+}
+
+bool CellTable::contains(int row, int col) const
+{
+    const Tile *tile = constTileFor(row, col);
+    return tile && tile->kinds[slotIndex(row, col)] != K_Empty;
+}
+
+bool CellTable::containsRow(int row) const
+{
+    if (row < 1)
+        return false;
+    const int tileRow = (row - 1) / TileRows;
+    const int r = (row - 1) % TileRows;
+    QMap<quint64, Tile>::const_iterator it = m_tiles.lowerBound(tileKey(tileRow, 0));
+    for (; it != m_tiles.constEnd() && int(it.key() >> 32) == tileRow; ++it) {
+        if (it.value().columnMask[r])
+            return true;
+    }
+    return false;
+}
+
+CellTable::Entry CellTable::entry(int row, int col) const
+{
+    Entry e;
+    const Tile *tile = constTileFor(row, col);
+    if (!tile) {
+        e.kind = K_Empty;
+        e.style = -1;
+        e.value.number = 0;
+        return e;
+    }
+
+    const int idx = slotIndex(row, col);
+    e.kind = tile->kinds[idx];
+    e.style = tile->styles[idx];
+    e.value = tile->values[idx];
+    return e;
+}
+
+const XlsxCellExtra *CellTable::extra(int row, int col) const
+{
+    QHash<quint64, XlsxCellExtra>::const_iterator it = m_extras.constFind(cellKey(row, col));
+    if (it == m_extras.constEnd())
+        return 0;
+    return &it.value();
+}
+
+void CellTable::setSlot(int row, int col, Kind kind, int style, Value value)
+{
+    Q_ASSERT(row > 0 && col > 0);
+    Tile *tile = tileFor(row, col, true);
+    const int idx = slotIndex(row, col);
+    const quint64 key = cellKey(row, col);
+
+    if (tile->kinds[idx] & K_HasExtra)
+        m_extras.remove(key);
+    tile->kinds[idx] = kind;
+    tile->styles[idx] = style;
+    tile->values[idx] = value;
+    tile->columnMask[(row - 1) % TileRows] |= 1 << ((col - 1) % TileColumns);
+
+    if (!m_cellCache.isEmpty())
+        m_cellCache.remove(key);
+}
+
+void CellTable::setBlank(int row, int col, int style)
+{
+    Value v;
+    v.number = 0;
+    setSlot(row, col, K_Blank, style, v);
+}
+
+void CellTable::setNumber(int row, int col, double value, int style)
+{
+    Value v;
+    v.number = value;
+    setSlot(row, col, K_Number, style, v);
+}
+
+void CellTable::setBoolean(int row, int col, bool value, int style)
+{
+    Value v;
+    v.number = value ? 1 : 0;
+    setSlot(row, col, K_Boolean, style, v);
+}
+
+void CellTable::setSharedString(int row, int col, int sstIndex, int style)
+{
+    Value v;
+    v.index = sstIndex;
+    setSlot(row, col, K_SharedString, style, v);
+}
+
+/*
+ * Fill \a count consecutive cells from (\a row, \a col), along the
+ * row or down the column depending on \a orientation. The tile is
+ * looked up once for all the cells it holds.
+ */
+template <typename ValueAt>
+void CellTable::setSlots(int row, int col, int count, Qt::Orientation orientation, Kind kind,
+                         int style, ValueAt valueAt)
+{
+    Q_ASSERT(row > 0 && col > 0);
+    const bool vertical = orientation == Qt::Vertical;
+    int done = 0;
+    while (done < count) {
+        const int firstRow = vertical ? row + done : row;
+        const int firstCol = vertical ? col : col + done;
+        Tile *tile = tileFor(firstRow, firstCol, true);
+        const int available = vertical ? TileRows - (firstRow - 1) % TileRows
+                                       : TileColumns - (firstCol - 1) % TileColumns;
+        const int n = qMin(available, count - done);
+        for (int i = 0; i < n; ++i) {
+            const int r = vertical ? firstRow + i : firstRow;
+            const int c = vertical ? firstCol : firstCol + i;
+            const int idx = slotIndex(r, c);
+            if (tile->kinds[idx] & K_HasExtra)
+                m_extras.remove(cellKey(r, c));
+            tile->kinds[idx] = kind;
+            if (style != KeepStyle)
+                tile->styles[idx] = style;
+            tile->values[idx] = valueAt(done + i);
+            tile->columnMask[(r - 1) % TileRows] |= 1 << ((c - 1) % TileColumns);
+            if (!m_cellCache.isEmpty())
+                m_cellCache.remove(cellKey(r, c));
+        }
+        done += n;
+    }
+}
+
+/*
+ * Bulk version of setNumber(). When \a style is KeepStyle, the cells
+ * which already exist keep their style.
+ */
+void CellTable::setNumbers(int row, int col, const double *values, int count,
+                           Qt::Orientation orientation, int style)
+{
+    setSlots(row, col, count, orientation, K_Number, style, [values](int i) {
+        Value v;
+        v.number = values[i];
+        return v;
+    });
+}
+
+/*
+ * Bulk version of setSharedString().
+ */
+void CellTable::setSharedStrings(int row, int col, const int *sstIndexes, int count,
+                                 Qt::Orientation orientation, int style)
+{
+    setSlots(row, col, count, orientation, K_SharedString, style, [sstIndexes](int i) {
+        Value v;
+        v.index = sstIndexes[i];
+        return v;
+    });
+}
+
+/*
+ * Used by the string kinds which are not stored in the shared string
+ * table: K_String, K_InlineString and K_Error.
+ */
+void CellTable::setText(int row, int col, Kind kind, const QString &text, int style)
+{
+    Value v;
+    v.number = 0;
+    setSlot(row, col, kind, style, v);
+
+    Tile *tile = tileFor(row, col, false);
+    tile->kinds[slotIndex(row, col)] |= K_HasExtra;
+    m_extras[cellKey(row, col)].text = text;
+}
+
+/*
+ * Attach \a formula to an existing cell, the value is kept as the
+ * cached result of the formula.
+ */
+void CellTable::setFormula(int row, int col, const CellFormula &formula)
+{
+    Tile *tile = tileFor(row, col, false);
+    if (!tile || tile->kinds[slotIndex(row, col)] == K_Empty)
+        return;
+
+    const int idx = slotIndex(row, col);
+    const quint64 key = cellKey(row, col);
+    if (formula.isValid()) {
+        tile->kinds[idx] |= K_HasExtra;
+        m_extras[key].formula = formula;
+    } else if (tile->kinds[idx] & K_HasExtra) {
+        QHash<quint64, XlsxCellExtra>::iterator it = m_extras.find(key);
+        it.value().formula = CellFormula();
+        if (it.value().text.isNull()) {
+            m_extras.erase(it);
+            tile->kinds[idx] &= K_KindMask;
+        }
+    }
+
+    if (!m_cellCache.isEmpty())
+        m_cellCache.remove(key);
+}
+
+/*
+ * Store the result of the formula of an existing formula cell, which
+ * keeps its formula and its style. \a text is the value of the K_String
+ * and K_Error kinds, \a number the one of the others.
+ */
+void CellTable::setFormulaResult(int row, int col, Kind kind, double number, const QString &text)
+{
+    Tile *tile = tileFor(row, col, false);
+    if (!tile)
+        return;
+    const int idx = slotIndex(row, col);
+    if (!(tile->kinds[idx] & K_HasExtra))
+        return;
+
+    const quint64 key = cellKey(row, col);
+    tile->kinds[idx] = quint8(kind | K_HasExtra);
+    tile->values[idx].number = number;
+    m_extras[key].text = kind == K_String || kind == K_Error ? text : QString();
+
+    if (!m_cellCache.isEmpty())
+        m_cellCache.remove(key);
+}
+
+void CellTable::setStyle(int row, int col, int style)
+{
+    Tile *tile = tileFor(row, col, false);
+    if (!tile || tile->kinds[slotIndex(row, col)] == K_Empty)
+        return;
+
+    tile->styles[slotIndex(row, col)] = style;
+    if (!m_cellCache.isEmpty())
+        m_cellCache.remove(cellKey(row, col));
+}
+
+/*
+ * Returns the number of rows which contain at least one cell.
+ */
+int CellTable::rowCount() const
+{
+    int count = 0;
+    QMap<quint64, Tile>::const_iterator it = m_tiles.constBegin();
+    while (it != m_tiles.constEnd()) {
+        const quint64 tileRow = it.key() >> 32;
+        quint32 rowsMask = 0;
+        for (; it != m_tiles.constEnd() && (it.key() >> 32) == tileRow; ++it) {
+            for (int r = 0; r < TileRows; ++r) {
+                if (it.value().columnMask[r])
+                    rowsMask |= 1 << r;
+            }
+        }
+        count += qPopulationCount(rowsMask);
+    }
+    return count;
+}
+
+/*
+ * Returns the first row not less than \a row which contains a cell,
+ * or -1 if there is none. Empty rows are skipped without being visited.
+ */
+int CellTable::nextRow(int row) const
+{
+    if (row < 1)
+        row = 1;
+    int tileRow = (row - 1) / TileRows;
+    int r = (row - 1) % TileRows;
+
+    QMap<quint64, Tile>::const_iterator it = m_tiles.lowerBound(tileKey(tileRow, 0));
+    while (it != m_tiles.constEnd()) {
+        if (int(it.key() >> 32) != tileRow) {
+            tileRow = int(it.key() >> 32);
+            r = 0;
+        }
+        quint32 rowsMask = 0;
+        for (; it != m_tiles.constEnd() && int(it.key() >> 32) == tileRow; ++it) {
+            for (int i = r; i < TileRows; ++i) {
+                if (it.value().columnMask[i])
+                    rowsMask |= 1 << i;
+            }
+        }
+        if (rowsMask)
+            return tileRow * TileRows + int(qCountTrailingZeroBits(rowsMask)) + 1;
+    }
+    return -1;
+}
+
+/*
+ * Get the first and the last used column of \a row. Returns false
+ * if the row is empty.
+ */
+bool CellTable::rowExtent(int row, int *firstColumn, int *lastColumn) const
+{
+    if (row < 1)
+        return false;
+    const int tileRow = (row - 1) / TileRows;
+    const int r = (row - 1) % TileRows;
+
+    bool found = false;
+    QMap<quint64, Tile>::const_iterator it = m_tiles.lowerBound(tileKey(tileRow, 0));
+    for (; it != m_tiles.constEnd() && int(it.key() >> 32) == tileRow; ++it) {
+        const quint32 mask = it.value().columnMask[r];
+        if (!mask)
+            continue;
+        const int colBase = int(quint32(it.key())) * TileColumns + 1;
+        if (!found)
+            *firstColumn = colBase + int(qCountTrailingZeroBits(mask));
+        *lastColumn = colBase + 31 - int(qCountLeadingZeroBits(mask));
+        found = true;
+    }
+    return found;
+}
+
+/*
+ * Returns the smallest range which contains all the cells, or an
+ * invalid range if the table is empty.
+ */
+CellRange CellTable::boundingRange() const
+{
+    int firstRow = -1, lastRow = -1, firstColumn = -1, lastColumn = -1;
+
+    QMap<quint64, Tile>::const_iterator it = m_tiles.constBegin();
+    for (; it != m_tiles.constEnd(); ++it) {
+        const Tile &tile = it.value();
+        const int rowBase = int(it.key() >> 32) * TileRows + 1;
+        const int colBase = int(quint32(it.key())) * TileColumns + 1;
+
+        quint32 columnsMask = 0;
+        for (int r = 0; r < TileRows; ++r) {
+            if (!tile.columnMask[r])
+                continue;
+            columnsMask |= tile.columnMask[r];
+            if (firstRow == -1 || rowBase + r < firstRow)
+                firstRow = rowBase + r;
+            if (rowBase + r > lastRow)
+                lastRow = rowBase + r;
+        }
+        if (!columnsMask)
+            continue;
+
+        const int first = colBase + int(qCountTrailingZeroBits(columnsMask));
+        const int last = colBase + 31 - int(qCountLeadingZeroBits(columnsMask));
+        if (firstColumn == -1 || first < firstColumn)
+            firstColumn = first;
+        if (last > lastColumn)
+            lastColumn = last;
+    }
+
+    if (firstRow == -1)
+        return CellRange();
+    return CellRange(firstRow, firstColumn, lastRow, lastColumn);
+}
+
+/*
+ * Approximate number of heap bytes used by the table, the cached
+ * Cell objects are not counted.
+ */
+qint64 CellTable::memoryUsage() const
+{
+    // QMap and QHash nodes carry a few pointers of bookkeeping each.
+    const qint64 nodeOverhead = 4 * sizeof(void *);
+    qint64 size = m_tiles.size() * (sizeof(Tile) + sizeof(quint64) + nodeOverhead);
+    QHash<quint64, XlsxCellExtra>::const_iterator it = m_extras.constBegin();
+    for (; it != m_extras.constEnd(); ++it) {
+        size += sizeof(quint64) + sizeof(XlsxCellExtra) + nodeOverhead;
+        size += it.value().text.capacity() * sizeof(QChar);
+    }
+    return size;
+}
+
+Cell *CellTable::cachedCell(int row, int col) const
+{
+    if (m_cellCache.isEmpty())
+        return 0;
+    return m_cellCache.value(cellKey(row, col)).data();
+}
+
+void CellTable::cacheCell(int row, int col, const QSharedPointer<Cell> &cell) const
+{
+    m_cellCache.insert(cellKey(row, col), cell);
+}
+
+QT_END_NAMESPACE_XLSX
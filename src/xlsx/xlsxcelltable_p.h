@@ -0,0 +1,297 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#ifndef XLSXCELLTABLE_P_H
+#define XLSXCELLTABLE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxcell.h"
+#include "xlsxcellformula.h"
+#include "xlsxcellrange.h"
+#include <QMap>
+#include <QHash>
+#include <QString>
+#include <QSharedPointer>
+#include <QtAlgorithms>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+  Payload of the cells which can not be described by the dense arrays
+  of a tile: formulas and the text of non shared strings. Most cells
+  don't have one.
+*/
+struct XlsxCellExtra
+{
+    QString text;
+    CellFormula formula;
+};
+
+/*
+  Storage of all the cells of one worksheet.
+
+  Cells are grouped into tiles of 16 rows x 16 columns, the same
+  16 rows blocks used by the "spans" attribute of <row>. Each tile
+  keeps dense, typed arrays for the cell kind, the xf index and the
+  numeric value or shared string index, so a numeric cell costs 13
+  bytes instead of a heap allocated Cell and two QMap nodes.
+
+  Cell objects are only created on demand by Worksheet::cellAt(), and
+  are dropped as soon as the underlying slot is modified.
+*/
+class XLSX_AUTOTEST_EXPORT CellTable
+{
+public:
+    enum { TileRows = 16, TileColumns = 16, TileSize = TileRows * TileColumns };
+    enum { KeepStyle = -2 }; // bulk setters: leave the style of each cell unchanged
+
+    enum Kind {
+        K_Empty = 0,
+        K_Blank, // NumberType cell without value
+        K_Number,
+        K_Boolean,
+        K_SharedString,
+        K_String,
+        K_InlineString,
+        K_Error,
+        K_KindMask = 0x7f,
+        K_HasExtra = 0x80
+    };
+
+    union Value {
+        double number; // K_Number, K_Boolean
+        qint32 index;  // K_SharedString
+    };
+
+    struct Entry
+    {
+        quint8 kind;
+        qint32 style;
+        Value value;
+
+        bool isValid() const { return kind != K_Empty; }
+        Kind baseKind() const { return Kind(kind & K_KindMask); }
+        bool hasExtra() const { return kind & K_HasExtra; }
+    };
+
+    struct Tile
+    {
+        Tile();
+
+        quint16 columnMask[TileRows]; // bit c is set when column c of row r is used
+        quint8 kinds[TileSize];
+        qint32 styles[TileSize];
+        Value values[TileSize];
+    };
+
+    CellTable();
+    CellTable(const CellTable &other);
+    CellTable &operator=(const CellTable &other);
+
+    static inline quint64 cellKey(int row, int col) { return (quint64(row) << 32) | quint32(col); }
+    static Cell::CellType cellType(Kind kind);
+
+    bool isEmpty() const { return m_tiles.isEmpty(); }
+    void clear();
+    void removeRowsBefore(int row);
+
+    bool contains(int row, int col) const;
+    bool containsRow(int row) const;
+    Entry entry(int row, int col) const;
+    const XlsxCellExtra *extra(int row, int col) const;
+
+    void setBlank(int row, int col, int style);
+    void setNumber(int row, int col, double value, int style);
+    void setBoolean(int row, int col, bool value, int style);
+    void setSharedString(int row, int col, int sstIndex, int style);
+    void setText(int row, int col, Kind kind, const QString &text, int style);
+    void setFormula(int row, int col, const CellFormula &formula);
+    void setFormulaResult(int row, int col, Kind kind, double number, const QString &text);
+    void setStyle(int row, int col, int style);
+
+    void setNumbers(int row, int col, const double *values, int count,
+                    Qt::Orientation orientation, int style);
+    void setSharedStrings(int row, int col, const int *sstIndexes, int count,
+                          Qt::Orientation orientation, int style);
+
+    int rowCount() const;
+    int nextRow(int row) const;
+    bool rowExtent(int row, int *firstColumn, int *lastColumn) const;
+    CellRange boundingRange() const;
+    qint64 memoryUsage() const;
+
+    /*
+      Visit all the cells of \a row in ascending column order.
+      \a func is called as func(int col, const Entry &entry).
+    */
+    template <typename Func>
+    void forEachInRow(int row, Func func) const
+    {
+        if (row < 1)
+            return;
+        const int tileRow = (row - 1) / TileRows;
+        const int r = (row - 1) % TileRows;
+        QMap<quint64, Tile>::const_iterator it = m_tiles.lowerBound(tileKey(tileRow, 0));
+        for (; it != m_tiles.constEnd() && int(it.key() >> 32) == tileRow; ++it) {
+            const Tile &tile = it.value();
+            quint32 mask = tile.columnMask[r];
+            const int colBase = int(quint32(it.key())) * TileColumns + 1;
+            while (mask) {
+                const int c = int(qCountTrailingZeroBits(mask));
+                mask &= mask - 1;
+                const int idx = r * TileColumns + c;
+                Entry e;
+                e.kind = tile.kinds[idx];
+                e.style = tile.styles[idx];
+                e.value = tile.values[idx];
+                func(colBase + c, e);
+            }
+        }
+    }
+
+    /*
+      Visit all the cells in ascending row, then column order.
+      \a func is called as func(int row, int col, const Entry &entry).
+    */
+    template <typename Func>
+    void forEach(Func func) const
+    {
+        QMap<quint64, Tile>::const_iterator it = m_tiles.constBegin();
+        while (it != m_tiles.constEnd()) {
+            const int tileRow = int(it.key() >> 32);
+            quint16 rowsMask = 0;
+            QMap<quint64, Tile>::const_iterator end = it;
+            for (; end != m_tiles.constEnd() && int(end.key() >> 32) == tileRow; ++end) {
+                for (int r = 0; r < TileRows; ++r) {
+                    if (end.value().columnMask[r])
+                        rowsMask |= 1 << r;
+                }
+            }
+            for (int r = 0; r < TileRows; ++r) {
+                if (!(rowsMask & (1 << r)))
+                    continue;
+                const int row = tileRow * TileRows + r + 1;
+                forEachInRow(row, [&](int col, const Entry &e) { func(row, col, e); });
+            }
+            it = end;
+        }
+    }
+
+    /*
+      Visit the cells of \a range, tile by tile, without looking at the
+      tiles outside of it. Tiles are taken in row, then column order,
+      and the cells of a tile row by row, so the cells of a single row
+      or a single column are visited in sheet order.
+      \a func is called as func(int row, int col, const Entry &entry).
+    */
+    template <typename Func>
+    void forEachInRange(const CellRange &range, Func func) const
+    {
+        if (!range.isValid())
+            return;
+        const int firstTileRow = (range.firstRow() - 1) / TileRows;
+        const int lastTileRow = (range.lastRow() - 1) / TileRows;
+        const int firstTileCol = (range.firstColumn() - 1) / TileColumns;
+        const int lastTileCol = (range.lastColumn() - 1) / TileColumns;
+        QMap<quint64, Tile>::const_iterator it =
+            m_tiles.lowerBound(tileKey(firstTileRow, firstTileCol));
+        while (it != m_tiles.constEnd()) {
+            const int tileRow = int(it.key() >> 32);
+            const int tileCol = int(quint32(it.key()));
+            if (tileRow > lastTileRow)
+                break;
+            if (tileCol < firstTileCol) {
+                it = m_tiles.lowerBound(tileKey(tileRow, firstTileCol));
+                continue;
+            }
+            if (tileCol > lastTileCol) {
+                it = m_tiles.lowerBound(tileKey(tileRow + 1, firstTileCol));
+                continue;
+            }
+
+            const Tile &tile = it.value();
+            const int rowBase = tileRow * TileRows + 1;
+            const int colBase = tileCol * TileColumns + 1;
+            const int firstR = qMax(range.firstRow() - rowBase, 0);
+            const int lastR = qMin(range.lastRow() - rowBase, int(TileRows) - 1);
+            const int firstC = qMax(range.firstColumn() - colBase, 0);
+            const int lastC = qMin(range.lastColumn() - colBase, int(TileColumns) - 1);
+            const quint32 columns = ((2u << lastC) - 1) & ~((1u << firstC) - 1);
+            for (int r = firstR; r <= lastR; ++r) {
+                quint32 mask = tile.columnMask[r] & columns;
+                while (mask) {
+                    const int c = int(qCountTrailingZeroBits(mask));
+                    mask &= mask - 1;
+                    const int idx = r * TileColumns + c;
+                    Entry e;
+                    e.kind = tile.kinds[idx];
+                    e.style = tile.styles[idx];
+                    e.value = tile.values[idx];
+                    func(rowBase + r, colBase + c, e);
+                }
+            }
+            ++it;
+        }
+    }
+
+    Cell *cachedCell(int row, int col) const;
+    void cacheCell(int row, int col, const QSharedPointer<Cell> &cell) const;
+
+private:
+    static inline quint64 tileKey(int tileRow, int tileCol)
+    {
+        return (quint64(tileRow) << 32) | quint32(tileCol);
+    }
+
+    Tile *tileFor(int row, int col, bool create);
+    const Tile *constTileFor(int row, int col) const;
+    int slotIndex(int row, int col) const
+    {
+        return ((row - 1) % TileRows) * TileColumns + (col - 1) % TileColumns;
+    }
+    void setSlot(int row, int col, Kind kind, int style, Value value);
+    template <typename ValueAt>
+    void setSlots(int row, int col, int count, Qt::Orientation orientation, Kind kind,
+                  int style, ValueAt valueAt);
+    void clearTileRow(Tile &tile, quint64 tileKey, int r);
+
+    QMap<quint64, Tile> m_tiles;
+    QHash<quint64, XlsxCellExtra> m_extras;
+    mutable QHash<quint64, QSharedPointer<Cell>> m_cellCache;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXCELLTABLE_P_H
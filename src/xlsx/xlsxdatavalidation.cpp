@@ -471,32 +471,32 @@ DataValidation DataValidation::loadFromXml(QXmlStreamReader &reader)
 {
     Q_ASSERT(reader.name() == QLatin1String("dataValidation"));
 
-    static QMap<QString, DataValidation::ValidationType> typeMap;
-    static QMap<QString, DataValidation::ValidationOperator> opMap;
-    static QMap<QString, DataValidation::ErrorStyle> esMap;
-    if (typeMap.isEmpty()) {
-        typeMap.insert(QStringLiteral("none"), DataValidation::None);
-        typeMap.insert(QStringLiteral("whole"), DataValidation::Whole);
-        typeMap.insert(QStringLiteral("decimal"), DataValidation::Decimal);
-        typeMap.insert(QStringLiteral("list"), DataValidation::List);
-        typeMap.insert(QStringLiteral("date"), DataValidation::Date);
-        typeMap.insert(QStringLiteral("time"), DataValidation::Time);
-        typeMap.insert(QStringLiteral("textLength"), DataValidation::TextLength);
-        typeMap.insert(QStringLiteral("custom"), DataValidation::Custom);
-
-        opMap.insert(QStringLiteral("between"), DataValidation::Between);
-        opMap.insert(QStringLiteral("notBetween"), DataValidation::NotBetween);
-        opMap.insert(QStringLiteral("equal"), DataValidation::Equal);
-        opMap.insert(QStringLiteral("notEqual"), DataValidation::NotEqual);
-        opMap.insert(QStringLiteral("lessThan"), DataValidation::LessThan);
-        opMap.insert(QStringLiteral("lessThanOrEqual"), DataValidation::LessThanOrEqual);
-        opMap.insert(QStringLiteral("greaterThan"), DataValidation::GreaterThan);
-        opMap.insert(QStringLiteral("greaterThanOrEqual"), DataValidation::GreaterThanOrEqual);
-
-        esMap.insert(QStringLiteral("stop"), DataValidation::Stop);
-        esMap.insert(QStringLiteral("warning"), DataValidation::Warning);
-        esMap.insert(QStringLiteral("information"), DataValidation::Information);
-    }
+    // Sheets may be loaded concurrently, so the maps are built only once.
+    static const QMap<QString, DataValidation::ValidationType> typeMap = {
+        { QStringLiteral("none"), DataValidation::None },
+        { QStringLiteral("whole"), DataValidation::Whole },
+        { QStringLiteral("decimal"), DataValidation::Decimal },
+        { QStringLiteral("list"), DataValidation::List },
+        { QStringLiteral("date"), DataValidation::Date },
+        { QStringLiteral("time"), DataValidation::Time },
+        { QStringLiteral("textLength"), DataValidation::TextLength },
+        { QStringLiteral("custom"), DataValidation::Custom }
+    };
+    static const QMap<QString, DataValidation::ValidationOperator> opMap = {
+        { QStringLiteral("between"), DataValidation::Between },
+        { QStringLiteral("notBetween"), DataValidation::NotBetween },
+        { QStringLiteral("equal"), DataValidation::Equal },
+        { QStringLiteral("notEqual"), DataValidation::NotEqual },
+        { QStringLiteral("lessThan"), DataValidation::LessThan },
+        { QStringLiteral("lessThanOrEqual"), DataValidation::LessThanOrEqual },
+        { QStringLiteral("greaterThan"), DataValidation::GreaterThan },
+        { QStringLiteral("greaterThanOrEqual"), DataValidation::GreaterThanOrEqual }
+    };
+    static const QMap<QString, DataValidation::ErrorStyle> esMap = {
+        { QStringLiteral("stop"), DataValidation::Stop },
+        { QStringLiteral("warning"), DataValidation::Warning },
+        { QStringLiteral("information"), DataValidation::Information }
+    };
 
     DataValidation validation;
     QXmlStreamAttributes attrs = reader.attributes();
@@ -507,15 +507,15 @@ DataValidation DataValidation::loadFromXml(QXmlStreamReader &reader)
 
     if (attrs.hasAttribute(QLatin1String("type"))) {
         QString t = attrs.value(QLatin1String("type")).toString();
-        validation.setValidationType(typeMap.contains(t) ? typeMap[t] : DataValidation::None);
+        validation.setValidationType(typeMap.value(t, DataValidation::None));
     }
     if (attrs.hasAttribute(QLatin1String("errorStyle"))) {
         QString es = attrs.value(QLatin1String("errorStyle")).toString();
-        validation.setErrorStyle(esMap.contains(es) ? esMap[es] : DataValidation::Stop);
+        validation.setErrorStyle(esMap.value(es, DataValidation::Stop));
     }
     if (attrs.hasAttribute(QLatin1String("operator"))) {
         QString op = attrs.value(QLatin1String("operator")).toString();
-        validation.setValidationOperator(opMap.contains(op) ? opMap[op] : DataValidation::Between);
+        validation.setValidationOperator(opMap.value(op, DataValidation::Between));
     }
     if (attrs.hasAttribute(QLatin1String("allowBlank"))) {
         validation.setAllowBlank(true);
@@ -27,6 +27,7 @@
 #include "xlsxdocument_p.h"
 #include "xlsxworkbook.h"
 #include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
 #include "xlsxcontenttypes_p.h"
 #include "xlsxrelationships_p.h"
 #include "xlsxstyles_p.h"
@@ -47,6 +48,12 @@
 #include <QPointF>
 #include <QBuffer>
 #include <QDir>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QXmlStreamReader>
 
 QT_BEGIN_NAMESPACE_XLSX
 
@@ -104,55 +111,16 @@ void DocumentPrivate::init()
         workbook = QSharedPointer<Workbook>(new Workbook(Workbook::F_NewFromScratch));
 }
 
-bool DocumentPrivate::loadPackage(QIODevice *device)
+/*
+  Load the workbook part of the package and, unless \a loadStyles is
+  false, the parts all its sheets depend on: the styles and the shared
+  strings. Used by loadPackage(), probePackage() and by the SheetReader.
+*/
+bool DocumentPrivate::loadWorkbook(ZipReader &zipReader, const Relationships &rootRels,
+                                   Workbook *workbook, bool loadStyles)
 {
-    Q_Q(Document);
-    ZipReader zipReader(device);
-    QStringList filePaths = zipReader.filePaths();
-
-    // Load the Content_Types file
-    if (!filePaths.contains(QLatin1String("[Content_Types].xml")))
-        return false;
-    contentTypes = QSharedPointer<ContentTypes>(new ContentTypes(ContentTypes::F_LoadFromExists));
-    contentTypes->loadFromXmlData(zipReader.fileData(QStringLiteral("[Content_Types].xml")));
-
-    // Load root rels file
-    if (!filePaths.contains(QLatin1String("_rels/.rels")))
-        return false;
-    Relationships rootRels;
-    rootRels.loadFromXmlData(zipReader.fileData(QStringLiteral("_rels/.rels")));
-
-    // load core property
-    QList<XlsxRelationship> rels_core =
-        rootRels.packageRelationships(QStringLiteral("/metadata/core-properties"));
-    if (!rels_core.isEmpty()) {
-        // Get the core property file name if it exists.
-        // In normal case, this should be "docProps/core.xml"
-        QString docPropsCore_Name = rels_core[0].target;
-
-        DocPropsCore props(DocPropsCore::F_LoadFromExists);
-        props.loadFromXmlData(zipReader.fileData(docPropsCore_Name));
-        foreach (QString name, props.propertyNames())
-            q->setDocumentProperty(name, props.property(name));
-    }
-
-    // load app property
-    QList<XlsxRelationship> rels_app =
-        rootRels.documentRelationships(QStringLiteral("/extended-properties"));
-    if (!rels_app.isEmpty()) {
-        // Get the app property file name if it exists.
-        // In normal case, this should be "docProps/app.xml"
-        QString docPropsApp_Name = rels_app[0].target;
-
-        DocPropsApp props(DocPropsApp::F_LoadFromExists);
-        props.loadFromXmlData(zipReader.fileData(docPropsApp_Name));
-        foreach (QString name, props.propertyNames())
-            q->setDocumentProperty(name, props.property(name));
-    }
-
-    // load workbook now, Get the workbook file path from the root rels file
+    // Get the workbook file path from the root rels file
     // In normal case, this should be "xl/workbook.xml"
-    workbook = QSharedPointer<Workbook>(new Workbook(Workbook::F_LoadFromExists));
     QList<XlsxRelationship> rels_xl =
         rootRels.documentRelationships(QStringLiteral("/officeDocument"));
     if (rels_xl.isEmpty())
@@ -162,6 +130,8 @@ bool DocumentPrivate::loadPackage(QIODevice *device)
     workbook->relationships()->loadFromXmlData(zipReader.fileData(getRelFilePath(xlworkbook_Path)));
     workbook->setFilePath(xlworkbook_Path);
     workbook->loadFromXmlData(zipReader.fileData(xlworkbook_Path));
+    if (!loadStyles)
+        return true;
 
     // load styles
     QList<XlsxRelationship> rels_styles =
@@ -185,56 +155,110 @@ bool DocumentPrivate::loadPackage(QIODevice *device)
         workbook->d_func()->sharedStrings->loadFromXmlData(zipReader.fileData(path));
     }
 
-    // load theme
-    QList<XlsxRelationship> rels_theme =
-        workbook->relationships()->documentRelationships(QStringLiteral("/theme"));
-    if (!rels_theme.isEmpty()) {
-        // In normal case this should be theme/theme1.xml which in xl
-        QString name = rels_theme[0].target;
-        QString path = xlworkbook_Dir + QLatin1String("/") + name;
-        workbook->theme()->loadFromXmlData(zipReader.fileData(path));
-    }
+    return true;
+}
 
-    // load sheets
-    for (int i = 0; i < workbook->sheetCount(); ++i) {
-        AbstractSheet *sheet = workbook->sheet(i);
-        QString rel_path = getRelFilePath(sheet->filePath());
-        // If the .rel file exists, load it.
-        if (zipReader.filePaths().contains(rel_path))
-            sheet->relationships()->loadFromXmlData(zipReader.fileData(rel_path));
-        sheet->loadFromXmlData(zipReader.fileData(sheet->filePath()));
+/*
+ * Load the relationships of \a file, if the package has them.
+ */
+static void loadRelationships(ZipReader &zipReader, AbstractOOXmlFile *file)
+{
+    QString rel_path = getRelFilePath(file->filePath());
+    // If the .rel file exists, load it.
+    if (zipReader.contains(rel_path))
+        file->relationships()->loadFromXmlData(zipReader.fileData(rel_path));
+}
+
+/*
+ * Parse the part \a path into \a file while it is inflated, without
+ * holding the uncompressed part in memory.
+ */
+static void loadPart(const ZipReader &zipReader, AbstractOOXmlFile *file, const QString &path)
+{
+    QScopedPointer<QIODevice> device(zipReader.openFile(path));
+    if (device)
+        file->loadFromXmlFile(device.data());
+    else
+        file->loadFromXmlData(QByteArray());
+}
+
+/*
+ * Restrict the cells loaded into \a sheet to the sheets, columns and
+ * rows of \a options, if it has any.
+ */
+static void setLoadProjection(AbstractSheet *sheet, const Document::LoadOptions &options)
+{
+    if (sheet->sheetType() != AbstractSheet::ST_WorkSheet)
+        return;
+    if (options.sheets.isEmpty() && options.columns.isEmpty() && options.firstRow <= 1
+        && options.lastRow < 0)
+        return;
+
+    XlsxLoadProjection &projection = static_cast<Worksheet *>(sheet)->d_func()->loadProjection;
+    projection.enabled = true;
+    if (!options.sheets.isEmpty() && !options.sheets.contains(sheet->sheetName())) {
+        // No row at all
+        projection.firstRow = 1;
+        projection.lastRow = 0;
+        return;
     }
 
-    // load external links
-    for (int i = 0; i < workbook->d_func()->externalLinks.count(); ++i) {
-        SimpleOOXmlFile *link = workbook->d_func()->externalLinks[i].data();
-        QString rel_path = getRelFilePath(link->filePath());
-        // If the .rel file exists, load it.
-        if (zipReader.filePaths().contains(rel_path))
-            link->relationships()->loadFromXmlData(zipReader.fileData(rel_path));
-        link->loadFromXmlData(zipReader.fileData(link->filePath()));
+    projection.firstRow = options.firstRow;
+    projection.lastRow = options.lastRow;
+    if (!options.columns.isEmpty()) {
+        int lastColumn = 0;
+        for (int column : options.columns)
+            lastColumn = qMax(lastColumn, column);
+        // A bit for every column up to the last one. The bits are never
+        // empty here, so a set of invalid columns selects no column.
+        projection.columns.resize(lastColumn + 1);
+        for (int column : options.columns) {
+            if (column > 0)
+                projection.columns.setBit(column);
+        }
     }
+}
 
-    // load drawings
-    for (int i = 0; i < workbook->drawings().size(); ++i) {
-        Drawing *drawing = workbook->drawings()[i];
-        QString rel_path = getRelFilePath(drawing->filePath());
-        if (zipReader.filePaths().contains(rel_path))
-            drawing->relationships()->loadFromXmlData(zipReader.fileData(rel_path));
+/*
+  Load \a sheet and the parts which only it refers to: its relationships,
+  its drawing with the charts and images of the drawing, and its
+  embedded objects.
+*/
+void DocumentPrivate::loadSheet(ZipReader &zipReader, Workbook *workbook, AbstractSheet *sheet,
+                                const Document::LoadOptions &options)
+{
+    const int firstMedia = workbook->d_func()->mediaFiles.size();
+    loadRelationships(zipReader, sheet);
+    setLoadProjection(sheet, options);
+    loadPart(zipReader, sheet, sheet->filePath());
+    loadSheetParts(zipReader, workbook, sheet, firstMedia);
+}
+
+/*
+  Load the parts of the already parsed \a sheet. The media files from
+  \a firstMedia on have been added by the sheet and are loaded too.
+*/
+void DocumentPrivate::loadSheetParts(ZipReader &zipReader, Workbook *workbook,
+                                     AbstractSheet *sheet, int firstMedia)
+{
+    const int firstChart = workbook->d_func()->chartFiles.size();
+
+    // load drawing
+    if (Drawing *drawing = sheet->drawing()) {
+        loadRelationships(zipReader, drawing);
         drawing->loadFromXmlData(zipReader.fileData(drawing->filePath()));
     }
 
-    // load charts
+    // load charts, the ones added by the drawing of this sheet
     QList<QSharedPointer<Chart>> chartFileToLoad = workbook->chartFiles();
-    for (int i = 0; i < chartFileToLoad.size(); ++i) {
+    for (int i = firstChart; i < chartFileToLoad.size(); ++i) {
         QSharedPointer<Chart> cf = chartFileToLoad[i];
         cf->loadFromXmlData(zipReader.fileData(cf->filePath()));
     }
 
     //load media files
     QList<QSharedPointer<MediaFile> > mediaFileToLoad = workbook->mediaFiles();
-    int msz = mediaFileToLoad.size();
-    for (int i = 0; i < mediaFileToLoad.size(); ++i) {
+    for (int i = firstMedia; i < mediaFileToLoad.size(); ++i) {
         QSharedPointer<MediaFile> mf = mediaFileToLoad[i];
         const QFileInfo fi(mf->fileName());
         const QString path = QStringLiteral("xl/media/%1").arg(fi.fileName());
@@ -243,24 +267,402 @@ bool DocumentPrivate::loadPackage(QIODevice *device)
     }
 
     //load ole object files
-    for (int i=0; i<workbook->sheetCount(); ++i) {
-        QXlsx::Worksheet* sheet =
-                reinterpret_cast<QXlsx::Worksheet*>(workbook->sheet(i));
-        QList<QSharedPointer<OleObject> > oleFileToLoad = sheet->oleObjectFiles();
-        for (int i=0; i<oleFileToLoad.size(); ++i) {
-            QSharedPointer<OleObject> obj = oleFileToLoad[i];
-            const QFileInfo fi(obj->fileName());
-            const QString path = QStringLiteral("xl/embeddings/%1").arg(fi.fileName());
-            obj->setContents(zipReader.fileData(path));
+    if (sheet->sheetType() != AbstractSheet::ST_WorkSheet)
+        return;
+    QList<QSharedPointer<OleObject> > oleFileToLoad =
+            static_cast<Worksheet *>(sheet)->oleObjectFiles();
+    for (int i=0; i<oleFileToLoad.size(); ++i) {
+        QSharedPointer<OleObject> obj = oleFileToLoad[i];
+        const QFileInfo fi(obj->fileName());
+        const QString path = QStringLiteral("xl/embeddings/%1").arg(fi.fileName());
+        obj->setContents(zipReader.fileData(path));
+    }
+}
+
+namespace {
+
+/*
+ * Inflates and parses the xml part of one worksheet on the thread pool.
+ */
+class SheetParser : public QRunnable
+{
+public:
+    SheetParser(const ZipReader &zipReader, AbstractSheet *sheet)
+        : zipReader(zipReader)
+        , sheet(sheet)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        loadPart(zipReader, sheet, sheet->filePath());
+        parsed.release();
+    }
+
+    const ZipReader &zipReader;
+    AbstractSheet *sheet;
+    QSemaphore parsed;
+};
+
+} // namespace
+
+/*
+ * Worksheets only read the styles and the shared strings of the workbook
+ * while they are parsed, unless they have OLE objects, whose preview
+ * images are added to the workbook media. Those are the sheets with
+ * image relationships.
+ */
+static bool canParseConcurrently(AbstractSheet *sheet)
+{
+    return sheet->sheetType() == AbstractSheet::ST_WorkSheet
+           && sheet->relationships()->documentRelationships(QStringLiteral("/image")).isEmpty();
+}
+
+/*
+  Load all the sheets of \a workbook. The worksheets are parsed
+  concurrently, a few sheets ahead of the one being finished. Everything
+  which touches the workbook, such as the shared string references and
+  the drawings, is then done here in sheet order, so the result is the
+  same as loading the sheets one after another.
+*/
+void DocumentPrivate::loadSheets(ZipReader &zipReader, Workbook *workbook,
+                                 const Document::LoadOptions &options)
+{
+    const int sheetCount = workbook->sheetCount();
+    QList<QSharedPointer<SheetParser>> parsers(sheetCount);
+
+    // Each parser inflates its own part while it parses it.
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int maxPending = 2 * qMax(pool->maxThreadCount(), 1);
+    int next = 0;
+    for (int i = 0; i < sheetCount; ++i) {
+        for (; next < sheetCount && next - i < maxPending; ++next) {
+            AbstractSheet *sheet = workbook->sheet(next);
+            loadRelationships(zipReader, sheet);
+            setLoadProjection(sheet, options);
+            if (!canParseConcurrently(sheet))
+                continue;
+            static_cast<Worksheet *>(sheet)->d_func()->deferSharedStringRefs = true;
+            parsers[next] = QSharedPointer<SheetParser>(new SheetParser(zipReader, sheet));
+            pool->start(parsers[next].data());
         }
+
+        AbstractSheet *sheet = workbook->sheet(i);
+        const int firstMedia = workbook->d_func()->mediaFiles.size();
+        if (SheetParser *parser = parsers[i].data()) {
+            // A sheet nobody has picked up yet is parsed here
+            if (pool->tryTake(parser))
+                parser->run();
+            parser->parsed.acquire();
+            WorksheetPrivate *sheet_d = static_cast<Worksheet *>(sheet)->d_func();
+            sheet_d->deferSharedStringRefs = false;
+            sheet_d->mergeSharedStringRefs();
+            parsers[i].reset();
+        } else {
+            loadPart(zipReader, sheet, sheet->filePath());
+        }
+        loadSheetParts(zipReader, workbook, sheet, firstMedia);
+    }
+}
+
+namespace {
+
+/*
+ * Keeps the package open for the sheets of a document opened with
+ * Document::LoadOptions::lazySheets.
+ */
+class PackageSheetLoader : public SheetLoader
+{
+public:
+    PackageSheetLoader(const QSharedPointer<ZipReader> &zipReader, Workbook *workbook,
+                       const Document::LoadOptions &options)
+        : zipReader(zipReader)
+        , workbook(workbook)
+        , options(options)
+    {
+    }
+
+    void loadSheet(AbstractSheet *sheet) override
+    {
+        DocumentPrivate::loadSheet(*zipReader, workbook, sheet, options);
+    }
+
+private:
+    QSharedPointer<ZipReader> zipReader;
+    Workbook *workbook;
+    Document::LoadOptions options;
+};
+
+} // namespace
+
+/*
+  Load the core and app properties of the package into \a properties.
+*/
+void DocumentPrivate::loadDocumentProperties(ZipReader &zipReader, const Relationships &rootRels,
+                                             QMap<QString, QString> *properties)
+{
+    // load core property
+    QList<XlsxRelationship> rels_core =
+        rootRels.packageRelationships(QStringLiteral("/metadata/core-properties"));
+    if (!rels_core.isEmpty()) {
+        // Get the core property file name if it exists.
+        // In normal case, this should be "docProps/core.xml"
+        QString docPropsCore_Name = rels_core[0].target;
+
+        DocPropsCore props(DocPropsCore::F_LoadFromExists);
+        props.loadFromXmlData(zipReader.fileData(docPropsCore_Name));
+        foreach (QString name, props.propertyNames())
+            properties->insert(name, props.property(name));
+    }
+
+    // load app property
+    QList<XlsxRelationship> rels_app =
+        rootRels.documentRelationships(QStringLiteral("/extended-properties"));
+    if (!rels_app.isEmpty()) {
+        // Get the app property file name if it exists.
+        // In normal case, this should be "docProps/app.xml"
+        QString docPropsApp_Name = rels_app[0].target;
+
+        DocPropsApp props(DocPropsApp::F_LoadFromExists);
+        props.loadFromXmlData(zipReader.fileData(docPropsApp_Name));
+        foreach (QString name, props.propertyNames())
+            properties->insert(name, props.property(name));
     }
+}
 
+/*
+  Read the metadata of the package into \a info: the document
+  properties, the sheets and the defined names of the workbook, and the
+  dimension each worksheet declares. Neither the styles, the shared
+  strings nor the cells are read.
+*/
+bool DocumentPrivate::probePackage(ZipReader &zipReader, Document::ProbeInfo *info)
+{
+    if (!zipReader.contains(QStringLiteral("[Content_Types].xml"))
+        || !zipReader.contains(QStringLiteral("_rels/.rels")))
+        return false;
+    Relationships rootRels;
+    rootRels.loadFromXmlData(zipReader.fileData(QStringLiteral("_rels/.rels")));
+
+    loadDocumentProperties(zipReader, rootRels, &info->documentProperties);
+
+    Workbook workbook(Workbook::F_LoadFromExists);
+    if (!loadWorkbook(zipReader, rootRels, &workbook, false))
+        return false;
+
+    for (int i = 0; i < workbook.sheetCount(); ++i) {
+        AbstractSheet *sheet = workbook.sheet(i);
+        Document::SheetInfo sheetInfo;
+        sheetInfo.name = sheet->sheetName();
+        sheetInfo.type = sheet->sheetType();
+        sheetInfo.state = sheet->sheetState();
+        if (sheetInfo.type == AbstractSheet::ST_WorkSheet)
+            sheetInfo.dimension = probeDimension(zipReader, sheet->filePath());
+        info->sheets.append(sheetInfo);
+    }
+
+    foreach (const XlsxDefineNameData &data, workbook.d_func()->definedNamesList) {
+        Document::DefinedNameInfo name;
+        name.name = data.name;
+        name.formula = data.formula;
+        name.comment = data.comment;
+        if (data.sheetId != -1) {
+            for (int i = 0; i < workbook.sheetCount(); ++i) {
+                if (workbook.sheet(i)->sheetId() == data.sheetId)
+                    name.scope = workbook.sheet(i)->sheetName();
+            }
+        }
+        info->definedNames.append(name);
+    }
     return true;
 }
 
-bool DocumentPrivate::savePackage(QIODevice *device) const
+/*
+  Read the <dimension> element of the worksheet part \a sheetPath. The
+  part is inflated only up to that element, or up to <sheetData> when
+  the worksheet has none.
+*/
+CellRange DocumentPrivate::probeDimension(ZipReader &zipReader, const QString &sheetPath)
+{
+    QScopedPointer<QIODevice> device(zipReader.openFile(sheetPath));
+    if (!device)
+        return CellRange();
+
+    QXmlStreamReader reader(device.data());
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement)
+            continue;
+        if (reader.name() == QLatin1String("dimension"))
+            return CellRange::fromString(reader.attributes().value(QLatin1String("ref")));
+        if (reader.name() == QLatin1String("sheetData"))
+            break;
+    }
+    return CellRange();
+}
+
+bool DocumentPrivate::loadPackage(const QSharedPointer<ZipReader> &package,
+                                  const Document::LoadOptions &options)
+{
+    ZipReader &zipReader = *package;
+
+    // Load the Content_Types file
+    if (!zipReader.contains(QStringLiteral("[Content_Types].xml")))
+        return false;
+    contentTypes = QSharedPointer<ContentTypes>(new ContentTypes(ContentTypes::F_LoadFromExists));
+    contentTypes->loadFromXmlData(zipReader.fileData(QStringLiteral("[Content_Types].xml")));
+
+    // Load root rels file
+    if (!zipReader.contains(QStringLiteral("_rels/.rels")))
+        return false;
+    Relationships rootRels;
+    rootRels.loadFromXmlData(zipReader.fileData(QStringLiteral("_rels/.rels")));
+
+    // load core and app properties
+    loadDocumentProperties(zipReader, rootRels, &documentProperties);
+
+    // load workbook now, with the styles and the shared strings
+    workbook = QSharedPointer<Workbook>(new Workbook(Workbook::F_LoadFromExists));
+    workbook->d_func()->sharedStrings->setLazyLoad(options.lazySharedStrings);
+    if (!loadWorkbook(zipReader, rootRels, workbook.data()))
+        return false;
+    QString xlworkbook_Dir = splitPath(workbook->filePath())[0];
+
+    // load theme
+    QList<XlsxRelationship> rels_theme =
+        workbook->relationships()->documentRelationships(QStringLiteral("/theme"));
+    if (!rels_theme.isEmpty()) {
+        // In normal case this should be theme/theme1.xml which in xl
+        QString name = rels_theme[0].target;
+        QString path = xlworkbook_Dir + QLatin1String("/") + name;
+        workbook->theme()->loadFromXmlData(zipReader.fileData(path));
+    }
+
+    // load external links
+    for (int i = 0; i < workbook->d_func()->externalLinks.count(); ++i) {
+        SimpleOOXmlFile *link = workbook->d_func()->externalLinks[i].data();
+        loadRelationships(zipReader, link);
+        link->loadFromXmlData(zipReader.fileData(link->filePath()));
+    }
+
+    // load sheets, with their drawings, charts, media and objects
+    if (options.lazySheets) {
+        workbook->d_func()->setSheetLoader(
+            new PackageSheetLoader(package, workbook.data(), options));
+    } else {
+        loadSheets(zipReader, workbook.data(), options);
+    }
+
+    return true;
+}
+
+namespace {
+
+/*
+ * One entry of the package. Xml parts are rendered and deflated on the
+ * thread pool, except the direct ones, which are rendered straight into
+ * the package on the calling thread. Relationships are filled while their
+ * owner part is rendered, so they and the binary files are written on the
+ * calling thread once everything before them is in the package.
+ */
+class PackagePart : public QRunnable
+{
+public:
+    PackagePart(const QString &filePath, const AbstractOOXmlFile *file)
+        : filePath(filePath)
+        , file(file)
+        , relationships(0)
+        , compressionLevel(-1)
+        , parallelDeflate(false)
+        , direct(false)
+    {
+        setAutoDelete(false);
+    }
+
+    PackagePart(const QString &filePath, const Relationships *relationships)
+        : filePath(filePath)
+        , file(0)
+        , relationships(relationships)
+        , compressionLevel(-1)
+        , parallelDeflate(false)
+        , direct(false)
+    {
+        setAutoDelete(false);
+    }
+
+    PackagePart(const QString &filePath, const QByteArray &contents)
+        : filePath(filePath)
+        , file(0)
+        , relationships(0)
+        , compressionLevel(-1)
+        , parallelDeflate(false)
+        , direct(false)
+        , contents(contents)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        data.reset(new ZipEntryBuffer);
+        data->setCompressionLevel(compressionLevel);
+        data->setParallelDeflate(parallelDeflate);
+        if (file)
+            file->saveToXmlFile(data.data());
+        else
+            relationships->saveToXmlFile(data.data());
+        data->close();
+        rendered.release();
+    }
+
+    QString filePath;
+    const AbstractOOXmlFile *file;
+    const Relationships *relationships;
+    int compressionLevel;
+    bool parallelDeflate;
+    bool direct;
+    QByteArray contents;
+    QScopedPointer<ZipEntryBuffer> data;
+    QSemaphore rendered;
+};
+
+// Cell storage above which a sheet is not buffered before entering the package
+const qint64 DirectPartMemory = 8 * 1024 * 1024;
+
+} // namespace
+
+/*
+ * Returns the deflate level \a filePath is written with.
+ */
+static int compressionLevel(const QString &filePath, const Document::SaveOptions &options)
+{
+    const QString fileName = filePath.mid(filePath.lastIndexOf(QLatin1Char('/')) + 1);
+    for (const QString &pattern : options.uncompressedFiles) {
+        const QRegularExpression re =
+            QRegularExpression::fromWildcard(pattern, Qt::CaseInsensitive);
+        if (re.match(pattern.contains(QLatin1Char('/')) ? filePath : fileName).hasMatch())
+            return 0;
+    }
+
+    if (!options.compressMedia && filePath.startsWith(QLatin1String("xl/media/"))) {
+        const QString suffix = QFileInfo(fileName).suffix().toLower();
+        if (suffix == QLatin1String("png") || suffix == QLatin1String("jpg")
+            || suffix == QLatin1String("jpeg") || suffix == QLatin1String("gif"))
+            return 0;
+    }
+    return options.compressionLevel;
+}
+
+bool DocumentPrivate::savePackage(QIODevice *device, const Document::SaveOptions &options) const
 {
     Q_Q(const Document);
+    // All the sheets of a lazily loaded package are saved
+    workbook->d_func()->loadAllSheets();
+    // A package needs at least one sheet. It is added before the parts
+    // are collected, as the workbook part is rendered on the pool.
+    if (workbook->sheetCount() == 0)
+        workbook->addSheet();
+
     ZipWriter zipWriter(device);
     if (zipWriter.error())
         return false;
@@ -269,6 +671,15 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
 
     DocPropsApp docPropsApp(DocPropsApp::F_NewFromScratch);
     DocPropsCore docPropsCore(DocPropsCore::F_NewFromScratch);
+    Relationships rootrels;
+
+    // Collect the parts in package order first. Everything shared between
+    // parts, such as the content types, the document properties and the
+    // media indexes, is filled in here, so rendering a part only reads the
+    // workbook and fills its own relationships.
+    // Shared string indexes are assigned when cells are written, so the
+    // sheets never touch the shared string table while being saved.
+    QList<QSharedPointer<PackagePart>> parts;
 
     // save worksheet xml files
     QList<QSharedPointer<AbstractSheet>> worksheets =
@@ -280,12 +691,19 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         contentTypes->addWorksheetName(QStringLiteral("sheet%1").arg(i + 1));
         docPropsApp.addPartTitle(sheet->sheetName());
 
-        zipWriter.addFile(QStringLiteral("xl/worksheets/sheet%1.xml").arg(i + 1),
-                          sheet->saveToXmlData());
-        Relationships *rel = sheet->relationships();
-        if (!rel->isEmpty())
-            zipWriter.addFile(QStringLiteral("xl/worksheets/_rels/sheet%1.xml.rels").arg(i + 1),
-                              rel->saveToXmlData());
+        QSharedPointer<PackagePart> part(
+            new PackagePart(QStringLiteral("xl/worksheets/sheet%1.xml").arg(i + 1), sheet.data()));
+        // Large sheets are additionally deflated block-wise in parallel.
+        part->parallelDeflate = true;
+        // The rows spooled by the streaming mode, and large sheets, are
+        // rendered straight into the package instead of into memory.
+        const WorksheetPrivate *sheet_d = static_cast<Worksheet *>(sheet.data())->d_func();
+        part->direct = !sheet_d->streamFile.isNull()
+            || sheet_d->cellTable.memoryUsage() > DirectPartMemory;
+        parts.append(part);
+        parts.append(QSharedPointer<PackagePart>(new PackagePart(
+            QStringLiteral("xl/worksheets/_rels/sheet%1.xml.rels").arg(i + 1),
+            sheet->relationships())));
     }
 
     // save chartsheet xml files
@@ -298,12 +716,11 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         contentTypes->addWorksheetName(QStringLiteral("sheet%1").arg(i + 1));
         docPropsApp.addPartTitle(sheet->sheetName());
 
-        zipWriter.addFile(QStringLiteral("xl/chartsheets/sheet%1.xml").arg(i + 1),
-                          sheet->saveToXmlData());
-        Relationships *rel = sheet->relationships();
-        if (!rel->isEmpty())
-            zipWriter.addFile(QStringLiteral("xl/chartsheets/_rels/sheet%1.xml.rels").arg(i + 1),
-                              rel->saveToXmlData());
+        parts.append(QSharedPointer<PackagePart>(new PackagePart(
+            QStringLiteral("xl/chartsheets/sheet%1.xml").arg(i + 1), sheet.data())));
+        parts.append(QSharedPointer<PackagePart>(new PackagePart(
+            QStringLiteral("xl/chartsheets/_rels/sheet%1.xml.rels").arg(i + 1),
+            sheet->relationships())));
     }
 
     // save external links xml files
@@ -311,31 +728,30 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         SimpleOOXmlFile *link = workbook->d_func()->externalLinks[i].data();
         contentTypes->addExternalLinkName(QStringLiteral("externalLink%1").arg(i + 1));
 
-        zipWriter.addFile(QStringLiteral("xl/externalLinks/externalLink%1.xml").arg(i + 1),
-                          link->saveToXmlData());
-        Relationships *rel = link->relationships();
-        if (!rel->isEmpty())
-            zipWriter.addFile(
-                QStringLiteral("xl/externalLinks/_rels/externalLink%1.xml.rels").arg(i + 1),
-                rel->saveToXmlData());
+        parts.append(QSharedPointer<PackagePart>(new PackagePart(
+            QStringLiteral("xl/externalLinks/externalLink%1.xml").arg(i + 1), link)));
+        parts.append(QSharedPointer<PackagePart>(new PackagePart(
+            QStringLiteral("xl/externalLinks/_rels/externalLink%1.xml.rels").arg(i + 1),
+            link->relationships())));
     }
 
     // save workbook xml file
     contentTypes->addWorkbook();
-    zipWriter.addFile(QStringLiteral("xl/workbook.xml"), workbook->saveToXmlData());
-    zipWriter.addFile(QStringLiteral("xl/_rels/workbook.xml.rels"),
-                      workbook->relationships()->saveToXmlData());
+    parts.append(QSharedPointer<PackagePart>(
+        new PackagePart(QStringLiteral("xl/workbook.xml"), workbook.data())));
+    parts.append(QSharedPointer<PackagePart>(
+        new PackagePart(QStringLiteral("xl/_rels/workbook.xml.rels"), workbook->relationships())));
 
     // save drawing xml files
     for (int i = 0; i < workbook->drawings().size(); ++i) {
         contentTypes->addDrawingName(QStringLiteral("drawing%1").arg(i + 1));
 
         Drawing *drawing = workbook->drawings()[i];
-        zipWriter.addFile(QStringLiteral("xl/drawings/drawing%1.xml").arg(i + 1),
-                          drawing->saveToXmlData());
-        if (!drawing->relationships()->isEmpty())
-            zipWriter.addFile(QStringLiteral("xl/drawings/_rels/drawing%1.xml.rels").arg(i + 1),
-                              drawing->relationships()->saveToXmlData());
+        parts.append(QSharedPointer<PackagePart>(
+            new PackagePart(QStringLiteral("xl/drawings/drawing%1.xml").arg(i + 1), drawing)));
+        parts.append(QSharedPointer<PackagePart>(new PackagePart(
+            QStringLiteral("xl/drawings/_rels/drawing%1.xml.rels").arg(i + 1),
+            drawing->relationships())));
     }
 
     // save docProps app/core xml file
@@ -345,39 +761,59 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
     }
     contentTypes->addDocPropApp();
     contentTypes->addDocPropCore();
-    zipWriter.addFile(QStringLiteral("docProps/app.xml"), docPropsApp.saveToXmlData());
-    zipWriter.addFile(QStringLiteral("docProps/core.xml"), docPropsCore.saveToXmlData());
+    parts.append(QSharedPointer<PackagePart>(
+        new PackagePart(QStringLiteral("docProps/app.xml"), &docPropsApp)));
+    parts.append(QSharedPointer<PackagePart>(
+        new PackagePart(QStringLiteral("docProps/core.xml"), &docPropsCore)));
 
     // save sharedStrings xml file
     if (!workbook->sharedStrings()->isEmpty()) {
         contentTypes->addSharedString();
-        zipWriter.addFile(QStringLiteral("xl/sharedStrings.xml"),
-                          workbook->sharedStrings()->saveToXmlData());
+        parts.append(QSharedPointer<PackagePart>(
+            new PackagePart(QStringLiteral("xl/sharedStrings.xml"), workbook->sharedStrings())));
     }
 
     // save styles xml file
     contentTypes->addStyles();
-    zipWriter.addFile(QStringLiteral("xl/styles.xml"), workbook->styles()->saveToXmlData());
+    parts.append(QSharedPointer<PackagePart>(
+        new PackagePart(QStringLiteral("xl/styles.xml"), workbook->styles())));
 
     // save theme xml file
     contentTypes->addTheme();
-    zipWriter.addFile(QStringLiteral("xl/theme/theme1.xml"), workbook->theme()->saveToXmlData());
+    parts.append(QSharedPointer<PackagePart>(
+        new PackagePart(QStringLiteral("xl/theme/theme1.xml"), workbook->theme())));
 
     // save chart xml files
     for (int i = 0; i < workbook->chartFiles().size(); ++i) {
         contentTypes->addChartName(QStringLiteral("chart%1").arg(i + 1));
         QSharedPointer<Chart> cf = workbook->chartFiles()[i];
-        zipWriter.addFile(QStringLiteral("xl/charts/chart%1.xml").arg(i + 1), cf->saveToXmlData());
+        parts.append(QSharedPointer<PackagePart>(
+            new PackagePart(QStringLiteral("xl/charts/chart%1.xml").arg(i + 1), cf.data())));
     }
 
+    // The preview images of the ole objects are named after their index
+    // both here and in the relationships of their sheet.
+    for (int i = 0; i < worksheets.size(); ++i) {
+        Worksheet *sheet = static_cast<Worksheet *>(worksheets[i].data());
+        const QList<QSharedPointer<OleObject>> oleFiles = sheet->oleObjectFiles();
+        for (const QSharedPointer<OleObject> &obj : oleFiles) {
+            QSharedPointer<MediaFile> media = obj->prMediaFile();
+            if (media && !workbook->mediaFiles().contains(media))
+                workbook->addMediaFile(media, true);
+        }
+    }
+    const QList<QSharedPointer<MediaFile>> mediaFiles = workbook->mediaFiles();
+    for (int i = 0; i < mediaFiles.size(); ++i)
+        mediaFiles[i]->setIndex(i);
+
     // save image files
     for (int i = 0; i < workbook->mediaFiles().size(); ++i) {
         QSharedPointer<MediaFile> mf = workbook->mediaFiles()[i];
         if (!mf->mimeType().isEmpty())
             contentTypes->addDefault(mf->suffix(), mf->mimeType());
-        zipWriter.addFile(QStringLiteral("xl/media/image%1.%2")
-                          .arg(mf->index()+1).arg(mf->suffix()),
-                          mf->contents());
+        parts.append(QSharedPointer<PackagePart>(new PackagePart(
+            QStringLiteral("xl/media/image%1.%2").arg(mf->index() + 1).arg(mf->suffix()),
+            mf->contents())));
     }
 
     // save ole object files
@@ -391,25 +827,79 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
                 contentTypes->addDefault(obj->suffix(), obj->mimeType());
                 contentTypes->addOverride(QStringLiteral("/xl/embeddings/%1").arg(obj->suffix()), obj->mimeType());
             }
-            zipWriter.addFile(QStringLiteral("xl/embeddings/%1").arg(fi.fileName()), obj->contents());
+            parts.append(QSharedPointer<PackagePart>(new PackagePart(
+                QStringLiteral("xl/embeddings/%1").arg(fi.fileName()), obj->contents())));
         }
     }
 
     // save root .rels xml file
-    Relationships rootrels;
     rootrels.addDocumentRelationship(QStringLiteral("/officeDocument"),
                                      QStringLiteral("xl/workbook.xml"));
     rootrels.addPackageRelationship(QStringLiteral("/metadata/core-properties"),
                                     QStringLiteral("docProps/core.xml"));
     rootrels.addDocumentRelationship(QStringLiteral("/extended-properties"),
                                      QStringLiteral("docProps/app.xml"));
-    zipWriter.addFile(QStringLiteral("_rels/.rels"), rootrels.saveToXmlData());
+    parts.append(QSharedPointer<PackagePart>(
+        new PackagePart(QStringLiteral("_rels/.rels"), &rootrels)));
 
     // save content types xml file
-    zipWriter.addFile(QStringLiteral("[Content_Types].xml"), contentTypes->saveToXmlData());
+    parts.append(QSharedPointer<PackagePart>(
+        new PackagePart(QStringLiteral("[Content_Types].xml"), contentTypes.data())));
+
+    for (const QSharedPointer<PackagePart> &part : std::as_const(parts)) {
+        part->compressionLevel = compressionLevel(part->filePath, options);
+        // Stored entries are buffered, ZipWriter::openFile() only deflates
+        if (part->compressionLevel == 0)
+            part->direct = false;
+    }
+
+    // Render the xml parts concurrently, and add all entries in order.
+    // Only a few parts are started ahead of the one being written, which
+    // bounds the compressed parts held in memory. A part nobody has picked
+    // up yet is rendered here, so saving never waits on a pool whose
+    // threads are all busy, even with our callers.
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int maxInFlight = 2 * qMax(pool->maxThreadCount(), 1);
+    int started = 0; // the parts before it have been started
+    int inFlight = 0;
+    for (int i = 0; i < parts.size(); ++i) {
+        for (; started < parts.size() && inFlight < maxInFlight; ++started) {
+            PackagePart *next = parts[started].data();
+            if (next->file && !next->direct) {
+                pool->start(next);
+                ++inFlight;
+            }
+        }
+
+        PackagePart *part = parts[i].data();
+        if (part->direct) {
+            zipWriter.setCompressionLevel(part->compressionLevel);
+            zipWriter.setParallelDeflate(part->parallelDeflate);
+            part->file->saveToXmlFile(zipWriter.openFile(part->filePath));
+            zipWriter.closeFile();
+            zipWriter.setParallelDeflate(false);
+        } else if (part->file) {
+            if (pool->tryTake(part))
+                part->run();
+            part->rendered.acquire();
+            --inFlight;
+            zipWriter.addFile(part->filePath, *part->data);
+            part->data.reset();
+        } else if (part->relationships) {
+            if (!part->relationships->isEmpty()) {
+                part->run();
+                part->rendered.acquire();
+                zipWriter.addFile(part->filePath, *part->data);
+                part->data.reset();
+            }
+        } else {
+            zipWriter.setCompressionLevel(part->compressionLevel);
+            zipWriter.addFile(part->filePath, part->contents);
+        }
+    }
 
     zipWriter.close();
-    return true;
+    return !zipWriter.error();
 }
 
 /*!
@@ -440,11 +930,8 @@ Document::Document(const QString &name, QObject *parent)
     , d_ptr(new DocumentPrivate(this))
 {
     d_ptr->packageName = name;
-    if (QFile::exists(name)) {
-        QFile xlsx(name);
-        if (xlsx.open(QFile::ReadOnly))
-            d_ptr->loadPackage(&xlsx);
-    }
+    if (QFile::exists(name))
+        d_ptr->loadPackage(QSharedPointer<ZipReader>(new ZipReader(name)));
     d_ptr->init();
 }
 
@@ -458,10 +945,76 @@ Document::Document(QIODevice *device, QObject *parent)
     , d_ptr(new DocumentPrivate(this))
 {
     if (device && device->isReadable())
-        d_ptr->loadPackage(device);
+        d_ptr->loadPackage(QSharedPointer<ZipReader>(new ZipReader(device)));
     d_ptr->init();
 }
 
+/*!
+ * \overload
+ * Try to open an existing xlsx document named \a name, loaded as
+ * described by \a options.
+ * The \a parent argument is passed to QObject's constructor.
+ */
+Document::Document(const QString &name, const LoadOptions &options, QObject *parent)
+    : QObject(parent)
+    , d_ptr(new DocumentPrivate(this))
+{
+    d_ptr->packageName = name;
+    if (QFile::exists(name))
+        d_ptr->loadPackage(QSharedPointer<ZipReader>(new ZipReader(name)), options);
+    d_ptr->init();
+}
+
+/*!
+ * \overload
+ * Try to open an existing xlsx document from \a device, loaded as
+ * described by \a options.
+ * The \a parent argument is passed to QObject's constructor.
+ */
+Document::Document(QIODevice *device, const LoadOptions &options, QObject *parent)
+    : QObject(parent)
+    , d_ptr(new DocumentPrivate(this))
+{
+    if (device && device->isReadable())
+        d_ptr->loadPackage(QSharedPointer<ZipReader>(new ZipReader(device)), options);
+    d_ptr->init();
+}
+
+/*!
+ * Reads the metadata of the xlsx document named \a name without loading
+ * it: the sheets with their type, state and dimension, the defined
+ * names and the document properties. Only the workbook part, its
+ * relationships, the document properties and the beginning of each
+ * worksheet part, up to its <dimension> element, are read, so the time
+ * taken does not depend on the number of cells.
+ *
+ * The returned ProbeInfo is invalid if \a name is not a xlsx package.
+ */
+Document::ProbeInfo Document::probe(const QString &name)
+{
+    ProbeInfo info;
+    if (QFile::exists(name)) {
+        ZipReader zipReader(name);
+        info.isValid = DocumentPrivate::probePackage(zipReader, &info);
+    }
+    return info;
+}
+
+/*!
+ * \overload
+ * Reads the metadata of the xlsx document in \a device without loading
+ * it.
+ */
+Document::ProbeInfo Document::probe(QIODevice *device)
+{
+    ProbeInfo info;
+    if (device && device->isReadable()) {
+        ZipReader zipReader(device);
+        info.isValid = DocumentPrivate::probePackage(zipReader, &info);
+    }
+    return info;
+}
+
 /*!
     \overload
 
@@ -1086,6 +1639,26 @@ bool Document::selectSheet(const QString &name)
     return d->workbook->setActiveSheet(sheetNames().indexOf(name));
 }
 
+/*!
+ * Compute the formulas of all the worksheets, one sheet after the
+ * other in the order of the workbook, and store their results as the
+ * cached values of the formula cells.
+ * Returns the number of formulas computed.
+ *
+ * \sa Worksheet::recalculate()
+ */
+int Document::recalculate()
+{
+    Q_D(Document);
+    int computed = 0;
+    for (int i = 0; i < d->workbook->sheetCount(); ++i) {
+        AbstractSheet *sheet = d->workbook->sheet(i);
+        if (sheet && sheet->sheetType() == AbstractSheet::ST_WorkSheet)
+            computed += static_cast<Worksheet *>(sheet)->recalculate();
+    }
+    return computed;
+}
+
 /*!
  * Returns the names of worksheets contained in current document.
  */
@@ -1114,6 +1687,9 @@ bool Document::save() const
  */
 bool Document::saveAs(const QString &name) const
 {
+    Q_D(const Document);
+    // A lazily loaded package may be the file being overwritten
+    d->workbook->d_func()->loadAllSheets();
     QFile file(name);
     if (file.open(QIODevice::WriteOnly))
         return saveAs(&file);
@@ -1132,6 +1708,206 @@ bool Document::saveAs(QIODevice *device) const
     return d->savePackage(device);
 }
 
+/*!
+ * \overload
+ * Saves the document to the file with the given \a name, compressed
+ * as described by \a options.
+ */
+bool Document::saveAs(const QString &name, const SaveOptions &options) const
+{
+    Q_D(const Document);
+    // A lazily loaded package may be the file being overwritten
+    d->workbook->d_func()->loadAllSheets();
+    QFile file(name);
+    if (file.open(QIODevice::WriteOnly))
+        return saveAs(&file, options);
+    return false;
+}
+
+/*!
+ * \overload
+ * This function writes a document to the given \a device, compressed
+ * as described by \a options.
+ *
+ * \warning The \a device will be closed when this function returned.
+ */
+bool Document::saveAs(QIODevice *device, const SaveOptions &options) const
+{
+    Q_D(const Document);
+    return d->savePackage(device, options);
+}
+
+/*!
+  \class Document::SaveOptions
+  \inmodule QtXlsx
+  \brief The SaveOptions struct controls how the parts of the package
+  are compressed by Document::saveAs().
+
+  \variable Document::SaveOptions::compressionLevel
+  The deflate level of the package, from 1 (fastest) to 9 (smallest),
+  or -1 for the zlib default. With 0 every part is stored uncompressed.
+
+  \variable Document::SaveOptions::uncompressedFiles
+  Wildcard patterns of the parts that are stored uncompressed, such as
+  "xl/worksheets/*.xml". A pattern without a '/' is matched against the
+  file name only, so "*.rels" matches the relationships of all parts.
+
+  \variable Document::SaveOptions::compressMedia
+  Whether PNG, JPEG and GIF images in xl/media are deflated. These are
+  compressed already, so storing them saves time at almost no size cost.
+  The default is true.
+*/
+
+/*!
+ * Constructs save options with the default compression level, no
+ * uncompressed parts and compressed media.
+ */
+Document::SaveOptions::SaveOptions()
+    : compressionLevel(-1)
+    , compressMedia(true)
+{
+}
+
+/*!
+  \class Document::LoadOptions
+  \inmodule QtXlsx
+  \brief The LoadOptions struct controls how much of the package is
+  loaded when a document is opened.
+
+  \variable Document::LoadOptions::lazySheets
+  Whether the sheets are parsed on first access instead of when the
+  document is opened. The workbook, the styles and the shared strings
+  are loaded up front; a sheet, with its drawing, charts, images and
+  embedded objects, is loaded the first time it is returned by
+  Document::sheet(), Document::currentSheet() or Workbook::sheet().
+  Saving the document loads all the sheets first. The package stays
+  open until every sheet has been loaded. The default is false.
+
+  \variable Document::LoadOptions::lazySharedStrings
+  Whether the shared strings are decoded on first access instead of
+  when the document is opened. The shared string part is kept in memory
+  with the position of every string in it, and a string is decoded
+  each time a cell that refers to it is read. The first change to the
+  shared strings, such as writing a new string, decodes them all.
+  Parts with comments, processing instructions or CDATA sections are
+  decoded up front. The default is false.
+
+  \variable Document::LoadOptions::sheets
+  The names of the worksheets whose cells are loaded. The cells of the
+  other worksheets are skipped. The default, an empty list, loads the
+  cells of every worksheet.
+
+  \variable Document::LoadOptions::columns
+  The columns whose cells are loaded, starting from 1. The default, an
+  empty set, loads every column.
+
+  \variable Document::LoadOptions::firstRow
+  The first row whose cells are loaded. The default is 1.
+
+  \variable Document::LoadOptions::lastRow
+  The last row whose cells are loaded, or -1 to load the rows up to the
+  end of the sheet. The default is -1.
+
+  Cells outside of the sheets, columns and rows above are skipped while
+  the worksheet is parsed: no Cell is created for them, and their
+  formats and shared strings are not looked up. Row information outside
+  of the rows is skipped as well. Everything else, such as the merged
+  cells, the column information and the data validations, is loaded as
+  usual. Saving such a document only writes the loaded cells.
+*/
+
+/*!
+ * Constructs load options which load the whole package up front.
+ */
+Document::LoadOptions::LoadOptions()
+    : lazySheets(false)
+    , lazySharedStrings(false)
+    , firstRow(1)
+    , lastRow(-1)
+{
+}
+
+/*!
+  \class Document::SheetInfo
+  \inmodule QtXlsx
+  \brief The SheetInfo struct describes a sheet of a probed document.
+
+  \variable Document::SheetInfo::name
+  The name of the sheet.
+
+  \variable Document::SheetInfo::type
+  The type of the sheet.
+
+  \variable Document::SheetInfo::state
+  Whether the sheet is visible, hidden or very hidden.
+
+  \variable Document::SheetInfo::dimension
+  The range of the used cells, as declared by the <dimension> element of
+  a worksheet. It is invalid for the other sheets, and for worksheets
+  which declare no dimension.
+
+  \sa Document::probe()
+*/
+
+/*!
+ * Constructs the description of a visible worksheet without dimension.
+ */
+Document::SheetInfo::SheetInfo()
+    : type(AbstractSheet::ST_WorkSheet)
+    , state(AbstractSheet::SS_Visible)
+{
+}
+
+/*!
+  \class Document::DefinedNameInfo
+  \inmodule QtXlsx
+  \brief The DefinedNameInfo struct describes a defined name of a probed
+  document.
+
+  \variable Document::DefinedNameInfo::name
+  The name.
+
+  \variable Document::DefinedNameInfo::formula
+  The formula the name refers to.
+
+  \variable Document::DefinedNameInfo::comment
+  The comment of the name.
+
+  \variable Document::DefinedNameInfo::scope
+  The name of the sheet the name is local to, or an empty string for a
+  name of the workbook.
+
+  \sa Document::probe(), Document::defineName()
+*/
+
+/*!
+  \class Document::ProbeInfo
+  \inmodule QtXlsx
+  \brief The ProbeInfo struct holds the metadata read by
+  Document::probe().
+
+  \variable Document::ProbeInfo::isValid
+  Whether the probed file is a xlsx package with a workbook.
+
+  \variable Document::ProbeInfo::sheets
+  The sheets of the workbook, in the workbook order.
+
+  \variable Document::ProbeInfo::definedNames
+  The defined names of the workbook.
+
+  \variable Document::ProbeInfo::documentProperties
+  The document properties, by name, as returned by
+  Document::documentProperty().
+*/
+
+/*!
+ * Constructs an invalid probe result.
+ */
+Document::ProbeInfo::ProbeInfo()
+    : isValid(false)
+{
+}
+
 /*!
  * Destroys the document and cleans up.
  */
@@ -30,7 +30,10 @@
 #include "xlsxformat.h"
 #include "xlsxworksheet.h"
 #include "xlsxdrawinganchor.h"
+#include <QMap>
 #include <QObject>
+#include <QSet>
+#include <QStringList>
 #include <QVariant>
 class QIODevice;
 class QImage;
@@ -52,9 +55,63 @@ class Q_XLSX_EXPORT Document : public QObject
     Q_DECLARE_PRIVATE(Document)
 
 public:
+    struct Q_XLSX_EXPORT SaveOptions
+    {
+        SaveOptions();
+
+        int compressionLevel;
+        QStringList uncompressedFiles;
+        bool compressMedia;
+    };
+
+    struct Q_XLSX_EXPORT LoadOptions
+    {
+        LoadOptions();
+
+        bool lazySheets;
+        bool lazySharedStrings;
+        QStringList sheets;
+        QSet<int> columns;
+        int firstRow;
+        int lastRow;
+    };
+
+    struct Q_XLSX_EXPORT SheetInfo
+    {
+        SheetInfo();
+
+        QString name;
+        AbstractSheet::SheetType type;
+        AbstractSheet::SheetState state;
+        CellRange dimension;
+    };
+
+    struct Q_XLSX_EXPORT DefinedNameInfo
+    {
+        QString name;
+        QString formula;
+        QString comment;
+        QString scope;
+    };
+
+    struct Q_XLSX_EXPORT ProbeInfo
+    {
+        ProbeInfo();
+
+        bool isValid;
+        QList<SheetInfo> sheets;
+        QList<DefinedNameInfo> definedNames;
+        QMap<QString, QString> documentProperties;
+    };
+
+    static ProbeInfo probe(const QString &xlsxName);
+    static ProbeInfo probe(QIODevice *device);
+
     explicit Document(QObject *parent = 0);
     Document(const QString &xlsxName, QObject *parent = 0);
     Document(QIODevice *device, QObject *parent = 0);
+    Document(const QString &xlsxName, const LoadOptions &options, QObject *parent = 0);
+    Document(QIODevice *device, const LoadOptions &options, QObject *parent = 0);
     ~Document();
 
     bool write(const CellReference &cell, const QVariant &value, const Format &format = Format());
@@ -136,9 +193,13 @@ public:
     AbstractSheet *currentSheet() const;
     Worksheet *currentWorksheet() const;
 
+    int recalculate();
+
     bool save() const;
     bool saveAs(const QString &xlsXname) const;
     bool saveAs(QIODevice *device) const;
+    bool saveAs(const QString &xlsXname, const SaveOptions &options) const;
+    bool saveAs(QIODevice *device, const SaveOptions &options) const;
 
 private:
     Q_DISABLE_COPY(Document)
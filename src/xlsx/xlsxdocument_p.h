@@ -42,9 +42,13 @@
 #include "xlsxcontenttypes_p.h"
 
 #include <QMap>
+#include <QSharedPointer>
 
 namespace QXlsx {
 
+class Relationships;
+class ZipReader;
+
 class DocumentPrivate
 {
     Q_DECLARE_PUBLIC(Document)
@@ -52,8 +56,22 @@ public:
     DocumentPrivate(Document *p);
     void init();
 
-    bool loadPackage(QIODevice *device);
-    bool savePackage(QIODevice *device) const;
+    bool loadPackage(const QSharedPointer<ZipReader> &package,
+                     const Document::LoadOptions &options = Document::LoadOptions());
+    static bool loadWorkbook(ZipReader &zipReader, const Relationships &rootRels,
+                             Workbook *workbook, bool loadStyles = true);
+    static void loadDocumentProperties(ZipReader &zipReader, const Relationships &rootRels,
+                                       QMap<QString, QString> *properties);
+    static bool probePackage(ZipReader &zipReader, Document::ProbeInfo *info);
+    static CellRange probeDimension(ZipReader &zipReader, const QString &sheetPath);
+    static void loadSheets(ZipReader &zipReader, Workbook *workbook,
+                           const Document::LoadOptions &options);
+    static void loadSheet(ZipReader &zipReader, Workbook *workbook, AbstractSheet *sheet,
+                          const Document::LoadOptions &options);
+    static void loadSheetParts(ZipReader &zipReader, Workbook *workbook, AbstractSheet *sheet,
+                               int firstMedia);
+    bool savePackage(QIODevice *device,
+                     const Document::SaveOptions &options = Document::SaveOptions()) const;
 
     Document *q_ptr;
     const QString defaultPackageName; // default name when package name not specified
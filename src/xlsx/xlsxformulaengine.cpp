@@ -0,0 +1,1402 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#include "xlsxformulaengine_p.h"
+#include "xlsxcellformula_p.h"
+#include "xlsxcelltable_p.h"
+#include "xlsxformulaexpression_p.h"
+#include "xlsxsharedstrings_p.h"
+#include "xlsxworksheet_p.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+typedef FormulaExpression::Token Token;
+
+const char ErrorDivZero[] = "#DIV/0!";
+const char ErrorNA[] = "#N/A";
+const char ErrorName[] = "#NAME?";
+const char ErrorNull[] = "#NULL!";
+const char ErrorNum[] = "#NUM!";
+const char ErrorRef[] = "#REF!";
+const char ErrorValue[] = "#VALUE!";
+
+/*
+  Intermediate result of a formula. A Range is only kept on the stack
+  of the evaluator, as the argument of a function or of a reference
+  operator; anywhere else it gives the value of its single cell.
+*/
+struct FormulaValue
+{
+    enum Type { Empty, Number, String, Boolean, Error, Range };
+
+    FormulaValue()
+        : type(Empty)
+        , number(0)
+        , sheet(0)
+    {
+    }
+
+    static FormulaValue fromNumber(double number)
+    {
+        FormulaValue v;
+        v.type = Number;
+        v.number = number;
+        return v;
+    }
+    static FormulaValue fromBool(bool value)
+    {
+        FormulaValue v;
+        v.type = Boolean;
+        v.number = value ? 1 : 0;
+        return v;
+    }
+    static FormulaValue fromString(const QString &text)
+    {
+        FormulaValue v;
+        v.type = String;
+        v.text = text;
+        return v;
+    }
+    static FormulaValue error(const QString &text)
+    {
+        FormulaValue v;
+        v.type = Error;
+        v.text = text;
+        return v;
+    }
+    static FormulaValue error(const char *text) { return error(QString::fromLatin1(text)); }
+    static FormulaValue fromRange(const WorksheetPrivate *sheet, const CellRange &range)
+    {
+        FormulaValue v;
+        v.type = Range;
+        v.sheet = sheet;
+        v.range = range;
+        return v;
+    }
+
+    Type type;
+    double number; // Number, Boolean
+    QString text; // String, Error
+    const WorksheetPrivate *sheet; // Range
+    CellRange range;
+};
+
+enum Function {
+    F_Unknown,
+    F_Sum,
+    F_Average,
+    F_Min,
+    F_Max,
+    F_Count,
+    F_CountA,
+    F_Product,
+    F_If,
+    F_IfError,
+    F_And,
+    F_Or,
+    F_Not,
+    F_True,
+    F_False,
+    F_Abs,
+    F_Int,
+    F_Round,
+    F_Mod,
+    F_Sqrt,
+    F_Power,
+    F_Concatenate,
+    F_Len,
+    F_VLookup,
+    F_HLookup,
+    F_Match,
+    F_Index,
+    F_IsBlank,
+    F_IsError,
+    F_IsNumber,
+    F_IsText
+};
+
+Function functionId(const QString &name)
+{
+    static const QHash<QString, Function> functions = {
+        {QStringLiteral("SUM"), F_Sum},
+        {QStringLiteral("AVERAGE"), F_Average},
+        {QStringLiteral("MIN"), F_Min},
+        {QStringLiteral("MAX"), F_Max},
+        {QStringLiteral("COUNT"), F_Count},
+        {QStringLiteral("COUNTA"), F_CountA},
+        {QStringLiteral("PRODUCT"), F_Product},
+        {QStringLiteral("IF"), F_If},
+        {QStringLiteral("IFERROR"), F_IfError},
+        {QStringLiteral("AND"), F_And},
+        {QStringLiteral("OR"), F_Or},
+        {QStringLiteral("NOT"), F_Not},
+        {QStringLiteral("TRUE"), F_True},
+        {QStringLiteral("FALSE"), F_False},
+        {QStringLiteral("ABS"), F_Abs},
+        {QStringLiteral("INT"), F_Int},
+        {QStringLiteral("ROUND"), F_Round},
+        {QStringLiteral("MOD"), F_Mod},
+        {QStringLiteral("SQRT"), F_Sqrt},
+        {QStringLiteral("POWER"), F_Power},
+        {QStringLiteral("CONCATENATE"), F_Concatenate},
+        {QStringLiteral("CONCAT"), F_Concatenate},
+        {QStringLiteral("LEN"), F_Len},
+        {QStringLiteral("VLOOKUP"), F_VLookup},
+        {QStringLiteral("HLOOKUP"), F_HLookup},
+        {QStringLiteral("MATCH"), F_Match},
+        {QStringLiteral("INDEX"), F_Index},
+        {QStringLiteral("ISBLANK"), F_IsBlank},
+        {QStringLiteral("ISERROR"), F_IsError},
+        {QStringLiteral("ISNUMBER"), F_IsNumber},
+        {QStringLiteral("ISTEXT"), F_IsText},
+    };
+
+    QString key = name.toUpper();
+    if (key.startsWith(QLatin1String("_XLFN.")))
+        key.remove(0, 6);
+    return functions.value(key, F_Unknown);
+}
+
+/*
+  The range a reference token refers to from a cell of a shared
+  formula, \a rowOffset rows and \a columnOffset columns away from the
+  master cell. Gives an invalid range when it falls out of the sheet.
+*/
+CellRange referenceRange(const Token &token, int rowOffset, int columnOffset)
+{
+    int firstRow = token.firstRow;
+    int firstColumn = token.firstColumn;
+    int lastRow = token.lastRow;
+    int lastColumn = token.lastColumn;
+
+    if (!(token.flags & FormulaExpression::WholeColumns)) {
+        if (!(token.flags & FormulaExpression::FirstRowAbsolute))
+            firstRow += rowOffset;
+        if (!(token.flags & FormulaExpression::LastRowAbsolute))
+            lastRow += rowOffset;
+    }
+    if (!(token.flags & FormulaExpression::WholeRows)) {
+        if (!(token.flags & FormulaExpression::FirstColumnAbsolute))
+            firstColumn += columnOffset;
+        if (!(token.flags & FormulaExpression::LastColumnAbsolute))
+            lastColumn += columnOffset;
+    }
+    if (!(token.flags & FormulaExpression::IsRange)) {
+        lastRow = firstRow;
+        lastColumn = firstColumn;
+    }
+
+    if (qMin(firstRow, lastRow) < 1 || qMin(firstColumn, lastColumn) < 1
+        || qMax(firstRow, lastRow) > XLSX_ROW_MAX
+        || qMax(firstColumn, lastColumn) > XLSX_COLUMN_MAX)
+        return CellRange();
+    return CellRange(qMin(firstRow, lastRow), qMin(firstColumn, lastColumn),
+                     qMax(firstRow, lastRow), qMax(firstColumn, lastColumn));
+}
+
+QString numberText(double number)
+{
+    return QString::number(number, 'g', 15);
+}
+
+FormulaValue toNumber(const FormulaValue &value)
+{
+    switch (value.type) {
+    case FormulaValue::Number:
+    case FormulaValue::Error:
+        return value;
+    case FormulaValue::Boolean:
+        return FormulaValue::fromNumber(value.number);
+    case FormulaValue::Empty:
+        return FormulaValue::fromNumber(0);
+    case FormulaValue::String: {
+        bool ok = false;
+        const double number = value.text.trimmed().toDouble(&ok);
+        return ok ? FormulaValue::fromNumber(number) : FormulaValue::error(ErrorValue);
+    }
+    default:
+        return FormulaValue::error(ErrorValue);
+    }
+}
+
+FormulaValue toBool(const FormulaValue &value)
+{
+    switch (value.type) {
+    case FormulaValue::Boolean:
+    case FormulaValue::Error:
+        return value;
+    case FormulaValue::Number:
+        return FormulaValue::fromBool(value.number != 0);
+    case FormulaValue::Empty:
+        return FormulaValue::fromBool(false);
+    case FormulaValue::String:
+        if (value.text.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0)
+            return FormulaValue::fromBool(true);
+        if (value.text.compare(QLatin1String("FALSE"), Qt::CaseInsensitive) == 0)
+            return FormulaValue::fromBool(false);
+        return FormulaValue::error(ErrorValue);
+    default:
+        return FormulaValue::error(ErrorValue);
+    }
+}
+
+FormulaValue toText(const FormulaValue &value)
+{
+    switch (value.type) {
+    case FormulaValue::String:
+    case FormulaValue::Error:
+        return value;
+    case FormulaValue::Number:
+        return FormulaValue::fromString(numberText(value.number));
+    case FormulaValue::Boolean:
+        return FormulaValue::fromString(value.number != 0 ? QStringLiteral("TRUE")
+                                                          : QStringLiteral("FALSE"));
+    case FormulaValue::Empty:
+        return FormulaValue::fromString(QString());
+    default:
+        return FormulaValue::error(ErrorValue);
+    }
+}
+
+/*
+  Order of the comparison operators: numbers, then strings, ignoring
+  case, then booleans. An empty value compares as the empty value of
+  the type of the other side.
+*/
+int compareValues(const FormulaValue &a, const FormulaValue &b)
+{
+    FormulaValue::Type typeA = a.type;
+    FormulaValue::Type typeB = b.type;
+    if (typeA == FormulaValue::Empty)
+        typeA = typeB == FormulaValue::Empty ? FormulaValue::Number : typeB;
+    if (typeB == FormulaValue::Empty)
+        typeB = typeA;
+    if (typeA != typeB) {
+        static const int ranks[] = {0, 0, 1, 2, 3, 3};
+        return ranks[typeA] < ranks[typeB] ? -1 : 1;
+    }
+
+    if (typeA == FormulaValue::String) {
+        const int result = QString::compare(a.text, b.text, Qt::CaseInsensitive);
+        return result < 0 ? -1 : (result > 0 ? 1 : 0);
+    }
+    const double x = a.type == FormulaValue::Empty ? 0 : a.number;
+    const double y = b.type == FormulaValue::Empty ? 0 : b.number;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/*
+  Totals of the arguments of SUM() and the other aggregate functions.
+  Cells of ranges only count when they hold numbers, values given
+  directly are converted to numbers.
+*/
+struct Aggregate
+{
+    Aggregate()
+        : sum(0)
+        , product(1)
+        , min(std::numeric_limits<double>::infinity())
+        , max(-std::numeric_limits<double>::infinity())
+        , numbers(0)
+        , values(0)
+        , hasError(false)
+    {
+    }
+
+    inline void addNumber(double number)
+    {
+        sum += number;
+        product *= number;
+        min = qMin(min, number);
+        max = qMax(max, number);
+        ++numbers;
+        ++values;
+    }
+    inline void addError(const QString &text)
+    {
+        if (!hasError)
+            error = text;
+        hasError = true;
+        ++values;
+    }
+
+    double sum;
+    double product;
+    double min;
+    double max;
+    int numbers;
+    int values; // non empty
+    bool hasError;
+    QString error;
+};
+
+/*
+  Evaluates the parsed formulas of one sheet. The sheets can be read
+  concurrently, so several threads may use the same evaluator as long
+  as none of them writes to a cell.
+*/
+class FormulaEvaluator
+{
+public:
+    FormulaEvaluator(const WorksheetPrivate *sheet,
+                     const QHash<QString, const WorksheetPrivate *> &sheets)
+        : m_sheet(sheet)
+        , m_sheets(sheets)
+    {
+    }
+
+    FormulaValue evaluate(const FormulaExpression &expression, int rowOffset,
+                          int columnOffset) const;
+
+private:
+    FormulaValue cellValue(const WorksheetPrivate *sheet, int row, int column,
+                           const CellTable::Entry &entry) const;
+    FormulaValue cellValue(const WorksheetPrivate *sheet, int row, int column) const;
+    FormulaValue scalar(const FormulaValue &value) const;
+    FormulaValue unaryOperation(int op, const FormulaValue &operand) const;
+    FormulaValue binaryOperation(int op, const FormulaValue &left,
+                                 const FormulaValue &right) const;
+    FormulaValue callFunction(const QString &name, const FormulaValue *args, int count) const;
+    void aggregate(Aggregate &totals, const FormulaValue &arg) const;
+    FormulaValue logical(Function function, const FormulaValue *args, int count) const;
+    int matchPosition(const FormulaValue &key, const WorksheetPrivate *sheet,
+                      const CellRange &line, int matchType) const;
+    FormulaValue lookup(Function function, const FormulaValue *args, int count) const;
+    FormulaValue match(const FormulaValue *args, int count) const;
+    FormulaValue index(const FormulaValue *args, int count) const;
+
+    const WorksheetPrivate *m_sheet;
+    const QHash<QString, const WorksheetPrivate *> &m_sheets;
+};
+
+FormulaValue FormulaEvaluator::evaluate(const FormulaExpression &expression, int rowOffset,
+                                        int columnOffset) const
+{
+    const QList<Token> &tokens = expression.tokens();
+    QList<FormulaValue> stack;
+    stack.reserve(tokens.size());
+
+    for (const Token &token : tokens) {
+        switch (token.type) {
+        case FormulaExpression::T_Number:
+            stack.append(FormulaValue::fromNumber(token.number));
+            break;
+        case FormulaExpression::T_String:
+            stack.append(FormulaValue::fromString(expression.text(token)));
+            break;
+        case FormulaExpression::T_Boolean:
+            stack.append(FormulaValue::fromBool(token.number != 0));
+            break;
+        case FormulaExpression::T_Error:
+            stack.append(FormulaValue::error(expression.text(token)));
+            break;
+        case FormulaExpression::T_Reference: {
+            const WorksheetPrivate *sheet = m_sheet;
+            if (token.sheet >= 0)
+                sheet = m_sheets.value(expression.sheetName(token).toLower());
+            const CellRange range = referenceRange(token, rowOffset, columnOffset);
+            if (sheet && range.isValid())
+                stack.append(FormulaValue::fromRange(sheet, range));
+            else
+                stack.append(FormulaValue::error(ErrorRef));
+            break;
+        }
+        case FormulaExpression::T_Missing:
+            stack.append(FormulaValue());
+            break;
+        case FormulaExpression::T_Array:
+            stack.append(FormulaValue::error(ErrorValue));
+            break;
+        case FormulaExpression::T_Name:
+            stack.append(FormulaValue::error(ErrorName));
+            break;
+        case FormulaExpression::T_Operator:
+            if (token.value >= FormulaExpression::Op_Negate) {
+                if (stack.isEmpty())
+                    return FormulaValue::error(ErrorValue);
+                stack.last() = unaryOperation(token.value, stack.last());
+            } else {
+                if (stack.size() < 2)
+                    return FormulaValue::error(ErrorValue);
+                const FormulaValue right = stack.takeLast();
+                stack.last() = binaryOperation(token.value, stack.last(), right);
+            }
+            break;
+        case FormulaExpression::T_Function: {
+            const int count = token.value;
+            if (stack.size() < count)
+                return FormulaValue::error(ErrorValue);
+            const int first = stack.size() - count;
+            const FormulaValue result =
+                callFunction(expression.text(token), stack.constData() + first, count);
+            stack.resize(first);
+            stack.append(result);
+            break;
+        }
+        default: // T_Paren
+            break;
+        }
+    }
+
+    if (stack.size() != 1)
+        return FormulaValue::error(ErrorValue);
+    return scalar(stack.first());
+}
+
+FormulaValue FormulaEvaluator::cellValue(const WorksheetPrivate *sheet, int row, int column,
+                                         const CellTable::Entry &entry) const
+{
+    switch (entry.baseKind()) {
+    case CellTable::K_Number:
+        return FormulaValue::fromNumber(entry.value.number);
+    case CellTable::K_Boolean:
+        return FormulaValue::fromBool(entry.value.number != 0);
+    case CellTable::K_SharedString:
+        if (entry.value.index < 0)
+            return FormulaValue();
+        return FormulaValue::fromString(
+            sheet->sharedStrings()->getSharedString(entry.value.index).toPlainString());
+    case CellTable::K_String:
+    case CellTable::K_InlineString:
+    case CellTable::K_Error: {
+        const XlsxCellExtra *extra = entry.hasExtra() ? sheet->cellTable.extra(row, column) : 0;
+        const QString text = extra ? extra->text : QString();
+        return entry.baseKind() == CellTable::K_Error ? FormulaValue::error(text)
+                                                      : FormulaValue::fromString(text);
+    }
+    default:
+        return FormulaValue();
+    }
+}
+
+FormulaValue FormulaEvaluator::cellValue(const WorksheetPrivate *sheet, int row,
+                                         int column) const
+{
+    return cellValue(sheet, row, column, sheet->cellTable.entry(row, column));
+}
+
+/*
+  The value of a single cell range, or #VALUE! for larger ones.
+*/
+FormulaValue FormulaEvaluator::scalar(const FormulaValue &value) const
+{
+    if (value.type != FormulaValue::Range)
+        return value;
+    if (value.range.rowCount() != 1 || value.range.columnCount() != 1)
+        return FormulaValue::error(ErrorValue);
+    return cellValue(value.sheet, value.range.firstRow(), value.range.firstColumn());
+}
+
+FormulaValue FormulaEvaluator::unaryOperation(int op, const FormulaValue &operand) const
+{
+    const FormulaValue value = toNumber(scalar(operand));
+    if (value.type == FormulaValue::Error)
+        return value;
+    switch (op) {
+    case FormulaExpression::Op_Negate:
+        return FormulaValue::fromNumber(-value.number);
+    case FormulaExpression::Op_Percent:
+        return FormulaValue::fromNumber(value.number / 100);
+    default: // Op_Plus
+        return value;
+    }
+}
+
+FormulaValue FormulaEvaluator::binaryOperation(int op, const FormulaValue &left,
+                                               const FormulaValue &right) const
+{
+    switch (op) {
+    case FormulaExpression::Op_Range:
+    case FormulaExpression::Op_Intersect:
+        if (left.type == FormulaValue::Error)
+            return left;
+        if (right.type == FormulaValue::Error)
+            return right;
+        if (left.type != FormulaValue::Range || right.type != FormulaValue::Range
+            || left.sheet != right.sheet)
+            return FormulaValue::error(ErrorValue);
+        if (op == FormulaExpression::Op_Range) {
+            return FormulaValue::fromRange(
+                left.sheet, CellRange(qMin(left.range.firstRow(), right.range.firstRow()),
+                                      qMin(left.range.firstColumn(), right.range.firstColumn()),
+                                      qMax(left.range.lastRow(), right.range.lastRow()),
+                                      qMax(left.range.lastColumn(), right.range.lastColumn())));
+        } else {
+            const CellRange range(qMax(left.range.firstRow(), right.range.firstRow()),
+                                  qMax(left.range.firstColumn(), right.range.firstColumn()),
+                                  qMin(left.range.lastRow(), right.range.lastRow()),
+                                  qMin(left.range.lastColumn(), right.range.lastColumn()));
+            if (range.firstRow() > range.lastRow() || range.firstColumn() > range.lastColumn())
+                return FormulaValue::error(ErrorNull);
+            return FormulaValue::fromRange(left.sheet, range);
+        }
+    case FormulaExpression::Op_Union:
+        // Only the reference functions could take a union.
+        return FormulaValue::error(ErrorValue);
+    default:
+        break;
+    }
+
+    const FormulaValue a = scalar(left);
+    const FormulaValue b = scalar(right);
+    if (a.type == FormulaValue::Error)
+        return a;
+    if (b.type == FormulaValue::Error)
+        return b;
+
+    switch (op) {
+    case FormulaExpression::Op_Concat: {
+        const FormulaValue x = toText(a);
+        const FormulaValue y = toText(b);
+        if (x.type == FormulaValue::Error)
+            return x;
+        if (y.type == FormulaValue::Error)
+            return y;
+        return FormulaValue::fromString(x.text + y.text);
+    }
+    case FormulaExpression::Op_Equal:
+        return FormulaValue::fromBool(compareValues(a, b) == 0);
+    case FormulaExpression::Op_NotEqual:
+        return FormulaValue::fromBool(compareValues(a, b) != 0);
+    case FormulaExpression::Op_Less:
+        return FormulaValue::fromBool(compareValues(a, b) < 0);
+    case FormulaExpression::Op_LessEqual:
+        return FormulaValue::fromBool(compareValues(a, b) <= 0);
+    case FormulaExpression::Op_Greater:
+        return FormulaValue::fromBool(compareValues(a, b) > 0);
+    case FormulaExpression::Op_GreaterEqual:
+        return FormulaValue::fromBool(compareValues(a, b) >= 0);
+    default:
+        break;
+    }
+
+    const FormulaValue x = toNumber(a);
+    const FormulaValue y = toNumber(b);
+    if (x.type == FormulaValue::Error)
+        return x;
+    if (y.type == FormulaValue::Error)
+        return y;
+
+    double result = 0;
+    switch (op) {
+    case FormulaExpression::Op_Add:
+        result = x.number + y.number;
+        break;
+    case FormulaExpression::Op_Subtract:
+        result = x.number - y.number;
+        break;
+    case FormulaExpression::Op_Multiply:
+        result = x.number * y.number;
+        break;
+    case FormulaExpression::Op_Divide:
+        if (y.number == 0)
+            return FormulaValue::error(ErrorDivZero);
+        result = x.number / y.number;
+        break;
+    case FormulaExpression::Op_Power:
+        if (x.number == 0 && y.number == 0)
+            return FormulaValue::error(ErrorNum);
+        result = std::pow(x.number, y.number);
+        break;
+    default:
+        return FormulaValue::error(ErrorValue);
+    }
+    if (!std::isfinite(result))
+        return FormulaValue::error(ErrorNum);
+    return FormulaValue::fromNumber(result);
+}
+
+/*
+  Ranges are scanned tile by tile, only the cells which exist in the
+  sheet are visited.
+*/
+void FormulaEvaluator::aggregate(Aggregate &totals, const FormulaValue &arg) const
+{
+    switch (arg.type) {
+    case FormulaValue::Range: {
+        const WorksheetPrivate *sheet = arg.sheet;
+        sheet->cellTable.forEachInRange(
+            arg.range, [&](int row, int column, const CellTable::Entry &entry) {
+                switch (entry.baseKind()) {
+                case CellTable::K_Number:
+                    totals.addNumber(entry.value.number);
+                    break;
+                case CellTable::K_Error: {
+                    const XlsxCellExtra *extra =
+                        entry.hasExtra() ? sheet->cellTable.extra(row, column) : 0;
+                    totals.addError(extra ? extra->text : QString::fromLatin1(ErrorValue));
+                    break;
+                }
+                case CellTable::K_Boolean:
+                case CellTable::K_SharedString:
+                case CellTable::K_String:
+                case CellTable::K_InlineString:
+                    ++totals.values;
+                    break;
+                default: // K_Blank
+                    break;
+                }
+            });
+        break;
+    }
+    case FormulaValue::Empty:
+        break;
+    default: {
+        const FormulaValue number = toNumber(arg);
+        if (number.type == FormulaValue::Error)
+            totals.addError(number.text);
+        else
+            totals.addNumber(number.number);
+        break;
+    }
+    }
+}
+
+FormulaValue FormulaEvaluator::logical(Function function, const FormulaValue *args,
+                                       int count) const
+{
+    bool result = function == F_And;
+    bool hasValue = false;
+    for (int i = 0; i < count; ++i) {
+        QList<FormulaValue> values;
+        if (args[i].type == FormulaValue::Range) {
+            const WorksheetPrivate *sheet = args[i].sheet;
+            sheet->cellTable.forEachInRange(
+                args[i].range, [&](int row, int column, const CellTable::Entry &entry) {
+                    const CellTable::Kind kind = entry.baseKind();
+                    if (kind == CellTable::K_Number || kind == CellTable::K_Boolean
+                        || kind == CellTable::K_Error)
+                        values.append(cellValue(sheet, row, column, entry));
+                });
+        } else if (args[i].type != FormulaValue::Empty) {
+            values.append(args[i]);
+        }
+
+        for (const FormulaValue &value : std::as_const(values)) {
+            const FormulaValue b = toBool(value);
+            if (b.type == FormulaValue::Error)
+                return b;
+            hasValue = true;
+            if (function == F_And)
+                result = result && b.number != 0;
+            else
+                result = result || b.number != 0;
+        }
+    }
+    if (!hasValue)
+        return FormulaValue::error(ErrorValue);
+    return FormulaValue::fromBool(result);
+}
+
+/*
+  Position of \a key in the single row or column \a line, from 0, or -1.
+  \a matchType 0 asks for an equal value, 1 for the largest value not
+  above the key in a line sorted ascending, and -1 for the smallest
+  value not below it in a line sorted descending.
+*/
+int FormulaEvaluator::matchPosition(const FormulaValue &key, const WorksheetPrivate *sheet,
+                                    const CellRange &line, int matchType) const
+{
+    const bool vertical = line.columnCount() == 1;
+    int position = -1;
+    bool done = false;
+    sheet->cellTable.forEachInRange(
+        line, [&](int row, int column, const CellTable::Entry &entry) {
+            if (done)
+                return;
+            const FormulaValue value = cellValue(sheet, row, column, entry);
+            if (value.type == FormulaValue::Empty)
+                return;
+            const int at = vertical ? row - line.firstRow() : column - line.firstColumn();
+            if (matchType == 0) {
+                if (value.type != FormulaValue::Error && compareValues(value, key) == 0) {
+                    position = at;
+                    done = true;
+                }
+                return;
+            }
+            // Approximate matches only compare values of the same type
+            if (value.type != key.type)
+                return;
+            const int order = compareValues(value, key);
+            if (matchType > 0 ? order <= 0 : order >= 0)
+                position = at;
+            else
+                done = true;
+        });
+    return position;
+}
+
+FormulaValue FormulaEvaluator::lookup(Function function, const FormulaValue *args,
+                                      int count) const
+{
+    if (count < 3 || count > 4)
+        return FormulaValue::error(ErrorValue);
+    const FormulaValue key = scalar(args[0]);
+    if (key.type == FormulaValue::Error)
+        return key;
+    if (args[1].type != FormulaValue::Range)
+        return args[1].type == FormulaValue::Error ? args[1] : FormulaValue::error(ErrorValue);
+    const FormulaValue offset = toNumber(scalar(args[2]));
+    if (offset.type == FormulaValue::Error)
+        return offset;
+    bool approximate = true;
+    if (count == 4) {
+        const FormulaValue b = toBool(scalar(args[3]));
+        if (b.type == FormulaValue::Error)
+            return b;
+        approximate = b.number != 0;
+    }
+
+    const CellRange &table = args[1].range;
+    const int n = int(offset.number);
+    if (n < 1)
+        return FormulaValue::error(ErrorValue);
+    const bool vertical = function == F_VLookup;
+    if (n > (vertical ? table.columnCount() : table.rowCount()))
+        return FormulaValue::error(ErrorRef);
+
+    const CellRange line = vertical ? CellRange(table.firstRow(), table.firstColumn(),
+                                                table.lastRow(), table.firstColumn())
+                                    : CellRange(table.firstRow(), table.firstColumn(),
+                                                table.firstRow(), table.lastColumn());
+    const int position = matchPosition(key, args[1].sheet, line, approximate ? 1 : 0);
+    if (position < 0)
+        return FormulaValue::error(ErrorNA);
+    if (vertical)
+        return cellValue(args[1].sheet, table.firstRow() + position, table.firstColumn() + n - 1);
+    return cellValue(args[1].sheet, table.firstRow() + n - 1, table.firstColumn() + position);
+}
+
+FormulaValue FormulaEvaluator::match(const FormulaValue *args, int count) const
+{
+    if (count < 2 || count > 3)
+        return FormulaValue::error(ErrorValue);
+    const FormulaValue key = scalar(args[0]);
+    if (key.type == FormulaValue::Error)
+        return key;
+    if (args[1].type != FormulaValue::Range)
+        return args[1].type == FormulaValue::Error ? args[1] : FormulaValue::error(ErrorNA);
+    int matchType = 1;
+    if (count == 3) {
+        const FormulaValue type = toNumber(scalar(args[2]));
+        if (type.type == FormulaValue::Error)
+            return type;
+        matchType = type.number > 0 ? 1 : (type.number < 0 ? -1 : 0);
+    }
+
+    const CellRange &line = args[1].range;
+    if (line.rowCount() != 1 && line.columnCount() != 1)
+        return FormulaValue::error(ErrorNA);
+    const int position = matchPosition(key, args[1].sheet, line, matchType);
+    if (position < 0)
+        return FormulaValue::error(ErrorNA);
+    return FormulaValue::fromNumber(position + 1);
+}
+
+FormulaValue FormulaEvaluator::index(const FormulaValue *args, int count) const
+{
+    if (count < 2 || count > 3)
+        return FormulaValue::error(ErrorValue);
+    if (args[0].type != FormulaValue::Range)
+        return args[0].type == FormulaValue::Error ? args[0] : FormulaValue::error(ErrorValue);
+    const CellRange &range = args[0].range;
+
+    int numbers[2] = {1, 1};
+    for (int i = 1; i < count; ++i) {
+        const FormulaValue n = toNumber(scalar(args[i]));
+        if (n.type == FormulaValue::Error)
+            return n;
+        numbers[i - 1] = int(n.number);
+    }
+    int row = numbers[0];
+    int column = numbers[1];
+    // A single row is indexed by its columns
+    if (count == 2 && range.rowCount() == 1) {
+        column = row;
+        row = 1;
+    }
+    if (row < 1 || column < 1)
+        return FormulaValue::error(ErrorValue);
+    if (row > range.rowCount() || column > range.columnCount())
+        return FormulaValue::error(ErrorRef);
+    return FormulaValue::fromRange(args[0].sheet,
+                                   CellRange(range.firstRow() + row - 1,
+                                             range.firstColumn() + column - 1,
+                                             range.firstRow() + row - 1,
+                                             range.firstColumn() + column - 1));
+}
+
+FormulaValue FormulaEvaluator::callFunction(const QString &name, const FormulaValue *args,
+                                            int count) const
+{
+    const Function function = functionId(name);
+    switch (function) {
+    case F_Sum:
+    case F_Average:
+    case F_Min:
+    case F_Max:
+    case F_Count:
+    case F_CountA:
+    case F_Product: {
+        Aggregate totals;
+        for (int i = 0; i < count; ++i)
+            aggregate(totals, args[i]);
+        if (function == F_Count)
+            return FormulaValue::fromNumber(totals.numbers);
+        if (function == F_CountA)
+            return FormulaValue::fromNumber(totals.values);
+        if (totals.hasError)
+            return FormulaValue::error(totals.error);
+        switch (function) {
+        case F_Sum:
+            return FormulaValue::fromNumber(totals.sum);
+        case F_Average:
+            if (totals.numbers == 0)
+                return FormulaValue::error(ErrorDivZero);
+            return FormulaValue::fromNumber(totals.sum / totals.numbers);
+        case F_Min:
+            return FormulaValue::fromNumber(totals.numbers ? totals.min : 0);
+        case F_Max:
+            return FormulaValue::fromNumber(totals.numbers ? totals.max : 0);
+        default:
+            return FormulaValue::fromNumber(totals.numbers ? totals.product : 0);
+        }
+    }
+    case F_If: {
+        if (count < 1 || count > 3)
+            return FormulaValue::error(ErrorValue);
+        const FormulaValue condition = toBool(scalar(args[0]));
+        if (condition.type == FormulaValue::Error)
+            return condition;
+        if (condition.number != 0)
+            return count > 1 ? args[1] : FormulaValue::fromBool(true);
+        return count > 2 ? args[2] : FormulaValue::fromBool(false);
+    }
+    case F_IfError: {
+        if (count != 2)
+            return FormulaValue::error(ErrorValue);
+        const FormulaValue value = scalar(args[0]);
+        return value.type == FormulaValue::Error ? args[1] : value;
+    }
+    case F_And:
+    case F_Or:
+        return logical(function, args, count);
+    case F_Not: {
+        if (count != 1)
+            return FormulaValue::error(ErrorValue);
+        const FormulaValue b = toBool(scalar(args[0]));
+        return b.type == FormulaValue::Error ? b : FormulaValue::fromBool(b.number == 0);
+    }
+    case F_True:
+    case F_False:
+        if (count != 0)
+            return FormulaValue::error(ErrorValue);
+        return FormulaValue::fromBool(function == F_True);
+    case F_Abs:
+    case F_Int:
+    case F_Sqrt: {
+        if (count != 1)
+            return FormulaValue::error(ErrorValue);
+        const FormulaValue n = toNumber(scalar(args[0]));
+        if (n.type == FormulaValue::Error)
+            return n;
+        if (function == F_Abs)
+            return FormulaValue::fromNumber(std::fabs(n.number));
+        if (function == F_Int)
+            return FormulaValue::fromNumber(std::floor(n.number));
+        if (n.number < 0)
+            return FormulaValue::error(ErrorNum);
+        return FormulaValue::fromNumber(std::sqrt(n.number));
+    }
+    case F_Round:
+    case F_Mod:
+    case F_Power: {
+        if (count != 2)
+            return FormulaValue::error(ErrorValue);
+        const FormulaValue x = toNumber(scalar(args[0]));
+        if (x.type == FormulaValue::Error)
+            return x;
+        const FormulaValue y = toNumber(scalar(args[1]));
+        if (y.type == FormulaValue::Error)
+            return y;
+        if (function == F_Power)
+            return binaryOperation(FormulaExpression::Op_Power, x, y);
+        if (function == F_Mod) {
+            if (y.number == 0)
+                return FormulaValue::error(ErrorDivZero);
+            return FormulaValue::fromNumber(x.number - y.number * std::floor(x.number / y.number));
+        }
+        // Halves are rounded away from zero
+        const double factor = std::pow(10.0, std::trunc(y.number));
+        return FormulaValue::fromNumber(std::round(x.number * factor) / factor);
+    }
+    case F_Concatenate: {
+        QString text;
+        for (int i = 0; i < count; ++i) {
+            const FormulaValue t = toText(scalar(args[i]));
+            if (t.type == FormulaValue::Error)
+                return t;
+            text += t.text;
+        }
+        return FormulaValue::fromString(text);
+    }
+    case F_Len: {
+        if (count != 1)
+            return FormulaValue::error(ErrorValue);
+        const FormulaValue t = toText(scalar(args[0]));
+        return t.type == FormulaValue::Error ? t : FormulaValue::fromNumber(t.text.size());
+    }
+    case F_VLookup:
+    case F_HLookup:
+        return lookup(function, args, count);
+    case F_Match:
+        return match(args, count);
+    case F_Index:
+        return index(args, count);
+    case F_IsBlank:
+    case F_IsError:
+    case F_IsNumber:
+    case F_IsText: {
+        if (count != 1)
+            return FormulaValue::error(ErrorValue);
+        const FormulaValue value = scalar(args[0]);
+        if (function == F_IsBlank)
+            return FormulaValue::fromBool(value.type == FormulaValue::Empty
+                                          && args[0].type == FormulaValue::Range);
+        if (function == F_IsError)
+            return FormulaValue::fromBool(value.type == FormulaValue::Error);
+        if (function == F_IsNumber)
+            return FormulaValue::fromBool(value.type == FormulaValue::Number);
+        return FormulaValue::fromBool(value.type == FormulaValue::String);
+    }
+    default:
+        return FormulaValue::error(ErrorName);
+    }
+}
+
+/*
+  Runs work(begin, end) over [0, count), in chunks spread over the
+  global thread pool when there are enough items.
+*/
+class ChunkRunner : public QRunnable
+{
+public:
+    ChunkRunner(const std::function<void(int, int)> &work, int begin, int end)
+        : work(work)
+        , begin(begin)
+        , end(end)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        work(begin, end);
+        done.release();
+    }
+
+    const std::function<void(int, int)> &work;
+    int begin;
+    int end;
+    QSemaphore done;
+};
+
+void parallelFor(int count, const std::function<void(int, int)> &work)
+{
+    const int chunkSize = 256;
+    QThreadPool *pool = QThreadPool::globalInstance();
+    if (count < 2 * chunkSize || pool->maxThreadCount() < 2) {
+        work(0, count);
+        return;
+    }
+
+    QList<QSharedPointer<ChunkRunner>> chunks;
+    for (int begin = 0; begin < count; begin += chunkSize) {
+        chunks.append(QSharedPointer<ChunkRunner>(
+            new ChunkRunner(work, begin, qMin(begin + chunkSize, count))));
+        pool->start(chunks.last().data());
+    }
+    // A chunk nobody has picked up yet is run here
+    for (const QSharedPointer<ChunkRunner> &chunk : std::as_const(chunks)) {
+        if (pool->tryTake(chunk.data()))
+            chunk->run();
+        chunk->done.acquire();
+    }
+}
+
+void storeResult(CellTable &cellTable, int row, int column, const FormulaValue &value)
+{
+    switch (value.type) {
+    case FormulaValue::Number:
+        cellTable.setFormulaResult(row, column, CellTable::K_Number, value.number, QString());
+        break;
+    case FormulaValue::Boolean:
+        cellTable.setFormulaResult(row, column, CellTable::K_Boolean, value.number, QString());
+        break;
+    case FormulaValue::String:
+        cellTable.setFormulaResult(row, column, CellTable::K_String, 0, value.text);
+        break;
+    case FormulaValue::Error:
+        cellTable.setFormulaResult(row, column, CellTable::K_Error, 0, value.text);
+        break;
+    default: // a formula referring to an empty cell gives 0
+        cellTable.setFormulaResult(row, column, CellTable::K_Number, 0, QString());
+        break;
+    }
+}
+
+// Buckets of the index of the ranges referred to by formulas
+const int BucketRows = 1024;
+const int BucketColumns = 64;
+
+inline quint32 bucketKey(int rowBucket, int columnBucket)
+{
+    return (quint32(rowBucket) << 16) | quint32(columnBucket);
+}
+
+} // namespace
+
+FormulaEngine::FormulaEngine(WorksheetPrivate *sheet)
+    : m_sheet(sheet)
+    , m_built(false)
+    , m_visit(0)
+    , m_deadNodes(0)
+{
+}
+
+/*
+  Compute the dirty formulas and the formulas depending on them, or
+  all the formulas the first time, and store their results in the
+  formula cells. Returns the number of formulas computed.
+*/
+int FormulaEngine::recalculate()
+{
+    m_stats = Worksheet::CalculationStats();
+    if (!m_built) {
+        build();
+        m_stats.rebuilt = true;
+    }
+    m_stats.formulas = int(m_nodeIndex.size());
+
+    // The dirty formulas, then the formulas depending on them
+    ++m_visit;
+    QList<int> cone;
+    for (int index : std::as_const(m_dirty)) {
+        Node &node = m_nodes[index];
+        node.dirty = false;
+        if (node.alive && node.visit != m_visit) {
+            node.visit = m_visit;
+            node.pendingInputs = 0;
+            cone.append(index);
+        }
+    }
+    m_dirty.clear();
+    m_stats.dirty = int(cone.size());
+
+    for (int i = 0; i < cone.size(); ++i) {
+        Node &node = m_nodes[cone[i]];
+        forEachDependent(node.row, node.column, [&](int index) {
+            node.dependents.append(index);
+            Node &dependent = m_nodes[index];
+            if (dependent.visit != m_visit) {
+                dependent.visit = m_visit;
+                dependent.pendingInputs = 0;
+                cone.append(index);
+            }
+        });
+    }
+
+    QList<int> level;
+    for (int index : std::as_const(cone)) {
+        for (int dependent : std::as_const(m_nodes[index].dependents))
+            ++m_nodes[dependent].pendingInputs;
+    }
+    for (int index : std::as_const(cone)) {
+        if (m_nodes[index].pendingInputs == 0)
+            level.append(index);
+    }
+
+    // The cells are only read while a level is evaluated, and only
+    // written between two levels.
+    const FormulaEvaluator evaluator(m_sheet, m_sheets);
+    QList<FormulaValue> results;
+    int computed = 0;
+    while (!level.isEmpty()) {
+        results.resize(level.size());
+        FormulaValue *values = results.data();
+        parallelFor(level.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                const Node &node = m_nodes.at(level.at(i));
+                values[i] = evaluator.evaluate(*node.expression, node.rowOffset,
+                                               node.columnOffset);
+            }
+        });
+
+        QList<int> next;
+        for (int i = 0; i < level.size(); ++i) {
+            Node &node = m_nodes[level[i]];
+            storeResult(m_sheet->cellTable, node.row, node.column, results[i]);
+            for (int dependent : std::as_const(node.dependents)) {
+                if (--m_nodes[dependent].pendingInputs == 0)
+                    next.append(dependent);
+            }
+        }
+        computed += level.size();
+        level.swap(next);
+    }
+
+    for (int index : std::as_const(cone))
+        m_nodes[index].dependents = QList<int>();
+
+    m_stats.recomputed = computed;
+    m_stats.circular = int(cone.size()) - computed;
+    return computed;
+}
+
+/*
+  Take the new content of the cells of \a range into account: formulas
+  written there replace the former ones, and the formulas referring to
+  these cells are marked dirty. Nothing is done before the first
+  recalculate(), which computes all the formulas anyway.
+*/
+void FormulaEngine::cellsWritten(const CellRange &range)
+{
+    if (!m_built || !range.isValid())
+        return;
+
+    for (int row = range.firstRow(); row <= range.lastRow(); ++row) {
+        for (int column = range.firstColumn(); column <= range.lastColumn(); ++column) {
+            QHash<quint64, int>::iterator it = m_nodeIndex.find(CellTable::cellKey(row, column));
+            if (it != m_nodeIndex.end()) {
+                m_nodes[it.value()].alive = false;
+                m_nodeIndex.erase(it);
+                ++m_deadNodes;
+            }
+            addNode(row, column);
+            markDependentsDirty(row, column);
+        }
+    }
+
+    // The index keeps referring to the overwritten formulas, so start
+    // over once they outnumber the others.
+    if (m_deadNodes > 1024 && m_deadNodes > m_nodeIndex.size())
+        invalidate();
+}
+
+/*
+  Drop the dependency index, the next recalculate() computes all the
+  formulas.
+*/
+void FormulaEngine::invalidate()
+{
+    m_built = false;
+    m_deadNodes = 0;
+    m_nodes.clear();
+    m_dirty.clear();
+    m_nodeIndex.clear();
+    m_cellDependents.clear();
+    m_ranges.clear();
+    m_rangeIndex.clear();
+    m_rangeBuckets.clear();
+    m_sheets.clear();
+}
+
+void FormulaEngine::build()
+{
+    invalidate();
+    m_built = true;
+    m_sheet->cellTable.forEach([&](int row, int column, const CellTable::Entry &entry) {
+        if (entry.hasExtra())
+            addNode(row, column);
+    });
+}
+
+/*
+  Add the formula of the cell, if any, to the index. The cells of a
+  shared formula share the expression of its master.
+*/
+void FormulaEngine::addNode(int row, int column)
+{
+    const XlsxCellExtra *extra = m_sheet->cellTable.extra(row, column);
+    if (!extra || !extra->formula.isValid())
+        return;
+
+    Node node;
+    node.row = row;
+    node.column = column;
+    node.rowOffset = 0;
+    node.columnOffset = 0;
+    node.alive = true;
+    node.dirty = false;
+    node.visit = 0;
+    node.pendingInputs = 0;
+    switch (extra->formula.formulaType()) {
+    case CellFormula::NormalType:
+    case CellFormula::ArrayType:
+        node.formula = extra->formula;
+        break;
+    case CellFormula::SharedType: {
+        if (!extra->formula.formulaText().isEmpty())
+            node.formula = extra->formula;
+        else
+            node.formula = m_sheet->sharedFormulaMap.value(extra->formula.sharedIndex());
+        const CellRange ref = node.formula.reference();
+        if (ref.isValid()) {
+            node.rowOffset = row - ref.firstRow();
+            node.columnOffset = column - ref.firstColumn();
+        }
+        break;
+    }
+    default:
+        // Data tables are left to the spreadsheet application
+        return;
+    }
+    if (!node.formula.isValid() || node.formula.formulaText().isEmpty())
+        return;
+    node.expression = &node.formula.d->expression();
+    if (!node.expression->isValid())
+        return;
+
+    const int index = int(m_nodes.size());
+    m_nodes.append(node);
+    m_nodeIndex.insert(CellTable::cellKey(row, column), index);
+    markDirty(index);
+
+    const FormulaExpression &expression = *node.expression;
+    for (const Token &token : expression.tokens()) {
+        if (token.type != FormulaExpression::T_Reference)
+            continue;
+        if (token.sheet >= 0 && resolveSheet(expression.sheetName(token)) != m_sheet)
+            continue;
+        const CellRange range = referenceRange(token, node.rowOffset, node.columnOffset);
+        if (range.isValid())
+            addDependent(index, range);
+    }
+}
+
+/*
+  Record that \a node refers to \a range. Ranges are shared by all the
+  formulas referring to the same cells, and listed in each bucket of
+  rows and columns they overlap.
+*/
+void FormulaEngine::addDependent(int node, const CellRange &range)
+{
+    if (range.rowCount() == 1 && range.columnCount() == 1) {
+        m_cellDependents[CellTable::cellKey(range.firstRow(), range.firstColumn())].append(node);
+        return;
+    }
+
+    const QPair<quint64, quint64> key(CellTable::cellKey(range.firstRow(), range.firstColumn()),
+                                      CellTable::cellKey(range.lastRow(), range.lastColumn()));
+    QHash<QPair<quint64, quint64>, int>::const_iterator it = m_rangeIndex.constFind(key);
+    int index;
+    if (it != m_rangeIndex.constEnd()) {
+        index = it.value();
+    } else {
+        index = int(m_ranges.size());
+        RangeDependents dependents;
+        dependents.range = range;
+        m_ranges.append(dependents);
+        m_rangeIndex.insert(key, index);
+        for (int r = (range.firstRow() - 1) / BucketRows; r <= (range.lastRow() - 1) / BucketRows;
+             ++r) {
+            for (int c = (range.firstColumn() - 1) / BucketColumns;
+                 c <= (range.lastColumn() - 1) / BucketColumns; ++c)
+                m_rangeBuckets[bucketKey(r, c)].append(index);
+        }
+    }
+    m_ranges[index].nodes.append(node);
+}
+
+void FormulaEngine::markDirty(int node)
+{
+    if (!m_nodes[node].dirty) {
+        m_nodes[node].dirty = true;
+        m_dirty.append(node);
+    }
+}
+
+void FormulaEngine::markDependentsDirty(int row, int column)
+{
+    forEachDependent(row, column, [this](int node) { markDirty(node); });
+}
+
+/*
+  Call func(int node) for each live formula referring to the cell, once
+  per reference.
+*/
+template <typename Func>
+void FormulaEngine::forEachDependent(int row, int column, Func func) const
+{
+    QHash<quint64, QList<int>>::const_iterator cell =
+        m_cellDependents.constFind(CellTable::cellKey(row, column));
+    if (cell != m_cellDependents.constEnd()) {
+        for (int node : cell.value()) {
+            if (m_nodes.at(node).alive)
+                func(node);
+        }
+    }
+
+    QHash<quint32, QList<int>>::const_iterator bucket = m_rangeBuckets.constFind(
+        bucketKey((row - 1) / BucketRows, (column - 1) / BucketColumns));
+    if (bucket == m_rangeBuckets.constEnd())
+        return;
+    for (int index : bucket.value()) {
+        const RangeDependents &dependents = m_ranges.at(index);
+        const CellRange &range = dependents.range;
+        if (row < range.firstRow() || row > range.lastRow() || column < range.firstColumn()
+            || column > range.lastColumn())
+            continue;
+        for (int node : dependents.nodes) {
+            if (m_nodes.at(node).alive)
+                func(node);
+        }
+    }
+}
+
+const WorksheetPrivate *FormulaEngine::resolveSheet(const QString &name)
+{
+    const QString key = name.toLower();
+    QHash<QString, const WorksheetPrivate *>::const_iterator it = m_sheets.constFind(key);
+    if (it != m_sheets.constEnd())
+        return it.value();
+    const WorksheetPrivate *sheet = m_sheet->findWorksheet(name);
+    m_sheets.insert(key, sheet);
+    return sheet;
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,132 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#ifndef XLSXFORMULAENGINE_P_H
+#define XLSXFORMULAENGINE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxcellformula.h"
+#include "xlsxcellrange.h"
+#include "xlsxworksheet.h"
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class FormulaExpression;
+class WorksheetPrivate;
+
+/*
+  Computes the formulas of one worksheet, and stores their results as
+  the cached values of the formula cells, which are saved in <v>.
+
+  The engine keeps a reverse dependency index, from the cells and the
+  ranges referred to by the formulas to the formulas referring to
+  them. It is built by the first recalculate(), and then kept up to
+  date by cellsWritten(), which also marks the formulas depending on
+  the written cells dirty. The next recalculate() only computes the
+  dirty formulas and the formulas depending on them.
+
+  The formulas to compute are run level by level in topological
+  order: a level holds all the formulas whose inputs have been
+  computed, and large levels are split between the threads of the
+  global thread pool. The formulas of a circular reference keep their
+  old values.
+
+  Cells of other sheets are read as they are. They are neither
+  computed first, nor tracked as dependencies.
+*/
+class XLSX_AUTOTEST_EXPORT FormulaEngine
+{
+public:
+    explicit FormulaEngine(WorksheetPrivate *sheet);
+
+    int recalculate();
+    void cellsWritten(const CellRange &range);
+    void invalidate();
+    Worksheet::CalculationStats stats() const { return m_stats; }
+
+private:
+    struct Node
+    {
+        int row;
+        int column;
+        CellFormula formula; // of the cell, or the master of its shared formula
+        const FormulaExpression *expression; // owned by formula
+        int rowOffset; // of the cell from the master of the shared formula
+        int columnOffset;
+        bool alive; // false once the cell has been overwritten
+        bool dirty;
+        int visit; // last recalculation the node took part in
+        int pendingInputs; // formulas of the recalculation not computed yet among the inputs
+        QList<int> dependents; // during a recalculation
+    };
+
+    struct RangeDependents
+    {
+        CellRange range;
+        QList<int> nodes;
+    };
+
+    void build();
+    void addNode(int row, int column);
+    void addDependent(int node, const CellRange &range);
+    void markDirty(int node);
+    void markDependentsDirty(int row, int column);
+    template <typename Func>
+    void forEachDependent(int row, int column, Func func) const;
+    const WorksheetPrivate *resolveSheet(const QString &name);
+
+    WorksheetPrivate *m_sheet;
+    bool m_built;
+    int m_visit;
+    int m_deadNodes;
+    QList<Node> m_nodes;
+    QList<int> m_dirty;
+    QHash<quint64, int> m_nodeIndex; // by CellTable::cellKey()
+    QHash<quint64, QList<int>> m_cellDependents; // by CellTable::cellKey()
+    QList<RangeDependents> m_ranges;
+    QHash<QPair<quint64, quint64>, int> m_rangeIndex; // by corners, index in m_ranges
+    QHash<quint32, QList<int>> m_rangeBuckets; // ranges overlapping each bucket
+    QHash<QString, const WorksheetPrivate *> m_sheets; // by lower case name
+    Worksheet::CalculationStats m_stats;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXFORMULAENGINE_P_H
@@ -0,0 +1,1094 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#include "xlsxformulaexpression_p.h"
+#include "xlsxcellreference.h"
+#include "xlsxutility_p.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+const int MaxRow = 1048576;
+const int MaxColumn = 16384;
+
+inline bool isSpace(char16_t c)
+{
+    return c == u' ' || c == u'\t' || c == u'\r' || c == u'\n';
+}
+
+inline bool isDigit(char16_t c)
+{
+    return c >= u'0' && c <= u'9';
+}
+
+inline bool isLetter(char16_t c)
+{
+    return (c >= u'A' && c <= u'Z') || (c >= u'a' && c <= u'z');
+}
+
+/*
+ * Chars of sheet names, defined names, function names and cell
+ * references, when they are not quoted.
+ */
+inline bool isWordChar(char16_t c)
+{
+    return isLetter(c) || isDigit(c) || c == u'_' || c == u'.' || c == u'\\' || c == u'?'
+        || c == u'$' || c > 0x7f;
+}
+
+const char16_t *skipWord(const char16_t *p, const char16_t *end)
+{
+    while (p != end && isWordChar(*p))
+        ++p;
+    return p;
+}
+
+/*
+ * Parse the "$?[A-Za-z]{1,3}" column at \a p. Returns the end of the
+ * column, or nullptr.
+ */
+const char16_t *scanColumn(const char16_t *p, const char16_t *end, int *column, bool *absolute)
+{
+    *absolute = p != end && *p == u'$';
+    if (*absolute)
+        ++p;
+    const char16_t *letters = p;
+    int col = 0;
+    while (p != end && isLetter(*p) && p - letters < 3) {
+        col = col * 26 + ((*p & ~0x20) - u'A' + 1);
+        ++p;
+    }
+    if (p == letters || col > MaxColumn || (p != end && isLetter(*p)))
+        return nullptr;
+    *column = col;
+    return p;
+}
+
+/*
+ * Parse the "$?[0-9]+" row at \a p. Returns the end of the row, or
+ * nullptr.
+ */
+const char16_t *scanRow(const char16_t *p, const char16_t *end, int *row, bool *absolute)
+{
+    *absolute = p != end && *p == u'$';
+    if (*absolute)
+        ++p;
+    const char16_t *digits = p;
+    int r = 0;
+    while (p != end && isDigit(*p)) {
+        r = r * 10 + (*p - u'0');
+        if (r > MaxRow)
+            return nullptr;
+        ++p;
+    }
+    if (p == digits || r == 0)
+        return nullptr;
+    *row = r;
+    return p;
+}
+
+/*
+ * Parse the cell reference at \a p, which must end at \a wordEnd.
+ */
+bool scanCell(const char16_t *p, const char16_t *wordEnd, int *row, int *column, int *flags)
+{
+    bool columnAbsolute;
+    bool rowAbsolute;
+    p = scanColumn(p, wordEnd, column, &columnAbsolute);
+    if (!p)
+        return false;
+    p = scanRow(p, wordEnd, row, &rowAbsolute);
+    if (!p || p != wordEnd)
+        return false;
+    *flags = (columnAbsolute ? 0x01 : 0) | (rowAbsolute ? 0x02 : 0);
+    return true;
+}
+
+const char *const errorLiterals[] = { "#NULL!", "#DIV/0!", "#VALUE!", "#REF!",         "#NAME?",
+                                      "#NUM!",  "#N/A",    "#SPILL!", "#GETTING_DATA", "#CALC!" };
+
+const char *const operatorNames[] = { "+", "-", "*", "/", "^", "&", "=",  "<>", "<",
+                                      "<=", ">", ">=", ":", " ", ",", "-", "+", "%" };
+
+QString columnName(int column, bool absolute)
+{
+    return CellReference(1, column).toString(false, absolute).chopped(1);
+}
+} // namespace
+
+/*
+  Lexer and recursive descent parser. The lexer reads one lexeme
+  ahead, the parser appends the tokens in reverse polish order as it
+  goes, so that no tree is ever built.
+
+  Precedence, from the lowest: comparisons, '&', '+' '-', '*' '/',
+  '^', '%', the unary '-' '+', then the reference operators ':', ' '
+  and ','. The ',' union is only taken inside of parentheses, where
+  it can not be a function argument separator.
+*/
+class FormulaParser
+{
+public:
+    FormulaParser(QStringView formula, FormulaExpression *expression);
+
+    bool parse();
+
+private:
+    enum LexemeKind {
+        L_End,
+        L_Operand,
+        L_Function,
+        L_Operator,
+        L_OpenParen,
+        L_CloseParen,
+        L_Comma,
+        L_Invalid
+    };
+
+    struct Lexeme
+    {
+        LexemeKind kind;
+        bool spaceBefore;
+        FormulaExpression::Operator op;
+        FormulaExpression::Token token;
+        QString text;
+        QString sheet;
+    };
+
+    // lexer
+    void next();
+    void lexString();
+    void lexArray();
+    void lexError(const char16_t *begin);
+    void lexNumber();
+    bool lexRows(const char16_t *begin);
+    void lexOperand();
+    void setOperator(FormulaExpression::Operator op, int size);
+    void setInvalid(const QString &error);
+
+    // parser
+    bool parseExpression();
+    bool parseBinary(int level);
+    bool parsePercent();
+    bool parseUnary();
+    bool parseIntersect();
+    bool parseRange();
+    bool parsePrimary();
+    bool parseFunction();
+    bool fail(const QString &error);
+
+    int addString(const QString &text);
+    void emitLexeme();
+    void emitOperator(FormulaExpression::Operator op);
+    void emitToken(FormulaExpression::TokenType type, quint16 value);
+
+    const char16_t *m_begin;
+    const char16_t *m_pos;
+    const char16_t *m_end;
+    Lexeme m_lexeme;
+    FormulaExpression *m_expression;
+};
+
+FormulaParser::FormulaParser(QStringView formula, FormulaExpression *expression)
+    : m_begin(formula.utf16())
+    , m_pos(formula.utf16())
+    , m_end(formula.utf16() + formula.size())
+    , m_expression(expression)
+{
+    if (m_pos != m_end && *m_pos == u'=')
+        ++m_pos;
+}
+
+bool FormulaParser::parse()
+{
+    next();
+    if (m_lexeme.kind == L_End)
+        return fail(QStringLiteral("Empty formula"));
+    if (!parseExpression())
+        return false;
+    if (m_lexeme.kind == L_Invalid)
+        return fail(m_lexeme.text);
+    if (m_lexeme.kind != L_End)
+        return fail(QStringLiteral("Unexpected text at %1").arg(m_pos - m_begin));
+    return true;
+}
+
+void FormulaParser::next()
+{
+    const char16_t *p = m_pos;
+    while (p != m_end && isSpace(*p))
+        ++p;
+    m_lexeme.spaceBefore = p != m_pos;
+    m_lexeme.token.type = FormulaExpression::T_Missing;
+    m_lexeme.token.flags = 0;
+    m_lexeme.token.value = 0;
+    m_lexeme.token.text = -1;
+    m_lexeme.token.sheet = -1;
+    m_lexeme.token.number = 0;
+    m_lexeme.token.firstRow = m_lexeme.token.firstColumn = -1;
+    m_lexeme.token.lastRow = m_lexeme.token.lastColumn = -1;
+    m_lexeme.text.clear();
+    m_lexeme.sheet.clear();
+    m_pos = p;
+    if (p == m_end) {
+        m_lexeme.kind = L_End;
+        return;
+    }
+
+    switch (*p) {
+    case u'"':
+        lexString();
+        break;
+    case u'{':
+        lexArray();
+        break;
+    case u'#':
+        lexError(p);
+        break;
+    case u'(':
+        m_lexeme.kind = L_OpenParen;
+        ++m_pos;
+        break;
+    case u')':
+        m_lexeme.kind = L_CloseParen;
+        ++m_pos;
+        break;
+    case u',':
+        m_lexeme.kind = L_Comma;
+        ++m_pos;
+        break;
+    case u'+':
+        setOperator(FormulaExpression::Op_Add, 1);
+        break;
+    case u'-':
+        setOperator(FormulaExpression::Op_Subtract, 1);
+        break;
+    case u'*':
+        setOperator(FormulaExpression::Op_Multiply, 1);
+        break;
+    case u'/':
+        setOperator(FormulaExpression::Op_Divide, 1);
+        break;
+    case u'^':
+        setOperator(FormulaExpression::Op_Power, 1);
+        break;
+    case u'&':
+        setOperator(FormulaExpression::Op_Concat, 1);
+        break;
+    case u'%':
+        setOperator(FormulaExpression::Op_Percent, 1);
+        break;
+    case u'=':
+        setOperator(FormulaExpression::Op_Equal, 1);
+        break;
+    case u':':
+        setOperator(FormulaExpression::Op_Range, 1);
+        break;
+    case u'<':
+        if (p + 1 != m_end && p[1] == u'=')
+            setOperator(FormulaExpression::Op_LessEqual, 2);
+        else if (p + 1 != m_end && p[1] == u'>')
+            setOperator(FormulaExpression::Op_NotEqual, 2);
+        else
+            setOperator(FormulaExpression::Op_Less, 1);
+        break;
+    case u'>':
+        if (p + 1 != m_end && p[1] == u'=')
+            setOperator(FormulaExpression::Op_GreaterEqual, 2);
+        else
+            setOperator(FormulaExpression::Op_Greater, 1);
+        break;
+    default:
+        if (isDigit(*p) || *p == u'$') {
+            if (lexRows(p))
+                break;
+        }
+        if (isDigit(*p) || *p == u'.')
+            lexNumber();
+        else if (isWordChar(*p) || *p == u'\'' || *p == u'[')
+            lexOperand();
+        else
+            setInvalid(QStringLiteral("Unexpected character at %1").arg(p - m_begin));
+        break;
+    }
+}
+
+void FormulaParser::setOperator(FormulaExpression::Operator op, int size)
+{
+    m_lexeme.kind = L_Operator;
+    m_lexeme.op = op;
+    m_pos += size;
+}
+
+void FormulaParser::setInvalid(const QString &error)
+{
+    m_lexeme.kind = L_Invalid;
+    m_lexeme.text = error;
+}
+
+/*
+ * "text", where "" stands for one quote.
+ */
+void FormulaParser::lexString()
+{
+    const char16_t *p = m_pos + 1;
+    const char16_t *chunk = p;
+    for (;;) {
+        while (p != m_end && *p != u'"')
+            ++p;
+        if (p == m_end) {
+            setInvalid(QStringLiteral("Unterminated string at %1").arg(m_pos - m_begin));
+            return;
+        }
+        if (p + 1 != m_end && p[1] == u'"') {
+            m_lexeme.text.append(QStringView(chunk, p + 1));
+            p += 2;
+            chunk = p;
+            continue;
+        }
+        m_lexeme.text.append(QStringView(chunk, p));
+        break;
+    }
+    m_lexeme.kind = L_Operand;
+    m_lexeme.token.type = FormulaExpression::T_String;
+    m_pos = p + 1;
+}
+
+/*
+ * {1,2;"a",TRUE}, which is kept as text.
+ */
+void FormulaParser::lexArray()
+{
+    const char16_t *p = m_pos + 1;
+    bool inString = false;
+    for (; p != m_end; ++p) {
+        if (*p == u'"')
+            inString = !inString;
+        else if (*p == u'}' && !inString)
+            break;
+    }
+    if (p == m_end) {
+        setInvalid(QStringLiteral("Unterminated array at %1").arg(m_pos - m_begin));
+        return;
+    }
+    m_lexeme.kind = L_Operand;
+    m_lexeme.token.type = FormulaExpression::T_Array;
+    m_lexeme.text = QStringView(m_pos, p + 1).toString();
+    m_pos = p + 1;
+}
+
+void FormulaParser::lexError(const char16_t *begin)
+{
+    const qsizetype available = m_end - begin;
+    for (const char *literal : errorLiterals) {
+        const qsizetype size = qsizetype(qstrlen(literal));
+        if (size > available)
+            continue;
+        qsizetype i = 0;
+        while (i < size && (begin[i] & ~0x20) == (literal[i] & ~0x20))
+            ++i;
+        if (i == size) {
+            m_lexeme.kind = L_Operand;
+            m_lexeme.token.type = FormulaExpression::T_Error;
+            m_lexeme.text = QString::fromLatin1(literal);
+            m_pos = begin + size;
+            return;
+        }
+    }
+    setInvalid(QStringLiteral("Unknown error literal at %1").arg(begin - m_begin));
+}
+
+void FormulaParser::lexNumber()
+{
+    const char16_t *p = m_pos;
+    while (p != m_end && isDigit(*p))
+        ++p;
+    if (p != m_end && *p == u'.') {
+        ++p;
+        while (p != m_end && isDigit(*p))
+            ++p;
+    }
+    if (p != m_end && (*p == u'E' || *p == u'e')) {
+        const char16_t *exponent = p + 1;
+        if (exponent != m_end && (*exponent == u'+' || *exponent == u'-'))
+            ++exponent;
+        if (exponent != m_end && isDigit(*exponent)) {
+            p = exponent;
+            while (p != m_end && isDigit(*p))
+                ++p;
+        }
+    }
+
+    bool ok = false;
+    const QStringView text(m_pos, p);
+    const double number = stringToDouble(text, &ok);
+    if (!ok || (p != m_end && isWordChar(*p))) {
+        setInvalid(QStringLiteral("Invalid number at %1").arg(m_pos - m_begin));
+        return;
+    }
+    m_lexeme.kind = L_Operand;
+    m_lexeme.token.type = FormulaExpression::T_Number;
+    m_lexeme.token.number = number;
+    m_lexeme.text = text.toString();
+    m_pos = p;
+}
+
+/*
+ * Whole rows, such as "1:3" or "$2:$2", at \a begin.
+ */
+bool FormulaParser::lexRows(const char16_t *begin)
+{
+    int firstRow;
+    int lastRow;
+    bool firstAbsolute;
+    bool lastAbsolute;
+    const char16_t *p = scanRow(begin, m_end, &firstRow, &firstAbsolute);
+    if (!p || p == m_end || *p != u':')
+        return false;
+    p = scanRow(p + 1, m_end, &lastRow, &lastAbsolute);
+    if (!p || (p != m_end && isWordChar(*p)))
+        return false;
+
+    FormulaExpression::Token &token = m_lexeme.token;
+    m_lexeme.kind = L_Operand;
+    token.type = FormulaExpression::T_Reference;
+    token.flags = FormulaExpression::IsRange | FormulaExpression::WholeRows
+        | (firstAbsolute ? FormulaExpression::FirstRowAbsolute : 0)
+        | (lastAbsolute ? FormulaExpression::LastRowAbsolute : 0);
+    token.firstRow = firstRow;
+    token.lastRow = lastRow;
+    token.firstColumn = 1;
+    token.lastColumn = MaxColumn;
+    m_pos = p;
+    return true;
+}
+
+/*
+ * A reference, a defined name or a function name, with the sheet it
+ * is qualified with if any: Sheet1!A1, 'My Sheet'!A1:B2, Sheet1:Sheet3!A1,
+ * [1]Sheet1!Name, Table1[Column], SUM(.
+ */
+void FormulaParser::lexOperand()
+{
+    const char16_t *p = m_pos;
+    const char16_t *wordBegin = p;
+    const char16_t *wordEnd = nullptr;
+    bool quoted = false;
+
+    if (*p == u'\'') {
+        // 'Sheet name'!, where '' stands for one apostrophe
+        ++p;
+        const char16_t *chunk = p;
+        for (;;) {
+            while (p != m_end && *p != u'\'')
+                ++p;
+            if (p == m_end) {
+                setInvalid(QStringLiteral("Unterminated sheet name at %1").arg(m_pos - m_begin));
+                return;
+            }
+            if (p + 1 != m_end && p[1] == u'\'') {
+                m_lexeme.sheet.append(QStringView(chunk, p + 1));
+                p += 2;
+                chunk = p;
+                continue;
+            }
+            m_lexeme.sheet.append(QStringView(chunk, p));
+            ++p;
+            break;
+        }
+        if (p == m_end || *p != u'!') {
+            setInvalid(QStringLiteral("Expected '!' at %1").arg(p - m_begin));
+            return;
+        }
+        ++p;
+        quoted = true;
+    } else {
+        // Sheet!, Sheet1:Sheet3!, [1]Sheet!, or the word itself
+        if (*p == u'[') {
+            while (p != m_end && *p != u']')
+                ++p;
+            if (p == m_end) {
+                setInvalid(QStringLiteral("Unterminated '[' at %1").arg(m_pos - m_begin));
+                return;
+            }
+            ++p;
+        }
+        wordEnd = skipWord(p, m_end);
+        const char16_t *sheetEnd = nullptr;
+        if (wordEnd != m_end && *wordEnd == u'!') {
+            sheetEnd = wordEnd;
+        } else if (wordEnd != m_end && *wordEnd == u':' && wordEnd != wordBegin) {
+            const char16_t *lastSheet = skipWord(wordEnd + 1, m_end);
+            if (lastSheet != wordEnd + 1 && lastSheet != m_end && *lastSheet == u'!')
+                sheetEnd = lastSheet;
+        }
+        if (sheetEnd) {
+            if (sheetEnd == wordBegin) {
+                setInvalid(QStringLiteral("Empty sheet name at %1").arg(m_pos - m_begin));
+                return;
+            }
+            m_lexeme.sheet = QStringView(wordBegin, sheetEnd).toString();
+            p = sheetEnd + 1;
+            wordEnd = nullptr;
+        } else if (p != wordBegin) {
+            // [@Column] and the like, structured reference of the table
+            // the formula is in
+            p = wordBegin;
+            wordEnd = wordBegin;
+        }
+    }
+
+    const bool qualified = wordEnd == nullptr;
+    FormulaExpression::Token &token = m_lexeme.token;
+    if (quoted)
+        token.flags |= FormulaExpression::SheetQuoted;
+
+    if (qualified) {
+        if (p != m_end && *p == u'#') {
+            lexError(p);
+            return;
+        }
+        if (p != m_end && (isDigit(*p) || *p == u'$') && lexRows(p)) {
+            m_lexeme.token.flags |= quoted ? FormulaExpression::SheetQuoted : 0;
+            return;
+        }
+        wordEnd = skipWord(p, m_end);
+    }
+    const char16_t *after = wordEnd;
+
+    if (!qualified && after != m_end && *after == u'(' && after != p) {
+        m_lexeme.kind = L_Function;
+        m_lexeme.text = QStringView(p, wordEnd).toString();
+        m_pos = after;
+        return;
+    }
+
+    int row;
+    int column;
+    int flags;
+    if (after != p && scanCell(p, wordEnd, &row, &column, &flags)) {
+        m_lexeme.kind = L_Operand;
+        token.type = FormulaExpression::T_Reference;
+        token.flags |= flags;
+        token.firstRow = token.lastRow = row;
+        token.firstColumn = token.lastColumn = column;
+        if (after != m_end && *after == u':') {
+            const char16_t *lastEnd = skipWord(after + 1, m_end);
+            if (scanCell(after + 1, lastEnd, &row, &column, &flags)) {
+                token.flags |= FormulaExpression::IsRange | (flags << 2);
+                token.lastRow = row;
+                token.lastColumn = column;
+                after = lastEnd;
+            }
+        }
+        m_pos = after;
+        return;
+    }
+
+    bool firstAbsolute;
+    bool lastAbsolute;
+    if (after != p && after != m_end && *after == u':'
+        && scanColumn(p, wordEnd, &column, &firstAbsolute) == wordEnd) {
+        const char16_t *lastEnd = skipWord(after + 1, m_end);
+        int lastColumn;
+        if (lastEnd != after + 1
+            && scanColumn(after + 1, lastEnd, &lastColumn, &lastAbsolute) == lastEnd) {
+            m_lexeme.kind = L_Operand;
+            token.type = FormulaExpression::T_Reference;
+            token.flags |= FormulaExpression::IsRange | FormulaExpression::WholeColumns
+                | (firstAbsolute ? FormulaExpression::FirstColumnAbsolute : 0)
+                | (lastAbsolute ? FormulaExpression::LastColumnAbsolute : 0);
+            token.firstRow = 1;
+            token.lastRow = MaxRow;
+            token.firstColumn = column;
+            token.lastColumn = lastColumn;
+            m_pos = lastEnd;
+            return;
+        }
+    }
+
+    if (!qualified && wordEnd - p == 4 && QStringView(p, wordEnd).compare(u"TRUE", Qt::CaseInsensitive) == 0) {
+        m_lexeme.kind = L_Operand;
+        token.type = FormulaExpression::T_Boolean;
+        token.number = 1;
+        m_pos = after;
+        return;
+    }
+    if (!qualified && wordEnd - p == 5 && QStringView(p, wordEnd).compare(u"FALSE", Qt::CaseInsensitive) == 0) {
+        m_lexeme.kind = L_Operand;
+        token.type = FormulaExpression::T_Boolean;
+        token.number = 0;
+        m_pos = after;
+        return;
+    }
+
+    // Defined name, or Table1[Column] / Table1[[#This Row],[Column]]
+    if (after != m_end && *after == u'[') {
+        int depth = 0;
+        for (; after != m_end; ++after) {
+            if (*after == u'\'' && after + 1 != m_end) {
+                ++after; // escaped bracket
+                continue;
+            }
+            if (*after == u'[')
+                ++depth;
+            else if (*after == u']' && --depth == 0)
+                break;
+        }
+        if (after == m_end) {
+            setInvalid(QStringLiteral("Unterminated '[' at %1").arg(p - m_begin));
+            return;
+        }
+        ++after;
+    }
+    if (after == p) {
+        setInvalid(QStringLiteral("Expected a name at %1").arg(p - m_begin));
+        return;
+    }
+    m_lexeme.kind = L_Operand;
+    token.type = FormulaExpression::T_Name;
+    m_lexeme.text = QStringView(p, after).toString();
+    m_pos = after;
+}
+
+bool FormulaParser::parseExpression()
+{
+    return parseBinary(0);
+}
+
+static int binaryLevel(FormulaExpression::Operator op)
+{
+    switch (op) {
+    case FormulaExpression::Op_Equal:
+    case FormulaExpression::Op_NotEqual:
+    case FormulaExpression::Op_Less:
+    case FormulaExpression::Op_LessEqual:
+    case FormulaExpression::Op_Greater:
+    case FormulaExpression::Op_GreaterEqual:
+        return 0;
+    case FormulaExpression::Op_Concat:
+        return 1;
+    case FormulaExpression::Op_Add:
+    case FormulaExpression::Op_Subtract:
+        return 2;
+    case FormulaExpression::Op_Multiply:
+    case FormulaExpression::Op_Divide:
+        return 3;
+    case FormulaExpression::Op_Power:
+        return 4;
+    default:
+        return -1;
+    }
+}
+
+/*
+ * The binary operators of \a level and above, all left associative
+ * as they are in Excel, even '^'.
+ */
+bool FormulaParser::parseBinary(int level)
+{
+    if (level > 4)
+        return parsePercent();
+    if (!parseBinary(level + 1))
+        return false;
+    while (m_lexeme.kind == L_Operator && binaryLevel(m_lexeme.op) == level) {
+        const FormulaExpression::Operator op = m_lexeme.op;
+        next();
+        if (!parseBinary(level + 1))
+            return false;
+        emitOperator(op);
+    }
+    return true;
+}
+
+bool FormulaParser::parsePercent()
+{
+    if (!parseUnary())
+        return false;
+    while (m_lexeme.kind == L_Operator && m_lexeme.op == FormulaExpression::Op_Percent) {
+        emitOperator(FormulaExpression::Op_Percent);
+        next();
+    }
+    return true;
+}
+
+bool FormulaParser::parseUnary()
+{
+    if (m_lexeme.kind == L_Operator
+        && (m_lexeme.op == FormulaExpression::Op_Subtract
+            || m_lexeme.op == FormulaExpression::Op_Add)) {
+        const FormulaExpression::Operator op = m_lexeme.op == FormulaExpression::Op_Subtract
+            ? FormulaExpression::Op_Negate
+            : FormulaExpression::Op_Plus;
+        next();
+        if (!parseUnary())
+            return false;
+        emitOperator(op);
+        return true;
+    }
+    return parseIntersect();
+}
+
+/*
+ * "A1:C3 B2:B4". The space is only an operator when it stands
+ * between two things that can be references.
+ */
+bool FormulaParser::parseIntersect()
+{
+    if (!parseRange())
+        return false;
+    while (m_lexeme.spaceBefore
+           && ((m_lexeme.kind == L_Operand
+                && (m_lexeme.token.type == FormulaExpression::T_Reference
+                    || m_lexeme.token.type == FormulaExpression::T_Name))
+               || m_lexeme.kind == L_Function || m_lexeme.kind == L_OpenParen)) {
+        if (!parseRange())
+            return false;
+        emitOperator(FormulaExpression::Op_Intersect);
+    }
+    return true;
+}
+
+/*
+ * ':' between operands the lexer did not take as a single range, as
+ * in A1:INDEX(B:B,3) or Name1:Name2.
+ */
+bool FormulaParser::parseRange()
+{
+    if (!parsePrimary())
+        return false;
+    while (m_lexeme.kind == L_Operator && m_lexeme.op == FormulaExpression::Op_Range) {
+        next();
+        if (!parsePrimary())
+            return false;
+        emitOperator(FormulaExpression::Op_Range);
+    }
+    return true;
+}
+
+bool FormulaParser::parsePrimary()
+{
+    switch (m_lexeme.kind) {
+    case L_Operand:
+        emitLexeme();
+        next();
+        return true;
+    case L_Function:
+        return parseFunction();
+    case L_OpenParen:
+        next();
+        if (!parseExpression())
+            return false;
+        while (m_lexeme.kind == L_Comma) {
+            next();
+            if (!parseExpression())
+                return false;
+            emitOperator(FormulaExpression::Op_Union);
+        }
+        if (m_lexeme.kind == L_Invalid)
+            return fail(m_lexeme.text);
+        if (m_lexeme.kind != L_CloseParen)
+            return fail(QStringLiteral("Expected ')' at %1").arg(m_pos - m_begin));
+        emitToken(FormulaExpression::T_Paren, 0);
+        next();
+        return true;
+    case L_Invalid:
+        return fail(m_lexeme.text);
+    case L_End:
+        return fail(QStringLiteral("Unexpected end of formula"));
+    default:
+        return fail(QStringLiteral("Expected an operand at %1").arg(m_pos - m_begin));
+    }
+}
+
+/*
+ * NAME(arg, ...). An empty argument, as in IF(A1,,1), is a T_Missing
+ * token; NOW() takes no argument at all.
+ */
+bool FormulaParser::parseFunction()
+{
+    const QString name = m_lexeme.text;
+    next();
+    Q_ASSERT(m_lexeme.kind == L_OpenParen);
+    next();
+
+    int count = 0;
+    if (m_lexeme.kind != L_CloseParen) {
+        for (;;) {
+            if (m_lexeme.kind == L_Comma || m_lexeme.kind == L_CloseParen)
+                emitToken(FormulaExpression::T_Missing, 0);
+            else if (!parseExpression())
+                return false;
+            ++count;
+            if (m_lexeme.kind == L_Comma) {
+                next();
+                continue;
+            }
+            if (m_lexeme.kind == L_CloseParen)
+                break;
+            if (m_lexeme.kind == L_Invalid)
+                return fail(m_lexeme.text);
+            return fail(QStringLiteral("Expected ',' or ')' at %1").arg(m_pos - m_begin));
+        }
+    }
+    if (count > 0xffff)
+        return fail(QStringLiteral("Too many arguments for %1").arg(name));
+
+    emitToken(FormulaExpression::T_Function, quint16(count));
+    m_expression->m_tokens.last().text = addString(name);
+    next();
+    return true;
+}
+
+bool FormulaParser::fail(const QString &error)
+{
+    m_expression->m_error = error;
+    return false;
+}
+
+int FormulaParser::addString(const QString &text)
+{
+    m_expression->m_strings.append(text);
+    return int(m_expression->m_strings.size() - 1);
+}
+
+void FormulaParser::emitLexeme()
+{
+    FormulaExpression::Token token = m_lexeme.token;
+    switch (token.type) {
+    case FormulaExpression::T_Number:
+    case FormulaExpression::T_String:
+    case FormulaExpression::T_Error:
+    case FormulaExpression::T_Array:
+    case FormulaExpression::T_Name:
+        token.text = addString(m_lexeme.text);
+        break;
+    default:
+        break;
+    }
+    if (!m_lexeme.sheet.isEmpty())
+        token.sheet = addString(m_lexeme.sheet);
+    m_expression->m_tokens.append(token);
+}
+
+void FormulaParser::emitOperator(FormulaExpression::Operator op)
+{
+    emitToken(FormulaExpression::T_Operator, quint16(op));
+}
+
+void FormulaParser::emitToken(FormulaExpression::TokenType type, quint16 value)
+{
+    FormulaExpression::Token token;
+    token.type = quint8(type);
+    token.flags = 0;
+    token.value = value;
+    token.text = -1;
+    token.sheet = -1;
+    token.number = 0;
+    token.firstRow = token.firstColumn = token.lastRow = token.lastColumn = -1;
+    m_expression->m_tokens.append(token);
+}
+
+/*!
+  \class FormulaExpression
+  \internal
+*/
+
+FormulaExpression::FormulaExpression()
+    : m_valid(false)
+{
+}
+
+/*
+  Parse \a formula, with or without its leading '='. The result is
+  invalid, with an errorString(), when the formula is not well formed.
+*/
+FormulaExpression FormulaExpression::parse(QStringView formula)
+{
+    FormulaExpression expression;
+    expression.m_tokens.reserve(formula.size() / 3 + 1);
+    FormulaParser parser(formula, &expression);
+    expression.m_valid = parser.parse();
+    if (!expression.m_valid) {
+        expression.m_tokens.clear();
+        expression.m_strings.clear();
+    }
+    return expression;
+}
+
+bool FormulaExpression::isValid() const
+{
+    return m_valid;
+}
+
+QString FormulaExpression::errorString() const
+{
+    return m_error;
+}
+
+const QList<FormulaExpression::Token> &FormulaExpression::tokens() const
+{
+    return m_tokens;
+}
+
+/*
+  The text of \a token: the value of a string, the name of a function
+  or of a defined name, the literal of a number, an error or an array.
+*/
+QString FormulaExpression::text(const Token &token) const
+{
+    return token.text >= 0 ? m_strings.at(token.text) : QString();
+}
+
+/*
+  The sheet \a token is qualified with, unescaped. Empty for the sheet
+  the formula belongs to.
+*/
+QString FormulaExpression::sheetName(const Token &token) const
+{
+    return token.sheet >= 0 ? m_strings.at(token.sheet) : QString();
+}
+
+/*
+  The formula, without the leading '='. Spaces which are not operators
+  are dropped, and column letters are upper cased.
+*/
+QString FormulaExpression::toString() const
+{
+    if (!m_valid)
+        return QString();
+
+    QList<QString> stack;
+    for (const Token &token : m_tokens) {
+        QString sheet;
+        if (token.sheet >= 0) {
+            sheet = m_strings.at(token.sheet);
+            if (token.flags & SheetQuoted)
+                sheet = QLatin1Char('\'') + sheet.replace(QLatin1Char('\''), QLatin1String("''"))
+                    + QLatin1Char('\'');
+            sheet.append(QLatin1Char('!'));
+        }
+
+        switch (token.type) {
+        case T_String: {
+            QString value = m_strings.at(token.text);
+            stack.append(QLatin1Char('"') + value.replace(QLatin1Char('"'), QLatin1String("\"\""))
+                         + QLatin1Char('"'));
+            break;
+        }
+        case T_Boolean:
+            stack.append(token.number ? QStringLiteral("TRUE") : QStringLiteral("FALSE"));
+            break;
+        case T_Missing:
+            stack.append(QString());
+            break;
+        case T_Number:
+        case T_Error:
+        case T_Array:
+        case T_Name:
+            stack.append(sheet + m_strings.at(token.text));
+            break;
+        case T_Reference: {
+            QString ref = sheet;
+            if (token.flags & WholeColumns) {
+                ref += columnName(token.firstColumn, token.flags & FirstColumnAbsolute);
+                ref += QLatin1Char(':');
+                ref += columnName(token.lastColumn, token.flags & LastColumnAbsolute);
+            } else if (token.flags & WholeRows) {
+                if (token.flags & FirstRowAbsolute)
+                    ref += QLatin1Char('$');
+                ref += QString::number(token.firstRow);
+                ref += QLatin1Char(':');
+                if (token.flags & LastRowAbsolute)
+                    ref += QLatin1Char('$');
+                ref += QString::number(token.lastRow);
+            } else {
+                ref += CellReference(token.firstRow, token.firstColumn)
+                           .toString(token.flags & FirstRowAbsolute,
+                                     token.flags & FirstColumnAbsolute);
+                if (token.flags & IsRange) {
+                    ref += QLatin1Char(':');
+                    ref += CellReference(token.lastRow, token.lastColumn)
+                               .toString(token.flags & LastRowAbsolute,
+                                         token.flags & LastColumnAbsolute);
+                }
+            }
+            stack.append(ref);
+            break;
+        }
+        case T_Paren:
+            stack.last() = QLatin1Char('(') + stack.last() + QLatin1Char(')');
+            break;
+        case T_Function: {
+            QString call = m_strings.at(token.text) + QLatin1Char('(');
+            const qsizetype first = stack.size() - token.value;
+            for (qsizetype i = first; i < stack.size(); ++i) {
+                if (i != first)
+                    call += QLatin1Char(',');
+                call += stack.at(i);
+            }
+            call += QLatin1Char(')');
+            stack.resize(first);
+            stack.append(call);
+            break;
+        }
+        case T_Operator: {
+            const QLatin1String op(operatorNames[token.value]);
+            if (token.value == Op_Negate || token.value == Op_Plus) {
+                stack.last().prepend(op);
+            } else if (token.value == Op_Percent) {
+                stack.last().append(op);
+            } else {
+                const QString right = stack.takeLast();
+                stack.last() += op;
+                stack.last() += right;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return stack.isEmpty() ? QString() : stack.last();
+}
+
+/*
+  The cells and ranges the formula refers to, in the order they are
+  written. Defined names are not resolved.
+*/
+QList<FormulaExpression::Reference> FormulaExpression::references() const
+{
+    QList<Reference> refs;
+    for (const Token &token : m_tokens) {
+        if (token.type != T_Reference)
+            continue;
+        Reference ref;
+        ref.sheet = sheetName(token);
+        ref.range = CellRange(token.firstRow, token.firstColumn, token.lastRow, token.lastColumn);
+        refs.append(ref);
+    }
+    return refs;
+}
+
+QT_END_NAMESPACE_XLSX
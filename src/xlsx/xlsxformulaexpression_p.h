@@ -0,0 +1,150 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+
+#ifndef XLSXFORMULAEXPRESSION_P_H
+#define XLSXFORMULAEXPRESSION_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxcellrange.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+  A formula parsed into reverse polish notation: the operands are
+  followed by the operator or the function which takes them. The
+  parentheses of the text are kept as T_Paren tokens, so that
+  toString() gives the formula back; evaluation skips them.
+*/
+class XLSX_AUTOTEST_EXPORT FormulaExpression
+{
+public:
+    enum TokenType {
+        T_Number,
+        T_String,
+        T_Boolean,
+        T_Error,
+        T_Array, // array constant, such as {1,2;3,4}
+        T_Reference, // cell, range, whole columns or whole rows
+        T_Name, // defined name, or structured reference
+        T_Missing, // omitted function argument
+        T_Function,
+        T_Operator,
+        T_Paren
+    };
+
+    enum Operator {
+        Op_Add,
+        Op_Subtract,
+        Op_Multiply,
+        Op_Divide,
+        Op_Power,
+        Op_Concat,
+        Op_Equal,
+        Op_NotEqual,
+        Op_Less,
+        Op_LessEqual,
+        Op_Greater,
+        Op_GreaterEqual,
+        Op_Range, // ':' between operands which are not plain references
+        Op_Intersect, // ' ' between two references
+        Op_Union, // ',' between references, inside of parentheses
+        Op_Negate,
+        Op_Plus,
+        Op_Percent
+    };
+
+    enum ReferenceFlag {
+        FirstColumnAbsolute = 0x01,
+        FirstRowAbsolute = 0x02,
+        LastColumnAbsolute = 0x04,
+        LastRowAbsolute = 0x08,
+        IsRange = 0x10, // written as a range, "A1:A1" is not "A1"
+        WholeColumns = 0x20, // "A:C"
+        WholeRows = 0x40, // "1:3"
+        SheetQuoted = 0x80 // the sheet was written as 'Sheet 1'!
+    };
+
+    struct Token
+    {
+        quint8 type; // TokenType
+        quint8 flags; // ReferenceFlag of a T_Reference, SheetQuoted of others
+        quint16 value; // Operator, or the argument count of a T_Function
+        int text; // index in m_strings, -1 when the token has no text
+        int sheet; // index in m_strings, -1 for the sheet of the formula
+        double number; // T_Number, T_Boolean
+        int firstRow;
+        int firstColumn;
+        int lastRow;
+        int lastColumn;
+    };
+
+    struct Reference
+    {
+        QString sheet; // empty for the sheet of the formula
+        CellRange range;
+    };
+
+    FormulaExpression();
+
+    static FormulaExpression parse(QStringView formula);
+
+    bool isValid() const;
+    QString errorString() const;
+
+    const QList<Token> &tokens() const;
+    QString text(const Token &token) const;
+    QString sheetName(const Token &token) const;
+
+    QString toString() const;
+    QList<Reference> references() const;
+
+private:
+    friend class FormulaParser;
+
+    QList<Token> m_tokens;
+    QStringList m_strings; // text of the tokens: literals, names, sheets
+    QString m_error;
+    bool m_valid;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXFORMULAEXPRESSION_P_H
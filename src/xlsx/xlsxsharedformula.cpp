@@ -0,0 +1,247 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#include "xlsxsharedformula_p.h"
+#include "xlsxcellrange.h"
+#include "xlsxformulaexpression_p.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+SharedFormulaTemplate::SharedFormulaTemplate()
+    : m_valid(false)
+{
+}
+
+/*
+  Split \a rootFormula, the formula of \a rootCell, into pieces. The
+  references are found as convertSharedFormula() always did: the
+  "$?[A-Z]+$?[0-9]+" patterns outside of string literals. A reference
+  with both parts absolute is kept as text.
+*/
+SharedFormulaTemplate::SharedFormulaTemplate(const QString &rootFormula,
+                                             const CellReference &rootCell)
+    : m_rootCell(rootCell)
+    , m_valid(true)
+{
+    m_text.reserve(rootFormula.size());
+    int textBegin = 0;
+    auto addSegment = [&](const QString &segment, int flags) {
+        if (flags == -1 || flags == 3) {
+            m_text.append(segment);
+            return;
+        }
+        const CellReference ref(segment);
+        Piece piece;
+        piece.textBegin = textBegin;
+        piece.textSize = m_text.size() - textBegin;
+        piece.flags = flags;
+        piece.row = ref.row();
+        piece.column = ref.column();
+        m_pieces.append(piece);
+        textBegin = m_text.size();
+    };
+
+    QString segment;
+    bool inQuote = false;
+    enum RefState { INVALID, PRE_AZ, AZ, PRE_09, _09 };
+    RefState refState = INVALID;
+    int refFlag = 0; // 0x00, 0x01, 0x02, 0x03 ==> A1, $A1, A$1, $A$1
+    for (QChar ch : rootFormula) {
+        if (inQuote) {
+            segment.append(ch);
+            if (ch == QLatin1Char('"'))
+                inQuote = false;
+        } else {
+            if (ch == QLatin1Char('"')) {
+                inQuote = true;
+                refState = INVALID;
+                segment.append(ch);
+            } else if (ch == QLatin1Char('$')) {
+                if (refState == AZ) {
+                    segment.append(ch);
+                    refState = PRE_09;
+                    refFlag |= 0x02;
+                } else {
+                    addSegment(segment, refState == _09 ? refFlag : -1);
+                    segment = QString(ch); // Start new segment.
+                    refState = PRE_AZ;
+                    refFlag = 0x01;
+                }
+            } else if (ch >= QLatin1Char('A') && ch <= QLatin1Char('Z')) {
+                if (refState == PRE_AZ || refState == AZ) {
+                    segment.append(ch);
+                } else {
+                    addSegment(segment, refState == _09 ? refFlag : -1);
+                    segment = QString(ch); // Start new segment.
+                    refFlag = 0x00;
+                }
+                refState = AZ;
+            } else if (ch >= QLatin1Char('0') && ch <= QLatin1Char('9')) {
+                segment.append(ch);
+
+                if (refState == AZ || refState == PRE_09 || refState == _09)
+                    refState = _09;
+                else
+                    refState = INVALID;
+            } else {
+                if (refState == _09) {
+                    addSegment(segment, refFlag);
+                    segment = QString(ch); // Start new segment.
+                } else {
+                    segment.append(ch);
+                }
+                refState = INVALID;
+            }
+        }
+    }
+    if (!segment.isEmpty())
+        addSegment(segment, refState == _09 ? refFlag : -1);
+
+    if (textBegin < m_text.size()) {
+        Piece piece;
+        piece.textBegin = textBegin;
+        piece.textSize = m_text.size() - textBegin;
+        piece.flags = -1;
+        piece.row = -1;
+        piece.column = -1;
+        m_pieces.append(piece);
+    }
+}
+
+bool SharedFormulaTemplate::isValid() const
+{
+    return m_valid;
+}
+
+CellReference SharedFormulaTemplate::rootCell() const
+{
+    return m_rootCell;
+}
+
+/*
+  The formula of the cell at \a row and \a column.
+*/
+QString SharedFormulaTemplate::formulaAt(int row, int column) const
+{
+    const int rowOffset = row - m_rootCell.row();
+    const int columnOffset = column - m_rootCell.column();
+    QString formula;
+    formula.reserve(m_text.size() + m_pieces.size() * 8);
+    for (const Piece &piece : m_pieces) {
+        formula.append(QStringView(m_text).mid(piece.textBegin, piece.textSize));
+        if (piece.flags != -1)
+            appendReference(formula, piece, rowOffset, columnOffset);
+    }
+    return formula;
+}
+
+QString SharedFormulaTemplate::formulaAt(const CellReference &cell) const
+{
+    return formulaAt(cell.row(), cell.column());
+}
+
+/*
+  The formulas of all the cells of \a range, row by row.
+*/
+QList<QString> SharedFormulaTemplate::expand(const CellRange &range) const
+{
+    QList<QString> formulas;
+    if (!range.isValid())
+        return formulas;
+    formulas.reserve(range.rowCount() * range.columnCount());
+    for (int row = range.firstRow(); row <= range.lastRow(); ++row) {
+        for (int column = range.firstColumn(); column <= range.lastColumn(); ++column)
+            formulas.append(formulaAt(row, column));
+    }
+    return formulas;
+}
+
+/*
+  Whether formulaAt() gives, for the cells below the root cell, the
+  formulas a spreadsheet application derives from the root formula,
+  parsed into \a expression. The references moved by formulaAt() must
+  be the cell references of the expression which aren't absolute in
+  both parts, in the same order, and no other reference of the
+  expression may move down with the cell.
+
+  This rules out the texts the pieces get wrong, such as LOG10(),
+  lower case references, whole rows and structured references.
+*/
+bool SharedFormulaTemplate::movesDownAs(const FormulaExpression &expression) const
+{
+    if (!m_valid || !expression.isValid())
+        return false;
+
+    int index = 0;
+    auto nextPiece = [&](int row, int column, int flags) {
+        if (flags == 3)
+            return true; // kept as text
+        while (index < m_pieces.size() && m_pieces[index].flags == -1)
+            ++index;
+        if (index == m_pieces.size())
+            return false;
+        const Piece &piece = m_pieces[index++];
+        return piece.flags == flags && piece.row == row && piece.column == column;
+    };
+
+    for (const FormulaExpression::Token &token : expression.tokens()) {
+        if (token.type == FormulaExpression::T_Name) {
+            if (expression.text(token).contains(QLatin1Char('[')))
+                return false;
+            continue;
+        }
+        if (token.type != FormulaExpression::T_Reference)
+            continue;
+        if (token.flags & FormulaExpression::WholeColumns)
+            continue;
+        if (token.flags & FormulaExpression::WholeRows) {
+            const int rowsAbsolute =
+                FormulaExpression::FirstRowAbsolute | FormulaExpression::LastRowAbsolute;
+            if ((token.flags & rowsAbsolute) != rowsAbsolute)
+                return false;
+            continue;
+        }
+        if (!nextPiece(token.firstRow, token.firstColumn, token.flags & 0x03))
+            return false;
+        if ((token.flags & FormulaExpression::IsRange)
+            && !nextPiece(token.lastRow, token.lastColumn, (token.flags >> 2) & 0x03))
+            return false;
+    }
+
+    while (index < m_pieces.size() && m_pieces[index].flags == -1)
+        ++index;
+    return index == m_pieces.size();
+}
+
+void SharedFormulaTemplate::appendReference(QString &out, const Piece &piece, int rowOffset,
+                                            int columnOffset)
+{
+    const bool rowAbsolute = piece.flags & 0x02;
+    const bool columnAbsolute = piece.flags & 0x01;
+    const int row = rowAbsolute ? piece.row : piece.row + rowOffset;
+    const int column = columnAbsolute ? piece.column : piece.column + columnOffset;
+    out.append(CellReference(row, column).toString(rowAbsolute, columnAbsolute));
+}
+
+QT_END_NAMESPACE_XLSX
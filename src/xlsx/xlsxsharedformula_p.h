@@ -0,0 +1,93 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+
+#ifndef XLSXSHAREDFORMULA_P_H
+#define XLSXSHAREDFORMULA_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxcellreference.h"
+
+#include <QList>
+#include <QString>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class CellRange;
+class FormulaExpression;
+
+/*
+  The formula of a shared formula master, split once into literal text
+  and the cell references which move with the cell the formula is
+  shared with. formulaAt() gives the formula of any cell of the group
+  in one pass over the pieces, without looking at the text again.
+*/
+class XLSX_AUTOTEST_EXPORT SharedFormulaTemplate
+{
+public:
+    SharedFormulaTemplate();
+    SharedFormulaTemplate(const QString &rootFormula, const CellReference &rootCell);
+
+    bool isValid() const;
+    CellReference rootCell() const;
+
+    QString formulaAt(int row, int column) const;
+    QString formulaAt(const CellReference &cell) const;
+    QList<QString> expand(const CellRange &range) const;
+    bool movesDownAs(const FormulaExpression &expression) const;
+
+private:
+    // Literal text, then a reference unless flags is -1
+    struct Piece
+    {
+        int textBegin;
+        int textSize;
+        int flags; // 0x01: column is absolute, 0x02: row is absolute
+        int row;
+        int column;
+    };
+
+    static void appendReference(QString &out, const Piece &piece, int rowOffset,
+                                int columnOffset);
+
+    QString m_text; // the literal text of all the pieces
+    QList<Piece> m_pieces;
+    CellReference m_rootCell;
+    bool m_valid;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXSHAREDFORMULA_P_H
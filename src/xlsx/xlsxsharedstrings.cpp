@@ -27,6 +27,7 @@
 #include "xlsxutility_p.h"
 #include "xlsxformat_p.h"
 #include "xlsxcolor_p.h"
+#include "xlsxsheetdatareader_p.h"
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 #include <QDir>
@@ -46,6 +47,7 @@ namespace QXlsx {
 
 SharedStrings::SharedStrings(CreateFlag flag)
     : AbstractOOXmlFile(flag)
+    , m_lazyLoad(false)
 {
     m_stringCount = 0;
 }
@@ -57,7 +59,23 @@ int SharedStrings::count() const
 
 bool SharedStrings::isEmpty() const
 {
-    return m_stringList.isEmpty();
+    return m_stringList.isEmpty() && m_lazyStrings.isEmpty();
+}
+
+/*
+ * With \a lazy set, the table loaded next keeps the xml part and only
+ * records where each string is. A string is decoded when it is asked
+ * for, and the lookup table is built the first time the table is
+ * modified.
+ */
+void SharedStrings::setLazyLoad(bool lazy)
+{
+    m_lazyLoad = lazy;
+}
+
+bool SharedStrings::isLazyLoad() const
+{
+    return m_lazyLoad;
 }
 
 int SharedStrings::addSharedString(const QString &string)
@@ -67,6 +85,7 @@ int SharedStrings::addSharedString(const QString &string)
 
 int SharedStrings::addSharedString(const RichString &string)
 {
+    buildTable();
     m_stringCount += 1;
 
     if (m_stringTable.contains(string)) {
@@ -81,14 +100,36 @@ int SharedStrings::addSharedString(const RichString &string)
     return index;
 }
 
-void SharedStrings::incRefByStringIndex(int idx)
+/*
+ * Add \a count references to the string at \a idx. The worksheets
+ * count the references to each index while they are loaded and add
+ * them here once, see WorksheetPrivate::mergeSharedStringRefs().
+ */
+void SharedStrings::incRefByStringIndex(int idx, int count)
 {
+    if (!m_lazyStrings.isEmpty()) {
+        if (idx < 0 || idx >= m_lazyStrings.size()) {
+            qDebug("SharedStrings: invlid index");
+            return;
+        }
+        m_stringCount += count;
+        m_lazyStrings[idx].count += count;
+        return;
+    }
+
     if (idx < 0 || idx >= m_stringList.size()) {
         qDebug("SharedStrings: invlid index");
         return;
     }
 
-    addSharedString(m_stringList[idx]);
+    QHash<RichString, XlsxSharedStringInfo>::iterator it = m_stringTable.find(m_stringList[idx]);
+    if (it == m_stringTable.end()) {
+        for (int i = 0; i < count; ++i)
+            addSharedString(m_stringList[idx]);
+        return;
+    }
+    m_stringCount += count;
+    it.value().count += count;
 }
 
 /*
@@ -104,6 +145,7 @@ void SharedStrings::removeSharedString(const QString &string)
  */
 void SharedStrings::removeSharedString(const RichString &string)
 {
+    buildTable();
     if (!m_stringTable.contains(string))
         return;
 
@@ -128,13 +170,28 @@ int SharedStrings::getSharedStringIndex(const QString &string) const
 
 int SharedStrings::getSharedStringIndex(const RichString &string) const
 {
+    // Without the lookup table, the last one wins as in the table
+    for (int i = m_lazyStrings.size() - 1; i >= 0; --i) {
+        if (decodeString(i) == string)
+            return i;
+    }
+
     if (m_stringTable.contains(string))
         return m_stringTable[string].index;
     return -1;
 }
 
+/*
+ * Safe to call from several threads as long as no string is added.
+ */
 RichString SharedStrings::getSharedString(int index) const
 {
+    if (!m_lazyStrings.isEmpty()) {
+        if (index < m_lazyStrings.size() && index >= 0)
+            return decodeString(index);
+        return RichString();
+    }
+
     if (index < m_stringList.count() && index >= 0)
         return m_stringList[index];
     return RichString();
@@ -142,7 +199,14 @@ RichString SharedStrings::getSharedString(int index) const
 
 QList<RichString> SharedStrings::getSharedStrings() const
 {
-    return m_stringList;
+    if (m_lazyStrings.isEmpty())
+        return m_stringList;
+
+    QList<RichString> strings;
+    strings.reserve(m_lazyStrings.size());
+    for (int i = 0; i < m_lazyStrings.size(); ++i)
+        strings.append(decodeString(i));
+    return strings;
 }
 
 void SharedStrings::writeRichStringPart_rPr(QXmlStreamWriter &writer, const Format &format) const
@@ -226,9 +290,12 @@ void SharedStrings::saveToXmlFile(QIODevice *device) const
         QStringLiteral("xmlns"),
         QStringLiteral("http://schemas.openxmlformats.org/spreadsheetml/2006/main"));
     writer.writeAttribute(QStringLiteral("count"), QString::number(m_stringCount));
-    writer.writeAttribute(QStringLiteral("uniqueCount"), QString::number(m_stringList.size()));
+    const int uniqueCount = m_lazyStrings.isEmpty() ? m_stringList.size() : m_lazyStrings.size();
+    writer.writeAttribute(QStringLiteral("uniqueCount"), QString::number(uniqueCount));
 
-    foreach (RichString string, m_stringList) {
+    for (int index = 0; index < uniqueCount; ++index) {
+        const RichString string =
+            m_lazyStrings.isEmpty() ? m_stringList[index] : decodeString(index);
         writer.writeStartElement(QStringLiteral("si"));
         if (string.isRichString()) {
             // Rich text string
@@ -263,6 +330,14 @@ void SharedStrings::saveToXmlFile(QIODevice *device) const
 }
 
 void SharedStrings::readString(QXmlStreamReader &reader)
+{
+    RichString richString = readRichString(reader);
+    int idx = m_stringList.size();
+    m_stringTable[richString] = XlsxSharedStringInfo(idx, 0);
+    m_stringList.append(richString);
+}
+
+RichString SharedStrings::readRichString(QXmlStreamReader &reader)
 {
     Q_ASSERT(reader.name() == QLatin1String("si"));
 
@@ -279,10 +354,7 @@ void SharedStrings::readString(QXmlStreamReader &reader)
                 readPlainStringPart(reader, richString);
         }
     }
-
-    int idx = m_stringList.size();
-    m_stringTable[richString] = XlsxSharedStringInfo(idx, 0);
-    m_stringList.append(richString);
+    return richString;
 }
 
 void SharedStrings::readRichStringPart(QXmlStreamReader &reader, RichString &richString)
@@ -382,6 +454,13 @@ Format SharedStrings::readRichStringPart_rPr(QXmlStreamReader &reader)
 }
 
 bool SharedStrings::loadFromXmlFile(QIODevice *device)
+{
+    if (m_lazyLoad)
+        return loadFromXmlData(device->readAll());
+    return readStrings(device);
+}
+
+bool SharedStrings::readStrings(QIODevice *device)
 {
     QXmlStreamReader reader(device);
     int count = 0;
@@ -412,4 +491,169 @@ bool SharedStrings::loadFromXmlFile(QIODevice *device)
     return true;
 }
 
+bool SharedStrings::loadFromXmlData(const QByteArray &data)
+{
+    if (m_lazyLoad) {
+        m_xmlData = data;
+        if (indexStrings())
+            return true;
+        // Not a part indexStrings() knows, read it as a whole
+        m_xmlData.clear();
+        m_lazyStrings.clear();
+
+        QBuffer buffer;
+        buffer.setData(data);
+        buffer.open(QIODevice::ReadOnly);
+        return readStrings(&buffer);
+    }
+    return AbstractOOXmlFile::loadFromXmlData(data);
+}
+
+/*
+ * Find the <si> elements of m_xmlData. Only UTF-8 parts without
+ * comments, processing instructions, CDATA sections or namespace
+ * prefixes are indexed; other parts are read by readStrings().
+ */
+bool SharedStrings::indexStrings()
+{
+    const char *begin = m_xmlData.constData();
+    const char *end = begin + m_xmlData.size();
+    if (!SheetDataReader::isUtf8(begin, end))
+        return false;
+
+    const QByteArrayView data(begin, end - begin);
+    qsizetype pos = data.startsWith("\xef\xbb\xbf") ? 3 : 0;
+    if (data.sliced(pos).startsWith("<?xml")) {
+        pos = data.indexOf("?>", pos);
+        if (pos < 0)
+            return false;
+        pos += 2;
+    }
+    if (data.indexOf("<!", pos) >= 0 || data.indexOf("<?", pos) >= 0)
+        return false;
+
+    while (pos < data.size() && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\r'
+                                 || data[pos] == '\n'))
+        ++pos;
+    if (!data.sliced(pos).startsWith("<sst") || pos + 4 >= data.size()
+        || (data[pos + 4] != '>' && data[pos + 4] != ' ' && data[pos + 4] != '\t'
+            && data[pos + 4] != '\r' && data[pos + 4] != '\n'))
+        return false;
+    const qsizetype sstEnd = data.indexOf('>', pos);
+    if (sstEnd < 0)
+        return false;
+
+    // The uniqueCount attribute, checked as loadFromXmlFile() does
+    int uniqueCount = -1;
+    const qsizetype countPos = data.sliced(pos, sstEnd - pos).indexOf(" uniqueCount=");
+    if (countPos >= 0) {
+        const qsizetype value = pos + countPos + 14;
+        const qsizetype valueEnd = value < sstEnd ? data.indexOf(data[value - 1], value) : -1;
+        if (valueEnd < 0 || valueEnd > sstEnd)
+            return false;
+        bool ok;
+        uniqueCount = data.sliced(value, valueEnd - value).toInt(&ok);
+        if (!ok)
+            return false;
+    }
+
+    pos = sstEnd + 1;
+    for (;;) {
+        pos = data.indexOf('<', pos);
+        if (pos < 0)
+            return false;
+        const QByteArrayView tag = data.sliced(pos);
+        if (tag.startsWith("</sst"))
+            break;
+        if (!tag.startsWith("<si") || tag.size() < 4
+            || (tag[3] != '>' && tag[3] != '/' && tag[3] != ' '))
+            return false;
+
+        const qsizetype startEnd = data.indexOf('>', pos);
+        if (startEnd < 0)
+            return false;
+        LazyString string;
+        string.begin = startEnd + 1;
+        string.size = 0;
+        string.count = 0;
+        if (data[startEnd - 1] == '/') {
+            pos = startEnd + 1;
+        } else {
+            const qsizetype close = data.indexOf("</si>", startEnd);
+            if (close < 0)
+                return false;
+            string.size = int(close - string.begin);
+            pos = close + 5;
+        }
+        m_lazyStrings.append(string);
+    }
+
+    return uniqueCount < 0 || m_lazyStrings.size() == uniqueCount;
+}
+
+/*
+ * Decode the string at \a index of the retained part. A lone <t> is
+ * decoded here, anything else through QXmlStreamReader.
+ */
+RichString SharedStrings::decodeString(int index) const
+{
+    const LazyString &string = m_lazyStrings[index];
+    const char *begin = m_xmlData.constData() + string.begin;
+    const char *end = begin + string.size;
+    RichString richString;
+    if (begin == end) // <si/>
+        return richString;
+
+    if (end - begin >= 4 && memcmp(begin, "<t", 2) == 0
+        && (begin[2] == '>' || begin[2] == ' ' || begin[2] == '/')) {
+        const char *startEnd = static_cast<const char *>(memchr(begin, '>', size_t(end - begin)));
+        if (startEnd && startEnd + 1 == end && startEnd[-1] == '/') { // <t/>
+            richString.addFragment(QString(), Format());
+            return richString;
+        }
+        const char *text = startEnd ? startEnd + 1 : end;
+        const char *textEnd = end - 4;
+        QByteArray decoded;
+        if (text <= textEnd && memcmp(textEnd, "</t>", 4) == 0
+            && !memchr(text, '<', size_t(textEnd - text))
+            && SheetDataReader::decodeText(text, textEnd, &decoded)) {
+            richString.addFragment(QString::fromUtf8(decoded), Format());
+            return richString;
+        }
+    }
+
+    QByteArray xml;
+    xml.reserve(string.size + 9);
+    xml.append("<si>").append(begin, string.size).append("</si>");
+    QXmlStreamReader reader(xml);
+    reader.readNextStartElement();
+    return readRichString(reader);
+}
+
+/*
+ * Decode all the strings of the retained part into the table, which
+ * is then used the usual way.
+ */
+void SharedStrings::buildTable()
+{
+    if (m_lazyStrings.isEmpty())
+        return;
+
+    m_stringList.reserve(m_lazyStrings.size());
+    for (int i = 0; i < m_lazyStrings.size(); ++i) {
+        const RichString richString = decodeString(i);
+        // As readString() and incRefByStringIndex() leave it
+        QHash<RichString, XlsxSharedStringInfo>::iterator it = m_stringTable.find(richString);
+        if (it == m_stringTable.end()) {
+            m_stringTable.insert(richString, XlsxSharedStringInfo(i, m_lazyStrings[i].count));
+        } else {
+            it.value().index = i;
+            it.value().count += m_lazyStrings[i].count;
+        }
+        m_stringList.append(richString);
+    }
+    m_lazyStrings.clear();
+    m_xmlData.clear();
+}
+
 } // namespace
@@ -73,26 +73,50 @@ public:
     int addSharedString(const RichString &string);
     void removeSharedString(const QString &string);
     void removeSharedString(const RichString &string);
-    void incRefByStringIndex(int idx);
+    void incRefByStringIndex(int idx, int count = 1);
 
     int getSharedStringIndex(const QString &string) const;
     int getSharedStringIndex(const RichString &string) const;
     RichString getSharedString(int index) const;
     QList<RichString> getSharedStrings() const;
 
+    void setLazyLoad(bool lazy);
+    bool isLazyLoad() const;
+
     void saveToXmlFile(QIODevice *device) const;
     bool loadFromXmlFile(QIODevice *device);
+    bool loadFromXmlData(const QByteArray &data);
 
 private:
+    // A <si> of the retained part, decoded when it is asked for
+    struct LazyString
+    {
+        qsizetype begin; // content of the <si>
+        int size;
+        int count; // references added by incRefByStringIndex()
+    };
+
     void readString(QXmlStreamReader &reader); // <si>
-    void readRichStringPart(QXmlStreamReader &reader, RichString &rich); // <r>
-    void readPlainStringPart(QXmlStreamReader &reader, RichString &rich); // <v>
-    Format readRichStringPart_rPr(QXmlStreamReader &reader);
+    static RichString readRichString(QXmlStreamReader &reader); // <si>
+    static void readRichStringPart(QXmlStreamReader &reader, RichString &rich); // <r>
+    static void readPlainStringPart(QXmlStreamReader &reader, RichString &rich); // <v>
+    static Format readRichStringPart_rPr(QXmlStreamReader &reader);
     void writeRichStringPart_rPr(QXmlStreamWriter &writer, const Format &format) const;
 
+    bool readStrings(QIODevice *device);
+    bool indexStrings();
+    RichString decodeString(int index) const;
+    void buildTable();
+
     QHash<RichString, XlsxSharedStringInfo> m_stringTable; // for fast lookup
     QList<RichString> m_stringList;
     int m_stringCount;
+
+    // Lazy load: the part and the place of every string in it, until
+    // the table is modified
+    bool m_lazyLoad;
+    QByteArray m_xmlData;
+    QList<LazyString> m_lazyStrings;
 };
 }
 #endif // XLSXSHAREDSTRINGS_H
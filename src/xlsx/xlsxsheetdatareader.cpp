@@ -0,0 +1,705 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#include "xlsxsheetdatareader_p.h"
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+enum Match { NoMatch, Matched, Partial };
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+inline const char *skipSpaces(const char *p, const char *end)
+{
+    while (p < end && isSpace(*p))
+        ++p;
+    return p;
+}
+
+/*
+  Whether the markup at \a p starts with \a tag, such as "<row" or
+  "</c", followed by the end of the element name. Partial when the
+  buffer ends before that can be told.
+*/
+Match matchTag(const char *p, const char *end, const char *tag, int size)
+{
+    const qsizetype available = end - p;
+    if (available <= size)
+        return memcmp(p, tag, size_t(available)) == 0 ? Partial : NoMatch;
+    if (memcmp(p, tag, size_t(size)) != 0)
+        return NoMatch;
+    const char c = p[size];
+    return isSpace(c) || c == '>' || c == '/' ? Matched : NoMatch;
+}
+
+const char *findBytes(const char *p, const char *end, const char *needle, int size)
+{
+    while (end - p >= size) {
+        p = static_cast<const char *>(memchr(p, needle[0], size_t(end - p - size + 1)));
+        if (!p)
+            return 0;
+        if (memcmp(p, needle, size_t(size)) == 0)
+            return p;
+        ++p;
+    }
+    return 0;
+}
+
+void appendUtf8(QByteArray *out, uint code)
+{
+    if (code < 0x80) {
+        out->append(char(code));
+    } else if (code < 0x800) {
+        out->append(char(0xc0 | (code >> 6)));
+        out->append(char(0x80 | (code & 0x3f)));
+    } else if (code < 0x10000) {
+        out->append(char(0xe0 | (code >> 12)));
+        out->append(char(0x80 | ((code >> 6) & 0x3f)));
+        out->append(char(0x80 | (code & 0x3f)));
+    } else {
+        out->append(char(0xf0 | (code >> 18)));
+        out->append(char(0x80 | ((code >> 12) & 0x3f)));
+        out->append(char(0x80 | ((code >> 6) & 0x3f)));
+        out->append(char(0x80 | (code & 0x3f)));
+    }
+}
+
+inline bool isXmlChar(uint code)
+{
+    return code == 0x9 || code == 0xa || code == 0xd || (code >= 0x20 && code <= 0xd7ff)
+           || (code >= 0xe000 && code <= 0xfffd) || (code >= 0x10000 && code <= 0x10ffff);
+}
+
+} // namespace
+
+/*
+  Creates a reader of the worksheet part read from \a source, which
+  reports the rows and cells of <sheetData> to \a handler.
+*/
+SheetDataReader::SheetDataReader(QIODevice *source, Handler *handler)
+    : m_source(source)
+    , m_handler(handler)
+    , m_state(Head)
+    , m_pos(0)
+    , m_emitEnd(0)
+    , m_searchPos(0)
+    , m_encodingChecked(false)
+    , m_sourceAtEnd(false)
+    , m_sheetDataRead(false)
+{
+    open(QIODevice::ReadOnly);
+}
+
+SheetDataReader::~SheetDataReader()
+{
+}
+
+/*
+  Returns true when all of <sheetData> has been read by this reader,
+  rather than passed through.
+*/
+bool SheetDataReader::isSheetDataRead() const
+{
+    return m_sheetDataRead;
+}
+
+qint64 SheetDataReader::readData(char *data, qint64 maxSize)
+{
+    if (m_state == Head && m_pos == m_emitEnd)
+        scanHead();
+    if (m_state == Body && m_pos == m_emitEnd)
+        readSheetData();
+
+    const qsizetype available = (m_state == PassThrough ? m_buffer.size() : m_emitEnd) - m_pos;
+    if (available > 0) {
+        const qsizetype size = qsizetype(qMin<qint64>(available, maxSize));
+        memcpy(data, m_buffer.constData() + m_pos, size_t(size));
+        m_pos += size;
+        return size;
+    }
+    if (m_state != PassThrough || m_sourceAtEnd)
+        return 0;
+    if (!m_buffer.isEmpty()) {
+        m_buffer = QByteArray();
+        m_pos = 0;
+    }
+    return m_source->read(data, maxSize);
+}
+
+/*
+  Append the next chunk of the source to the buffer, dropping the
+  bytes before m_pos. Returns false at the end of the source.
+*/
+bool SheetDataReader::fill()
+{
+    if (m_sourceAtEnd)
+        return false;
+    if (m_pos > 0) {
+        m_buffer.remove(0, m_pos);
+        m_emitEnd = qMax<qsizetype>(0, m_emitEnd - m_pos);
+        m_searchPos = qMax<qsizetype>(0, m_searchPos - m_pos);
+        m_pos = 0;
+    }
+    const qsizetype size = m_buffer.size();
+    m_buffer.resize(size + ChunkSize);
+    const qint64 read = m_source->read(m_buffer.data() + size, ChunkSize);
+    m_buffer.resize(size + qsizetype(qMax<qint64>(read, 0)));
+    if (read <= 0) {
+        m_sourceAtEnd = true;
+        return false;
+    }
+    return true;
+}
+
+/*
+  Only UTF-8 parts are read here, which is what Excel writes. [\a p,
+  \a end) is the start of the part, all of it when \a atEnd is set.
+*/
+SheetDataReader::Status SheetDataReader::checkEncoding(const char *p, const char *end,
+                                                       bool atEnd)
+{
+    if (end - p >= 3 && memcmp(p, "\xef\xbb\xbf", 3) == 0)
+        p += 3;
+    if (end - p < 5)
+        return atEnd ? Unusual : NeedMore;
+    if (memcmp(p, "<?xml", 5) != 0)
+        return *p == '<' ? Ok : Unusual; // UTF-16 or UTF-32 otherwise
+
+    const char *close = findBytes(p, end, "?>", 2);
+    if (!close)
+        return atEnd || end - p > 1024 ? Unusual : NeedMore;
+    const char *encoding = findBytes(p, close, "encoding", 8);
+    if (!encoding)
+        return Ok;
+    const char *q = skipSpaces(encoding + 8, close);
+    if (q == close || *q != '=')
+        return Unusual;
+    q = skipSpaces(q + 1, close);
+    if (q == close || (*q != '"' && *q != '\''))
+        return Unusual;
+    const char *value = q + 1;
+    const char *valueEnd = static_cast<const char *>(memchr(value, *q, size_t(close - value)));
+    if (!valueEnd)
+        return Unusual;
+    const qsizetype size = valueEnd - value;
+    if ((size == 5 && qstrnicmp(value, "utf-8", 5) == 0)
+        || (size == 4 && qstrnicmp(value, "utf8", 4) == 0))
+        return Ok;
+    return Unusual;
+}
+
+/*
+  Look for the <sheetData> start tag. The bytes before it are handed
+  out as they are found; after the start tag the reader switches to
+  the Body state.
+*/
+void SheetDataReader::scanHead()
+{
+    for (;;) {
+        if (!m_encodingChecked) {
+            const Status status = checkEncoding(m_buffer.constData(),
+                                                m_buffer.constData() + m_buffer.size(),
+                                                m_sourceAtEnd);
+            if (status == NeedMore && fill())
+                continue;
+            if (status != Ok) {
+                m_state = PassThrough;
+                return;
+            }
+            m_encodingChecked = true;
+        }
+
+        const char *begin = m_buffer.constData();
+        const char *end = begin + m_buffer.size();
+        while (m_searchPos < m_buffer.size()) {
+            const char *lt = static_cast<const char *>(
+                memchr(begin + m_searchPos, '<', size_t(m_buffer.size() - m_searchPos)));
+            if (!lt) {
+                m_searchPos = m_emitEnd = m_buffer.size();
+                break;
+            }
+            m_searchPos = m_emitEnd = lt - begin;
+            if (end - lt < 2)
+                break;
+            // Comments, CDATA sections and DTDs are left to the QXmlStreamReader
+            if (lt[1] == '!') {
+                m_state = PassThrough;
+                return;
+            }
+            const Match match = matchTag(lt, end, "<sheetData", 10);
+            if (match == Partial)
+                break;
+            if (match == Matched) {
+                const char *p = lt + 10;
+                int count;
+                bool empty;
+                const Status status = readAttributes(p, end, m_attributes, &count, &empty);
+                if (status == NeedMore)
+                    break;
+                if (status != Ok || empty) {
+                    m_state = PassThrough;
+                    return;
+                }
+                m_emitEnd = p - begin;
+                m_state = Body;
+                return;
+            }
+            ++m_searchPos;
+        }
+
+        if (m_emitEnd > m_pos)
+            return;
+        if (!fill()) {
+            m_state = PassThrough;
+            return;
+        }
+    }
+}
+
+/*
+  Read the rows and cells up to </sheetData>, which is passed through
+  with the rest of the part. At the first element not known here, the
+  remaining content of <sheetData> is passed through too; a <row> start
+  tag is inserted when that happens inside a row, since the row has
+  already been read. When the handler stops at a row, the rest of the
+  content is skipped.
+*/
+void SheetDataReader::readSheetData()
+{
+    bool inRow = false;
+    for (;;) {
+        const char *begin = m_buffer.constData();
+        const char *end = begin + m_buffer.size();
+        const char *p = skipSpaces(begin + m_pos, end);
+        m_pos = p - begin;
+
+        const Status status = p == end ? NeedMore : readElement(p, end, &inRow);
+        if (status == Ok) {
+            m_pos = p - begin;
+            continue;
+        }
+        if (status == NeedMore && fill())
+            continue;
+
+        if (status == Stopped) {
+            skipSheetData();
+            return;
+        }
+        if (status == Done)
+            m_sheetDataRead = true;
+        else if (inRow)
+            m_buffer.insert(m_pos, "<row>", 5);
+        m_state = PassThrough;
+        return;
+    }
+}
+
+/*
+  Drop everything up to </sheetData>, which is passed through with the
+  rest of the part. Only the bytes are searched, the markup in between
+  is not parsed.
+*/
+void SheetDataReader::skipSheetData()
+{
+    static const char endTag[] = "</sheetData";
+    const int size = int(sizeof(endTag)) - 1;
+    for (;;) {
+        const char *begin = m_buffer.constData();
+        const char *end = begin + m_buffer.size();
+        if (const char *found = findBytes(begin + m_pos, end, endTag, size)) {
+            m_pos = found - begin;
+            m_sheetDataRead = true;
+            break;
+        }
+        // The end tag may be split between this chunk and the next one
+        m_pos = qMax(m_pos, m_buffer.size() - (size - 1));
+        if (!fill())
+            break;
+    }
+    m_state = PassThrough;
+}
+
+/*
+  Read the element at \a p, which is not a space. \a p is moved past
+  the element only when Ok is returned.
+*/
+SheetDataReader::Status SheetDataReader::readElement(const char *&p, const char *end, bool *inRow)
+{
+    if (*p != '<')
+        return Unusual;
+
+    Match match = matchTag(p, end, "</sheetData", 11);
+    if (match != NoMatch)
+        return match == Matched ? Done : NeedMore;
+
+    if (*inRow) {
+        match = matchTag(p, end, "<c", 2);
+        if (match != NoMatch)
+            return match == Matched ? readCell(p, end) : NeedMore;
+        match = matchTag(p, end, "</row", 5);
+        if (match != Matched)
+            return match == Partial ? NeedMore : Unusual;
+        const char *q = skipSpaces(p + 5, end);
+        if (q == end)
+            return NeedMore;
+        if (*q != '>')
+            return Unusual;
+        p = q + 1;
+        *inRow = false;
+        return Ok;
+    }
+
+    match = matchTag(p, end, "<row", 4);
+    if (match != Matched)
+        return match == Partial ? NeedMore : Unusual;
+    const char *q = p + 4;
+    Row row;
+    bool empty;
+    const Status status = readAttributes(q, end, m_attributes, &row.attributeCount, &empty);
+    if (status != Ok)
+        return status;
+    row.attributes = m_attributes;
+    if (!m_handler->row(row))
+        return Stopped;
+    *inRow = !empty;
+    p = q;
+    return Ok;
+}
+
+/*
+  Read the <c> element at \a p, and hand it to the handler once it has
+  been read completely.
+*/
+SheetDataReader::Status SheetDataReader::readCell(const char *&p, const char *end)
+{
+    const char *q = p + 2;
+    Attribute *attributes = m_attributes;
+    int count;
+    bool empty;
+    Status status = readAttributes(q, end, attributes, &count, &empty);
+    if (status != Ok)
+        return status;
+
+    Cell cell;
+    for (int i = 0; i < count; ++i) {
+        if (attributes[i].name.size() != 1)
+            continue;
+        switch (attributes[i].name.data()[0]) {
+        case 'r':
+            cell.reference = attributes[i].value;
+            break;
+        case 's':
+            cell.style = attributes[i].value;
+            break;
+        case 't':
+            cell.type = attributes[i].value;
+            break;
+        default:
+            break;
+        }
+    }
+
+    while (!empty) {
+        q = skipSpaces(q, end);
+        if (q == end)
+            return NeedMore;
+        if (*q != '<')
+            return Unusual;
+
+        Match match = matchTag(q, end, "</c", 3);
+        if (match == Matched) {
+            q = skipSpaces(q + 3, end);
+            if (q == end)
+                return NeedMore;
+            if (*q != '>')
+                return Unusual;
+            ++q;
+            break;
+        }
+        if (match == Partial)
+            return NeedMore;
+
+        bool emptyChild;
+        if ((match = matchTag(q, end, "<v", 2)) == Matched) {
+            q += 2;
+            if ((status = readAttributes(q, end, attributes, &count, &emptyChild)) != Ok)
+                return status;
+            cell.value = QByteArrayView(q, 0);
+            if (!emptyChild
+                && (status = readText(q, end, "v", 1, &cell.value, &m_valueText)) != Ok)
+                return status;
+            cell.hasValue = true;
+        } else if (match == Partial) {
+            return NeedMore;
+        } else if ((match = matchTag(q, end, "<f", 2)) == Matched) {
+            if (cell.hasFormula)
+                return Unusual;
+            q += 2;
+            if ((status = readAttributes(q, end, attributes, &count, &emptyChild)) != Ok)
+                return status;
+            for (int i = 0; i < count; ++i) {
+                const QByteArrayView name = attributes[i].name;
+                if (name.size() == 1 && name.data()[0] == 't')
+                    cell.formulaType = attributes[i].value;
+                else if (name.size() == 3 && memcmp(name.data(), "ref", 3) == 0)
+                    cell.formulaReference = attributes[i].value;
+                else if (name.size() == 2 && memcmp(name.data(), "si", 2) == 0)
+                    cell.formulaIndex = attributes[i].value;
+            }
+            cell.formula = QByteArrayView(q, 0);
+            if (!emptyChild
+                && (status = readText(q, end, "f", 1, &cell.formula, &m_formulaText)) != Ok)
+                return status;
+            cell.hasFormula = true;
+        } else if (match == Partial) {
+            return NeedMore;
+        } else if ((match = matchTag(q, end, "<is", 3)) == Matched) {
+            q += 3;
+            if ((status = readAttributes(q, end, attributes, &count, &emptyChild)) != Ok)
+                return status;
+            // Only plain text is known here, <r> runs and <rPh> are not.
+            while (!emptyChild) {
+                q = skipSpaces(q, end);
+                if (q == end)
+                    return NeedMore;
+                match = matchTag(q, end, "</is", 4);
+                if (match == Matched) {
+                    q = skipSpaces(q + 4, end);
+                    if (q == end)
+                        return NeedMore;
+                    if (*q != '>')
+                        return Unusual;
+                    ++q;
+                    break;
+                }
+                if (match == Partial)
+                    return NeedMore;
+                match = matchTag(q, end, "<t", 2);
+                if (match != Matched)
+                    return match == Partial ? NeedMore : Unusual;
+                q += 2;
+                bool emptyText;
+                if ((status = readAttributes(q, end, attributes, &count, &emptyText)) != Ok)
+                    return status;
+                cell.value = QByteArrayView(q, 0);
+                if (!emptyText
+                    && (status = readText(q, end, "t", 1, &cell.value, &m_valueText)) != Ok)
+                    return status;
+                cell.hasValue = true;
+            }
+        } else {
+            return match == Partial ? NeedMore : Unusual;
+        }
+    }
+
+    p = q;
+    m_handler->cell(cell);
+    return Ok;
+}
+
+/*
+  Read the attributes of a start tag, \a p is just after the element
+  name and is moved past the end of the tag. Values with entity
+  references or white space characters, which would have to be
+  normalized, are Unusual.
+*/
+SheetDataReader::Status SheetDataReader::readAttributes(const char *&p, const char *end,
+                                                        Attribute *attributes, int *count,
+                                                        bool *empty)
+{
+    const char *q = p;
+    int n = 0;
+    for (;;) {
+        q = skipSpaces(q, end);
+        if (q == end)
+            return NeedMore;
+        if (*q == '>') {
+            ++q;
+            *empty = false;
+            break;
+        }
+        if (*q == '/') {
+            if (end - q < 2)
+                return NeedMore;
+            if (q[1] != '>')
+                return Unusual;
+            q += 2;
+            *empty = true;
+            break;
+        }
+
+        const char *name = q;
+        while (q < end && *q != '=' && *q != '>' && *q != '/' && !isSpace(*q))
+            ++q;
+        const char *nameEnd = q;
+        q = skipSpaces(q, end);
+        if (q == end)
+            return NeedMore;
+        if (*q != '=' || name == nameEnd)
+            return Unusual;
+        q = skipSpaces(q + 1, end);
+        if (q == end)
+            return NeedMore;
+        if (*q != '"' && *q != '\'')
+            return Unusual;
+        const char *value = q + 1;
+        const char *valueEnd = static_cast<const char *>(memchr(value, *q, size_t(end - value)));
+        if (!valueEnd)
+            return NeedMore;
+        for (const char *c = value; c < valueEnd; ++c) {
+            if (*c == '&' || *c == '<' || *c == '\t' || *c == '\n' || *c == '\r')
+                return Unusual;
+        }
+        if (n == MaxAttributes)
+            return Unusual;
+        attributes[n].name = QByteArrayView(name, nameEnd - name);
+        attributes[n].value = QByteArrayView(value, valueEnd - value);
+        ++n;
+
+        q = valueEnd + 1;
+        if (q < end && *q != '>' && *q != '/' && !isSpace(*q))
+            return Unusual;
+    }
+    *count = n;
+    p = q;
+    return Ok;
+}
+
+/*
+  Read the text of the element \a name up to and including its end tag,
+  \a p is just after the start tag. The text is decoded into \a scratch
+  when it has references or carriage returns.
+*/
+SheetDataReader::Status SheetDataReader::readText(const char *&p, const char *end,
+                                                  const char *name, int nameSize,
+                                                  QByteArrayView *text, QByteArray *scratch)
+{
+    const char *lt = static_cast<const char *>(memchr(p, '<', size_t(end - p)));
+    if (!lt)
+        return NeedMore;
+    if (end - lt < nameSize + 3)
+        return NeedMore;
+    if (lt[1] != '/' || memcmp(lt + 2, name, size_t(nameSize)) != 0)
+        return Unusual;
+    const char *q = skipSpaces(lt + 2 + nameSize, end);
+    if (q == end)
+        return NeedMore;
+    if (*q != '>')
+        return Unusual;
+
+    const size_t size = size_t(lt - p);
+    if (memchr(p, '&', size) || memchr(p, '\r', size)) {
+        if (!decodeText(p, lt, scratch))
+            return Unusual;
+        *text = QByteArrayView(scratch->constData(), scratch->size());
+    } else {
+        *text = QByteArrayView(p, lt - p);
+    }
+    p = q + 1;
+    return Ok;
+}
+
+/*
+  Returns true if the whole part [\a begin, \a end) is UTF-8 encoded.
+*/
+bool SheetDataReader::isUtf8(const char *begin, const char *end)
+{
+    return checkEncoding(begin, end, true) == Ok;
+}
+
+/*
+  Replace the predefined entities and the character references of the
+  text [\a begin, \a end) and normalize its line ends, as an XML parser
+  does. Returns false for any other reference.
+*/
+bool SheetDataReader::decodeText(const char *begin, const char *end, QByteArray *out)
+{
+    out->resize(0);
+    out->reserve(end - begin);
+    for (const char *p = begin; p < end; ++p) {
+        if (*p == '\r') {
+            out->append('\n');
+            if (p + 1 < end && p[1] == '\n')
+                ++p;
+            continue;
+        }
+        if (*p != '&') {
+            out->append(*p);
+            continue;
+        }
+
+        const char *name = p + 1;
+        const char *semicolon = static_cast<const char *>(memchr(name, ';', size_t(end - name)));
+        if (!semicolon)
+            return false;
+        const qsizetype size = semicolon - name;
+        if (size == 2 && memcmp(name, "lt", 2) == 0) {
+            out->append('<');
+        } else if (size == 2 && memcmp(name, "gt", 2) == 0) {
+            out->append('>');
+        } else if (size == 3 && memcmp(name, "amp", 3) == 0) {
+            out->append('&');
+        } else if (size == 4 && memcmp(name, "quot", 4) == 0) {
+            out->append('"');
+        } else if (size == 4 && memcmp(name, "apos", 4) == 0) {
+            out->append('\'');
+        } else if (size > 1 && name[0] == '#') {
+            const bool hex = name[1] == 'x';
+            const char *digit = name + (hex ? 2 : 1);
+            if (digit == semicolon)
+                return false;
+            uint code = 0;
+            for (; digit < semicolon; ++digit) {
+                uint value;
+                if (*digit >= '0' && *digit <= '9')
+                    value = uint(*digit - '0');
+                else if (hex && *digit >= 'a' && *digit <= 'f')
+                    value = uint(*digit - 'a' + 10);
+                else if (hex && *digit >= 'A' && *digit <= 'F')
+                    value = uint(*digit - 'A' + 10);
+                else
+                    return false;
+                code = code * (hex ? 16 : 10) + value;
+                if (code > 0x10ffff)
+                    return false;
+            }
+            if (!isXmlChar(code))
+                return false;
+            appendUtf8(out, code);
+        } else {
+            return false;
+        }
+        p = semicolon;
+    }
+    return true;
+}
+
+QT_END_NAMESPACE_XLSX
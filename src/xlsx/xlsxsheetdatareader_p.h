@@ -0,0 +1,160 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+
+#ifndef XLSXSHEETDATAREADER_P_H
+#define XLSXSHEETDATAREADER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QIODevice>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+  Byte level reader of the <row> and <c> elements of <sheetData>.
+
+  The reader is a sequential device in front of a worksheet part. All
+  of the part is passed through to the QXmlStreamReader reading the
+  device, except the content of <sheetData>: it is scanned as UTF-8
+  here and every row and cell is handed to the Handler, without any
+  QString or QXmlStreamAttributes.
+
+  Only the usual markup of <row>, <c>, <v>, <f> and <is><t> is known
+  here. At anything else, such as comments, CDATA sections, namespace
+  prefixes or <extLst>, the rest of <sheetData> is passed through from
+  the start of that element, so the QXmlStreamReader sees it as well.
+
+  When Handler::row() returns false, that row and the rest of the
+  content of <sheetData> are skipped without being parsed.
+*/
+class XLSX_AUTOTEST_EXPORT SheetDataReader : public QIODevice
+{
+public:
+    struct Attribute
+    {
+        QByteArrayView name;
+        QByteArrayView value;
+    };
+
+    // The start tag of a <row>, valid during Handler::row().
+    struct Row
+    {
+        const Attribute *attributes;
+        int attributeCount;
+    };
+
+    // One <c> element, valid during Handler::cell(). The attribute
+    // views are null when the attribute is missing; texts are decoded.
+    struct Cell
+    {
+        Cell()
+            : hasValue(false)
+            , hasFormula(false)
+        {
+        }
+
+        QByteArrayView reference; // "r"
+        QByteArrayView style; // "s"
+        QByteArrayView type; // "t"
+        QByteArrayView value; // text of <v>, or of <is><t>
+        bool hasValue;
+        bool hasFormula;
+        QByteArrayView formula; // text of <f>
+        QByteArrayView formulaType; // "t" of <f>
+        QByteArrayView formulaReference; // "ref" of <f>
+        QByteArrayView formulaIndex; // "si" of <f>
+    };
+
+    class Handler
+    {
+    public:
+        virtual ~Handler() {}
+        // Returns false when no more rows are needed
+        virtual bool row(const Row &row) = 0;
+        virtual void cell(const Cell &cell) = 0;
+    };
+
+    SheetDataReader(QIODevice *source, Handler *handler);
+    ~SheetDataReader();
+
+    bool isSequential() const override { return true; }
+    bool isSheetDataRead() const;
+
+    static bool isUtf8(const char *begin, const char *end);
+    static bool decodeText(const char *begin, const char *end, QByteArray *out);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    enum State { Head, Body, PassThrough };
+    enum Status { Ok, NeedMore, Unusual, Done, Stopped };
+    enum { ChunkSize = 64 * 1024, MaxAttributes = 16 };
+
+    bool fill();
+    void scanHead();
+    static Status checkEncoding(const char *p, const char *end, bool atEnd);
+    void readSheetData();
+    void skipSheetData();
+    Status readElement(const char *&p, const char *end, bool *inRow);
+    Status readCell(const char *&p, const char *end);
+    static Status readAttributes(const char *&p, const char *end, Attribute *attributes,
+                                 int *count, bool *empty);
+    static Status readText(const char *&p, const char *end, const char *name, int nameSize,
+                           QByteArrayView *text, QByteArray *scratch);
+
+    QIODevice *m_source;
+    Handler *m_handler;
+    State m_state;
+    QByteArray m_buffer;
+    qsizetype m_pos; // first byte not handed out or parsed yet
+    qsizetype m_emitEnd; // end of the head bytes which can be handed out
+    qsizetype m_searchPos; // where to look for <sheetData> next
+    bool m_encodingChecked;
+    bool m_sourceAtEnd;
+    bool m_sheetDataRead;
+    Attribute m_attributes[MaxAttributes];
+    QByteArray m_valueText;
+    QByteArray m_formulaText;
+
+    Q_DISABLE_COPY(SheetDataReader)
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXSHEETDATAREADER_P_H
@@ -0,0 +1,401 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#include "xlsxsheetdatawriter_p.h"
+#include "xlsxutility_p.h"
+
+#include <QIODevice>
+#include <QXmlStreamWriter>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+/*
+  Names of all the columns of a worksheet, "A" to "XFD".
+*/
+struct ColumnNames
+{
+    enum { MaxColumns = 16384 };
+
+    ColumnNames()
+    {
+        for (int column = 1; column <= MaxColumns; ++column) {
+            char buffer[3];
+            int size = 0;
+            for (int c = column; c > 0; c = (c - 1) / 26)
+                buffer[size++] = char('A' + (c - 1) % 26);
+            sizes[column - 1] = char(size);
+            for (int i = 0; i < size; ++i)
+                names[column - 1][i] = buffer[size - 1 - i];
+        }
+    }
+
+    char names[MaxColumns][3];
+    char sizes[MaxColumns];
+};
+
+const ColumnNames &columnNames()
+{
+    static const ColumnNames table;
+    return table;
+}
+
+} // namespace
+
+SheetDataWriter::SheetDataWriter(QXmlStreamWriter &writer)
+    : m_writer(writer)
+    , m_device(writer.device())
+    , m_size(0)
+    , m_numberPrecision(15)
+    , m_inStartTag(false)
+    , m_rowHasCells(false)
+{
+    Q_ASSERT(m_device);
+    m_writer.writeCharacters(QString()); // close the pending start tag of the writer
+    m_buffer.resize(BufferSize);
+}
+
+SheetDataWriter::~SheetDataWriter()
+{
+    flush();
+}
+
+/*
+  Sets the number of significant digits of the numeric values to
+  \a precision, 0 for the shortest exact representation.
+ */
+void SheetDataWriter::setNumberPrecision(int precision)
+{
+    m_numberPrecision = precision;
+}
+
+int SheetDataWriter::numberPrecision() const
+{
+    return m_numberPrecision;
+}
+
+/*
+  Writes the digits of \a value to \a out, returns the number of bytes written.
+  \a out must have room for 11 characters.
+ */
+int SheetDataWriter::formatInteger(char *out, int value)
+{
+    char buffer[12];
+    char *end = buffer + sizeof(buffer);
+    char *p = end;
+    unsigned int v = value < 0 ? 0u - unsigned(value) : unsigned(value);
+    do {
+        *--p = char('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0)
+        *--p = '-';
+    const int size = int(end - p);
+    memcpy(out, p, size);
+    return size;
+}
+
+/*
+  Writes the name of \a column, such as "XFD", to \a out. \a out must have
+  room for 3 characters.
+ */
+int SheetDataWriter::formatColumn(char *out, int column)
+{
+    if (column < 1 || column > ColumnNames::MaxColumns)
+        return 0;
+    const ColumnNames &table = columnNames();
+    const int size = table.sizes[column - 1];
+    memcpy(out, table.names[column - 1], size);
+    return size;
+}
+
+char *SheetDataWriter::reserve(int size)
+{
+    if (m_size + size > m_buffer.size()) {
+        flush();
+        if (size > m_buffer.size())
+            m_buffer.resize(size);
+    }
+    return m_buffer.data() + m_size;
+}
+
+void SheetDataWriter::append(const char *data, int size)
+{
+    memcpy(reserve(size), data, size);
+    m_size += size;
+}
+
+void SheetDataWriter::append(char c)
+{
+    *reserve(1) = c;
+    ++m_size;
+}
+
+void SheetDataWriter::closeStartTag()
+{
+    if (m_inStartTag) {
+        append('>');
+        m_inStartTag = false;
+    }
+}
+
+/*
+  Same escaping as QXmlStreamWriter. Characters which are not allowed
+  in XML are dropped.
+ */
+void SheetDataWriter::writeEscaped(const QString &text, bool attribute)
+{
+    const QChar *it = text.constData();
+    const QChar *end = it + text.size();
+    while (it != end) {
+        // Plain ASCII runs are copied in one go
+        char *out = reserve(int(end - it) < 256 ? int(end - it) : 256);
+        const QChar *runEnd = it + (int(end - it) < 256 ? int(end - it) : 256);
+        int size = 0;
+        for (; it != runEnd; ++it) {
+            const ushort u = it->unicode();
+            if (u >= 0x80 || u < 0x20 || u == '<' || u == '>' || u == '&'
+                || (attribute && u == '"'))
+                break;
+            out[size++] = char(u);
+        }
+        m_size += size;
+        if (it == runEnd)
+            continue;
+
+        const ushort u = it->unicode();
+        ++it;
+        switch (u) {
+        case '<':
+            append("&lt;", 4);
+            break;
+        case '>':
+            append("&gt;", 4);
+            break;
+        case '&':
+            append("&amp;", 5);
+            break;
+        case '"':
+            append("&quot;", 6);
+            break;
+        case '\t':
+            if (attribute)
+                append("&#9;", 4);
+            else
+                append('\t');
+            break;
+        case '\n':
+            if (attribute)
+                append("&#10;", 5);
+            else
+                append('\n');
+            break;
+        case '\r':
+            if (attribute)
+                append("&#13;", 5);
+            else
+                append('\r');
+            break;
+        default:
+            if (u < 0x20 || u == 0xfffe || u == 0xffff)
+                break;
+            char *p = reserve(4);
+            if (u < 0x800) {
+                p[0] = char(0xc0 | (u >> 6));
+                p[1] = char(0x80 | (u & 0x3f));
+                m_size += 2;
+            } else if (QChar::isHighSurrogate(u) && it != end && it->isLowSurrogate()) {
+                const uint ucs4 = QChar::surrogateToUcs4(u, it->unicode());
+                ++it;
+                p[0] = char(0xf0 | (ucs4 >> 18));
+                p[1] = char(0x80 | ((ucs4 >> 12) & 0x3f));
+                p[2] = char(0x80 | ((ucs4 >> 6) & 0x3f));
+                p[3] = char(0x80 | (ucs4 & 0x3f));
+                m_size += 4;
+            } else if (QChar::isSurrogate(u)) {
+                break; // unpaired surrogate
+            } else {
+                p[0] = char(0xe0 | (u >> 12));
+                p[1] = char(0x80 | ((u >> 6) & 0x3f));
+                p[2] = char(0x80 | (u & 0x3f));
+                m_size += 3;
+            }
+            break;
+        }
+    }
+}
+
+void SheetDataWriter::writeStartRow(int row)
+{
+    char *p = reserve(8 + MaxNumberLength);
+    memcpy(p, "<row r=\"", 8);
+    int size = 8 + formatInteger(p + 8, row);
+    p[size++] = '"';
+    m_size += size;
+    m_inStartTag = true;
+    m_rowHasCells = false;
+}
+
+void SheetDataWriter::writeStartCell(int row, int column)
+{
+    closeStartTag();
+    char *p = reserve(6 + 3 + MaxNumberLength);
+    memcpy(p, "<c r=\"", 6);
+    int size = 6 + formatColumn(p + 6, column);
+    size += formatInteger(p + size, row);
+    p[size++] = '"';
+    m_size += size;
+    m_inStartTag = true;
+    m_rowHasCells = true;
+}
+
+void SheetDataWriter::writeAttribute(const char *name, int value)
+{
+    const int nameSize = int(strlen(name));
+    char *p = reserve(nameSize + 4 + MaxNumberLength);
+    p[0] = ' ';
+    memcpy(p + 1, name, nameSize);
+    int size = nameSize + 1;
+    p[size++] = '=';
+    p[size++] = '"';
+    size += formatInteger(p + size, value);
+    p[size++] = '"';
+    m_size += size;
+}
+
+void SheetDataWriter::writeAttribute(const char *name, double value, int precision)
+{
+    const int nameSize = int(strlen(name));
+    char *p = reserve(nameSize + 4 + MaxNumberLength);
+    p[0] = ' ';
+    memcpy(p + 1, name, nameSize);
+    int size = nameSize + 1;
+    p[size++] = '=';
+    p[size++] = '"';
+    size += doubleToChars(p + size, value, precision);
+    p[size++] = '"';
+    m_size += size;
+}
+
+void SheetDataWriter::writeAttribute(const char *name, const char *value)
+{
+    append(' ');
+    append(name, int(strlen(name)));
+    append("=\"", 2);
+    append(value, int(strlen(value)));
+    append('"');
+}
+
+void SheetDataWriter::writeAttribute(const char *name, const QString &value)
+{
+    append(' ');
+    append(name, int(strlen(name)));
+    append("=\"", 2);
+    writeEscaped(value, true);
+    append('"');
+}
+
+void SheetDataWriter::writeEndRow()
+{
+    if (m_inStartTag) {
+        append("/>", 2);
+        m_inStartTag = false;
+    } else {
+        append("</row>", 6);
+    }
+}
+
+void SheetDataWriter::writeEndCell()
+{
+    if (m_inStartTag) {
+        append("/>", 2);
+        m_inStartTag = false;
+    } else {
+        append("</c>", 4);
+    }
+}
+
+void SheetDataWriter::writeValue(int value)
+{
+    closeStartTag();
+    char *p = reserve(7 + MaxNumberLength);
+    memcpy(p, "<v>", 3);
+    int size = 3 + formatInteger(p + 3, value);
+    memcpy(p + size, "</v>", 4);
+    m_size += size + 4;
+}
+
+void SheetDataWriter::writeValue(double value)
+{
+    closeStartTag();
+    char *p = reserve(7 + MaxNumberLength);
+    memcpy(p, "<v>", 3);
+    int size = 3 + doubleToChars(p + 3, value, m_numberPrecision);
+    memcpy(p + size, "</v>", 4);
+    m_size += size + 4;
+}
+
+void SheetDataWriter::writeValue(const QString &value)
+{
+    closeStartTag();
+    append("<v>", 3);
+    writeEscaped(value, false);
+    append("</v>", 4);
+}
+
+void SheetDataWriter::writeInlineString(const QString &text)
+{
+    closeStartTag();
+    append("<is><t", 6);
+    if (isSpaceReserveNeeded(text))
+        append(" xml:space=\"preserve\"", 21);
+    append('>');
+    writeEscaped(text, false);
+    append("</t></is>", 9);
+}
+
+/*
+  Returns the QXmlStreamWriter, for the elements which are not handled
+  by this class. The pending output is flushed first, the returned
+  writer must be left with no open element.
+ */
+QXmlStreamWriter &SheetDataWriter::xmlWriter()
+{
+    closeStartTag();
+    flush();
+    return m_writer;
+}
+
+void SheetDataWriter::flush()
+{
+    if (m_size) {
+        m_device->write(m_buffer.constData(), m_size);
+        m_size = 0;
+    }
+}
+
+QT_END_NAMESPACE_XLSX
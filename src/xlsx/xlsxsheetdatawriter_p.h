@@ -0,0 +1,114 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#ifndef XLSXSHEETDATAWRITER_P_H
+#define XLSXSHEETDATAWRITER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include <QByteArray>
+#include <QString>
+
+class QIODevice;
+class QXmlStreamWriter;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+  Byte level writer of the <row>, <c> and <v> elements of <sheetData>.
+
+  The markup is formatted straight into an UTF-8 buffer which is
+  flushed to the device of the QXmlStreamWriter, instead of going
+  through one QString per attribute. Cell references use a table of
+  the column names, integers and doubles are formatted without any
+  allocation.
+
+  Numbers are written with 15 significant digits, or with the shortest
+  exact representation when the number precision is 0.
+
+  Elements which are not known here, such as <f>, can still be written
+  with the QXmlStreamWriter returned by xmlWriter().
+*/
+class XLSX_AUTOTEST_EXPORT SheetDataWriter
+{
+public:
+    explicit SheetDataWriter(QXmlStreamWriter &writer);
+    ~SheetDataWriter();
+
+    void writeStartRow(int row);
+    void writeStartCell(int row, int column);
+    void writeAttribute(const char *name, int value);
+    void writeAttribute(const char *name, double value, int precision);
+    void writeAttribute(const char *name, const char *value);
+    void writeAttribute(const char *name, const QString &value);
+    void writeEndRow();
+    void writeEndCell();
+
+    void writeValue(int value);
+    void writeValue(double value);
+    void writeValue(const QString &value);
+    void writeInlineString(const QString &text);
+
+    QXmlStreamWriter &xmlWriter();
+    void flush();
+
+    void setNumberPrecision(int precision);
+    int numberPrecision() const;
+
+    static int formatInteger(char *out, int value);
+    static int formatColumn(char *out, int column);
+
+private:
+    enum { BufferSize = 64 * 1024, MaxNumberLength = 32 };
+
+    char *reserve(int size);
+    void append(const char *data, int size);
+    void append(char c);
+    void closeStartTag();
+    void writeEscaped(const QString &text, bool attribute);
+
+    QXmlStreamWriter &m_writer;
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    int m_size;
+    int m_numberPrecision;
+    bool m_inStartTag;
+    bool m_rowHasCells;
+
+    Q_DISABLE_COPY(SheetDataWriter)
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXSHEETDATAWRITER_P_H
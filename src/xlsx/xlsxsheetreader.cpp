@@ -0,0 +1,372 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#include "xlsxsheetreader.h"
+#include "xlsxsheetreader_p.h"
+#include "xlsxabstractsheet.h"
+#include "xlsxdocument_p.h"
+#include "xlsxrelationships_p.h"
+#include "xlsxsharedstrings_p.h"
+#include "xlsxstyles_p.h"
+#include "xlsxutility_p.h"
+#include "xlsxworksheet_p.h"
+#include "xlsxzipreader_p.h"
+
+#include <QFile>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+SheetReaderPrivate::SheetReaderPrivate(SheetReader *p)
+    : q_ptr(p)
+    , styles(0)
+    , sharedStrings(0)
+    , row(0)
+    , atEnd(true)
+{
+}
+
+void SheetReaderPrivate::setError(const QString &message)
+{
+    if (errorString.isEmpty())
+        errorString = message;
+    atEnd = true;
+}
+
+/*
+  Load the workbook, its styles and shared strings, then position the
+  XML reader at the <sheetData> element of the sheet called \a name.
+*/
+bool SheetReaderPrivate::open(QIODevice *device, const QString &name)
+{
+    package.reset(new ZipReader(device));
+    ZipReader &zipReader = *package;
+    if (!zipReader.contains(QStringLiteral("_rels/.rels"))) {
+        setError(QStringLiteral("Not a xlsx package"));
+        return false;
+    }
+
+    Relationships rootRels;
+    rootRels.loadFromXmlData(zipReader.fileData(QStringLiteral("_rels/.rels")));
+    workbook = QSharedPointer<Workbook>(new Workbook(Workbook::F_LoadFromExists));
+    if (!DocumentPrivate::loadWorkbook(zipReader, rootRels, workbook.data())) {
+        setError(QStringLiteral("The package has no workbook"));
+        return false;
+    }
+    styles = workbook->styles();
+    sharedStrings = workbook->sharedStrings();
+
+    AbstractSheet *sheet = 0;
+    for (int i = 0; i < workbook->sheetCount() && !sheet; ++i) {
+        AbstractSheet *s = workbook->sheet(i);
+        if (s->sheetType() == AbstractSheet::ST_WorkSheet
+            && (name.isEmpty() || s->sheetName() == name))
+            sheet = s;
+    }
+    if (!sheet) {
+        setError(QStringLiteral("Worksheet %1 not found").arg(name));
+        return false;
+    }
+    sheetName = sheet->sheetName();
+
+    sheetDevice.reset(zipReader.openFile(sheet->filePath()));
+    if (!sheetDevice) {
+        setError(QStringLiteral("Worksheet %1 can not be read").arg(sheetName));
+        return false;
+    }
+    reader.setDevice(sheetDevice.data());
+
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement() && reader.name() == QLatin1String("sheetData")) {
+            atEnd = false;
+            return true;
+        }
+    }
+    if (reader.hasError())
+        setError(reader.errorString());
+    return !reader.hasError(); // A sheet without <sheetData> has no rows
+}
+
+/*
+  Read the next <row> which holds cells into \a cells.
+*/
+bool SheetReaderPrivate::readRow()
+{
+    cells.clear();
+    while (!atEnd && !reader.atEnd()) {
+        reader.readNext();
+        if (reader.isEndElement() && reader.name() == QLatin1String("sheetData"))
+            break;
+        if (!reader.isStartElement() || reader.name() != QLatin1String("row"))
+            continue;
+
+        //"r" is optional.
+        const QStringView r = reader.attributes().value(QLatin1String("r"));
+        row = r.isEmpty() ? row + 1 : r.toInt();
+
+        int column = 0;
+        while (!reader.atEnd()) {
+            reader.readNext();
+            if (reader.isEndElement() && reader.name() == QLatin1String("row"))
+                break;
+            if (!reader.isStartElement() || reader.name() != QLatin1String("c"))
+                continue;
+
+            XlsxCellData data;
+            WorksheetPrivate::loadXmlCell(reader, &data);
+            if (data.pos.isValid()) {
+                row = data.pos.row();
+                column = data.pos.column();
+            } else {
+                ++column;
+            }
+
+            SheetReader::CellValue cell;
+            cell.column = column;
+            cell.cellType = data.cellType;
+            cell.hasValue = data.hasValue;
+            cell.number = 0;
+            cell.styleIndex = -1;
+            if (data.styleIndex >= 0 && styles->hasXfFormat(data.styleIndex))
+                cell.styleIndex = data.styleIndex;
+
+            switch (data.cellType) {
+            case Cell::SharedStringType:
+                if (data.hasValue)
+                    cell.text = sharedStrings->getSharedString(data.value.toInt()).toPlainString();
+                break;
+            case Cell::NumberType:
+                if (data.hasValue)
+                    cell.number = stringToDouble(data.value);
+                break;
+            case Cell::BooleanType:
+                cell.number = data.value.toInt() != 0 ? 1 : 0;
+                break;
+            default:
+                cell.text = data.value;
+                break;
+            }
+
+            const CellFormula &formula = data.formula;
+            if (formula.formulaType() == CellFormula::SharedType) {
+                if (!formula.formulaText().isEmpty()) {
+                    sharedFormulas[formula.sharedIndex()] = SharedFormulaTemplate(
+                        formula.formulaText(), formula.reference().topLeft());
+                    cell.formula = formula.formulaText();
+                } else if (sharedFormulas.contains(formula.sharedIndex())) {
+                    cell.formula = sharedFormulas[formula.sharedIndex()].formulaAt(row, column);
+                }
+            } else if (formula.isValid()) {
+                cell.formula = formula.formulaText();
+            }
+
+            cells.append(cell);
+        }
+
+        // Rows which only carry a format are skipped
+        if (!cells.isEmpty())
+            return true;
+    }
+
+    if (reader.hasError())
+        setError(reader.errorString());
+    atEnd = true;
+    return false;
+}
+
+/*!
+  \class SheetReader
+  \inmodule QtXlsx
+  \brief Forward-only reader of the rows of one worksheet.
+
+  SheetReader reads the rows of a worksheet one after the other,
+  without building the cells of the sheet in memory. Only the
+  current row is kept, so it suits the jobs which scan the rows
+  of a large workbook once. The shared strings and the styles of
+  the workbook are loaded first, string cells come with their text
+  and cellFormat() resolves the format of a cell.
+
+  \code
+  SheetReader reader("book1.xlsx");
+  for (SheetReader::RowView row = reader.next(); row.isValid(); row = reader.next()) {
+      for (const SheetReader::CellValue &cell : row)
+          qDebug() << row.row() << cell.column << reader.cellValue(cell);
+  }
+  \endcode
+
+  Use Document when the cells need to be modified or accessed in
+  random order.
+*/
+
+/*!
+  \class SheetReader::RowView
+  \brief The cells of the current row of a SheetReader.
+
+  A row view holds the cells of one row which have a value or a
+  format, in ascending column order. It is only valid until the
+  next call of SheetReader::next().
+*/
+
+/*!
+  Creates a reader of the worksheet \a sheetName of the .xlsx file
+  \a xlsxName. The first worksheet is read when \a sheetName is empty.
+*/
+SheetReader::SheetReader(const QString &xlsxName, const QString &sheetName)
+    : d_ptr(new SheetReaderPrivate(this))
+{
+    Q_D(SheetReader);
+    QFile xlsx(xlsxName);
+    if (xlsx.open(QFile::ReadOnly))
+        d->open(&xlsx, sheetName);
+    else
+        d->setError(xlsx.errorString());
+}
+
+/*!
+  \overload
+  Creates a reader of the worksheet \a sheetName of the package read
+  from \a device. The device is no longer used once the constructor
+  returns.
+*/
+SheetReader::SheetReader(QIODevice *device, const QString &sheetName)
+    : d_ptr(new SheetReaderPrivate(this))
+{
+    Q_D(SheetReader);
+    if (device && device->isReadable())
+        d->open(device, sheetName);
+    else
+        d->setError(QStringLiteral("The device is not readable"));
+}
+
+/*!
+  Destroys the reader.
+*/
+SheetReader::~SheetReader()
+{
+    delete d_ptr;
+}
+
+/*!
+  Returns true if the worksheet has been found.
+*/
+bool SheetReader::isValid() const
+{
+    Q_D(const SheetReader);
+    return !d->sheetName.isEmpty();
+}
+
+/*!
+  Returns true if the package or the worksheet could not be read.
+*/
+bool SheetReader::hasError() const
+{
+    Q_D(const SheetReader);
+    return !d->errorString.isEmpty();
+}
+
+/*!
+  Returns a description of the error.
+*/
+QString SheetReader::errorString() const
+{
+    Q_D(const SheetReader);
+    return d->errorString;
+}
+
+/*!
+  Returns the names of all the worksheets of the workbook.
+*/
+QStringList SheetReader::sheetNames() const
+{
+    Q_D(const SheetReader);
+    QStringList names;
+    if (!d->workbook)
+        return names;
+    for (int i = 0; i < d->workbook->sheetCount(); ++i) {
+        AbstractSheet *sheet = d->workbook->sheet(i);
+        if (sheet->sheetType() == AbstractSheet::ST_WorkSheet)
+            names.append(sheet->sheetName());
+    }
+    return names;
+}
+
+/*!
+  Returns the name of the worksheet being read.
+*/
+QString SheetReader::sheetName() const
+{
+    Q_D(const SheetReader);
+    return d->sheetName;
+}
+
+/*!
+  Reads the next row which has cells. Returns an invalid view at the
+  end of the worksheet, or on error.
+*/
+SheetReader::RowView SheetReader::next()
+{
+    Q_D(SheetReader);
+    if (!d->readRow())
+        return RowView();
+    return RowView(d->row, &d->cells);
+}
+
+/*!
+  Returns the format of \a cell.
+*/
+Format SheetReader::cellFormat(const CellValue &cell) const
+{
+    Q_D(const SheetReader);
+    if (cell.styleIndex < 0 || !d->styles)
+        return Format();
+    return d->styles->xfFormat(cell.styleIndex);
+}
+
+/*!
+  Returns the value of \a cell, same as Worksheet::read() would for
+  a cell without formula: numbers with a date time format are
+  converted to QDate, QTime or QDateTime.
+*/
+QVariant SheetReader::cellValue(const CellValue &cell) const
+{
+    Q_D(const SheetReader);
+    if (!cell.hasValue)
+        return QVariant();
+
+    switch (cell.cellType) {
+    case Cell::NumberType:
+        if (cell.number >= 0 && cell.styleIndex >= 0) {
+            const Format format = cellFormat(cell);
+            if (format.isValid() && format.isDateTimeFormat())
+                return datetimeValueFromNumber(cell.number, d->workbook->isDate1904());
+        }
+        return cell.number;
+    case Cell::BooleanType:
+        return cell.number != 0;
+    default:
+        return cell.text;
+    }
+}
+
+QT_END_NAMESPACE_XLSX
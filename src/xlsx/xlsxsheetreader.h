@@ -0,0 +1,108 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+
+#ifndef QXLSX_XLSXSHEETREADER_H
+#define QXLSX_XLSXSHEETREADER_H
+
+#include "xlsxglobal.h"
+#include "xlsxcell.h"
+#include "xlsxformat.h"
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+class QIODevice;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class SheetReaderPrivate;
+class Q_XLSX_EXPORT SheetReader
+{
+    Q_DECLARE_PRIVATE(SheetReader)
+
+public:
+    struct CellValue
+    {
+        int column;
+        Cell::CellType cellType;
+        bool hasValue;   // false for the blank cells, which only carry a format
+        double number;   // value of the number and boolean cells
+        QString text;    // value of the string and error cells
+        QString formula; // formula of the cell, without the leading '='
+        int styleIndex;  // -1 when the cell has no format
+    };
+
+    class RowView
+    {
+    public:
+        RowView()
+            : m_row(0)
+            , m_cells(0)
+        {
+        }
+
+        bool isValid() const { return m_cells != 0; }
+        int row() const { return m_row; }
+        int cellCount() const { return m_cells ? int(m_cells->size()) : 0; }
+        const CellValue &cell(int index) const { return m_cells->at(index); }
+        QList<CellValue>::const_iterator begin() const { return m_cells->constBegin(); }
+        QList<CellValue>::const_iterator end() const { return m_cells->constEnd(); }
+
+    private:
+        friend class SheetReader;
+        RowView(int row, const QList<CellValue> *cells)
+            : m_row(row)
+            , m_cells(cells)
+        {
+        }
+
+        int m_row;
+        const QList<CellValue> *m_cells;
+    };
+
+    explicit SheetReader(const QString &xlsxName, const QString &sheetName = QString());
+    explicit SheetReader(QIODevice *device, const QString &sheetName = QString());
+    ~SheetReader();
+
+    bool isValid() const;
+    bool hasError() const;
+    QString errorString() const;
+    QStringList sheetNames() const;
+    QString sheetName() const;
+
+    RowView next();
+
+    Format cellFormat(const CellValue &cell) const;
+    QVariant cellValue(const CellValue &cell) const;
+
+private:
+    Q_DISABLE_COPY(SheetReader)
+    SheetReaderPrivate *const d_ptr;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // QXLSX_XLSXSHEETREADER_H
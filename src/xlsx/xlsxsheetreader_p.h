@@ -0,0 +1,87 @@
+/****************************************************************************
+** Copyright (c) 2013-2014 Debao Zhang <hello@debao.me>
+** All right reserved.
+**
+** Permission is hereby granted, free of charge, to any person obtaining
+** a copy of this software and associated documentation files (the
+** "Software"), to deal in the Software without restriction, including
+** without limitation the rights to use, copy, modify, merge, publish,
+** distribute, sublicense, and/or sell copies of the Software, and to
+** permit persons to whom the Software is furnished to do so, subject to
+** the following conditions:
+**
+** The above copyright notice and this permission notice shall be
+** included in all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+** MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+** NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+** LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+** OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+** WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**
+****************************************************************************/
+#ifndef XLSXSHEETREADER_P_H
+#define XLSXSHEETREADER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxsheetreader.h"
+#include "xlsxcellformula.h"
+#include "xlsxsharedformula_p.h"
+#include "xlsxworkbook.h"
+
+#include <QMap>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QXmlStreamReader>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class SharedStrings;
+class Styles;
+class ZipReader;
+
+class SheetReaderPrivate
+{
+    Q_DECLARE_PUBLIC(SheetReader)
+public:
+    SheetReaderPrivate(SheetReader *p);
+
+    bool open(QIODevice *device, const QString &name);
+    bool readRow();
+    void setError(const QString &message);
+
+    SheetReader *q_ptr;
+
+    QSharedPointer<Workbook> workbook;
+    Styles *styles;
+    SharedStrings *sharedStrings;
+    QString sheetName;
+
+    // The sheet part is inflated while the QXmlStreamReader reads it,
+    // straight from the package.
+    QScopedPointer<ZipReader> package;
+    QScopedPointer<QIODevice> sheetDevice;
+    QXmlStreamReader reader;
+
+    int row;
+    QList<SheetReader::CellValue> cells;
+    QMap<int, SharedFormulaTemplate> sharedFormulas; // root formulas, by "si"
+    bool atEnd;
+    QString errorString;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXSHEETREADER_P_H
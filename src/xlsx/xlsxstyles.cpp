@@ -104,6 +104,27 @@ Format Styles::xfFormat(int idx) const
     return m_xf_formatsList[idx];
 }
 
+/*
+ * Same as xfFormat(idx).isValid(), without copying the format. The
+ * formats are shared by all the cells which use them, so sheets parsed
+ * concurrently would otherwise all update the same reference count.
+ * Like xfFormat(), it is safe to call from several threads as long as
+ * no format is added.
+ */
+bool Styles::hasXfFormat(int idx) const
+{
+    return idx >= 0 && idx < m_xf_formatsList.size() && m_xf_formatsList[idx].isValid();
+}
+
+/*
+ * Same as xfFormat(idx).isDateTimeFormat() for a valid format. The
+ * number format of an xf is parsed once, when the xf is added.
+ */
+bool Styles::isDateTimeXf(int idx) const
+{
+    return idx >= 0 && idx < m_xf_isDateTime.size() && m_xf_isDateTime[idx];
+}
+
 Format Styles::dxfFormat(int idx) const
 {
     if (idx < 0 || idx >= m_dxf_formatsList.size())
@@ -285,6 +306,7 @@ void Styles::addXfFormat(const Format &format, bool force)
     }
     if (!m_xf_formatsHash.contains(format.formatKey()) || force) {
         m_xf_formatsList.append(format);
+        m_xf_isDateTime.append(format.isValid() && format.isDateTimeFormat());
         m_xf_formatsHash[format.formatKey()] = format;
     }
 }
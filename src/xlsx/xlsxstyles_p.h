@@ -74,6 +74,8 @@ public:
     ~Styles();
     void addXfFormat(const Format &format, bool force = false);
     Format xfFormat(int idx) const;
+    bool hasXfFormat(int idx) const;
+    bool isDateTimeXf(int idx) const;
     void addDxfFormat(const Format &format, bool force = false);
     Format dxfFormat(int idx) const;
 
@@ -132,6 +134,7 @@ private:
     bool m_isIndexedColorsDefault;
 
     QList<Format> m_xf_formatsList;
+    QList<bool> m_xf_isDateTime; // isDateTimeFormat() of each xf format
     QHash<QByteArray, Format> m_xf_formatsHash;
 
     QList<Format> m_dxf_formatsList;
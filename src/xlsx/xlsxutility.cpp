@@ -24,6 +24,7 @@
 ****************************************************************************/
 #include "xlsxutility_p.h"
 #include "xlsxcellreference.h"
+#include "xlsxsharedformula_p.h"
 
 #include <QString>
 #include <QPoint>
@@ -33,6 +34,10 @@
 #include <QColor>
 #include <QDateTime>
 #include <QDebug>
+#include <QVariant>
+
+#include <charconv>
+#include <math.h>
 
 namespace QXlsx {
 
@@ -112,6 +117,97 @@ QDateTime datetimeFromNumber(double num, bool is1904)
     return dt;
 }
 
+/*
+ * Value of a number cell with a date time format: a QTime below 1,
+ * a QDate for whole days, a QDateTime otherwise.
+ */
+QVariant datetimeValueFromNumber(double num, bool is1904)
+{
+    QDateTime dt = datetimeFromNumber(num, is1904);
+    if (num < 1)
+        return dt.time();
+    if (fmod(num, 1.0) < 1.0 / (1000 * 60 * 60 * 24)) // integer
+        return dt.date();
+    return dt;
+}
+
+/*
+ * Format the number of a <v> element to out, which must have room for
+ * 32 characters, and return the number of characters written.
+ *
+ * The output is the same as QString::number(value, 'g', precision).
+ * When precision is 0, the shortest output which reads back to the
+ * same double is used, with up to 17 significant digits.
+ */
+int doubleToChars(char *out, double value, int precision)
+{
+    char *const last = out + 32;
+    if (precision > 0) {
+        const std::to_chars_result result =
+            std::to_chars(out, last, value, std::chars_format::general, precision);
+        return result.ec == std::errc() ? int(result.ptr - out) : 0;
+    }
+
+    // The closest decimal of a given length is the one which reads back
+    // to value, if any of that length does.
+    for (precision = 15; precision < 17; ++precision) {
+        const std::to_chars_result result =
+            std::to_chars(out, last, value, std::chars_format::general, precision);
+        if (result.ec != std::errc())
+            return 0;
+        double parsed;
+        if (std::from_chars(out, result.ptr, parsed).ptr == result.ptr && parsed == value)
+            return int(result.ptr - out);
+    }
+    const std::to_chars_result result =
+        std::to_chars(out, last, value, std::chars_format::general, 17);
+    return result.ec == std::errc() ? int(result.ptr - out) : 0;
+}
+
+/*
+ * Parse the number of a <v> element, such as "1.5" or "-2E-3".
+ */
+double charsToDouble(const char *begin, const char *end, bool *ok)
+{
+    double value = 0;
+    const std::from_chars_result result = std::from_chars(begin, end, value);
+    const bool valid = result.ec == std::errc() && result.ptr == end && begin != end;
+    if (ok)
+        *ok = valid;
+    return valid ? value : 0;
+}
+
+/*
+ * Same as QString::toDouble(), the common case of plain ASCII numbers
+ * is parsed without any allocation.
+ */
+double stringToDouble(QStringView text, bool *ok)
+{
+    char buffer[64];
+    const qsizetype size = text.size();
+    if (size > 0 && size <= qsizetype(sizeof(buffer))) {
+        const QChar *data = text.data();
+        qsizetype i = 0;
+        for (; i < size; ++i) {
+            const ushort u = data[i].unicode();
+            if (u > 0x7f)
+                break;
+            buffer[i] = char(u);
+        }
+        if (i == size && buffer[0] != '+') {
+            bool valid;
+            const double value = charsToDouble(buffer, buffer + size, &valid);
+            if (valid) {
+                if (ok)
+                    *ok = true;
+                return value;
+            }
+        }
+    }
+    // Leading '+', white spaces, ...
+    return text.toDouble(ok);
+}
+
 /*
   Creates a valid sheet name
     minimum length is 1
@@ -180,8 +276,13 @@ QString unescapeSheetName(const QString &sheetName)
  */
 bool isSpaceReserveNeeded(const QString &s)
 {
-    QString spaces(QStringLiteral(" \t\n\r"));
-    return !s.isEmpty() && (spaces.contains(s.at(0)) || spaces.contains(s.at(s.length() - 1)));
+    if (s.isEmpty())
+        return false;
+    const auto isSpace = [](QChar c) {
+        return c == QLatin1Char(' ') || c == QLatin1Char('\t') || c == QLatin1Char('\n')
+               || c == QLatin1Char('\r');
+    };
+    return isSpace(s.at(0)) || isSpace(s.at(s.length() - 1));
 }
 
 /*
@@ -193,89 +294,13 @@ bool isSpaceReserveNeeded(const QString &s)
  * Note, the formula "=A1*A1" for B1 can also be written as "=RC[-1]*RC[-1]", which is the same
  * for all other cells. In other words, this formula is shared.
  *
- * For long run, we need a formula parser.
+ * The sheets keep a SharedFormulaTemplate of each shared formula
+ * instead, so that the formula is only split once.
  */
 QString convertSharedFormula(const QString &rootFormula, const CellReference &rootCell,
                              const CellReference &cell)
 {
-    // Find all the "$?[A-Z]+$?[0-9]+" patterns in the rootFormula.
-    QList<QPair<QString, int>> segments;
-
-    QString segment;
-    bool inQuote = false;
-    enum RefState { INVALID, PRE_AZ, AZ, PRE_09, _09 };
-    RefState refState = INVALID;
-    int refFlag = 0; // 0x00, 0x01, 0x02, 0x03 ==> A1, $A1, A$1, $A$1
-    foreach (QChar ch, rootFormula) {
-        if (inQuote) {
-            segment.append(ch);
-            if (ch == QLatin1Char('"'))
-                inQuote = false;
-        } else {
-            if (ch == QLatin1Char('"')) {
-                inQuote = true;
-                refState = INVALID;
-                segment.append(ch);
-            } else if (ch == QLatin1Char('$')) {
-                if (refState == AZ) {
-                    segment.append(ch);
-                    refState = PRE_09;
-                    refFlag |= 0x02;
-                } else {
-                    segments.append(qMakePair(segment, refState == _09 ? refFlag : -1));
-                    segment = QString(ch); // Start new segment.
-                    refState = PRE_AZ;
-                    refFlag = 0x01;
-                }
-            } else if (ch >= QLatin1Char('A') && ch <= QLatin1Char('Z')) {
-                if (refState == PRE_AZ || refState == AZ) {
-                    segment.append(ch);
-                } else {
-                    segments.append(qMakePair(segment, refState == _09 ? refFlag : -1));
-                    segment = QString(ch); // Start new segment.
-                    refFlag = 0x00;
-                }
-                refState = AZ;
-            } else if (ch >= QLatin1Char('0') && ch <= QLatin1Char('9')) {
-                segment.append(ch);
-
-                if (refState == AZ || refState == PRE_09 || refState == _09)
-                    refState = _09;
-                else
-                    refState = INVALID;
-            } else {
-                if (refState == _09) {
-                    segments.append(qMakePair(segment, refFlag));
-                    segment = QString(ch); // Start new segment.
-                } else {
-                    segment.append(ch);
-                }
-                refState = INVALID;
-            }
-        }
-    }
-
-    if (!segment.isEmpty())
-        segments.append(qMakePair(segment, refState == _09 ? refFlag : -1));
-
-    // Replace "A1", "$A1", "A$1" segment with proper one.
-    QStringList result;
-    typedef QPair<QString, int> PairType;
-    foreach (PairType p, segments) {
-        // qDebug()<<p.first<<p.second;
-        if (p.second != -1 && p.second != 3) {
-            CellReference oldRef(p.first);
-            int row = p.second & 0x02 ? oldRef.row() : oldRef.row() - rootCell.row() + cell.row();
-            int col = p.second & 0x01 ? oldRef.column()
-                                      : oldRef.column() - rootCell.column() + cell.column();
-            result.append(CellReference(row, col).toString(p.second & 0x02, p.second & 0x01));
-        } else {
-            result.append(p.first);
-        }
-    }
-
-    // OK
-    return result.join(QString());
+    return SharedFormulaTemplate(rootFormula, rootCell).formulaAt(cell);
 }
 
 } // namespace QXlsx
@@ -37,11 +37,13 @@
 //
 
 #include "xlsxglobal.h"
+#include <QStringView>
 class QPoint;
 class QString;
 class QColor;
 class QDateTime;
 class QTime;
+class QVariant;
 
 namespace QXlsx {
 class CellReference;
@@ -53,8 +55,13 @@ XLSX_AUTOTEST_EXPORT QString getRelFilePath(const QString &filePath);
 
 XLSX_AUTOTEST_EXPORT double datetimeToNumber(const QDateTime &dt, bool is1904 = false);
 XLSX_AUTOTEST_EXPORT QDateTime datetimeFromNumber(double num, bool is1904 = false);
+XLSX_AUTOTEST_EXPORT QVariant datetimeValueFromNumber(double num, bool is1904 = false);
 XLSX_AUTOTEST_EXPORT double timeToNumber(const QTime &t);
 
+XLSX_AUTOTEST_EXPORT int doubleToChars(char *out, double value, int precision = 15);
+XLSX_AUTOTEST_EXPORT double charsToDouble(const char *begin, const char *end, bool *ok = 0);
+XLSX_AUTOTEST_EXPORT double stringToDouble(QStringView text, bool *ok = 0);
+
 XLSX_AUTOTEST_EXPORT QString createSafeSheetName(const QString &nameProposal);
 XLSX_AUTOTEST_EXPORT QString escapeSheetName(const QString &sheetName);
 XLSX_AUTOTEST_EXPORT QString unescapeSheetName(const QString &sheetName);
@@ -58,6 +58,8 @@ WorkbookPrivate::WorkbookPrivate(Workbook *q, Workbook::CreateFlag flag)
     strings_to_numbers_enabled = false;
     strings_to_hyperlinks_enabled = true;
     html_to_richstring_enabled = false;
+    exact_numbers_enabled = false;
+    formula_sharing_enabled = true;
     date1904 = false;
     defaultDateFormat = QStringLiteral("yyyy-mm-dd");
     activesheetIndex = 0;
@@ -78,6 +80,37 @@ WorkbookPrivate::~WorkbookPrivate()
     }
 }
 
+/*
+  All the sheets loaded so far are left unparsed, \a loader parses
+  each of them when it is first accessed.
+*/
+void WorkbookPrivate::setSheetLoader(SheetLoader *loader)
+{
+    unloadedSheets.clear();
+    for (int i = 0; i < sheets.size(); ++i)
+        unloadedSheets.append(sheets[i].data());
+    if (unloadedSheets.isEmpty())
+        delete loader;
+    else
+        sheetLoader.reset(loader);
+}
+
+void WorkbookPrivate::loadSheet(AbstractSheet *sheet)
+{
+    if (!unloadedSheets.removeOne(sheet))
+        return;
+    sheetLoader->loadSheet(sheet);
+    // The package is released once every sheet is loaded
+    if (unloadedSheets.isEmpty())
+        sheetLoader.reset();
+}
+
+void WorkbookPrivate::loadAllSheets()
+{
+    while (!unloadedSheets.isEmpty())
+        loadSheet(unloadedSheets.first());
+}
+
 Workbook::Workbook(CreateFlag flag)
     : AbstractOOXmlFile(new WorkbookPrivate(this, flag))
 {
@@ -152,6 +185,46 @@ bool Workbook::isHtmlToRichStringEnabled() const
     return d->html_to_richstring_enabled;
 }
 
+/*
+  Numeric cells are saved with 15 significant digits by default,
+  same as Excel. When \a enable is true, they are saved with the
+  shortest representation which reads back to the same double,
+  up to 17 significant digits.
+
+  The default is false
+ */
+void Workbook::setExactNumbersEnabled(bool enable)
+{
+    Q_D(Workbook);
+    d->exact_numbers_enabled = enable;
+}
+
+bool Workbook::isExactNumbersEnabled() const
+{
+    Q_D(const Workbook);
+    return d->exact_numbers_enabled;
+}
+
+/*
+  When \a enable is true, the runs of cells down a column whose
+  formulas are the formula of the first cell moved down are saved
+  as one shared formula, which is much smaller in the file. The
+  formulas of the cells are not changed.
+
+  The default is true
+ */
+void Workbook::setFormulaSharingEnabled(bool enable)
+{
+    Q_D(Workbook);
+    d->formula_sharing_enabled = enable;
+}
+
+bool Workbook::isFormulaSharingEnabled() const
+{
+    Q_D(const Workbook);
+    return d->formula_sharing_enabled;
+}
+
 QString Workbook::defaultDateFormat() const
 {
     Q_D(const Workbook);
@@ -280,7 +353,7 @@ AbstractSheet *Workbook::activeSheet() const
     Q_D(const Workbook);
     if (d->sheets.isEmpty())
         const_cast<Workbook *>(this)->addSheet();
-    return d->sheets[d->activesheetIndex].data();
+    return sheet(d->activesheetIndex);
 }
 
 bool Workbook::setActiveSheet(int index)
@@ -325,6 +398,8 @@ bool Workbook::deleteSheet(int index)
         return false;
     if (index < 0 || index >= d->sheets.size())
         return false;
+    if (d->unloadedSheets.removeOne(d->sheets[index].data()) && d->unloadedSheets.isEmpty())
+        d->sheetLoader.reset();
     d->sheets.removeAt(index);
     d->sheetNames.removeAt(index);
     return true;
@@ -375,6 +450,7 @@ bool Workbook::copySheet(int index, const QString &newName)
     }
 
     ++d->last_sheet_id;
+    d->loadSheet(d->sheets[index].data());
     AbstractSheet *sheet = d->sheets[index]->copy(worksheetName, d->last_sheet_id);
     d->sheets.append(QSharedPointer<AbstractSheet>(sheet));
     d->sheetNames.append(sheet->sheetName());
@@ -399,7 +475,9 @@ AbstractSheet *Workbook::sheet(int index) const
     Q_D(const Workbook);
     if (index < 0 || index >= d->sheets.size())
         return 0;
-    return d->sheets.at(index).data();
+    AbstractSheet *sheet = d->sheets.at(index).data();
+    const_cast<WorkbookPrivate *>(d)->loadSheet(sheet);
+    return sheet;
 }
 
 SharedStrings *Workbook::sharedStrings() const
@@ -444,6 +522,7 @@ QList<Drawing *> Workbook::drawings()
 QList<QSharedPointer<AbstractSheet>> Workbook::getSheetsByTypes(AbstractSheet::SheetType type) const
 {
     Q_D(const Workbook);
+    const_cast<WorkbookPrivate *>(d)->loadAllSheets();
     QList<QSharedPointer<AbstractSheet>> list;
     for (int i = 0; i < d->sheets.size(); ++i) {
         if (d->sheets[i]->sheetType() == type)
@@ -456,8 +535,6 @@ void Workbook::saveToXmlFile(QIODevice *device) const
 {
     Q_D(const Workbook);
     d->relationships->clear();
-    if (d->sheets.isEmpty())
-        const_cast<Workbook *>(this)->addSheet();
 
     QXmlStreamWriter writer(device);
 
@@ -81,6 +81,10 @@ public:
     void setStringsToHyperlinksEnabled(bool enable = true);
     bool isHtmlToRichStringEnabled() const;
     void setHtmlToRichStringEnabled(bool enable = true);
+    bool isExactNumbersEnabled() const;
+    void setExactNumbersEnabled(bool enable = true);
+    bool isFormulaSharingEnabled() const;
+    void setFormulaSharingEnabled(bool enable = true);
     QString defaultDateFormat() const;
     void setDefaultDateFormat(const QString &format);
 
@@ -96,6 +100,7 @@ private:
     friend class WorksheetPrivate;
     friend class Document;
     friend class DocumentPrivate;
+    friend class SheetReaderPrivate;
 
     Workbook(Workbook::CreateFlag flag);
 
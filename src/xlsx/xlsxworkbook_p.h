@@ -42,6 +42,7 @@
 #include "xlsxsimpleooxmlfile_p.h"
 #include "xlsxrelationships_p.h"
 
+#include <QScopedPointer>
 #include <QSharedPointer>
 #include <QPair>
 #include <QStringList>
@@ -69,6 +70,17 @@ struct XlsxDefineNameData
     int sheetId;
 };
 
+/*
+  Loads the sheets which have been left in the package when it was
+  opened, see Document::LoadOptions::lazySheets.
+*/
+class SheetLoader
+{
+public:
+    virtual ~SheetLoader() {}
+    virtual void loadSheet(AbstractSheet *sheet) = 0;
+};
+
 class WorkbookPrivate : public AbstractOOXmlFilePrivate
 {
     Q_DECLARE_PUBLIC(Workbook)
@@ -76,6 +88,10 @@ public:
     WorkbookPrivate(Workbook *q, Workbook::CreateFlag flag);
     ~WorkbookPrivate();
 
+    void setSheetLoader(SheetLoader *loader);
+    void loadSheet(AbstractSheet *sheet);
+    void loadAllSheets();
+
     QSharedPointer<SharedStrings> sharedStrings;
     QList<QSharedPointer<AbstractSheet>> sheets;
     QList<QSharedPointer<SimpleOOXmlFile>> externalLinks;
@@ -86,9 +102,15 @@ public:
     QList<QSharedPointer<Chart>> chartFiles;
     QList<XlsxDefineNameData> definedNamesList;
 
+    // Sheets not parsed yet, and the loader which holds their package
+    QList<AbstractSheet *> unloadedSheets;
+    QScopedPointer<SheetLoader> sheetLoader;
+
     bool strings_to_numbers_enabled;
     bool strings_to_hyperlinks_enabled;
     bool html_to_richstring_enabled;
+    bool exact_numbers_enabled;
+    bool formula_sharing_enabled;
     bool date1904;
     QString defaultDateFormat;
 
@@ -40,8 +40,10 @@
 #include "xlsxchart.h"
 #include "xlsxcellformula.h"
 #include "xlsxcellformula_p.h"
+#include "xlsxformulaengine_p.h"
 #include "xlsxanchor.h"
 #include "xlsxmediafile_p.h"
+#include "xlsxsheetdatawriter_p.h"
 
 #include <QVariant>
 #include <QDateTime>
@@ -55,8 +57,12 @@
 #include <QXmlStreamReader>
 #include <QTextDocument>
 #include <QDir>
+#include <QTemporaryFile>
 
 #include <math.h>
+#include <string.h>
+
+#include <charconv>
 
 #include <iostream>
 using namespace std;
@@ -76,6 +82,9 @@ WorksheetPrivate::WorksheetPrivate(Worksheet *p, Worksheet::CreateFlag flag)
     , showOutlineSymbols(true)
     , showWhiteSpace(true)
     , urlPattern(QStringLiteral("^([fh]tt?ps?://)|(mailto:)|(file://)"))
+    , deferSharedStringRefs(false)
+    , streaming(false)
+    , streamRow(0)
 {
     previous_row = 0;
 
@@ -101,49 +110,56 @@ void WorksheetPrivate::calculateSpans() const
     row_spans.clear();
     int span_min = XLSX_COLUMN_MAX + 1;
     int span_max = -1;
+    int span_index = -1;
 
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-        if (cellTable.contains(row_num)) {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn();
-                 col_num++) {
-                if (cellTable[row_num].contains(col_num)) {
-                    if (span_max == -1) {
-                        span_min = col_num;
-                        span_max = col_num;
-                    } else {
-                        if (col_num < span_min)
-                            span_min = col_num;
-                        else if (col_num > span_max)
-                            span_max = col_num;
-                    }
-                }
-            }
+    auto flushSpan = [&]() {
+        if (span_max != -1) {
+            row_spans[span_index] = QStringLiteral("%1:%2").arg(span_min).arg(span_max);
+            span_min = XLSX_COLUMN_MAX + 1;
+            span_max = -1;
         }
-        if (comments.contains(row_num)) {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn();
-                 col_num++) {
-                if (comments[row_num].contains(col_num)) {
-                    if (span_max == -1) {
-                        span_min = col_num;
-                        span_max = col_num;
-                    } else {
-                        if (col_num < span_min)
-                            span_min = col_num;
-                        else if (col_num > span_max)
-                            span_max = col_num;
-                    }
-                }
-            }
+    };
+
+    // Only the used rows are visited, and only their first and last column.
+    for (int row_num = nextUsedRow(dimension.firstRow());
+         row_num != -1 && row_num <= dimension.lastRow(); row_num = nextUsedRow(row_num + 1)) {
+        if ((row_num - 1) / 16 != span_index) {
+            flushSpan();
+            span_index = (row_num - 1) / 16;
         }
 
-        if (row_num % 16 == 0 || row_num == dimension.lastRow()) {
-            if (span_max != -1) {
-                row_spans[row_num / 16] = QStringLiteral("%1:%2").arg(span_min).arg(span_max);
-                span_min = XLSX_COLUMN_MAX + 1;
-                span_max = -1;
-            }
+        int first_col, last_col;
+        if (cellTable.rowExtent(row_num, &first_col, &last_col)) {
+            span_min = qMin(span_min, first_col);
+            span_max = qMax(span_max, last_col);
+        }
+
+        QMap<int, QMap<int, QString>>::const_iterator it = comments.constFind(row_num);
+        if (it != comments.constEnd() && !it.value().isEmpty()) {
+            span_min = qMin(span_min, it.value().firstKey());
+            span_max = qMax(span_max, it.value().lastKey());
         }
     }
+    flushSpan();
+}
+
+/*
+  Returns the first row not less than \a row which has cell data,
+  comments or formatting, or -1 if there is none.
+ */
+int WorksheetPrivate::nextUsedRow(int row) const
+{
+    int next = cellTable.nextRow(row);
+
+    QMap<int, QMap<int, QString>>::const_iterator cit = comments.lowerBound(row);
+    if (cit != comments.constEnd() && (next == -1 || cit.key() < next))
+        next = cit.key();
+
+    QMap<int, QSharedPointer<XlsxRowInfo>>::const_iterator rit = rowsInfo.lowerBound(row);
+    if (rit != rowsInfo.constEnd() && (next == -1 || rit.key() < next))
+        next = rit.key();
+
+    return next;
 }
 
 QString WorksheetPrivate::generateDimensionString() const
@@ -169,6 +185,9 @@ int WorksheetPrivate::checkDimensions(int row, int col, bool ignore_row, bool ig
     if (row > XLSX_ROW_MAX || row < 1 || col > XLSX_COLUMN_MAX || col < 1)
         return -1;
 
+    if (streaming && !ignore_row && !advanceStreamRow(row))
+        return -1;
+
     if (!ignore_row) {
         if (row < dimension.firstRow() || dimension.firstRow() == -1)
             dimension.setFirstRow(row);
@@ -185,6 +204,110 @@ int WorksheetPrivate::checkDimensions(int row, int col, bool ignore_row, bool ig
     return 0;
 }
 
+/*
+  Same as checkDimensions(), for all the cells of a block at once.
+  Nothing is stored when a corner of the block is out of range.
+*/
+int WorksheetPrivate::checkRangeDimensions(int firstRow, int firstCol, int lastRow, int lastCol)
+{
+    if (firstRow < 1 || firstCol < 1 || lastRow > XLSX_ROW_MAX || lastCol > XLSX_COLUMN_MAX
+        || firstRow > lastRow || firstCol > lastCol)
+        return -1;
+
+    if (checkDimensions(firstRow, firstCol) || checkDimensions(lastRow, lastCol))
+        return -1;
+    return 0;
+}
+
+/*
+  Style index used by the bulk writes. Without a valid format,
+  the cells keep their current style, as writeNumeric() does.
+*/
+int WorksheetPrivate::bulkStyleIndex(const Format &format)
+{
+    if (!format.isValid())
+        return CellTable::KeepStyle;
+    Format fmt = format;
+    workbook->styles()->addXfFormat(fmt);
+    return styleIndex(fmt);
+}
+
+/*
+  Write a block of \a rows x \a cols numbers, \a values are stored row
+  after row.
+*/
+bool WorksheetPrivate::writeNumbers(int row, int col, int rows, int cols, const double *values,
+                                    const Format &format)
+{
+    Q_Q(Worksheet);
+    if (rows < 0 || cols < 0 || rows > XLSX_ROW_MAX || cols > XLSX_COLUMN_MAX)
+        return false;
+    if (rows == 0 || cols == 0)
+        return true;
+
+    if (streaming) {
+        // Rows must be completed one after the other
+        for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < cols; ++c) {
+                if (!q->writeNumeric(row + r, col + c, values[qsizetype(r) * cols + c], format))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    if (checkRangeDimensions(row, col, row + rows - 1, col + cols - 1))
+        return false;
+
+    const int style = bulkStyleIndex(format);
+    if (cols == 1) {
+        cellTable.setNumbers(row, col, values, rows, Qt::Vertical, style);
+    } else {
+        for (int r = 0; r < rows; ++r)
+            cellTable.setNumbers(row + r, col, values + qsizetype(r) * cols, cols, Qt::Horizontal,
+                                 style);
+    }
+    cellsWritten(CellRange(row, col, row + rows - 1, col + cols - 1));
+    return true;
+}
+
+/*
+  Write a row (\a rows == 1) or a column (\a cols == 1) of strings.
+*/
+bool WorksheetPrivate::writeStrings(int row, int col, int rows, int cols,
+                                    const QStringList &values, const Format &format)
+{
+    Q_Q(Worksheet);
+    Q_ASSERT(rows == 1 || cols == 1);
+    if (rows > XLSX_ROW_MAX || cols > XLSX_COLUMN_MAX)
+        return false;
+    if (values.isEmpty())
+        return true;
+
+    if (streaming || workbook->isHtmlToRichStringEnabled()) {
+        for (int i = 0; i < values.size(); ++i) {
+            if (!q->writeString(rows == 1 ? row : row + i, rows == 1 ? col + i : col,
+                                values[i], format))
+                return false;
+        }
+        return true;
+    }
+
+    if (checkRangeDimensions(row, col, row + rows - 1, col + cols - 1))
+        return false;
+
+    QList<int> sstIndexes(values.size());
+    SharedStrings *sst = sharedStrings();
+    for (int i = 0; i < values.size(); ++i)
+        sstIndexes[i] = sst->addSharedString(values[i]);
+
+    cellTable.setSharedStrings(row, col, sstIndexes.constData(), int(sstIndexes.size()),
+                               rows == 1 ? Qt::Horizontal : Qt::Vertical,
+                               bulkStyleIndex(format));
+    cellsWritten(CellRange(row, col, row + rows - 1, col + cols - 1));
+    return true;
+}
+
 /*!
  * \internal
  */
@@ -240,24 +363,11 @@ Worksheet *Worksheet::copy(const QString &distName, int distId) const
 
     sheet_d->dimension = d->dimension;
 
-    QMapIterator<int, QMap<int, QSharedPointer<Cell>>> it(d->cellTable);
-    while (it.hasNext()) {
-        it.next();
-        int row = it.key();
-        QMapIterator<int, QSharedPointer<Cell>> it2(it.value());
-        while (it2.hasNext()) {
-            it2.next();
-            int col = it2.key();
-
-            QSharedPointer<Cell> cell(new Cell(it2.value().data()));
-            cell->d_ptr->parent = sheet;
-
-            if (cell->cellType() == Cell::SharedStringType)
-                d->workbook->sharedStrings()->addSharedString(cell->d_ptr->richString);
-
-            sheet_d->cellTable[row][col] = cell;
-        }
-    }
+    sheet_d->cellTable = d->cellTable;
+    d->cellTable.forEach([d](int, int, const CellTable::Entry &entry) {
+        if (entry.baseKind() == CellTable::K_SharedString && entry.value.index >= 0)
+            d->workbook->sharedStrings()->incRefByStringIndex(entry.value.index);
+    });
 
     sheet_d->merges = d->merges;
     //    sheet_d->rowsInfo = d->rowsInfo;
@@ -456,6 +566,97 @@ void Worksheet::setWhiteSpaceVisible(bool visible)
     d->showWhiteSpace = visible;
 }
 
+/*!
+ * Returns whether the streaming write mode is enabled.
+ *
+ * \sa setStreamingEnabled()
+ */
+bool Worksheet::isStreamingEnabled() const
+{
+    Q_D(const Worksheet);
+    return d->streaming;
+}
+
+/*!
+ * Enable or disable the streaming write mode based on \a enable.
+ *
+ * In streaming mode rows can only be appended. Writing to a row
+ * completes all the rows above it, which are serialized to a
+ * temporary file and released from memory, so memory use is bounded
+ * by the pending row plus the shared string and style tables.
+ *
+ * Writing cells or setting properties of a completed row fails, and
+ * completed rows can no longer be read by read() or cellAt().
+ *
+ * Streaming can't be disabled once a row has been completed.
+ * Returns true on success.
+ */
+bool Worksheet::setStreamingEnabled(bool enable)
+{
+    Q_D(Worksheet);
+    if (!enable && d->streamRow > 0)
+        return false;
+
+    d->streaming = enable;
+    return true;
+}
+
+/*!
+ * Compute the formulas of the worksheet, and store their results as
+ * the cached values of the formula cells, which are saved along with
+ * the formulas. Returns the number of formulas computed.
+ *
+ * The first call computes all the formulas, and builds an index of the
+ * cells and ranges each formula refers to. From then on, writing a
+ * cell marks the formulas referring to it dirty, and the next call only
+ * computes the dirty formulas and the formulas depending on them.
+ *
+ * Independent formulas are computed concurrently on the global thread
+ * pool. Formulas which are part of a circular reference keep their
+ * old values. Cells of other worksheets are read as they are, so a
+ * formula referring to a formula of another sheet sees its cached
+ * value, and writing to another sheet doesn't make it dirty. In
+ * streaming mode, only the rows which have not been completed yet are
+ * computed.
+ *
+ * The functions supported are SUM, AVERAGE, MIN, MAX, COUNT, COUNTA,
+ * PRODUCT, IF, IFERROR, AND, OR, NOT, TRUE, FALSE, ABS, INT, ROUND,
+ * MOD, SQRT, POWER, CONCATENATE, CONCAT, LEN, VLOOKUP, HLOOKUP, MATCH,
+ * INDEX, ISBLANK, ISERROR, ISNUMBER and ISTEXT. Other functions and
+ * defined names give #NAME?.
+ *
+ * \sa calculationStats()
+ */
+int Worksheet::recalculate()
+{
+    Q_D(Worksheet);
+    if (!d->formulaEngine)
+        d->formulaEngine.reset(new FormulaEngine(d));
+    return d->formulaEngine->recalculate();
+}
+
+/*!
+ * Returns the counters of the last recalculate(): the number of
+ * formulas of the sheet, of formulas marked dirty by the writes since
+ * the previous recalculation, or all of them when the dependency index
+ * was rebuilt, of formulas computed, and of formulas left out because
+ * of circular references.
+ */
+Worksheet::CalculationStats Worksheet::calculationStats() const
+{
+    Q_D(const Worksheet);
+    return d->formulaEngine ? d->formulaEngine->stats() : CalculationStats();
+}
+
+Worksheet::CalculationStats::CalculationStats()
+    : formulas(0)
+    , dirty(0)
+    , recomputed(0)
+    , circular(0)
+    , rebuilt(false)
+{
+}
+
 /*!
  * Write \a value to cell (\a row, \a column) with the \a format.
  * Both \a row and \a column are all 1-indexed value.
@@ -554,38 +755,58 @@ QVariant Worksheet::read(int row, int column) const
 {
     Q_D(const Worksheet);
 
-    Cell *cell = cellAt(row, column);
-    if (!cell)
+    // Read the storage directly, no Cell object is needed here.
+    const CellTable::Entry entry = d->cellTable.entry(row, column);
+    if (!entry.isValid())
         return QVariant();
 
-    if (cell->hasFormula()) {
-        if (cell->formula().formulaType() == CellFormula::NormalType) {
-            return QVariant(QLatin1String("=") + cell->formula().formulaText());
-        } else if (cell->formula().formulaType() == CellFormula::SharedType) {
-            if (!cell->formula().formulaText().isEmpty()) {
-                return QVariant(QLatin1String("=") + cell->formula().formulaText());
-            } else {
-                const CellFormula &rootFormula = d->sharedFormulaMap[cell->formula().sharedIndex()];
-                CellReference rootCellRef = rootFormula.reference().topLeft();
-                QString rootFormulaText = rootFormula.formulaText();
-                QString newFormulaText =
-                    convertSharedFormula(rootFormulaText, rootCellRef, CellReference(row, column));
-                return QVariant(QLatin1String("=") + newFormulaText);
-            }
-        }
+    const XlsxCellExtra *extra = entry.hasExtra() ? d->cellTable.extra(row, column) : 0;
+    if (extra && extra->formula.isValid()) {
+        const CellFormula &formula = extra->formula;
+        if (formula.formulaType() == CellFormula::NormalType
+            || formula.formulaType() == CellFormula::SharedType)
+            return QVariant(QLatin1String("=") + d->formulaText(row, column, formula));
     }
 
-    if (cell->isDateTime()) {
-        double val = cell->value().toDouble();
-        QDateTime dt = cell->dateTime();
-        if (val < 1)
-            return dt.time();
-        if (fmod(val, 1.0) < 1.0 / (1000 * 60 * 60 * 24)) // integer
-            return dt.date();
-        return dt;
+    // Same check as Cell::isDateTime(), a blank cell counts as 0.
+    if (entry.baseKind() == CellTable::K_Number || entry.baseKind() == CellTable::K_Blank) {
+        double val = entry.baseKind() == CellTable::K_Number ? entry.value.number : 0;
+        if (val >= 0 && d->workbook->styles()->isDateTimeXf(entry.style))
+            return datetimeValueFromNumber(val, d->workbook->isDate1904());
     }
 
-    return cell->value();
+    return d->cellValue(row, column, entry);
+}
+
+/*!
+    Returns the formulas of the cells in \a range, row by row, without
+    the leading '='. The entry of a cell without formula is an empty
+    string.
+
+    The cells a shared formula is shared with get their formula from the
+    master formula, which is parsed once when it is loaded or written.
+    \sa read()
+ */
+QStringList Worksheet::readFormulas(const CellRange &range) const
+{
+    Q_D(const Worksheet);
+    QStringList formulas;
+    if (!range.isValid())
+        return formulas;
+
+    formulas.reserve(range.rowCount() * range.columnCount());
+    for (int row = range.firstRow(); row <= range.lastRow(); ++row) {
+        for (int column = range.firstColumn(); column <= range.lastColumn(); ++column) {
+            const CellTable::Entry entry = d->cellTable.entry(row, column);
+            const XlsxCellExtra *extra =
+                entry.isValid() && entry.hasExtra() ? d->cellTable.extra(row, column) : 0;
+            if (extra && extra->formula.isValid())
+                formulas.append(d->formulaText(row, column, extra->formula));
+            else
+                formulas.append(QString());
+        }
+    }
+    return formulas;
 }
 
 /*!
@@ -607,21 +828,85 @@ Cell *Worksheet::cellAt(const CellReference &row_column) const
 Cell *Worksheet::cellAt(int row, int column) const
 {
     Q_D(const Worksheet);
-    if (!d->cellTable.contains(row))
-        return 0;
-    if (!d->cellTable[row].contains(column))
-        return 0;
-
-    return d->cellTable[row][column].data();
+    return d->cellAt(row, column);
 }
 
 Format WorksheetPrivate::cellFormat(int row, int col) const
 {
-    if (!cellTable.contains(row))
-        return Format();
-    if (!cellTable[row].contains(col))
+    const CellTable::Entry entry = cellTable.entry(row, col);
+    if (!entry.isValid() || entry.style < 0)
         return Format();
-    return cellTable[row][col]->format();
+    return workbook->styles()->xfFormat(entry.style);
+}
+
+/*
+ * Create the Cell object of (\a row, \a col) from the cell table. The
+ * object is kept alive until the cell is modified.
+ */
+Cell *WorksheetPrivate::cellAt(int row, int col) const
+{
+    Q_Q(const Worksheet);
+    if (Cell *cell = cellTable.cachedCell(row, col))
+        return cell;
+
+    const CellTable::Entry entry = cellTable.entry(row, col);
+    if (!entry.isValid())
+        return 0;
+
+    QSharedPointer<Cell> cell(new Cell(cellValue(row, col, entry),
+                                       CellTable::cellType(entry.baseKind()), Format(),
+                                       const_cast<Worksheet *>(q)));
+    cell->d_ptr->styles = workbook->styles();
+    cell->d_ptr->styleIndex = entry.style;
+    if (entry.hasExtra()) {
+        if (const XlsxCellExtra *extra = cellTable.extra(row, col))
+            cell->d_ptr->formula = extra->formula;
+    }
+    if (entry.baseKind() == CellTable::K_SharedString && entry.value.index >= 0) {
+        RichString rs = sharedStrings()->getSharedString(entry.value.index);
+        if (rs.isRichString())
+            cell->d_ptr->richString = rs;
+    }
+
+    cellTable.cacheCell(row, col, cell);
+    return cell.data();
+}
+
+QVariant WorksheetPrivate::cellValue(int row, int col, const CellTable::Entry &entry) const
+{
+    switch (entry.baseKind()) {
+    case CellTable::K_Number:
+        return entry.value.number;
+    case CellTable::K_Boolean:
+        return entry.value.number != 0;
+    case CellTable::K_SharedString:
+        if (entry.value.index < 0)
+            return QVariant();
+        return sharedStrings()->getSharedString(entry.value.index).toPlainString();
+    case CellTable::K_String:
+    case CellTable::K_InlineString:
+    case CellTable::K_Error:
+        if (entry.hasExtra()) {
+            const XlsxCellExtra *extra = cellTable.extra(row, col);
+            if (extra && !extra->text.isNull())
+                return extra->text;
+        }
+        return QVariant();
+    default:
+        // Note: NumberType with an invalid QVariant value means blank.
+        return QVariant();
+    }
+}
+
+/*
+ * Index of \a format in the xf table, or -1 when the cell has no style.
+ * The format must have been added to the styles already.
+ */
+int WorksheetPrivate::styleIndex(const Format &format)
+{
+    if (format.isEmpty())
+        return -1;
+    return format.xfIndex();
 }
 
 /*!
@@ -655,15 +940,13 @@ bool Worksheet::writeString(int row, int column, const RichString &value, const
     //        error = -2;
     //    }
 
-    d->sharedStrings()->addSharedString(value);
+    int sst_idx = d->sharedStrings()->addSharedString(value);
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     if (value.fragmentCount() == 1 && value.fragmentFormat(0).isValid())
         fmt.mergeFormat(value.fragmentFormat(0));
     d->workbook->styles()->addXfFormat(fmt);
-    QSharedPointer<Cell> cell =
-        QSharedPointer<Cell>(new Cell(value.toPlainString(), Cell::SharedStringType, fmt, this));
-    cell->d_ptr->richString = value;
-    d->cellTable[row][column] = cell;
+    d->cellTable.setSharedString(row, column, sst_idx, d->styleIndex(fmt));
+    d->cellsWritten(CellRange(row, column, row, column));
     return true;
 }
 
@@ -733,8 +1016,8 @@ bool Worksheet::writeInlineString(int row, int column, const QString &value, con
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
-    d->cellTable[row][column] =
-        QSharedPointer<Cell>(new Cell(value, Cell::InlineStringType, fmt, this));
+    d->cellTable.setText(row, column, CellTable::K_InlineString, value, d->styleIndex(fmt));
+    d->cellsWritten(CellRange(row, column, row, column));
     return true;
 }
 
@@ -763,7 +1046,8 @@ bool Worksheet::writeNumeric(int row, int column, double value, const Format &fo
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
-    d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this));
+    d->cellTable.setNumber(row, column, value, d->styleIndex(fmt));
+    d->cellsWritten(CellRange(row, column, row, column));
     return true;
 }
 
@@ -804,11 +1088,14 @@ bool Worksheet::writeFormula(int row, int column, const CellFormula &formula_, c
             ++si;
         formula.d->si = si;
         d->sharedFormulaMap[si] = formula;
+        d->sharedFormulaTemplates[si] =
+            SharedFormulaTemplate(formula.formulaText(), formula.reference().topLeft());
     }
 
-    QSharedPointer<Cell> data = QSharedPointer<Cell>(new Cell(result, Cell::NumberType, fmt, this));
-    data->d_ptr->formula = formula;
-    d->cellTable[row][column] = data;
+    const int style = d->styleIndex(fmt);
+    d->cellTable.setNumber(row, column, result, style);
+    d->cellTable.setFormula(row, column, formula);
+    d->cellsWritten(CellRange(row, column, row, column));
 
     CellRange range = formula.reference();
     if (formula.formulaType() == CellFormula::SharedType) {
@@ -817,14 +1104,10 @@ bool Worksheet::writeFormula(int row, int column, const CellFormula &formula_, c
         for (int r = range.firstRow(); r <= range.lastRow(); ++r) {
             for (int c = range.firstColumn(); c <= range.lastColumn(); ++c) {
                 if (!(r == row && c == column)) {
-                    if (Cell *cell = cellAt(r, c)) {
-                        cell->d_ptr->formula = sf;
-                    } else {
-                        QSharedPointer<Cell> newCell =
-                            QSharedPointer<Cell>(new Cell(result, Cell::NumberType, fmt, this));
-                        newCell->d_ptr->formula = sf;
-                        d->cellTable[r][c] = newCell;
-                    }
+                    if (!d->cellTable.contains(r, c))
+                        d->cellTable.setNumber(r, c, result, style);
+                    d->cellTable.setFormula(r, c, sf);
+                    d->cellsWritten(CellRange(r, c, r, c));
                 }
             }
         }
@@ -860,9 +1143,8 @@ bool Worksheet::writeBlank(int row, int column, const Format &format)
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
 
-    // Note: NumberType with an invalid QVariant value means blank.
-    d->cellTable[row][column] =
-        QSharedPointer<Cell>(new Cell(QVariant(), Cell::NumberType, fmt, this));
+    d->cellTable.setBlank(row, column, d->styleIndex(fmt));
+    d->cellsWritten(CellRange(row, column, row, column));
 
     return true;
 }
@@ -891,7 +1173,8 @@ bool Worksheet::writeBool(int row, int column, bool value, const Format &format)
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
-    d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::BooleanType, fmt, this));
+    d->cellTable.setBoolean(row, column, value, d->styleIndex(fmt));
+    d->cellsWritten(CellRange(row, column, row, column));
 
     return true;
 }
@@ -926,7 +1209,8 @@ bool Worksheet::writeDateTime(int row, int column, const QDateTime &dt, const Fo
 
     double value = datetimeToNumber(dt, d->workbook->isDate1904());
 
-    d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this));
+    d->cellTable.setNumber(row, column, value, d->styleIndex(fmt));
+    d->cellsWritten(CellRange(row, column, row, column));
 
     return true;
 }
@@ -959,12 +1243,126 @@ bool Worksheet::writeTime(int row, int column, const QTime &t, const Format &for
         fmt.setNumberFormat(QStringLiteral("hh:mm:ss"));
     d->workbook->styles()->addXfFormat(fmt);
 
-    d->cellTable[row][column] =
-        QSharedPointer<Cell>(new Cell(timeToNumber(t), Cell::NumberType, fmt, this));
+    d->cellTable.setNumber(row, column, timeToNumber(t), d->styleIndex(fmt));
+    d->cellsWritten(CellRange(row, column, row, column));
 
     return true;
 }
 
+/*!
+    Write \a count numbers from \a values to the cells of \a row,
+    starting at \a column, with the \a format.
+
+    The cells are validated and stored at once, which is much faster
+    than calling writeNumeric() for each of them. When \a format is
+    not valid, existing cells keep their format.
+
+    Returns true on success. Nothing is written if one of the cells is
+    out of range.
+
+    \sa writeColumn(), writeBlock()
+*/
+bool Worksheet::writeRow(int row, int column, const double *values, int count,
+                         const Format &format)
+{
+    Q_D(Worksheet);
+    return d->writeNumbers(row, column, 1, count, values, format);
+}
+
+/*!
+    \overload
+    Write the numbers \a values to the cells of \a row, starting at \a column,
+    with the \a format.
+*/
+bool Worksheet::writeRow(int row, int column, const QList<double> &values, const Format &format)
+{
+    Q_D(Worksheet);
+    return d->writeNumbers(row, column, 1, int(values.size()), values.constData(), format);
+}
+
+/*!
+    \overload
+    Write the strings \a values to the cells of \a row, starting at \a column,
+    with the \a format. The strings are added to the shared strings table,
+    same as writeString().
+*/
+bool Worksheet::writeRow(int row, int column, const QStringList &values, const Format &format)
+{
+    Q_D(Worksheet);
+    return d->writeStrings(row, column, 1, int(values.size()), values, format);
+}
+
+/*!
+    Write \a count numbers from \a values to the cells of \a column,
+    starting at \a row, with the \a format.
+
+    Returns true on success. Nothing is written if one of the cells is
+    out of range.
+
+    \sa writeRow(), writeBlock()
+*/
+bool Worksheet::writeColumn(int row, int column, const double *values, int count,
+                            const Format &format)
+{
+    Q_D(Worksheet);
+    return d->writeNumbers(row, column, count, 1, values, format);
+}
+
+/*!
+    \overload
+    Write the numbers \a values to the cells of \a column, starting at \a row,
+    with the \a format.
+*/
+bool Worksheet::writeColumn(int row, int column, const QList<double> &values,
+                            const Format &format)
+{
+    Q_D(Worksheet);
+    return d->writeNumbers(row, column, int(values.size()), 1, values.constData(), format);
+}
+
+/*!
+    \overload
+    Write the strings \a values to the cells of \a column, starting at \a row,
+    with the \a format.
+*/
+bool Worksheet::writeColumn(int row, int column, const QStringList &values,
+                            const Format &format)
+{
+    Q_D(Worksheet);
+    return d->writeStrings(row, column, int(values.size()), 1, values, format);
+}
+
+/*!
+    Write numbers to all the cells of \a range with the \a format.
+    \a values holds range.rowCount() * range.columnCount() numbers,
+    row after row.
+
+    Returns true on success.
+
+    \sa writeRow(), writeColumn()
+*/
+bool Worksheet::writeBlock(const CellRange &range, const double *values, const Format &format)
+{
+    Q_D(Worksheet);
+    if (!range.isValid())
+        return false;
+    return d->writeNumbers(range.firstRow(), range.firstColumn(), range.rowCount(),
+                           range.columnCount(), values, format);
+}
+
+/*!
+    \overload
+    Write the numbers \a values to all the cells of \a range with the \a format.
+    Returns false if the size of \a values doesn't match the size of \a range.
+*/
+bool Worksheet::writeBlock(const CellRange &range, const QList<double> &values,
+                           const Format &format)
+{
+    if (!range.isValid() || values.size() != qsizetype(range.rowCount()) * range.columnCount())
+        return false;
+    return writeBlock(range, values.constData(), format);
+}
+
 /*!
     \overload
     Write a QUrl \a url to the cell \a row_column with the given \a format \a display and \a tip.
@@ -1026,9 +1424,9 @@ bool Worksheet::writeHyperlink(int row, int column, const QUrl &url, const Forma
     d->workbook->styles()->addXfFormat(fmt);
 
     // Write the hyperlink string as normal string.
-    d->sharedStrings()->addSharedString(displayString);
-    d->cellTable[row][column] =
-        QSharedPointer<Cell>(new Cell(displayString, Cell::SharedStringType, fmt, this));
+    int sst_idx = d->sharedStrings()->addSharedString(displayString);
+    d->cellTable.setSharedString(row, column, sst_idx, d->styleIndex(fmt));
+    d->cellsWritten(CellRange(row, column, row, column));
 
     // Store the hyperlink data in a separate table
     d->urlTable[row][column] = QSharedPointer<XlsxHyperlinkData>(new XlsxHyperlinkData(
@@ -1271,10 +1669,9 @@ bool Worksheet::mergeCells(const CellRange &range, const Format &format)
     for (int row = range.firstRow(); row <= range.lastRow(); ++row) {
         for (int col = range.firstColumn(); col <= range.lastColumn(); ++col) {
             if (row == range.firstRow() && col == range.firstColumn()) {
-                Cell *cell = cellAt(row, col);
-                if (cell) {
+                if (d->cellTable.contains(row, col)) {
                     if (format.isValid())
-                        cell->d_ptr->format = format;
+                        d->cellTable.setStyle(row, col, d->styleIndex(format));
                 } else {
                     writeBlank(row, col, format);
                 }
@@ -1432,138 +1829,289 @@ void Worksheet::saveToXmlFile(QIODevice *device) const
 
 void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
 {
-    calculateSpans();
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-        if (!(cellTable.contains(row_num) || comments.contains(row_num)
-              || rowsInfo.contains(row_num))) {
-            // Only process rows with cell data / comments / formatting
-            continue;
+    if (streamFile) {
+        // Rows completed in streaming mode are copied as is.
+        QIODevice *device = writer.device();
+        Q_ASSERT(device);
+        writer.writeCharacters(QString()); // close the start tag of <sheetData>
+        streamFile->flush();
+        const qint64 end = streamFile->pos();
+        streamFile->seek(0);
+        QByteArray buffer;
+        while (streamFile->pos() < end) {
+            buffer = streamFile->read(qMin(end - streamFile->pos(), qint64(256 * 1024)));
+            if (buffer.isEmpty())
+                break;
+            device->write(buffer);
         }
+        streamFile->seek(end);
+    } else {
+        calculateSpans();
+    }
 
-        int span_index = (row_num - 1) / 16;
-        QString span;
-        if (row_spans.contains(span_index))
-            span = row_spans[span_index];
+    // Formulas saved in place of the ones of the cells
+    QHash<quint64, CellFormula> formulas;
+    if (!streaming && workbook && workbook->isFormulaSharingEnabled())
+        formulas = sharedFormulaRuns();
+
+    // Only process rows with cell data / comments / formatting
+    SheetDataWriter sheetDataWriter(writer);
+    if (workbook && workbook->isExactNumbersEnabled())
+        sheetDataWriter.setNumberPrecision(0);
+    for (int row_num = nextUsedRow(dimension.firstRow());
+         row_num != -1 && row_num <= dimension.lastRow(); row_num = nextUsedRow(row_num + 1)) {
+        if (streaming) {
+            saveXmlRow(sheetDataWriter, row_num, rowSpan(row_num));
+        } else {
+            int span_index = (row_num - 1) / 16;
+            saveXmlRow(sheetDataWriter, row_num, row_spans.value(span_index),
+                       formulas.isEmpty() ? 0 : &formulas);
+        }
+    }
+}
+
+/*
+  Find the runs of cells down a column whose normal formulas are the
+  formula of the first cell of the run moved down, as the reader
+  expands shared formulas, and give the formulas they are saved with:
+  the first cell becomes the master of a shared formula over the run,
+  and the others only refer to it by its index. The cells themselves
+  are not changed.
+*/
+QHash<quint64, CellFormula> WorksheetPrivate::sharedFormulaRuns() const
+{
+    struct Run
+    {
+        int firstRow;
+        int lastRow;
+        CellFormula formula;
+        SharedFormulaTemplate formulaTemplate; // built when the second cell is met
+        bool shareable;
+    };
+
+    QHash<quint64, CellFormula> formulas;
+    QHash<int, Run> runs; // open run of each column
+    int si = sharedFormulaMap.isEmpty() ? 0 : sharedFormulaMap.lastKey() + 1;
+
+    auto closeRun = [&](int column, const Run &run) {
+        if (run.lastRow == run.firstRow)
+            return;
+        CellFormula master(run.formula.formulaText(),
+                           CellRange(run.firstRow, column, run.lastRow, column),
+                           CellFormula::SharedType);
+        master.d->ca = run.formula.d->ca;
+        master.d->si = si;
+        formulas.insert(CellTable::cellKey(run.firstRow, column), master);
+
+        CellFormula child(QString(), CellFormula::SharedType);
+        child.d->ca = master.d->ca;
+        child.d->si = si;
+        for (int row = run.firstRow + 1; row <= run.lastRow; ++row)
+            formulas.insert(CellTable::cellKey(row, column), child);
+        ++si;
+    };
+
+    cellTable.forEach([&](int row, int column, const CellTable::Entry &cell) {
+        const XlsxCellExtra *extra = cell.hasExtra() ? cellTable.extra(row, column) : 0;
+        // saveXmlCellData() leaves out the formulas of the string kinds
+        const int kind = cell.baseKind();
+        const bool eligible = extra && extra->formula.formulaType() == CellFormula::NormalType
+            && !extra->formula.formulaText().isEmpty() && kind != CellTable::K_SharedString
+            && kind != CellTable::K_InlineString;
+
+        QHash<int, Run>::iterator it = runs.find(column);
+        if (it != runs.end()) {
+            Run &run = it.value();
+            if (eligible && row == run.lastRow + 1
+                && extra->formula.d->ca == run.formula.d->ca) {
+                if (run.lastRow == run.firstRow) {
+                    const QString text = run.formula.formulaText();
+                    run.formulaTemplate =
+                        SharedFormulaTemplate(text, CellReference(run.firstRow, column));
+                    // Not the cached expression, sheets are saved in parallel and
+                    // the formula may be shared with a copy of the sheet
+                    run.shareable = run.formulaTemplate.movesDownAs(FormulaExpression::parse(text));
+                }
+                if (run.shareable
+                    && run.formulaTemplate.formulaAt(row, column) == extra->formula.formulaText()) {
+                    run.lastRow = row;
+                    return;
+                }
+            }
+            closeRun(column, run);
+            runs.erase(it);
+        }
+        if (eligible) {
+            Run run;
+            run.firstRow = row;
+            run.lastRow = row;
+            run.formula = extra->formula;
+            run.shareable = false;
+            runs.insert(column, run);
+        }
+    });
 
-        writer.writeStartElement(QStringLiteral("row"));
-        writer.writeAttribute(QStringLiteral("r"), QString::number(row_num));
+    for (QHash<int, Run>::const_iterator it = runs.constBegin(); it != runs.constEnd(); ++it)
+        closeRun(it.key(), it.value());
+    return formulas;
+}
 
-        if (!span.isEmpty())
-            writer.writeAttribute(QStringLiteral("spans"), span);
+/*
+  The cells found in \a formulas, when given, are saved with that
+  formula instead of their own.
+ */
+void WorksheetPrivate::saveXmlRow(SheetDataWriter &writer, int row_num, const QString &span,
+                                  const QHash<quint64, CellFormula> *formulas) const
+{
+    writer.writeStartRow(row_num);
 
-        if (rowsInfo.contains(row_num)) {
-            const auto& rowInfo = rowsInfo[row_num];
-            if (!rowInfo->format.isEmpty()) {
-                writer.writeAttribute(QStringLiteral("s"),
-                                      QString::number(rowInfo->format.xfIndex()));
-                writer.writeAttribute(QStringLiteral("customFormat"), QStringLiteral("1"));
-            }
-            //! Todo: support customHeight from info struct
-            //! Todo: where does this magic number '15' come from?
-            if (rowInfo->customHeight) {
-                writer.writeAttribute(QStringLiteral("ht"), QString::number(rowInfo->height));
-                writer.writeAttribute(QStringLiteral("customHeight"), QStringLiteral("1"));
-            } else {
-                writer.writeAttribute(QStringLiteral("customHeight"), QStringLiteral("0"));
-            }
+    if (!span.isEmpty())
+        writer.writeAttribute("spans", span);
 
-            if (rowInfo->hidden)
-                writer.writeAttribute(QStringLiteral("hidden"), QStringLiteral("1"));
-            if (rowInfo->outlineLevel > 0)
-                writer.writeAttribute(QStringLiteral("outlineLevel"),
-                                      QString::number(rowInfo->outlineLevel));
-            if (rowInfo->collapsed)
-                writer.writeAttribute(QStringLiteral("collapsed"), QStringLiteral("1"));
+    if (rowsInfo.contains(row_num)) {
+        const auto& rowInfo = rowsInfo[row_num];
+        if (!rowInfo->format.isEmpty()) {
+            writer.writeAttribute("s", rowInfo->format.xfIndex());
+            writer.writeAttribute("customFormat", "1");
+        }
+        //! Todo: support customHeight from info struct
+        //! Todo: where does this magic number '15' come from?
+        if (rowInfo->customHeight) {
+            writer.writeAttribute("ht", rowInfo->height, 6);
+            writer.writeAttribute("customHeight", "1");
+        } else {
+            writer.writeAttribute("customHeight", "0");
         }
 
-        // Write cell data if row contains filled cells
-        if (cellTable.contains(row_num)) {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn();
-                 col_num++) {
-                if (cellTable[row_num].contains(col_num)) {
-                    saveXmlCellData(writer, row_num, col_num, cellTable[row_num][col_num]);
-                }
+        if (rowInfo->hidden)
+            writer.writeAttribute("hidden", "1");
+        if (rowInfo->outlineLevel > 0)
+            writer.writeAttribute("outlineLevel", rowInfo->outlineLevel);
+        if (rowInfo->collapsed)
+            writer.writeAttribute("collapsed", "1");
+    }
+
+    // Write cell data if row contains filled cells
+    cellTable.forEachInRow(row_num, [&](int col_num, const CellTable::Entry &cell) {
+        saveXmlCellData(writer, row_num, col_num, cell, formulas);
+    });
+    writer.writeEndRow();
+}
+
+/*
+  The "spans" of a single row. Used in streaming mode, where the
+  following rows of the 16 rows block are not known yet.
+ */
+QString WorksheetPrivate::rowSpan(int row) const
+{
+    int first_col, last_col;
+    if (!cellTable.rowExtent(row, &first_col, &last_col))
+        return QString();
+    return QStringLiteral("%1:%2").arg(first_col).arg(last_col);
+}
+
+/*
+  In streaming mode rows can only be appended. Touching \a row
+  completes all the rows before it: they are serialized to the
+  stream file and released. Returns false if \a row has already
+  been completed.
+ */
+bool WorksheetPrivate::advanceStreamRow(int row)
+{
+    if (row <= streamRow)
+        return false;
+
+    int row_num = nextUsedRow(streamRow + 1);
+    if (row_num != -1 && row_num < row) {
+        if (!streamFile) {
+            streamFile.reset(new QTemporaryFile);
+            if (!streamFile->open()) {
+                qWarning("Worksheet: can not create the file used by the streaming mode");
+                streamFile.reset();
+                return false;
             }
+            streamWriter.reset(new QXmlStreamWriter(streamFile.data()));
         }
-        writer.writeEndElement(); // row
+
+        SheetDataWriter sheetDataWriter(*streamWriter);
+        if (workbook && workbook->isExactNumbersEnabled())
+            sheetDataWriter.setNumberPrecision(0);
+        for (; row_num != -1 && row_num < row; row_num = nextUsedRow(row_num + 1))
+            saveXmlRow(sheetDataWriter, row_num, rowSpan(row_num));
+
+        cellTable.removeRowsBefore(row);
+        if (formulaEngine)
+            formulaEngine->invalidate();
+        rowsInfo.erase(rowsInfo.begin(), rowsInfo.lowerBound(row));
+        comments.erase(comments.begin(), comments.lowerBound(row));
     }
+
+    streamRow = row - 1;
+    return true;
 }
 
-void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int col,
-                                       QSharedPointer<Cell> cell) const
+void WorksheetPrivate::saveXmlCellData(SheetDataWriter &writer, int row, int col,
+                                       const CellTable::Entry &cell,
+                                       const QHash<quint64, CellFormula> *formulas) const
 {
     //This is the innermost loop so efficiency is important.
-    const auto& cell_pos = CellReference(row, col).toString();
-
-    writer.writeStartElement(QStringLiteral("c"));
-    writer.writeAttribute(QStringLiteral("r"), cell_pos);
+    writer.writeStartCell(row, col);
 
     // Style used by the cell, row or col
-    if (!cell->format().isEmpty())
-        writer.writeAttribute(QStringLiteral("s"), QString::number(cell->format().xfIndex()));
+    if (cell.style >= 0 && !workbook->styles()->xfFormat(cell.style).isEmpty())
+        writer.writeAttribute("s", int(cell.style));
     else if (rowsInfo.contains(row) && !rowsInfo[row]->format.isEmpty())
-        writer.writeAttribute(QStringLiteral("s"),
-                              QString::number(rowsInfo[row]->format.xfIndex()));
+        writer.writeAttribute("s", rowsInfo[row]->format.xfIndex());
     else if (colsInfoHelper.contains(col) && !colsInfoHelper[col]->format.isEmpty())
-        writer.writeAttribute(QStringLiteral("s"),
-                              QString::number(colsInfoHelper[col]->format.xfIndex()));
-
-    if (cell->cellType() == Cell::SharedStringType) {
-        int sst_idx;
-        if (cell->isRichString())
-            sst_idx = sharedStrings()->getSharedStringIndex(cell->d_ptr->richString);
-        else
-            sst_idx = sharedStrings()->getSharedStringIndex(cell->value().toString());
-
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("s"));
-        writer.writeTextElement(QStringLiteral("v"), QString::number(sst_idx));
-    } else if (cell->cellType() == Cell::InlineStringType) {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("inlineStr"));
-        writer.writeStartElement(QStringLiteral("is"));
-        if (cell->isRichString()) {
-            // Rich text string
-            RichString string = cell->d_ptr->richString;
-            for (int i = 0; i < string.fragmentCount(); ++i) {
-                writer.writeStartElement(QStringLiteral("r"));
-                if (string.fragmentFormat(i).hasFontData()) {
-                    writer.writeStartElement(QStringLiteral("rPr"));
-                    //:Todo
-                    writer.writeEndElement(); // rPr
-                }
-                writer.writeStartElement(QStringLiteral("t"));
-                if (isSpaceReserveNeeded(string.fragmentText(i)))
-                    writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
-                writer.writeCharacters(string.fragmentText(i));
-                writer.writeEndElement(); // t
-                writer.writeEndElement(); // r
-            }
-        } else {
-            writer.writeStartElement(QStringLiteral("t"));
-            QString string = cell->value().toString();
-            if (isSpaceReserveNeeded(string))
-                writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
-            writer.writeCharacters(string);
-            writer.writeEndElement(); // t
-        }
-        writer.writeEndElement(); // is
-    } else if (cell->cellType() == Cell::NumberType) {
-        if (cell->hasFormula())
-            cell->formula().saveToXml(writer);
-        if (cell->value().isValid()) { // note that, invalid value means 'v' is blank
-            double value = cell->value().toDouble();
-            writer.writeTextElement(QStringLiteral("v"), QString::number(value, 'g', 15));
-        }
-    } else if (cell->cellType() == Cell::StringType) {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("str"));
-        if (cell->hasFormula())
-            cell->formula().saveToXml(writer);
-        writer.writeTextElement(QStringLiteral("v"), cell->value().toString());
-    } else if (cell->cellType() == Cell::BooleanType) {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("b"));
-        writer.writeTextElement(QStringLiteral("v"),
-                                cell->value().toBool() ? QStringLiteral("1") : QStringLiteral("0"));
+        writer.writeAttribute("s", colsInfoHelper[col]->format.xfIndex());
+
+    const XlsxCellExtra *extra = cell.hasExtra() ? cellTable.extra(row, col) : 0;
+    const CellFormula *formula = extra && extra->formula.isValid() ? &extra->formula : 0;
+    if (formula && formulas) {
+        QHash<quint64, CellFormula>::const_iterator it =
+            formulas->constFind(CellTable::cellKey(row, col));
+        if (it != formulas->constEnd())
+            formula = &it.value();
+    }
+    switch (cell.baseKind()) {
+    case CellTable::K_SharedString:
+        writer.writeAttribute("t", "s");
+        if (cell.value.index >= 0)
+            writer.writeValue(int(cell.value.index));
+        break;
+    case CellTable::K_InlineString:
+        writer.writeAttribute("t", "inlineStr");
+        writer.writeInlineString(extra ? extra->text : QString());
+        break;
+    case CellTable::K_Blank:
+    case CellTable::K_Number:
+        if (formula)
+            formula->saveToXml(writer.xmlWriter());
+        if (cell.baseKind() == CellTable::K_Number) // note that, blank means 'v' is blank
+            writer.writeValue(cell.value.number);
+        break;
+    case CellTable::K_String:
+        writer.writeAttribute("t", "str");
+        if (formula)
+            formula->saveToXml(writer.xmlWriter());
+        writer.writeValue(extra ? extra->text : QString());
+        break;
+    case CellTable::K_Boolean:
+        writer.writeAttribute("t", "b");
+        if (formula)
+            formula->saveToXml(writer.xmlWriter());
+        writer.writeValue(cell.value.number != 0 ? 1 : 0);
+        break;
+    case CellTable::K_Error:
+        writer.writeAttribute("t", "e");
+        if (formula)
+            formula->saveToXml(writer.xmlWriter());
+        writer.writeValue(extra ? extra->text : QString());
+        break;
+    default:
+        break;
     }
-    writer.writeEndElement(); // c
+    writer.writeEndCell();
 }
 
 void WorksheetPrivate::saveXmlMergeCells(QXmlStreamWriter &writer) const
@@ -1603,8 +2151,10 @@ void WorksheetPrivate::saveXmlOleObjects(QXmlStreamWriter &writer) const
 
     writer.writeStartElement(QStringLiteral("oleObjects"));
     const auto& oleFiles = oleObjectFiles();
-    const auto& mediaFiles = workbook->mediaFiles();
 
+    // Sheets are saved in parallel: the objects and their preview images
+    // are only read here, the media indexes are assigned by the document
+    // before any part is saved.
     for (int i=0; i < oleFiles.size(); ++i) {
         const auto& obj = oleFiles[i];
 
@@ -1612,16 +2162,16 @@ void WorksheetPrivate::saveXmlOleObjects(QXmlStreamWriter &writer) const
         relationships->addWorksheetRelationship(QStringLiteral("/package"),
                                                 QStringLiteral("../embeddings/%1")
                                                 .arg(fi.fileName()));
-        obj->setIndex(relationships->count());
+        const int objectId = relationships->count();
 
+        int previewId = -1;
         const auto& media = obj->prMediaFile();
-        if (media && media->fileName().size() > 0) {
-            media->setIndex(mediaFiles.size());
+        if (media && media->fileName().size() > 0 && media->isIndexValid()) {
             relationships->addDocumentRelationship(QStringLiteral("/image"),
                                                    QStringLiteral("../media/image%1.%2")
                                                    .arg(media->index()+1)
                                                    .arg(media->suffix()));
-            obj->setPrIndex(relationships->count());
+            previewId = relationships->count();
         }
 
         writer.writeStartElement(QStringLiteral("mc:AlternateContent"));
@@ -1640,16 +2190,12 @@ void WorksheetPrivate::saveXmlOleObjects(QXmlStreamWriter &writer) const
         if (obj->shapeID().size() > 0)
             writer.writeAttribute(QStringLiteral("shapeId"), obj->shapeID());
 
-        if (obj->isIndexValid())
-            writer.writeAttribute(QStringLiteral("r:id"),
-                                  QStringLiteral("rId%1").arg(obj->index()));
+        writer.writeAttribute(QStringLiteral("r:id"), QStringLiteral("rId%1").arg(objectId));
 
         writer.writeStartElement(QStringLiteral("objectPr"));
         writer.writeAttribute(QStringLiteral("defaultSize"), QStringLiteral("0"));
-        if (media->isIndexValid()) {
-            writer.writeAttribute(QStringLiteral("r:id"),
-                                  QStringLiteral("rId%1").arg(obj->prIndex()));
-        }
+        if (previewId != -1)
+            writer.writeAttribute(QStringLiteral("r:id"), QStringLiteral("rId%1").arg(previewId));
 
         // write the anchor
         obj->anchor()->saveToXml(writer);
@@ -1666,9 +2212,7 @@ void WorksheetPrivate::saveXmlOleObjects(QXmlStreamWriter &writer) const
         if (obj->shapeID().size() > 0)
             writer.writeAttribute(QStringLiteral("shapeId"), obj->shapeID());
 
-        if (obj->isIndexValid())
-            writer.writeAttribute(QStringLiteral("r:id"),
-                                  QStringLiteral("rId%1").arg(obj->index()));
+        writer.writeAttribute(QStringLiteral("r:id"), QStringLiteral("rId%1").arg(objectId));
         writer.writeEndElement(); // oleObject
         writer.writeEndElement(); // Fallback
         writer.writeEndElement(); // mc:AlternateContent
@@ -2181,9 +2725,72 @@ int WorksheetPrivate::colPixelsSize(int col) const
     return pixels;
 }
 
+/*
+  Read the <c> element the \a reader is positioned on, up to and
+  including its end element. Shared by loadXmlSheetData() and the
+  SheetReader.
+*/
+void WorksheetPrivate::loadXmlCell(QXmlStreamReader &reader, XlsxCellData *cell)
+{
+    Q_ASSERT(reader.name() == QLatin1String("c"));
+
+    QXmlStreamAttributes attributes = reader.attributes();
+    cell->pos = CellReference(attributes.value(QLatin1String("r")));
+
+    if (attributes.hasAttribute(QLatin1String("s"))) //"s" == style index
+        cell->styleIndex = attributes.value(QLatin1String("s")).toString().toInt();
+
+    if (attributes.hasAttribute(QLatin1String("t"))) {
+        const QStringView typeString = attributes.value(QLatin1String("t"));
+        if (typeString == QLatin1String("s"))
+            cell->cellType = Cell::SharedStringType;
+        else if (typeString == QLatin1String("inlineStr"))
+            cell->cellType = Cell::InlineStringType;
+        else if (typeString == QLatin1String("str"))
+            cell->cellType = Cell::StringType;
+        else if (typeString == QLatin1String("b"))
+            cell->cellType = Cell::BooleanType;
+        else if (typeString == QLatin1String("e"))
+            cell->cellType = Cell::ErrorType;
+        else
+            cell->cellType = Cell::NumberType;
+    }
+
+    while (!reader.atEnd()
+           && !(reader.name() == QLatin1String("c")
+                && reader.tokenType() == QXmlStreamReader::EndElement)) {
+        if (reader.readNextStartElement()) {
+            if (reader.name() == QLatin1String("f")) {
+                cell->formula.loadFromXml(reader);
+            } else if (reader.name() == QLatin1String("v")) {
+                cell->value = reader.readElementText();
+                cell->hasValue = true;
+            } else if (reader.name() == QLatin1String("is")) {
+                while (!reader.atEnd()
+                       && !(reader.name() == QLatin1String("is")
+                            && reader.tokenType() == QXmlStreamReader::EndElement)) {
+                    if (reader.readNextStartElement()) {
+                        //:Todo, add rich text read support
+                        if (reader.name() == QLatin1String("t")) {
+                            cell->value = reader.readElementText();
+                            cell->hasValue = true;
+                        }
+                    }
+                }
+            } else if (reader.name() == QLatin1String("extLst")) {
+                // skip extLst element
+                while (!reader.atEnd()
+                       && !(reader.name() == QLatin1String("extLst")
+                            && reader.tokenType() == QXmlStreamReader::EndElement)) {
+                    reader.readNextStartElement();
+                }
+            }
+        }
+    }
+}
+
 void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 {
-    Q_Q(Worksheet);
     Q_ASSERT(reader.name() == QLatin1String("sheetData"));
 
     while (!reader.atEnd()
@@ -2191,133 +2798,305 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
                 && reader.tokenType() == QXmlStreamReader::EndElement)) {
         if (reader.readNextStartElement()) {
             if (reader.name() == QLatin1String("row")) {
-                QXmlStreamAttributes attributes = reader.attributes();
+                const QXmlStreamAttributes attributes = reader.attributes();
+                // Nothing after the last row of the projection is needed,
+                // not even the shared formulas.
+                if (loadProjection.enabled && loadProjection.lastRow >= 0
+                    && attributes.value(QLatin1String("r")).toInt() > loadProjection.lastRow) {
+                    reader.skipCurrentElement();
+                    while (reader.readNextStartElement())
+                        reader.skipCurrentElement();
+                    break;
+                }
+                loadXmlRowInfo(attributes);
+            } else if (reader.name() == QLatin1String("c")) { // Cell
+                XlsxCellData cell;
+                loadXmlCell(reader, &cell);
+                if (!loadProjection.enabled || loadProjection.contains(cell.pos))
+                    storeXmlCell(cell);
+                else
+                    storeSharedFormula(cell.formula);
+            }
+        }
+    }
 
-                if (attributes.hasAttribute(QLatin1String("customFormat"))
-                    || attributes.hasAttribute(QLatin1String("customHeight"))
-                    || attributes.hasAttribute(QLatin1String("hidden"))
-                    || attributes.hasAttribute(QLatin1String("outlineLevel"))
-                    || attributes.hasAttribute(QLatin1String("collapsed"))) {
-
-                    QSharedPointer<XlsxRowInfo> info(new XlsxRowInfo);
-                    if (attributes.hasAttribute(QLatin1String("customFormat"))
-                        && attributes.hasAttribute(QLatin1String("s"))) {
-                        int idx = attributes.value(QLatin1String("s")).toString().toInt();
-                        info->format = workbook->styles()->xfFormat(idx);
-                    }
+    if (!deferSharedStringRefs)
+        mergeSharedStringRefs();
+}
 
-                    if (attributes.hasAttribute(QLatin1String("customHeight"))) {
-                        info->customHeight =
-                            attributes.value(QLatin1String("customHeight")) == QLatin1String("1");
-                        // Row height is only specified when customHeight is set
-                        if (attributes.hasAttribute(QLatin1String("ht"))) {
-                            info->height =
-                                attributes.value(QLatin1String("ht")).toString().toDouble();
-                        }
-                    }
+/*
+  Keep the row information of a <row> with the given \a attributes.
+*/
+void WorksheetPrivate::loadXmlRowInfo(const QXmlStreamAttributes &attributes)
+{
+    if (attributes.hasAttribute(QLatin1String("customFormat"))
+        || attributes.hasAttribute(QLatin1String("customHeight"))
+        || attributes.hasAttribute(QLatin1String("hidden"))
+        || attributes.hasAttribute(QLatin1String("outlineLevel"))
+        || attributes.hasAttribute(QLatin1String("collapsed"))) {
+
+        QSharedPointer<XlsxRowInfo> info(new XlsxRowInfo);
+        if (attributes.hasAttribute(QLatin1String("customFormat"))
+            && attributes.hasAttribute(QLatin1String("s"))) {
+            int idx = attributes.value(QLatin1String("s")).toString().toInt();
+            info->format = workbook->styles()->xfFormat(idx);
+        }
 
-                    // both "hidden" and "collapsed" default are false
-                    info->hidden = attributes.value(QLatin1String("hidden")) == QLatin1String("1");
-                    info->collapsed =
-                        attributes.value(QLatin1String("collapsed")) == QLatin1String("1");
+        if (attributes.hasAttribute(QLatin1String("customHeight"))) {
+            info->customHeight =
+                attributes.value(QLatin1String("customHeight")) == QLatin1String("1");
+            // Row height is only specified when customHeight is set
+            if (attributes.hasAttribute(QLatin1String("ht"))) {
+                info->height =
+                    attributes.value(QLatin1String("ht")).toString().toDouble();
+            }
+        }
 
-                    if (attributes.hasAttribute(QLatin1String("outlineLevel")))
-                        info->outlineLevel =
-                            attributes.value(QLatin1String("outlineLevel")).toString().toInt();
+        // both "hidden" and "collapsed" default are false
+        info->hidden = attributes.value(QLatin1String("hidden")) == QLatin1String("1");
+        info->collapsed =
+            attributes.value(QLatin1String("collapsed")) == QLatin1String("1");
 
-                    //"r" is optional too.
-                    if (attributes.hasAttribute(QLatin1String("r"))) {
-                        int row = attributes.value(QLatin1String("r")).toString().toInt();
-                        rowsInfo[row] = info;
-                    }
-                }
+        if (attributes.hasAttribute(QLatin1String("outlineLevel")))
+            info->outlineLevel =
+                attributes.value(QLatin1String("outlineLevel")).toString().toInt();
 
-            } else if (reader.name() == QLatin1String("c")) { // Cell
-                QXmlStreamAttributes attributes = reader.attributes();
-                QString r = attributes.value(QLatin1String("r")).toString();
-                CellReference pos(r);
-
-                // get format
-                Format format;
-                if (attributes.hasAttribute(QLatin1String("s"))) { //"s" == style index
-                    int idx = attributes.value(QLatin1String("s")).toString().toInt();
-                    format = workbook->styles()->xfFormat(idx);
-                    ////Empty format exists in styles xf table of real .xlsx files, see issue #65.
-                    // if (!format.isValid())
-                    //    qDebug()<<QStringLiteral("<c s=\"%1\">Invalid style index:
-                    //    ").arg(idx)<<idx;
-                }
+        //"r" is optional too.
+        if (attributes.hasAttribute(QLatin1String("r"))) {
+            int row = attributes.value(QLatin1String("r")).toString().toInt();
+            if (!loadProjection.enabled || loadProjection.containsRow(row))
+                rowsInfo[row] = info;
+        }
+    }
+}
 
-                Cell::CellType cellType = Cell::NumberType;
-                if (attributes.hasAttribute(QLatin1String("t"))) {
-                    QString typeString = attributes.value(QLatin1String("t")).toString();
-                    if (typeString == QLatin1String("s"))
-                        cellType = Cell::SharedStringType;
-                    else if (typeString == QLatin1String("inlineStr"))
-                        cellType = Cell::InlineStringType;
-                    else if (typeString == QLatin1String("str"))
-                        cellType = Cell::StringType;
-                    else if (typeString == QLatin1String("b"))
-                        cellType = Cell::BooleanType;
-                    else if (typeString == QLatin1String("e"))
-                        cellType = Cell::ErrorType;
-                    else
-                        cellType = Cell::NumberType;
-                }
+/*
+  Parse an integer attribute or value, as QString::toInt() does.
+*/
+static int bytesToInt(QByteArrayView text)
+{
+    int value = 0;
+    const char *end = text.data() + text.size();
+    const std::from_chars_result result = std::from_chars(text.data(), end, value);
+    if (result.ec == std::errc() && result.ptr == end && text.size() > 0)
+        return value;
+    return QString::fromUtf8(text.data(), text.size()).toInt();
+}
 
-                QSharedPointer<Cell> cell(new Cell(QVariant(), cellType, format, q));
-                while (!reader.atEnd()
-                       && !(reader.name() == QLatin1String("c")
-                            && reader.tokenType() == QXmlStreamReader::EndElement)) {
-                    if (reader.readNextStartElement()) {
-                        if (reader.name() == QLatin1String("f")) {
-                            CellFormula &formula = cell->d_func()->formula;
-                            formula.loadFromXml(reader);
-                            if (formula.formulaType() == CellFormula::SharedType
-                                && !formula.formulaText().isEmpty()) {
-                                sharedFormulaMap[formula.sharedIndex()] = formula;
-                            }
-                        } else if (reader.name() == QLatin1String("v")) {
-                            QString value = reader.readElementText();
-                            if (cellType == Cell::SharedStringType) {
-                                int sst_idx = value.toInt();
-                                sharedStrings()->incRefByStringIndex(sst_idx);
-                                RichString rs = sharedStrings()->getSharedString(sst_idx);
-                                cell->d_func()->value = rs.toPlainString();
-                                if (rs.isRichString())
-                                    cell->d_func()->richString = rs;
-                            } else if (cellType == Cell::NumberType) {
-                                cell->d_func()->value = value.toDouble();
-                            } else if (cellType == Cell::BooleanType) {
-                                cell->d_func()->value = value.toInt() ? true : false;
-                            } else { // Cell::ErrorType and Cell::StringType
-                                cell->d_func()->value = value;
-                            }
-                        } else if (reader.name() == QLatin1String("is")) {
-                            while (!reader.atEnd()
-                                   && !(reader.name() == QLatin1String("is")
-                                        && reader.tokenType() == QXmlStreamReader::EndElement)) {
-                                if (reader.readNextStartElement()) {
-                                    //:Todo, add rich text read support
-                                    if (reader.name() == QLatin1String("t")) {
-                                        cell->d_func()->value = reader.readElementText();
-                                    }
-                                }
-                            }
-                        } else if (reader.name() == QLatin1String("extLst")) {
-                            // skip extLst element
-                            while (!reader.atEnd()
-                                   && !(reader.name() == QLatin1String("extLst")
-                                        && reader.tokenType() == QXmlStreamReader::EndElement)) {
-                                reader.readNextStartElement();
-                            }
-                        }
-                    }
-                }
-                cellTable[pos.row()][pos.column()] = cell;
-            }
+static double bytesToDouble(QByteArrayView text)
+{
+    bool ok;
+    const double value = charsToDouble(text.data(), text.data() + text.size(), &ok);
+    return ok ? value : stringToDouble(QString::fromUtf8(text.data(), text.size()));
+}
+
+/*
+  Store a cell read from <sheetData>. The value is parsed from the
+  UTF-8 text \a utf8Value, or from cell.value when it is null.
+*/
+void WorksheetPrivate::storeXmlCell(const XlsxCellData &cell, QByteArrayView utf8Value)
+{
+    // get format
+    int style = -1;
+    if (cell.styleIndex >= 0) {
+        if (workbook->styles()->hasXfFormat(cell.styleIndex))
+            style = cell.styleIndex;
+        ////Empty format exists in styles xf table of real .xlsx files, see issue #65.
+        // if (!format.isValid())
+        //    qDebug()<<QStringLiteral("<c s=\"%1\">Invalid style index:
+        //    ").arg(idx)<<idx;
+    }
+
+    storeSharedFormula(cell.formula);
+
+    // Cells without a valid reference can not be stored.
+    if (!cell.pos.isValid())
+        return;
+
+    const bool utf8 = !utf8Value.isNull();
+    const int row = cell.pos.row();
+    const int col = cell.pos.column();
+    if (cell.cellType == Cell::SharedStringType) {
+        int sst_idx = -1;
+        if (cell.hasValue) {
+            sst_idx = utf8 ? bytesToInt(utf8Value) : cell.value.toInt();
+            ++sharedStringRefs[sst_idx];
+        }
+        cellTable.setSharedString(row, col, sst_idx, style);
+    } else if (cell.cellType == Cell::NumberType) {
+        if (cell.hasValue) {
+            cellTable.setNumber(row, col,
+                                utf8 ? bytesToDouble(utf8Value) : stringToDouble(cell.value),
+                                style);
+        } else {
+            cellTable.setBlank(row, col, style);
         }
+    } else if (cell.cellType == Cell::BooleanType) {
+        cellTable.setBoolean(row, col, (utf8 ? bytesToInt(utf8Value) : cell.value.toInt()) != 0,
+                             style);
+    } else {
+        // Cell::ErrorType, Cell::StringType and Cell::InlineStringType
+        CellTable::Kind kind = cell.cellType == Cell::ErrorType
+                                   ? CellTable::K_Error
+                                   : cell.cellType == Cell::StringType
+                                         ? CellTable::K_String
+                                         : CellTable::K_InlineString;
+        QString text;
+        if (cell.hasValue)
+            text = utf8 ? QString::fromUtf8(utf8Value.data(), utf8Value.size()) : cell.value;
+        cellTable.setText(row, col, kind, text, style);
     }
+    if (cell.formula.isValid())
+        cellTable.setFormula(row, col, cell.formula);
+}
+
+/*
+  A <row> read by the SheetDataReader. Rows only matter here when they
+  carry row information, which is rare enough to go through
+  QXmlStreamAttributes. Returns false after the last row of the
+  projection: nothing after it is needed, not even the shared formulas.
+*/
+bool WorksheetPrivate::loadSheetDataRow(const SheetDataReader::Row &row)
+{
+    static const char *const infoNames[] = {"customFormat", "customHeight", "hidden",
+                                            "outlineLevel", "collapsed"};
+    bool hasInfo = false;
+    for (int i = 0; i < row.attributeCount; ++i) {
+        const QByteArrayView name = row.attributes[i].name;
+        if (name.size() == 1 && name.data()[0] == 'r') {
+            if (loadProjection.enabled && loadProjection.lastRow >= 0
+                && bytesToInt(row.attributes[i].value) > loadProjection.lastRow)
+                return false;
+            continue;
+        }
+        for (const char *infoName : infoNames) {
+            if (qsizetype(qstrlen(infoName)) == name.size()
+                && memcmp(infoName, name.data(), size_t(name.size())) == 0)
+                hasInfo = true;
+        }
+    }
+    if (!hasInfo)
+        return true;
+
+    QXmlStreamAttributes attributes;
+    for (int i = 0; i < row.attributeCount; ++i) {
+        const SheetDataReader::Attribute &attribute = row.attributes[i];
+        attributes.append(QString::fromUtf8(attribute.name.data(), attribute.name.size()),
+                          QString::fromUtf8(attribute.value.data(), attribute.value.size()));
+    }
+    loadXmlRowInfo(attributes);
+    return true;
+}
+
+/*
+  A <c> read by the SheetDataReader, stored as loadXmlCell() and
+  loadXmlSheetData() would.
+*/
+void WorksheetPrivate::loadSheetDataCell(const SheetDataReader::Cell &data)
+{
+    XlsxCellData cell;
+    if (!data.reference.isNull())
+        cell.pos = CellReference::fromUtf8(data.reference);
+    if (loadProjection.enabled && !loadProjection.contains(cell.pos)) {
+        // Cells of the projection below this one may use its shared formula
+        if (data.hasFormula && !data.formula.isEmpty()
+            && QLatin1String(data.formulaType.data(), data.formulaType.size())
+                   == QLatin1String("shared")
+            && (loadProjection.lastRow < 0 || cell.pos.row() <= loadProjection.lastRow))
+            storeSharedFormula(loadSheetDataFormula(data));
+        return;
+    }
+    if (!data.style.isNull())
+        cell.styleIndex = bytesToInt(data.style);
+
+    if (!data.type.isNull()) {
+        const QLatin1String type(data.type.data(), data.type.size());
+        if (type == QLatin1String("s"))
+            cell.cellType = Cell::SharedStringType;
+        else if (type == QLatin1String("inlineStr"))
+            cell.cellType = Cell::InlineStringType;
+        else if (type == QLatin1String("str"))
+            cell.cellType = Cell::StringType;
+        else if (type == QLatin1String("b"))
+            cell.cellType = Cell::BooleanType;
+        else if (type == QLatin1String("e"))
+            cell.cellType = Cell::ErrorType;
+        else
+            cell.cellType = Cell::NumberType;
+    }
+
+    if (data.hasFormula)
+        cell.formula = loadSheetDataFormula(data);
+
+    cell.hasValue = data.hasValue;
+    // An empty, but not null, view when there is no value
+    storeXmlCell(cell, data.hasValue ? data.value : QByteArrayView("", 0));
+}
+
+/*
+  The <f> of a cell read by the SheetDataReader, the same as
+  CellFormula::loadFromXml() reads it.
+*/
+CellFormula WorksheetPrivate::loadSheetDataFormula(const SheetDataReader::Cell &data)
+{
+    CellFormulaPrivate *formula =
+        new CellFormulaPrivate(QString(), CellRange(), CellFormula::NormalType);
+    const QLatin1String type(data.formulaType.data(), data.formulaType.size());
+    if (type == QLatin1String("array"))
+        formula->type = CellFormula::ArrayType;
+    else if (type == QLatin1String("shared"))
+        formula->type = CellFormula::SharedType;
+    if (!data.formulaReference.isNull())
+        formula->reference = CellRange::fromUtf8(data.formulaReference);
+    if (!data.formulaIndex.isNull()) {
+        const QString si = QString::fromUtf8(data.formulaIndex.data(), data.formulaIndex.size());
+        formula->ca = parseXsdBoolean(si, false);
+        formula->si = si.toInt();
+    }
+    formula->formula = QString::fromUtf8(data.formula.data(), data.formula.size());
+
+    CellFormula result;
+    result.d = formula;
+    return result;
+}
+
+/*
+  Keep \a formula when it is the master of a shared formula, which the
+  cells it is shared with are expanded from.
+*/
+void WorksheetPrivate::storeSharedFormula(const CellFormula &formula)
+{
+    if (formula.formulaType() == CellFormula::SharedType && !formula.formulaText().isEmpty()) {
+        sharedFormulaMap[formula.sharedIndex()] = formula;
+        sharedFormulaTemplates[formula.sharedIndex()] =
+            SharedFormulaTemplate(formula.formulaText(), formula.reference().topLeft());
+    }
+}
+
+/*
+  The text of \a formula, the formula of the cell at \a row and \a col.
+  The cells a shared formula is shared with have no text of their own,
+  theirs is made from the template of the master.
+*/
+QString WorksheetPrivate::formulaText(int row, int col, const CellFormula &formula) const
+{
+    if (formula.formulaType() != CellFormula::SharedType || !formula.formulaText().isEmpty())
+        return formula.formulaText();
+    return sharedFormulaTemplates.value(formula.sharedIndex()).formulaAt(row, col);
+}
+
+/*
+  Add the shared string references counted while loading the sheet
+  data to the shared string table, which is not safe to update from
+  the threads loading the sheets.
+*/
+void WorksheetPrivate::mergeSharedStringRefs()
+{
+    SharedStrings *sst = sharedStrings();
+    for (QHash<int, int>::const_iterator it = sharedStringRefs.constBegin();
+         it != sharedStringRefs.constEnd(); ++it)
+        sst->incRefByStringIndex(it.key(), it.value());
+    sharedStringRefs.clear();
 }
 
 void WorksheetPrivate::loadXmlColumnsInfo(QXmlStreamReader &reader)
@@ -2384,8 +3163,7 @@ void WorksheetPrivate::loadXmlMergeCells(QXmlStreamReader &reader)
         if (reader.tokenType() == QXmlStreamReader::StartElement) {
             if (reader.name() == QLatin1String("mergeCell")) {
                 QXmlStreamAttributes attrs = reader.attributes();
-                QString rangeStr = attrs.value(QLatin1String("ref")).toString();
-                merges.append(CellRange(rangeStr));
+                merges.append(CellRange(attrs.value(QLatin1String("ref"))));
             }
         }
     }
@@ -2663,18 +3441,43 @@ QList<QSharedPointer<XlsxRowInfo>> WorksheetPrivate::getRowInfoList(int rowFirst
     return rowInfoList;
 }
 
+namespace {
+
+/*
+ * Stores the rows and cells read by a SheetDataReader in the worksheet.
+ */
+class SheetDataLoader : public SheetDataReader::Handler
+{
+public:
+    explicit SheetDataLoader(WorksheetPrivate *d)
+        : d(d)
+    {
+    }
+
+    bool row(const SheetDataReader::Row &row) override { return d->loadSheetDataRow(row); }
+    void cell(const SheetDataReader::Cell &cell) override { d->loadSheetDataCell(cell); }
+
+private:
+    WorksheetPrivate *d;
+};
+
+} // namespace
+
 bool Worksheet::loadFromXmlFile(QIODevice *device)
 {
     Q_D(Worksheet);
 
-    QXmlStreamReader reader(device);
+    // The cells of <sheetData> are read by the SheetDataReader, the
+    // QXmlStreamReader gets the rest of the part.
+    SheetDataLoader loader(d);
+    SheetDataReader sheetData(device, &loader);
+    QXmlStreamReader reader(&sheetData);
     while (!reader.atEnd()) {
         reader.readNextStartElement();
         if (reader.tokenType() == QXmlStreamReader::StartElement) {
             if (reader.name() == QLatin1String("dimension")) {
                 QXmlStreamAttributes attributes = reader.attributes();
-                QString range = attributes.value(QLatin1String("ref")).toString();
-                d->dimension = CellRange(range);
+                d->dimension = CellRange(attributes.value(QLatin1String("ref")));
             } else if (reader.name() == QLatin1String("sheetViews")) {
                 d->loadXmlSheetViews(reader);
             } else if (reader.name() == QLatin1String("sheetFormatPr")) {
@@ -2725,23 +3528,7 @@ void WorksheetPrivate::validateDimension()
     if (dimension.isValid() || cellTable.isEmpty())
         return;
 
-    const auto firstRow = cellTable.constBegin().key();
-    const auto lastRow = (--cellTable.constEnd()).key();
-    int firstColumn = -1;
-    int lastColumn = -1;
-
-    for (QMap<int, QMap<int, QSharedPointer<Cell>>>::const_iterator it = cellTable.begin();
-         it != cellTable.end(); ++it) {
-        Q_ASSERT(!it.value().isEmpty());
-
-        if (firstColumn == -1 || it.value().constBegin().key() < firstColumn)
-            firstColumn = it.value().constBegin().key();
-
-        if (lastColumn == -1 || (--it.value().constEnd()).key() > lastColumn)
-            lastColumn = (--it.value().constEnd()).key();
-    }
-
-    CellRange cr(firstRow, firstColumn, lastRow, lastColumn);
+    CellRange cr = cellTable.boundingRange();
 
     if (cr.isValid())
         dimension = cr;
@@ -2756,4 +3543,27 @@ SharedStrings *WorksheetPrivate::sharedStrings() const
     return workbook->sharedStrings();
 }
 
+/*
+  The worksheet named \a name, ignoring case, in the workbook of this
+  sheet, or 0. The sheet is loaded if it hasn't been yet.
+*/
+WorksheetPrivate *WorksheetPrivate::findWorksheet(const QString &name) const
+{
+    if (name.compare(this->name, Qt::CaseInsensitive) == 0)
+        return const_cast<WorksheetPrivate *>(this);
+    if (!workbook)
+        return 0;
+
+    const QStringList names = workbook->worksheetNames();
+    for (int i = 0; i < names.size(); ++i) {
+        if (names[i].compare(name, Qt::CaseInsensitive) != 0)
+            continue;
+        AbstractSheet *sheet = workbook->sheet(i);
+        if (!sheet || sheet->sheetType() != AbstractSheet::ST_WorkSheet)
+            return 0;
+        return static_cast<Worksheet *>(sheet)->d_func();
+    }
+    return 0;
+}
+
 QT_END_NAMESPACE_XLSX
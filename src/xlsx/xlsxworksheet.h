@@ -59,11 +59,23 @@ class Q_XLSX_EXPORT Worksheet : public AbstractSheet
 {
     Q_DECLARE_PRIVATE(Worksheet)
 public:
+    struct Q_XLSX_EXPORT CalculationStats
+    {
+        CalculationStats();
+
+        int formulas;
+        int dirty;
+        int recomputed;
+        int circular;
+        bool rebuilt;
+    };
+
     bool write(const CellReference &row_column, const QVariant &value,
                const Format &format = Format());
     bool write(int row, int column, const QVariant &value, const Format &format = Format());
     QVariant read(const CellReference &row_column) const;
     QVariant read(int row, int column) const;
+    QStringList readFormulas(const CellRange &range) const;
     bool writeString(const CellReference &row_column, const QString &value,
                      const Format &format = Format());
     bool writeString(int row, int column, const QString &value, const Format &format = Format());
@@ -92,6 +104,23 @@ public:
                    const Format &format = Format());
     bool writeTime(int row, int column, const QTime &t, const Format &format = Format());
 
+    bool writeRow(int row, int column, const double *values, int count,
+                  const Format &format = Format());
+    bool writeRow(int row, int column, const QList<double> &values,
+                  const Format &format = Format());
+    bool writeRow(int row, int column, const QStringList &values,
+                  const Format &format = Format());
+    bool writeColumn(int row, int column, const double *values, int count,
+                     const Format &format = Format());
+    bool writeColumn(int row, int column, const QList<double> &values,
+                     const Format &format = Format());
+    bool writeColumn(int row, int column, const QStringList &values,
+                     const Format &format = Format());
+    bool writeBlock(const CellRange &range, const double *values,
+                    const Format &format = Format());
+    bool writeBlock(const CellRange &range, const QList<double> &values,
+                    const Format &format = Format());
+
     bool writeHyperlink(const CellReference &row_column, const QUrl &url,
                         const Format &format = Format(), const QString &display = QString(),
                         const QString &tip = QString());
@@ -169,6 +198,12 @@ public:
     bool isWhiteSpaceVisible() const;
     void setWhiteSpaceVisible(bool visible);
 
+    bool isStreamingEnabled() const;
+    bool setStreamingEnabled(bool enable = true);
+
+    int recalculate();
+    CalculationStats calculationStats() const;
+
     ~Worksheet();
 
 private:
@@ -42,13 +42,21 @@
 #include "xlsxdatavalidation.h"
 #include "xlsxconditionalformatting.h"
 #include "xlsxcellformula.h"
+#include "xlsxcelltable_p.h"
+#include "xlsxsheetdatareader_p.h"
+#include "xlsxsharedformula_p.h"
+#include "xlsxformulaengine_p.h"
 
+#include <QBitArray>
+#include <QHash>
 #include <QImage>
 #include <QSharedPointer>
+#include <QScopedPointer>
 #include <QRegularExpression>
 
 class QXmlStreamWriter;
 class QXmlStreamReader;
+class QTemporaryFile;
 class OleObject;
 
 namespace QXlsx {
@@ -58,6 +66,7 @@ const int XLSX_COLUMN_MAX = 16384;
 const int XLSX_STRING_MAX = 32767;
 
 class SharedStrings;
+class SheetDataWriter;
 
 struct XlsxHyperlinkData
 {
@@ -155,6 +164,56 @@ struct XlsxColumnInfo
     bool collapsed;
 };
 
+/*
+  Content of one <c> element of <sheetData>.
+*/
+struct XlsxCellData
+{
+    XlsxCellData()
+        : styleIndex(-1)
+        , cellType(Cell::NumberType)
+        , hasValue(false)
+    {
+    }
+
+    CellReference pos;
+    int styleIndex; // "s" attribute, -1 when missing
+    Cell::CellType cellType;
+    CellFormula formula;
+    QString value; // text of <v>, or of <is><t> for inline strings
+    bool hasValue;
+};
+
+/*
+  The cells kept when a sheet is loaded, see Document::LoadOptions.
+*/
+struct XlsxLoadProjection
+{
+    XlsxLoadProjection()
+        : enabled(false)
+        , firstRow(1)
+        , lastRow(-1)
+    {
+    }
+
+    inline bool containsRow(int row) const
+    {
+        return row >= firstRow && (lastRow < 0 || row <= lastRow);
+    }
+    inline bool contains(const CellReference &pos) const
+    {
+        return containsRow(pos.row())
+               && (columns.isEmpty()
+                   || (pos.column() > 0 && pos.column() < columns.size()
+                       && columns.testBit(pos.column())));
+    }
+
+    bool enabled;
+    QBitArray columns; // indexed by column, empty for all columns
+    int firstRow;
+    int lastRow; // -1 for all the rows from firstRow on
+};
+
 class XLSX_AUTOTEST_EXPORT WorksheetPrivate : public AbstractSheetPrivate
 {
     Q_DECLARE_PUBLIC(Worksheet)
@@ -162,15 +221,30 @@ public:
     WorksheetPrivate(Worksheet *p, Worksheet::CreateFlag flag);
     ~WorksheetPrivate();
     int checkDimensions(int row, int col, bool ignore_row = false, bool ignore_col = false);
+    int checkRangeDimensions(int firstRow, int firstCol, int lastRow, int lastCol);
+    int bulkStyleIndex(const Format &format);
+    bool writeNumbers(int row, int col, int rows, int cols, const double *values,
+                      const Format &format);
+    bool writeStrings(int row, int col, int rows, int cols, const QStringList &values,
+                      const Format &format);
     Format cellFormat(int row, int col) const;
+    Cell *cellAt(int row, int col) const;
+    QVariant cellValue(int row, int col, const CellTable::Entry &entry) const;
+    static int styleIndex(const Format &format);
     QString generateDimensionString() const;
     void calculateSpans() const;
+    int nextUsedRow(int row) const;
     void splitColsInfo(int colFirst, int colLast);
     void validateDimension();
 
     void saveXmlSheetData(QXmlStreamWriter &writer) const;
-    void saveXmlCellData(QXmlStreamWriter &writer, int row, int col,
-                         QSharedPointer<Cell> cell) const;
+    QHash<quint64, CellFormula> sharedFormulaRuns() const;
+    void saveXmlRow(SheetDataWriter &writer, int row_num, const QString &span,
+                    const QHash<quint64, CellFormula> *formulas = 0) const;
+    QString rowSpan(int row) const;
+    bool advanceStreamRow(int row);
+    void saveXmlCellData(SheetDataWriter &writer, int row, int col, const CellTable::Entry &cell,
+                         const QHash<quint64, CellFormula> *formulas = 0) const;
     void saveXmlMergeCells(QXmlStreamWriter &writer) const;
     void saveXmlHyperlinks(QXmlStreamWriter &writer) const;
     void saveXmlDrawings(QXmlStreamWriter &writer) const;
@@ -180,6 +254,15 @@ public:
     int colPixelsSize(int col) const;
 
     void loadXmlSheetData(QXmlStreamReader &reader);
+    void loadXmlRowInfo(const QXmlStreamAttributes &attributes);
+    void storeXmlCell(const XlsxCellData &cell, QByteArrayView utf8Value = QByteArrayView());
+    bool loadSheetDataRow(const SheetDataReader::Row &row);
+    void loadSheetDataCell(const SheetDataReader::Cell &data);
+    static CellFormula loadSheetDataFormula(const SheetDataReader::Cell &data);
+    void storeSharedFormula(const CellFormula &formula);
+    QString formulaText(int row, int col, const CellFormula &formula) const;
+    void mergeSharedStringRefs();
+    static void loadXmlCell(QXmlStreamReader &reader, XlsxCellData *cell);
     void loadXmlColumnsInfo(QXmlStreamReader &reader);
     void loadXmlMergeCells(QXmlStreamReader &reader);
     void loadXmlDataValidations(QXmlStreamReader &reader);
@@ -195,8 +278,17 @@ public:
     bool isColumnRangeValid(int colFirst, int colLast);
 
     SharedStrings *sharedStrings() const;
+    WorksheetPrivate *findWorksheet(const QString &name) const;
 
-    QMap<int, QMap<int, QSharedPointer<Cell>>> cellTable;
+    // The formulas referring to written cells are recomputed by the
+    // next Worksheet::recalculate()
+    inline void cellsWritten(const CellRange &range)
+    {
+        if (formulaEngine)
+            formulaEngine->cellsWritten(range);
+    }
+
+    CellTable cellTable;
     QMap<int, QMap<int, QString>> comments;
     QMap<int, QMap<int, QSharedPointer<XlsxHyperlinkData>>> urlTable;
     QList<CellRange> merges;
@@ -207,6 +299,17 @@ public:
     QList<DataValidation> dataValidationsList;
     QList<ConditionalFormatting> conditionalFormattingList;
     QMap<int, CellFormula> sharedFormulaMap;
+    QMap<int, SharedFormulaTemplate> sharedFormulaTemplates; // of sharedFormulaMap
+    QScopedPointer<FormulaEngine> formulaEngine; // created by the first recalculation
+
+    // References to the shared strings counted by loadXmlSheetData(),
+    // kept until mergeSharedStringRefs() when the sheet is loaded on
+    // a worker thread.
+    QHash<int, int> sharedStringRefs;
+    bool deferSharedStringRefs;
+
+    // Only these cells are kept by loadXmlSheetData()
+    XlsxLoadProjection loadProjection;
 
     void addOleObjectFile(QSharedPointer<OleObject> obj, bool force=false);
     QList<QSharedPointer<OleObject> > oleObjectFiles() const;
@@ -239,6 +342,12 @@ public:
 
     QRegularExpression urlPattern;
 
+    // Streaming write mode, completed rows are kept in streamFile only
+    bool streaming;
+    int streamRow; // last completed row
+    QScopedPointer<QTemporaryFile> streamFile;
+    QScopedPointer<QXmlStreamWriter> streamWriter;
+
 private:
     static double calculateColWidth(int characters);
     QList<QSharedPointer<OleObject>> m_oleObjectFiles;
@@ -25,20 +25,155 @@
 
 #include "xlsxzipreader_p.h"
 
-#include <private/qzipreader_p.h>
-#include <QtCore/qvector.h>
+#include <QBuffer>
+#include <QFile>
+#include <QtEndian>
+
+#include <zlib.h>
 
 namespace QXlsx {
 
+// Zip format constants, see APPNOTE.TXT of PKWARE.
+enum {
+    LocalHeaderSignature = 0x04034b50,
+    CentralHeaderSignature = 0x02014b50,
+    EndOfCentralDirSignature = 0x06054b50,
+    LocalHeaderSize = 30,
+    CentralHeaderSize = 46,
+    EndOfCentralDirSize = 22,
+    MaxCommentSize = 0xffff,
+    MethodStored = 0,
+    MethodDeflated = 8
+};
+
+static inline quint16 readUInt16(const char *data)
+{
+    return qFromLittleEndian<quint16>(data);
+}
+
+static inline quint32 readUInt32(const char *data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+/*!
+ * \internal
+ *
+ * Sequential read only device that inflates a raw deflate stream on
+ * demand. The compressed bytes are read in place, so only the zlib
+ * state and the caller's read buffer are held in memory.
+ */
+class ZipInflateDevice : public QIODevice
+{
+public:
+    ZipInflateDevice(const char *data, qint64 compressedSize, qint64 uncompressedSize)
+        : m_remaining(uncompressedSize)
+        , m_error(false)
+    {
+        m_stream.zalloc = Z_NULL;
+        m_stream.zfree = Z_NULL;
+        m_stream.opaque = Z_NULL;
+        m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        m_stream.avail_in = uInt(compressedSize);
+        m_initialized = inflateInit2(&m_stream, -MAX_WBITS) == Z_OK;
+        open(QIODevice::ReadOnly);
+    }
+
+    ~ZipInflateDevice()
+    {
+        if (m_initialized)
+            inflateEnd(&m_stream);
+    }
+
+    bool isSequential() const override { return true; }
+
+    qint64 bytesAvailable() const override
+    {
+        return (m_error ? 0 : m_remaining) + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        if (!m_initialized || m_error) {
+            setErrorString(QStringLiteral("Corrupt deflate stream"));
+            return -1;
+        }
+        const qint64 wanted = qMin(maxSize, m_remaining);
+        if (wanted <= 0)
+            return 0;
+
+        m_stream.next_out = reinterpret_cast<Bytef *>(data);
+        m_stream.avail_out = uInt(wanted);
+        const int ret = inflate(&m_stream, Z_NO_FLUSH);
+        const qint64 produced = wanted - m_stream.avail_out;
+        // Every call must make progress until the declared size is
+        // reached; a stream that ends early or stalls is truncated.
+        if ((ret != Z_OK && ret != Z_STREAM_END) || produced == 0) {
+            m_error = true;
+            setErrorString(QStringLiteral("Corrupt deflate stream"));
+            return -1;
+        }
+        m_remaining -= produced;
+        return produced;
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    z_stream m_stream;
+    qint64 m_remaining;
+    bool m_initialized;
+    bool m_error;
+};
+
+/*!
+ * \internal
+ *
+ * \class ZipReader
+ *
+ * Reads the entries of a zip package. The archive is memory mapped when
+ * it lives in a file, otherwise its bytes are held in memory once. The
+ * central directory is indexed by path on construction, so lookups do
+ * not scan the entry list.
+ *
+ * Entries are read from the mapped bytes without touching the source
+ * device, all const members can be called from several threads at the
+ * same time.
+ */
 ZipReader::ZipReader(const QString &filePath)
-    : m_reader(new QZipReader(filePath))
+    : m_data(0)
+    , m_size(0)
+    , m_exists(false)
 {
+    mapFile(filePath);
     init();
 }
 
+/*!
+ * \internal
+ *
+ * Reads the package from \a device. A QFile is mapped through its own
+ * handle and a QBuffer is shared, other devices are read completely.
+ * The \a device is not used after the constructor returns.
+ */
 ZipReader::ZipReader(QIODevice *device)
-    : m_reader(new QZipReader(device))
+    : m_data(0)
+    , m_size(0)
+    , m_exists(false)
 {
+    QFile *file = qobject_cast<QFile *>(device);
+    if (!file || file->fileName().isEmpty() || !mapFile(file->fileName())) {
+        if (QBuffer *buffer = qobject_cast<QBuffer *>(device)) {
+            m_buffer = buffer->data();
+        } else if (device && device->isReadable()) {
+            if (!device->isSequential())
+                device->seek(0);
+            m_buffer = device->readAll();
+        }
+        m_data = m_buffer.constData();
+        m_size = m_buffer.size();
+    }
     init();
 }
 
@@ -46,28 +181,214 @@ ZipReader::~ZipReader()
 {
 }
 
+bool ZipReader::mapFile(const QString &filePath)
+{
+    m_file.reset(new QFile(filePath));
+    if (!m_file->open(QIODevice::ReadOnly)) {
+        m_file.reset();
+        return false;
+    }
+    const qint64 size = m_file->size();
+    uchar *data = size > 0 ? m_file->map(0, size) : 0;
+    if (data) {
+        m_data = reinterpret_cast<const char *>(data);
+        m_size = size;
+    } else {
+        // Not mappable, e.g. an empty file or an unsupported file system.
+        m_buffer = m_file->readAll();
+        m_file.reset();
+        m_data = m_buffer.constData();
+        m_size = m_buffer.size();
+    }
+    return true;
+}
+
 void ZipReader::init()
 {
-    const auto& allFiles = m_reader->fileInfoList();
-    for (const auto &fi : allFiles) {
-        if (fi.isFile)
-            m_filePaths.append(fi.filePath);
+    m_exists = m_data && readCentralDirectory();
+}
+
+bool ZipReader::readCentralDirectory()
+{
+    if (m_size < EndOfCentralDirSize)
+        return false;
+
+    // The end record is followed by a comment of up to 64 KB.
+    qint64 eocd = m_size - EndOfCentralDirSize;
+    const qint64 last = qMax<qint64>(0, eocd - MaxCommentSize);
+    while (eocd >= last && readUInt32(m_data + eocd) != EndOfCentralDirSignature)
+        --eocd;
+    if (eocd < last)
+        return false;
+
+    const int count = readUInt16(m_data + eocd + 10);
+    const qint64 dirSize = readUInt32(m_data + eocd + 12);
+    const qint64 dirOffset = readUInt32(m_data + eocd + 16);
+    if (dirOffset + dirSize > eocd)
+        return false;
+
+    m_entries.reserve(count);
+    const char *p = m_data + dirOffset;
+    const char *end = p + dirSize;
+    for (int i = 0; i < count; ++i) {
+        if (end - p < CentralHeaderSize || readUInt32(p) != CentralHeaderSignature)
+            return false;
+        const quint16 flags = readUInt16(p + 8);
+        const int nameLength = readUInt16(p + 28);
+        const int extraLength = readUInt16(p + 30);
+        const int commentLength = readUInt16(p + 32);
+        if (end - p < CentralHeaderSize + nameLength + extraLength + commentLength)
+            return false;
+
+        // Bit 11 marks UTF-8 names; the parts of an xlsx package are
+        // ASCII in practice, so the legacy code page is read as UTF-8 too.
+        const QString name = QString::fromUtf8(p + CentralHeaderSize, nameLength);
+        if (!name.isEmpty() && !name.endsWith(QLatin1Char('/'))) {
+            Entry entry;
+            entry.flags = flags;
+            entry.method = readUInt16(p + 10);
+            entry.crc = readUInt32(p + 16);
+            entry.compressedSize = readUInt32(p + 20);
+            entry.uncompressedSize = readUInt32(p + 24);
+            entry.headerOffset = readUInt32(p + 42);
+            if (!m_entries.contains(name))
+                m_filePaths.append(name);
+            m_entries.insert(name, entry);
+        }
+        p += CentralHeaderSize + nameLength + extraLength + commentLength;
     }
+    return true;
+}
+
+/*
+ * Returns the first byte of the (compressed) data of \a entry, or 0 when
+ * the local header or the data lie outside the archive.
+ */
+const char *ZipReader::entryData(const Entry &entry) const
+{
+    if (entry.headerOffset + LocalHeaderSize > m_size)
+        return 0;
+    const char *header = m_data + entry.headerOffset;
+    if (readUInt32(header) != LocalHeaderSignature)
+        return 0;
+    // The local extra field may differ from the central one.
+    const qint64 offset = entry.headerOffset + LocalHeaderSize + readUInt16(header + 26)
+                          + readUInt16(header + 28);
+    if (offset + entry.compressedSize > m_size)
+        return 0;
+    return m_data + offset;
 }
 
+/*!
+ * \internal
+ *
+ * Returns true when the package was read and its central directory
+ * could be parsed.
+ */
 bool ZipReader::exists() const
 {
-    return m_reader->exists();
+    return m_exists;
 }
 
+/*!
+ * \internal
+ *
+ * Returns the paths of all file entries in central directory order.
+ */
 QStringList ZipReader::filePaths() const
 {
     return m_filePaths;
 }
 
+/*!
+ * \internal
+ *
+ * Returns true when the package has a file entry named \a filePath.
+ */
+bool ZipReader::contains(const QString &filePath) const
+{
+    return m_entries.contains(filePath);
+}
+
+/*!
+ * \internal
+ *
+ * Returns the uncompressed size of \a filePath, or -1 when there is no
+ * such entry.
+ */
+qint64 ZipReader::fileSize(const QString &filePath) const
+{
+    QHash<QString, Entry>::const_iterator it = m_entries.constFind(filePath);
+    return it == m_entries.constEnd() ? -1 : it->uncompressedSize;
+}
+
+/*!
+ * \internal
+ *
+ * Returns a copy of the uncompressed content of \a fileName, an empty
+ * array when the entry is missing or can not be read.
+ */
 QByteArray ZipReader::fileData(const QString &fileName) const
 {
-    return m_reader->fileData(fileName);
+    QHash<QString, Entry>::const_iterator it = m_entries.constFind(fileName);
+    if (it == m_entries.constEnd())
+        return QByteArray();
+    const char *data = entryData(*it);
+    if (!data)
+        return QByteArray();
+
+    if (it->method == MethodStored)
+        return QByteArray(data, qsizetype(it->compressedSize));
+    if (it->method != MethodDeflated || it->uncompressedSize == 0)
+        return QByteArray();
+
+    QByteArray result(qsizetype(it->uncompressedSize), Qt::Uninitialized);
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream.avail_in = uInt(it->compressedSize);
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return QByteArray();
+    stream.next_out = reinterpret_cast<Bytef *>(result.data());
+    stream.avail_out = uInt(result.size());
+    const int ret = inflate(&stream, Z_FINISH);
+    const qint64 produced = qint64(stream.total_out);
+    inflateEnd(&stream);
+    if (ret != Z_STREAM_END || produced != it->uncompressedSize)
+        return QByteArray();
+    return result;
+}
+
+/*!
+ * \internal
+ *
+ * Opens \a filePath for reading and returns a device owned by the
+ * caller, or 0 when the entry is missing or can not be read.
+ *
+ * Deflated entries are inflated while they are read, stored entries are
+ * exposed without a copy. The device reads straight from the package,
+ * so it must be deleted before the ZipReader.
+ */
+QIODevice *ZipReader::openFile(const QString &filePath) const
+{
+    QHash<QString, Entry>::const_iterator it = m_entries.constFind(filePath);
+    if (it == m_entries.constEnd())
+        return 0;
+    const char *data = entryData(*it);
+    if (!data)
+        return 0;
+
+    if (it->method == MethodStored) {
+        QBuffer *buffer = new QBuffer;
+        buffer->setData(QByteArray::fromRawData(data, qsizetype(it->compressedSize)));
+        buffer->open(QIODevice::ReadOnly);
+        return buffer;
+    }
+    if (it->method == MethodDeflated)
+        return new ZipInflateDevice(data, it->compressedSize, it->uncompressedSize);
+    return 0;
 }
 
 } // namespace QXlsx
@@ -38,9 +38,11 @@
 //
 
 #include "xlsxglobal.h"
+#include <QByteArray>
+#include <QHash>
 #include <QScopedPointer>
 #include <QStringList>
-class QZipReader;
+class QFile;
 class QIODevice;
 
 namespace QXlsx {
@@ -53,13 +55,36 @@ public:
     ~ZipReader();
     bool exists() const;
     QStringList filePaths() const;
+    bool contains(const QString &filePath) const;
+    qint64 fileSize(const QString &filePath) const;
     QByteArray fileData(const QString &fileName) const;
+    QIODevice *openFile(const QString &filePath) const;
 
 private:
     Q_DISABLE_COPY(ZipReader)
+
+    struct Entry
+    {
+        quint16 flags;
+        quint16 method;
+        quint32 crc;
+        qint64 compressedSize;
+        qint64 uncompressedSize;
+        qint64 headerOffset;
+    };
+
     void init();
-    QScopedPointer<QZipReader> m_reader;
+    bool mapFile(const QString &filePath);
+    bool readCentralDirectory();
+    const char *entryData(const Entry &entry) const;
+
+    QScopedPointer<QFile> m_file;
+    QByteArray m_buffer;
+    const char *m_data;
+    qint64 m_size;
+    bool m_exists;
     QStringList m_filePaths;
+    QHash<QString, Entry> m_entries;
 };
 
 } // namespace QXlsx
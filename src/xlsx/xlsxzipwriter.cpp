@@ -23,46 +23,842 @@
 **
 ****************************************************************************/
 #include "xlsxzipwriter_p.h"
-#include <QDebug>
-#include <private/qzipwriter_p.h>
+
+#include <QDateTime>
+#include <QFile>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QtEndian>
+
+#include <zlib.h>
 
 namespace QXlsx {
 
+// Zip format constants, see APPNOTE.TXT of PKWARE.
+// Zip64 is not supported, every size and offset must fit in 32 bits.
+enum {
+    LocalHeaderSignature = 0x04034b50,
+    DataDescriptorSignature = 0x08074b50,
+    CentralHeaderSignature = 0x02014b50,
+    EndOfCentralDirSignature = 0x06054b50,
+    VersionNeeded = 20,
+    FlagDataDescriptor = 0x0008,
+    FlagUtf8 = 0x0800,
+    MethodStored = 0,
+    MethodDeflated = 8,
+    OutputBufferSize = 64 * 1024,
+    ParallelBlockSize = 128 * 1024,
+    DictionarySize = 32 * 1024
+};
+
+static const qint64 MaxZipSize = Q_INT64_C(0xffffffff);
+
+/*!
+ * \internal
+ *
+ * One block of a parallel deflate stream. The block is compressed as a
+ * raw deflate stream primed with the last 32 KB of the data before it
+ * and ended with a sync flush, so consecutive blocks concatenate into
+ * a single valid deflate stream. Only the last block sets the final bit.
+ */
+class ZipDeflateBlock : public QRunnable
+{
+public:
+    ZipDeflateBlock(const QByteArray &input, const QByteArray &dictionary, int level, bool last)
+        : input(input)
+        , dictionary(dictionary)
+        , inputSize(input.size())
+        , level(level)
+        , last(last)
+        , crc(0)
+        , error(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override;
+
+    QByteArray input;
+    QByteArray dictionary;
+    qint64 inputSize;
+    int level;
+    bool last;
+    QByteArray output;
+    quint32 crc;
+    bool error;
+    QSemaphore done;
+};
+
+void ZipDeflateBlock::run()
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    error = deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK;
+    if (!error) {
+        if (!dictionary.isEmpty())
+            deflateSetDictionary(&stream, reinterpret_cast<const Bytef *>(dictionary.constData()),
+                                 uInt(dictionary.size()));
+        // deflateBound() covers Z_FINISH, a sync flush adds an empty stored block.
+        output.resize(qsizetype(deflateBound(&stream, uLong(input.size()))) + 16);
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.constData()));
+        stream.avail_in = uInt(input.size());
+        stream.next_out = reinterpret_cast<Bytef *>(output.data());
+        stream.avail_out = uInt(output.size());
+        const int ret = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        error = last ? ret != Z_STREAM_END : (ret != Z_OK || stream.avail_out == 0);
+        output.resize(qsizetype(stream.total_out));
+        deflateEnd(&stream);
+    }
+    crc = crc32(0, reinterpret_cast<const Bytef *>(input.constData()), uInt(input.size()));
+
+    input = QByteArray();
+    dictionary = QByteArray();
+    done.release();
+}
+
+/*!
+ * \internal
+ *
+ * Raw deflate stream of one zip entry. The compressed output is written
+ * to \a sink as it is produced, while the crc and sizes needed by the
+ * zip headers are accumulated.
+ *
+ * A stored stream copies the input to \a sink unchanged.
+ *
+ * In parallel mode the input is cut into 128 KB blocks that are
+ * compressed on the global thread pool, pigz style, and written in
+ * order; the crc of the blocks is combined with crc32_combine().
+ */
+class ZipDeflater
+{
+public:
+    explicit ZipDeflater(QIODevice *sink);
+    ~ZipDeflater();
+
+    void reset();
+    void setCompressionLevel(int level);
+    void setStored(bool stored);
+    void setParallel(bool parallel);
+    bool write(const char *data, qint64 len);
+    bool finish();
+
+    bool error() const { return m_error; }
+    bool isStored() const { return m_stored; }
+    quint32 crc() const { return m_crc; }
+    qint64 compressedSize() const { return m_compressedSize; }
+    qint64 uncompressedSize() const { return m_uncompressedSize; }
+
+private:
+    bool deflateData(const char *data, qint64 len, bool finish);
+    bool flushOutput();
+    bool startBlock(bool last);
+    bool writeBlock(ZipDeflateBlock *block);
+    void waitForBlocks();
+
+    QIODevice *m_sink;
+    z_stream m_stream;
+    QByteArray m_outBuffer;
+    quint32 m_crc;
+    qint64 m_compressedSize;
+    qint64 m_uncompressedSize;
+    bool m_error;
+
+    int m_level;
+    bool m_stored;
+    bool m_parallel;
+    QByteArray m_block;
+    QByteArray m_dictionary;
+    QList<ZipDeflateBlock *> m_pendingBlocks;
+};
+
+ZipDeflater::ZipDeflater(QIODevice *sink)
+    : m_sink(sink)
+    , m_outBuffer(OutputBufferSize, Qt::Uninitialized)
+    , m_level(Z_DEFAULT_COMPRESSION)
+    , m_stored(false)
+    , m_parallel(false)
+{
+    m_stream.zalloc = Z_NULL;
+    m_stream.zfree = Z_NULL;
+    m_stream.opaque = Z_NULL;
+    m_error = deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                           Z_DEFAULT_STRATEGY) != Z_OK;
+    reset();
+}
+
+ZipDeflater::~ZipDeflater()
+{
+    waitForBlocks();
+    deflateEnd(&m_stream);
+}
+
+void ZipDeflater::reset()
+{
+    waitForBlocks();
+    m_block = QByteArray();
+    m_dictionary = QByteArray();
+    deflateReset(&m_stream);
+    m_stream.next_out = reinterpret_cast<Bytef *>(m_outBuffer.data());
+    m_stream.avail_out = OutputBufferSize;
+    m_crc = crc32(0, Z_NULL, 0);
+    m_compressedSize = 0;
+    m_uncompressedSize = 0;
+}
+
+/*!
+ * Sets the zlib compression \a level, from 0 to 9 or -1 for the default.
+ * It must be set before anything is written to the stream.
+ */
+void ZipDeflater::setCompressionLevel(int level)
+{
+    if (level < Z_DEFAULT_COMPRESSION || level > Z_BEST_COMPRESSION)
+        level = Z_DEFAULT_COMPRESSION;
+    if (level != m_level && deflateParams(&m_stream, level, Z_DEFAULT_STRATEGY) != Z_OK)
+        m_error = true;
+    m_level = level;
+}
+
+/*!
+ * Copies the data unchanged instead of deflating it, for entries stored
+ * with method 0. It must be set before anything is written to the stream.
+ */
+void ZipDeflater::setStored(bool stored)
+{
+    m_stored = stored;
+}
+
+/*!
+ * Enables or disables block parallel compression. It must be set before
+ * anything is written to the stream.
+ */
+void ZipDeflater::setParallel(bool parallel)
+{
+    m_parallel = parallel;
+}
+
+bool ZipDeflater::write(const char *data, qint64 len)
+{
+    if (m_error)
+        return false;
+
+    m_uncompressedSize += len;
+    if (m_parallel && !m_stored) {
+        while (len > 0) {
+            const qint64 chunk = qMin(len, qint64(ParallelBlockSize - m_block.size()));
+            if (m_block.isEmpty())
+                m_block.reserve(ParallelBlockSize);
+            m_block.append(data, chunk);
+            data += chunk;
+            len -= chunk;
+            if (m_block.size() == ParallelBlockSize && !startBlock(false))
+                return false;
+        }
+        return true;
+    }
+
+    const char *ptr = data;
+    for (qint64 left = len; left > 0;) {
+        const uInt chunk = uInt(qMin(left, qint64(1) << 30));
+        m_crc = crc32(m_crc, reinterpret_cast<const Bytef *>(ptr), chunk);
+        ptr += chunk;
+        left -= chunk;
+    }
+    if (m_stored) {
+        m_compressedSize += len;
+        if (len > 0 && m_sink->write(data, len) != len)
+            m_error = true;
+        return !m_error;
+    }
+    return deflateData(data, len, false);
+}
+
+bool ZipDeflater::finish()
+{
+    if (m_error)
+        return false;
+    if (m_stored)
+        return true;
+    if (!m_parallel)
+        return deflateData(0, 0, true);
+
+    if (m_pendingBlocks.isEmpty()) {
+        // Small entries are a single block, no need to leave this thread.
+        ZipDeflateBlock block(m_block, m_dictionary, m_level, true);
+        m_block = QByteArray();
+        block.run();
+        return writeBlock(&block);
+    }
+    if (!startBlock(true))
+        return false;
+    while (!m_pendingBlocks.isEmpty()) {
+        QScopedPointer<ZipDeflateBlock> block(m_pendingBlocks.takeFirst());
+        if (!writeBlock(block.data()))
+            return false;
+    }
+    return true;
+}
+
+bool ZipDeflater::startBlock(bool last)
+{
+    ZipDeflateBlock *block = new ZipDeflateBlock(m_block, m_dictionary, m_level, last);
+    if (m_block.size() >= DictionarySize)
+        m_dictionary = m_block.right(DictionarySize);
+    else
+        m_dictionary = (m_dictionary + m_block).right(DictionarySize);
+    m_block = QByteArray();
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    pool->start(block);
+    m_pendingBlocks.append(block);
+
+    // Bound the memory held by blocks in flight.
+    const int maxPending = 2 * qMax(pool->maxThreadCount(), 1);
+    while (m_pendingBlocks.size() > maxPending) {
+        QScopedPointer<ZipDeflateBlock> first(m_pendingBlocks.takeFirst());
+        if (!writeBlock(first.data()))
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Waits for \a block and appends its output to the stream. A block no
+ * thread has picked up yet is compressed here, so the pool can never be
+ * exhausted by threads waiting for their own blocks.
+ */
+bool ZipDeflater::writeBlock(ZipDeflateBlock *block)
+{
+    if (QThreadPool::globalInstance()->tryTake(block))
+        block->run();
+    block->done.acquire();
+
+    const qint64 size = block->output.size();
+    if (block->error || m_error) {
+        m_error = true;
+        return false;
+    }
+    m_crc = crc32_combine(m_crc, block->crc, z_off_t(block->inputSize));
+    m_compressedSize += size;
+    if (size > 0 && m_sink->write(block->output.constData(), size) != size)
+        m_error = true;
+    return !m_error;
+}
+
+void ZipDeflater::waitForBlocks()
+{
+    QThreadPool *pool = QThreadPool::globalInstance();
+    while (!m_pendingBlocks.isEmpty()) {
+        QScopedPointer<ZipDeflateBlock> block(m_pendingBlocks.takeFirst());
+        if (!pool->tryTake(block.data()))
+            block->done.acquire();
+    }
+}
+
+bool ZipDeflater::deflateData(const char *data, qint64 len, bool finish)
+{
+    do {
+        const uInt chunk = uInt(qMin(len, qint64(1) << 30));
+        m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        m_stream.avail_in = chunk;
+        data += chunk;
+        len -= chunk;
+
+        const int flush = (finish && len == 0) ? Z_FINISH : Z_NO_FLUSH;
+        int ret;
+        do {
+            if (m_stream.avail_out == 0 && !flushOutput())
+                return false;
+            ret = deflate(&m_stream, flush);
+            if (ret == Z_STREAM_ERROR) {
+                m_error = true;
+                return false;
+            }
+        } while (m_stream.avail_in != 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+    } while (len > 0);
+
+    return finish ? flushOutput() : true;
+}
+
+bool ZipDeflater::flushOutput()
+{
+    const qint64 size = OutputBufferSize - m_stream.avail_out;
+    m_stream.next_out = reinterpret_cast<Bytef *>(m_outBuffer.data());
+    m_stream.avail_out = OutputBufferSize;
+    m_compressedSize += size;
+    if (size > 0 && m_sink->write(m_outBuffer.constData(), size) != size)
+        m_error = true;
+    return !m_error;
+}
+
+/*!
+ * \internal
+ *
+ * Write only device returned by ZipWriter::openFile(). Everything written
+ * to it is deflated straight into the zip package, so the uncompressed
+ * part is never held in memory.
+ */
+class ZipEntryDevice : public QIODevice
+{
+public:
+    explicit ZipEntryDevice(ZipWriter *writer)
+        : m_writer(writer)
+    {
+    }
+
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        return m_writer->writeEntryData(data, len) ? len : -1;
+    }
+
+private:
+    ZipWriter *m_writer;
+};
+
+/*!
+ * \internal
+ *
+ * \class ZipEntryBuffer
+ *
+ * Write only device that deflates everything written to it into memory.
+ * It allows a part to be rendered and compressed away from the thread
+ * that writes the package; the result is added with
+ * ZipWriter::addFile(). The device is open for writing on construction
+ * and close() finishes the stream.
+ */
+ZipEntryBuffer::ZipEntryBuffer()
+    : m_crc(0)
+    , m_uncompressedSize(0)
+    , m_error(false)
+    , m_stored(false)
+{
+    m_buffer.setBuffer(&m_data);
+    m_buffer.open(QIODevice::WriteOnly);
+    m_deflater = new ZipDeflater(&m_buffer);
+    open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+ZipEntryBuffer::~ZipEntryBuffer()
+{
+    delete m_deflater;
+}
+
+void ZipEntryBuffer::close()
+{
+    // The deflate state is much larger than a typical part, so it is
+    // released as soon as the stream is finished.
+    if (m_deflater) {
+        m_error = !m_deflater->finish();
+        m_crc = m_deflater->crc();
+        m_uncompressedSize = m_deflater->uncompressedSize();
+        delete m_deflater;
+        m_deflater = 0;
+        m_buffer.close();
+    }
+    QIODevice::close();
+}
+
+/*!
+ * Compresses large contents in 128 KB blocks on the global thread pool.
+ * Must be called before anything is written.
+ */
+void ZipEntryBuffer::setParallelDeflate(bool enable)
+{
+    if (m_deflater)
+        m_deflater->setParallel(enable);
+}
+
+/*!
+ * Sets the deflate compression \a level, from 1 to 9 or -1 for the zlib
+ * default. Level 0 stores the contents uncompressed, as method 0 entries.
+ * Must be called before anything is written.
+ */
+void ZipEntryBuffer::setCompressionLevel(int level)
+{
+    if (!m_deflater)
+        return;
+    m_stored = level == 0;
+    m_deflater->setStored(m_stored);
+    if (!m_stored)
+        m_deflater->setCompressionLevel(level);
+}
+
+bool ZipEntryBuffer::isStored() const
+{
+    return m_stored;
+}
+
+QByteArray ZipEntryBuffer::compressedData() const
+{
+    return m_data;
+}
+
+quint32 ZipEntryBuffer::crc() const
+{
+    return m_crc;
+}
+
+qint64 ZipEntryBuffer::uncompressedSize() const
+{
+    return m_uncompressedSize;
+}
+
+bool ZipEntryBuffer::error() const
+{
+    return m_error;
+}
+
+qint64 ZipEntryBuffer::readData(char *, qint64)
+{
+    return -1;
+}
+
+qint64 ZipEntryBuffer::writeData(const char *data, qint64 len)
+{
+    return m_deflater && m_deflater->write(data, len) ? len : -1;
+}
+
 ZipWriter::ZipWriter(const QString &filePath)
 {
-    m_writer = new QZipWriter(filePath, QIODevice::WriteOnly);
-    m_writer->setCompressionPolicy(QZipWriter::AutoCompress);
+    QFile *file = new QFile(filePath);
+    m_device = file;
+    m_ownDevice = true;
+    init();
+    if (!file->open(QIODevice::WriteOnly))
+        m_error = true;
 }
 
 ZipWriter::ZipWriter(QIODevice *device)
 {
-    m_writer = new QZipWriter(device);
-    m_writer->setCompressionPolicy(QZipWriter::AutoCompress);
+    m_device = device;
+    m_ownDevice = false;
+    init();
+    if (!m_device->isOpen())
+        m_device->open(QIODevice::WriteOnly);
+    if (!m_device->isWritable())
+        m_error = true;
 }
 
 ZipWriter::~ZipWriter()
 {
-    delete m_writer;
+    close();
+    delete m_deflater;
+    delete m_entryDevice;
+    if (m_ownDevice)
+        delete m_device;
+}
+
+void ZipWriter::init()
+{
+    m_closed = false;
+    m_error = false;
+    m_offset = 0;
+    m_entryDevice = 0;
+    m_deflater = 0;
+    m_parallelDeflate = false;
+    m_compressionLevel = -1;
+    m_current = Entry();
+
+    const QDateTime now = QDateTime::currentDateTime();
+    const QDate date = now.date();
+    const QTime time = now.time();
+    m_dosTime = quint16((time.hour() << 11) | (time.minute() << 5) | (time.second() / 2));
+    m_dosDate = quint16(((qMax(date.year(), 1980) - 1980) << 9) | (date.month() << 5) | date.day());
+}
+
+/*!
+ * Compresses the entries added afterwards in 128 KB blocks on the global
+ * thread pool, see ZipEntryBuffer::setParallelDeflate().
+ */
+void ZipWriter::setParallelDeflate(bool enable)
+{
+    m_parallelDeflate = enable;
+}
+
+/*!
+ * Sets the deflate compression \a level of the entries added afterwards,
+ * from 1 to 9 or -1 for the zlib default. With level 0 addFile() stores
+ * the data uncompressed; entries written through openFile() are still
+ * deflate streams, just without compression, as their size is not known
+ * up front.
+ */
+void ZipWriter::setCompressionLevel(int level)
+{
+    m_compressionLevel = level;
 }
 
 bool ZipWriter::error() const
 {
-    return m_writer->status() != QZipWriter::NoError;
+    return m_error;
+}
+
+ZipWriter::Entry ZipWriter::newEntry(const QString &filePath) const
+{
+    Entry entry;
+    entry.name = filePath.toUtf8();
+    entry.flags = 0;
+    for (char c : std::as_const(entry.name)) {
+        if (uchar(c) >= 0x80) {
+            entry.flags |= FlagUtf8;
+            break;
+        }
+    }
+    entry.method = MethodDeflated;
+    entry.crc = 0;
+    entry.compressedSize = 0;
+    entry.uncompressedSize = 0;
+    entry.offset = m_offset;
+    return entry;
+}
+
+/*!
+ * Starts a new deflated entry \a filePath and returns the device its
+ * contents should be written to. The sizes and crc are not known up front,
+ * so they follow the data in a data descriptor.
+ *
+ * The device stays valid until closeFile() is called or another file
+ * is added.
+ */
+QIODevice *ZipWriter::openFile(const QString &filePath)
+{
+    closeFile();
+
+    if (!m_deflater)
+        m_deflater = new ZipDeflater(m_device);
+    else
+        m_deflater->reset();
+    m_deflater->setCompressionLevel(m_compressionLevel);
+    m_deflater->setParallel(m_parallelDeflate);
+    if (!m_entryDevice)
+        m_entryDevice = new ZipEntryDevice(this);
+
+    m_current = newEntry(filePath);
+    m_current.flags |= FlagDataDescriptor;
+    writeLocalHeader(m_current);
+
+    m_entryDevice->open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    return m_entryDevice;
+}
+
+bool ZipWriter::writeEntryData(const char *data, qint64 len)
+{
+    if (m_error)
+        return false;
+    if (m_deflater->uncompressedSize() + len > MaxZipSize || !m_deflater->write(data, len)) {
+        m_error = true;
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * Finishes the entry started by openFile(). Returns false if the entry
+ * could not be written.
+ */
+bool ZipWriter::closeFile()
+{
+    if (!m_entryDevice || !m_entryDevice->isOpen())
+        return !m_error;
+    m_entryDevice->close();
+
+    if (m_error)
+        return false;
+    if (!m_deflater->finish() || m_deflater->compressedSize() > MaxZipSize) {
+        m_error = true;
+        return false;
+    }
+    m_offset += m_deflater->compressedSize();
+    m_current.crc = m_deflater->crc();
+    m_current.compressedSize = m_deflater->compressedSize();
+    m_current.uncompressedSize = m_deflater->uncompressedSize();
+
+    uchar descriptor[16];
+    qToLittleEndian<quint32>(DataDescriptorSignature, descriptor);
+    qToLittleEndian<quint32>(m_current.crc, descriptor + 4);
+    qToLittleEndian<quint32>(quint32(m_current.compressedSize), descriptor + 8);
+    qToLittleEndian<quint32>(quint32(m_current.uncompressedSize), descriptor + 12);
+    if (!write(reinterpret_cast<const char *>(descriptor), sizeof(descriptor)))
+        return false;
+
+    m_entries.append(m_current);
+    return true;
 }
 
 void ZipWriter::addFile(const QString &filePath, QIODevice *device)
 {
-    m_writer->addFile(filePath, device);
+    const bool opened = !device->isOpen();
+    if (opened && !device->open(QIODevice::ReadOnly)) {
+        m_error = true;
+        return;
+    }
+
+    QIODevice *entry = openFile(filePath);
+    QByteArray buffer;
+    while (!(buffer = device->read(OutputBufferSize)).isEmpty())
+        entry->write(buffer);
+    closeFile();
+
+    if (opened)
+        device->close();
 }
 
 void ZipWriter::addFile(const QString &filePath, const QByteArray &data)
 {
-    m_writer->addFile(filePath, data);
+    closeFile();
+
+    ZipEntryBuffer buffer;
+    buffer.setCompressionLevel(m_compressionLevel);
+    buffer.setParallelDeflate(m_parallelDeflate);
+    buffer.write(data);
+    buffer.close();
+
+    // Data that does not shrink under deflate, as the data of media
+    // files usually does not, is stored as is.
+    Entry entry = newEntry(filePath);
+    entry.crc = buffer.crc();
+    entry.uncompressedSize = data.size();
+    if (!buffer.error() && !buffer.isStored() && buffer.compressedData().size() < data.size()) {
+        addEntry(entry, buffer.compressedData());
+    } else {
+        entry.method = MethodStored;
+        addEntry(entry, data);
+    }
+}
+
+/*!
+ * Adds \a filePath with the contents compressed by the closed \a entry.
+ */
+void ZipWriter::addFile(const QString &filePath, const ZipEntryBuffer &entry)
+{
+    closeFile();
+    if (entry.error() || entry.isOpen()) {
+        m_error = true;
+        return;
+    }
+
+    Entry e = newEntry(filePath);
+    if (entry.isStored())
+        e.method = MethodStored;
+    e.crc = entry.crc();
+    e.uncompressedSize = entry.uncompressedSize();
+    addEntry(e, entry.compressedData());
+}
+
+void ZipWriter::addEntry(Entry &entry, const QByteArray &data)
+{
+    entry.compressedSize = data.size();
+    if (entry.compressedSize > MaxZipSize || entry.uncompressedSize > MaxZipSize) {
+        m_error = true;
+        return;
+    }
+    if (writeLocalHeader(entry) && write(data.constData(), data.size()))
+        m_entries.append(entry);
+}
+
+bool ZipWriter::writeLocalHeader(const Entry &entry)
+{
+    if (entry.offset > MaxZipSize) {
+        m_error = true;
+        return false;
+    }
+
+    // With a data descriptor the crc and sizes are left zero here.
+    const bool deferred = entry.flags & FlagDataDescriptor;
+    uchar header[30];
+    qToLittleEndian<quint32>(LocalHeaderSignature, header);
+    qToLittleEndian<quint16>(VersionNeeded, header + 4);
+    qToLittleEndian<quint16>(entry.flags, header + 6);
+    qToLittleEndian<quint16>(entry.method, header + 8);
+    qToLittleEndian<quint16>(m_dosTime, header + 10);
+    qToLittleEndian<quint16>(m_dosDate, header + 12);
+    qToLittleEndian<quint32>(deferred ? 0 : entry.crc, header + 14);
+    qToLittleEndian<quint32>(deferred ? 0 : quint32(entry.compressedSize), header + 18);
+    qToLittleEndian<quint32>(deferred ? 0 : quint32(entry.uncompressedSize), header + 22);
+    qToLittleEndian<quint16>(quint16(entry.name.size()), header + 26);
+    qToLittleEndian<quint16>(0, header + 28);
+
+    return write(reinterpret_cast<const char *>(header), sizeof(header))
+           && write(entry.name.constData(), entry.name.size());
+}
+
+bool ZipWriter::writeCentralDirectory()
+{
+    const qint64 start = m_offset;
+    for (const Entry &entry : std::as_const(m_entries)) {
+        uchar header[46];
+        qToLittleEndian<quint32>(CentralHeaderSignature, header);
+        qToLittleEndian<quint16>(VersionNeeded, header + 4); // made by, MS-DOS
+        qToLittleEndian<quint16>(VersionNeeded, header + 6);
+        qToLittleEndian<quint16>(entry.flags, header + 8);
+        qToLittleEndian<quint16>(entry.method, header + 10);
+        qToLittleEndian<quint16>(m_dosTime, header + 12);
+        qToLittleEndian<quint16>(m_dosDate, header + 14);
+        qToLittleEndian<quint32>(entry.crc, header + 16);
+        qToLittleEndian<quint32>(quint32(entry.compressedSize), header + 20);
+        qToLittleEndian<quint32>(quint32(entry.uncompressedSize), header + 24);
+        qToLittleEndian<quint16>(quint16(entry.name.size()), header + 28);
+        qToLittleEndian<quint16>(0, header + 30); // extra field length
+        qToLittleEndian<quint16>(0, header + 32); // comment length
+        qToLittleEndian<quint16>(0, header + 34); // disk number
+        qToLittleEndian<quint16>(0, header + 36); // internal attributes
+        qToLittleEndian<quint32>(0, header + 38); // external attributes
+        qToLittleEndian<quint32>(quint32(entry.offset), header + 42);
+        if (!write(reinterpret_cast<const char *>(header), sizeof(header))
+            || !write(entry.name.constData(), entry.name.size()))
+            return false;
+    }
+
+    const qint64 size = m_offset - start;
+    if (m_entries.size() > 0xffff || m_offset > MaxZipSize) {
+        m_error = true;
+        return false;
+    }
+
+    uchar end[22];
+    qToLittleEndian<quint32>(EndOfCentralDirSignature, end);
+    qToLittleEndian<quint16>(0, end + 4);
+    qToLittleEndian<quint16>(0, end + 6);
+    qToLittleEndian<quint16>(quint16(m_entries.size()), end + 8);
+    qToLittleEndian<quint16>(quint16(m_entries.size()), end + 10);
+    qToLittleEndian<quint32>(quint32(size), end + 12);
+    qToLittleEndian<quint32>(quint32(start), end + 16);
+    qToLittleEndian<quint16>(0, end + 20);
+    return write(reinterpret_cast<const char *>(end), sizeof(end));
+}
+
+bool ZipWriter::write(const char *data, qint64 len)
+{
+    if (m_error)
+        return false;
+    if (len > 0 && m_device->write(data, len) != len) {
+        m_error = true;
+        return false;
+    }
+    m_offset += len;
+    return true;
 }
 
+/*!
+ * Writes the central directory and closes the device.
+ */
 void ZipWriter::close()
 {
-    m_writer->close();
+    if (m_closed)
+        return;
+    m_closed = true;
+
+    if (m_device->isWritable()) {
+        closeFile();
+        writeCentralDirectory();
+    }
+    m_device->close();
 }
 
 } // namespace QXlsx
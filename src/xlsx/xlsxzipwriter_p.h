@@ -36,26 +36,103 @@
 // We mean it.
 //
 
+#include "xlsxglobal.h"
 #include <QString>
-class QIODevice;
-class QZipWriter;
+#include <QByteArray>
+#include <QBuffer>
+#include <QIODevice>
+#include <QList>
 
 namespace QXlsx {
 
-class ZipWriter
+class ZipDeflater;
+class ZipEntryDevice;
+
+class XLSX_AUTOTEST_EXPORT ZipEntryBuffer : public QIODevice
+{
+public:
+    ZipEntryBuffer();
+    ~ZipEntryBuffer();
+
+    bool isSequential() const override { return true; }
+    void close() override;
+
+    void setParallelDeflate(bool enable);
+    void setCompressionLevel(int level);
+    bool isStored() const;
+    QByteArray compressedData() const;
+    quint32 crc() const;
+    qint64 uncompressedSize() const;
+    bool error() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    Q_DISABLE_COPY(ZipEntryBuffer)
+    QByteArray m_data;
+    QBuffer m_buffer;
+    ZipDeflater *m_deflater;
+    quint32 m_crc;
+    qint64 m_uncompressedSize;
+    bool m_error;
+    bool m_stored;
+};
+
+class XLSX_AUTOTEST_EXPORT ZipWriter
 {
 public:
     explicit ZipWriter(const QString &filePath);
     explicit ZipWriter(QIODevice *device);
     ~ZipWriter();
 
+    void setParallelDeflate(bool enable);
+    void setCompressionLevel(int level);
+    QIODevice *openFile(const QString &filePath);
+    bool closeFile();
     void addFile(const QString &filePath, QIODevice *device);
     void addFile(const QString &filePath, const QByteArray &data);
+    void addFile(const QString &filePath, const ZipEntryBuffer &entry);
     bool error() const;
     void close();
 
 private:
-    QZipWriter *m_writer;
+    Q_DISABLE_COPY(ZipWriter)
+    friend class ZipEntryDevice;
+
+    struct Entry
+    {
+        QByteArray name;
+        quint16 flags;
+        quint16 method;
+        quint32 crc;
+        qint64 compressedSize;
+        qint64 uncompressedSize;
+        qint64 offset;
+    };
+
+    void init();
+    Entry newEntry(const QString &filePath) const;
+    bool writeEntryData(const char *data, qint64 len);
+    void addEntry(Entry &entry, const QByteArray &data);
+    bool writeLocalHeader(const Entry &entry);
+    bool writeCentralDirectory();
+    bool write(const char *data, qint64 len);
+
+    QIODevice *m_device;
+    bool m_ownDevice;
+    bool m_closed;
+    bool m_error;
+    qint64 m_offset;
+    quint16 m_dosTime;
+    quint16 m_dosDate;
+    QList<Entry> m_entries;
+    Entry m_current;
+    ZipEntryDevice *m_entryDevice;
+    ZipDeflater *m_deflater;
+    bool m_parallelDeflate;
+    int m_compressionLevel;
 };
 
 } // namespace QXlsx
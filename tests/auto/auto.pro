@@ -3,6 +3,7 @@ SUBDIRS=\
     utility \
     worksheet \
     zipreader \
+    zipwriter \
     relationships \
     propscore \
     propsapp \
@@ -13,4 +14,5 @@ SUBDIRS=\
     richstring \
     xlsxconditionalformatting \
     cellreference \
+    formulaexpression \
     cmake
@@ -1,4 +1,6 @@
 #include "xlsxcellreference.h"
+#include "xlsxcellrange.h"
+#include <QRegularExpression>
 #include <QString>
 #include <QtTest>
 
@@ -16,6 +18,17 @@ private Q_SLOTS:
     void test_toString();
     void test_fromString_data();
     void test_fromString();
+    void test_fromString_invalid_data();
+    void test_fromString_invalid();
+    void test_range_data();
+    void test_range();
+    void benchmark_fromString_data();
+    void benchmark_fromString();
+    void benchmark_toString_data();
+    void benchmark_toString();
+
+private:
+    QStringList referenceList() const;
 };
 
 CellReferenceTest::CellReferenceTest()
@@ -30,6 +43,11 @@ void CellReferenceTest::test_fromString()
     CellReference pos(cell);
     QCOMPARE(pos.row(), row);
     QCOMPARE(pos.column(), col);
+
+    const QByteArray utf8 = cell.toUtf8();
+    QCOMPARE(CellReference(utf8.constData()), pos);
+    QCOMPARE(CellReference::fromUtf8(utf8), pos);
+    QCOMPARE(CellReference::fromString(QStringView(cell)), pos);
 }
 
 void CellReferenceTest::test_fromString_data()
@@ -52,6 +70,150 @@ void CellReferenceTest::test_fromString_data()
     QTest::newRow("XFE1048577") << "XFE1048577" << 1048577 << 16385;
 }
 
+void CellReferenceTest::test_fromString_invalid_data()
+{
+    QTest::addColumn<QString>("cell");
+
+    QTest::newRow("empty") << QString();
+    QTest::newRow("dollar") << "$";
+    QTest::newRow("no row") << "AB";
+    QTest::newRow("no column") << "12";
+    QTest::newRow("row only abs") << "$12";
+    QTest::newRow("lower case") << "a1";
+    QTest::newRow("four letters") << "ABCD1";
+    QTest::newRow("trailing letter") << "A1B";
+    QTest::newRow("space") << "A 1";
+    QTest::newRow("double dollar") << "$A$$1";
+    QTest::newRow("row zero") << "A0";
+    QTest::newRow("row overflow") << "A2147483648";
+    QTest::newRow("range") << "A1:B2";
+}
+
+void CellReferenceTest::test_fromString_invalid()
+{
+    QFETCH(QString, cell);
+
+    QVERIFY(!CellReference(cell).isValid());
+    QCOMPARE(CellReference(cell), CellReference());
+    const QByteArray utf8 = cell.toUtf8();
+    QVERIFY(!CellReference(utf8.constData()).isValid());
+    QVERIFY(!CellReference::fromUtf8(utf8).isValid());
+}
+
+void CellReferenceTest::test_range_data()
+{
+    QTest::addColumn<QString>("range");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QString>("normalized");
+
+    QTest::newRow("cell") << "B3" << true << "B3";
+    QTest::newRow("range") << "A1:C5" << true << "A1:C5";
+    QTest::newRow("absolute") << "$A$1:$XFD$1048576" << true << "A1:XFD1048576";
+    QTest::newRow("one cell range") << "D4:D4" << true << "D4";
+    QTest::newRow("empty") << QString() << false << QString();
+    QTest::newRow("no end") << "A1:" << false << QString();
+    QTest::newRow("no start") << ":B2" << false << QString();
+    QTest::newRow("three parts") << "A1:B2:C3" << false << QString();
+    QTest::newRow("bad cell") << "A1:2B" << false << QString();
+}
+
+void CellReferenceTest::test_range()
+{
+    QFETCH(QString, range);
+    QFETCH(bool, valid);
+    QFETCH(QString, normalized);
+
+    const CellRange fromString(range);
+    QCOMPARE(fromString.isValid(), valid);
+    QCOMPARE(fromString.toString(), normalized);
+
+    const QByteArray utf8 = range.toUtf8();
+    QCOMPARE(CellRange(utf8.constData()), fromString);
+    QCOMPARE(CellRange::fromUtf8(utf8), fromString);
+    QCOMPARE(CellRange::fromString(QStringView(range)), fromString);
+}
+
+QStringList CellReferenceTest::referenceList() const
+{
+    QStringList cells;
+    for (int row = 1; row <= 1000; ++row) {
+        for (int col = 1; col <= 16384; col += 1337)
+            cells.append(CellReference(row, col).toString(row % 3 == 0, row % 5 == 0));
+    }
+    return cells;
+}
+
+/*
+  The regular expression CellReference used to parse with.
+*/
+static CellReference regexCellReference(const QString &cell)
+{
+    static QRegularExpression re(QStringLiteral("^\\$?([A-Z]{1,3})\\$?(\\d+)$"));
+    QRegularExpressionMatch match = re.match(cell);
+    if (!match.hasMatch())
+        return CellReference();
+    int col = 0;
+    foreach (QChar ch, match.captured(1))
+        col = col * 26 + ch.unicode() - 'A' + 1;
+    return CellReference(match.captured(2).toInt(), col);
+}
+
+void CellReferenceTest::benchmark_fromString_data()
+{
+    QTest::addColumn<int>("parser");
+    QTest::newRow("QRegularExpression") << 0;
+    QTest::newRow("QStringView") << 1;
+    QTest::newRow("UTF-8") << 2;
+}
+
+void CellReferenceTest::benchmark_fromString()
+{
+    QFETCH(int, parser);
+
+    const QStringList cells = referenceList();
+    QList<QByteArray> utf8Cells;
+    foreach (const QString &cell, cells)
+        utf8Cells.append(cell.toUtf8());
+
+    qint64 sum = 0;
+    QBENCHMARK {
+        sum = 0;
+        for (int i = 0; i < cells.size(); ++i) {
+            CellReference ref;
+            if (parser == 0)
+                ref = regexCellReference(cells[i]);
+            else if (parser == 1)
+                ref = CellReference(cells[i]);
+            else
+                ref = CellReference::fromUtf8(utf8Cells[i]);
+            sum += ref.row() + ref.column();
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
+void CellReferenceTest::benchmark_toString_data()
+{
+    QTest::addColumn<bool>("absolute");
+    QTest::newRow("relative") << false;
+    QTest::newRow("absolute") << true;
+}
+
+void CellReferenceTest::benchmark_toString()
+{
+    QFETCH(bool, absolute);
+
+    qint64 size = 0;
+    QBENCHMARK {
+        size = 0;
+        for (int row = 1; row <= 1000; ++row) {
+            for (int col = 1; col <= 16384; col += 97)
+                size += CellReference(row, col).toString(absolute, absolute).size();
+        }
+    }
+    QVERIFY(size > 0);
+}
+
 void CellReferenceTest::test_toString()
 {
     QFETCH(int, row);
@@ -76,6 +238,13 @@ void CellReferenceTest::test_toString_data()
     QTest::newRow("colabs") << 1 << 1 << false << true << "$A1";
     QTest::newRow("bothabs") << 1 << 1 << true << true << "$A$1";
     QTest::newRow("...") << 1048577 << 16385 << false << false << "XFE1048577";
+    QTest::newRow("Z") << 1 << 26 << false << false << "Z1";
+    QTest::newRow("AA") << 1 << 27 << false << false << "AA1";
+    QTest::newRow("ZZ") << 1 << 702 << false << false << "ZZ1";
+    QTest::newRow("AAA") << 1 << 703 << false << false << "AAA1";
+    QTest::newRow("XFD") << 1048576 << 16384 << true << true << "$XFD$1048576";
+    QTest::newRow("ZZZ") << 1 << 18278 << false << false << "ZZZ1";
+    QTest::newRow("AAAA") << 1 << 18279 << false << false << "AAAA1";
 }
 
 QTEST_APPLESS_MAIN(CellReferenceTest)
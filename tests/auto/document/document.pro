@@ -1,4 +1,4 @@
-QT       += testlib xlsx # xlsx-private
+QT       += testlib xlsx xlsx-private
 CONFIG += testcase
 DEFINES += XLSX_TEST
 
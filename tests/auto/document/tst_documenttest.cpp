@@ -2,8 +2,16 @@
 #include "xlsxcell.h"
 #include "xlsxformat.h"
 #include "xlsxcellformula.h"
+#include "xlsxcellrange.h"
+#include "xlsxworkbook.h"
+#include "xlsxsheetreader.h"
+#include "xlsxoleobject.h"
+#include "private/xlsxzipreader_p.h"
 #include <QString>
 #include <QtTest>
+#include <QThreadPool>
+#include <QImage>
+#include <QTemporaryDir>
 
 QTXLSX_USE_NAMESPACE
 
@@ -18,6 +26,7 @@ private Q_SLOTS:
     void testDocumentProperty();
     void testReadWriteString();
     void testReadWriteNumeric();
+    void testReadWriteExactNumeric();
     void testReadWriteBool();
     void testReadWriteBlank();
     void testReadWriteFormula();
@@ -27,6 +36,15 @@ private Q_SLOTS:
 
     void testMoveWorksheet();
     void testDeleteWorksheet();
+    void testSaveManySheets();
+    void testLoadManySheets();
+    void testSaveOptions();
+    void testSaveOleObject();
+    void testSaveEmptyDocument();
+    void testSheetReader();
+    void testLazyLoad();
+    void testLoadProjection();
+    void testProbe();
     void testCopyWorksheet();
 };
 
@@ -109,6 +127,31 @@ void DocumentTest::testReadWriteNumeric()
     QCOMPARE(xlsx2.cellAt("A2")->format(), format);
 }
 
+void DocumentTest::testReadWriteExactNumeric()
+{
+    const double value = 0.1 + 0.2; // 0.30000000000000004
+
+    Document xlsx1;
+    xlsx1.write("A1", value);
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    xlsx1.saveAs(&device);
+
+    // 15 significant digits by default
+    device.open(QIODevice::ReadOnly);
+    Document xlsx2(&device);
+    QVERIFY(xlsx2.read("A1").toDouble() == 0.3);
+
+    xlsx1.workbook()->setExactNumbersEnabled();
+    QBuffer device2;
+    device2.open(QIODevice::WriteOnly);
+    xlsx1.saveAs(&device2);
+
+    device2.open(QIODevice::ReadOnly);
+    Document xlsx3(&device2);
+    QVERIFY(xlsx3.read("A1").toDouble() == value);
+}
+
 void DocumentTest::testReadWriteBool()
 {
     QBuffer device;
@@ -319,6 +362,214 @@ void DocumentTest::testMoveWorksheet()
     QCOMPARE(xlsx1.sheetNames(), QStringList()<<"Sheet1"<<"Sheet2");
 }
 
+void DocumentTest::testSheetReader()
+{
+    Document xlsx1;
+    Format bold;
+    bold.setFontBold(true);
+    xlsx1.write("A1", "Hello", bold);
+    xlsx1.write("C1", 1.5);
+    xlsx1.write("A3", true);
+    xlsx1.write("B3", QDate(2012, 11, 12));
+    xlsx1.write("C3", "=C1*2");
+    xlsx1.write("D3", QVariant(), bold);
+    xlsx1.addSheet("Sheet2");
+    xlsx1.write("B2", "Second");
+
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device));
+
+    device.open(QIODevice::ReadOnly);
+    SheetReader reader(&device);
+    QVERIFY(reader.isValid());
+    QVERIFY(!reader.hasError());
+    QCOMPARE(reader.sheetName(), QStringLiteral("Sheet1"));
+    QCOMPARE(reader.sheetNames(), QStringList() << "Sheet1" << "Sheet2");
+
+    SheetReader::RowView row = reader.next();
+    QVERIFY(row.isValid());
+    QCOMPARE(row.row(), 1);
+    QCOMPARE(row.cellCount(), 2);
+    QCOMPARE(row.cell(0).column, 1);
+    QCOMPARE(row.cell(0).cellType, Cell::SharedStringType);
+    QCOMPARE(reader.cellValue(row.cell(0)).toString(), QStringLiteral("Hello"));
+    QVERIFY(reader.cellFormat(row.cell(0)).fontBold());
+    QCOMPARE(row.cell(1).column, 3);
+    QCOMPARE(row.cell(1).number, 1.5);
+
+    row = reader.next();
+    QCOMPARE(row.row(), 3);
+    QCOMPARE(row.cellCount(), 4);
+    QCOMPARE(reader.cellValue(row.cell(0)).toBool(), true);
+    QCOMPARE(reader.cellValue(row.cell(1)).toDate(), QDate(2012, 11, 12));
+    QCOMPARE(row.cell(2).formula, QStringLiteral("C1*2"));
+    QVERIFY(!row.cell(3).hasValue);
+    QVERIFY(reader.cellValue(row.cell(3)).isNull());
+
+    QVERIFY(!reader.next().isValid());
+    QVERIFY(!reader.hasError());
+
+    device.seek(0);
+    SheetReader reader2(&device, "Sheet2");
+    row = reader2.next();
+    QCOMPARE(row.row(), 2);
+    QCOMPARE(reader2.cellValue(row.cell(0)).toString(), QStringLiteral("Second"));
+
+    device.seek(0);
+    SheetReader reader3(&device, "NotExists");
+    QVERIFY(!reader3.isValid());
+    QVERIFY(reader3.hasError());
+    QVERIFY(!reader3.next().isValid());
+}
+
+void DocumentTest::testLazyLoad()
+{
+    Document xlsx1;
+    for (int i = 1; i <= 5; ++i) {
+        if (i > 1)
+            xlsx1.addSheet();
+        xlsx1.write("A1", QStringLiteral("Sheet %1").arg(i));
+        xlsx1.write("B2", i);
+    }
+
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device));
+
+    Document::LoadOptions options;
+    options.lazySheets = true;
+    device.open(QIODevice::ReadOnly);
+    Document xlsx2(&device, options);
+    QCOMPARE(xlsx2.sheetNames().size(), 5);
+    QVERIFY(xlsx2.selectSheet("Sheet4"));
+    QCOMPARE(xlsx2.read("A1").toString(), QStringLiteral("Sheet 4"));
+    QCOMPARE(xlsx2.read("B2").toInt(), 4);
+
+    // Untouched sheets survive a rename, a move and a copy
+    QVERIFY(xlsx2.renameSheet("Sheet2", "Second"));
+    QVERIFY(xlsx2.moveSheet("Sheet5", 0));
+    xlsx2.copySheet("Sheet3", "Third");
+    QVERIFY(xlsx2.deleteSheet("Sheet1"));
+
+    QBuffer device2;
+    device2.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx2.saveAs(&device2));
+
+    device2.open(QIODevice::ReadOnly);
+    Document xlsx3(&device2);
+    QCOMPARE(xlsx3.sheetNames(), QStringList() << "Sheet5" << "Second" << "Sheet3" << "Sheet4" << "Third");
+    xlsx3.selectSheet("Second");
+    QCOMPARE(xlsx3.read("A1").toString(), QStringLiteral("Sheet 2"));
+    xlsx3.selectSheet("Sheet5");
+    QCOMPARE(xlsx3.read("B2").toInt(), 5);
+    xlsx3.selectSheet("Third");
+    QCOMPARE(xlsx3.read("A1").toString(), QStringLiteral("Sheet 3"));
+}
+
+void DocumentTest::testLoadProjection()
+{
+    Document xlsx1;
+    xlsx1.addSheet("Data");
+    for (int row = 1; row <= 20; ++row) {
+        xlsx1.write(row, 1, row);
+        xlsx1.write(row, 2, QStringLiteral("Row %1").arg(row));
+        xlsx1.write(row, 3, row * 0.5);
+    }
+    xlsx1.currentWorksheet()->writeFormula(1, 4,
+            CellFormula("A1*2", CellRange("D1:D20"), CellFormula::SharedType));
+    xlsx1.setRowHeight(3, 30.0);
+    xlsx1.setRowHeight(12, 40.0);
+    xlsx1.addSheet("Other");
+    xlsx1.write("A1", QStringLiteral("Other"));
+
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device));
+
+    Document::LoadOptions options;
+    options.sheets << "Data";
+    options.columns << 2 << 4;
+    options.firstRow = 10;
+    options.lastRow = 15;
+    device.open(QIODevice::ReadOnly);
+    Document xlsx2(&device, options);
+    QCOMPARE(xlsx2.sheetNames(), QStringList() << "Data" << "Other");
+
+    QVERIFY(xlsx2.selectSheet("Data"));
+    for (int row = 1; row <= 20; ++row) {
+        const bool loaded = row >= 10 && row <= 15;
+        QVERIFY(!xlsx2.cellAt(row, 1));
+        QVERIFY(!xlsx2.cellAt(row, 3));
+        QCOMPARE(xlsx2.cellAt(row, 2) != 0, loaded);
+        QCOMPARE(xlsx2.cellAt(row, 4) != 0, loaded);
+        if (loaded) {
+            QCOMPARE(xlsx2.read(row, 2).toString(), QStringLiteral("Row %1").arg(row));
+            // The master of the shared formula is in row 1
+            QCOMPARE(xlsx2.read(row, 4).toString(), QStringLiteral("=A%1*2").arg(row));
+        }
+    }
+    QVERIFY(xlsx2.rowHeight(12) > 39.0);
+    QVERIFY(xlsx2.rowHeight(3) < 29.0);
+
+    // The cells of the sheets not asked for are not loaded
+    QVERIFY(xlsx2.selectSheet("Other"));
+    QVERIFY(!xlsx2.cellAt(1, 1));
+
+    // The same with the sheets parsed on first access
+    options.lazySheets = true;
+    device.open(QIODevice::ReadOnly);
+    Document xlsx3(&device, options);
+    QVERIFY(xlsx3.selectSheet("Data"));
+    QVERIFY(!xlsx3.cellAt(9, 2));
+    QCOMPARE(xlsx3.read(10, 2).toString(), QStringLiteral("Row 10"));
+    QVERIFY(!xlsx3.cellAt(10, 3));
+}
+
+void DocumentTest::testProbe()
+{
+    Document xlsx1;
+    xlsx1.setDocumentProperty("title", "Routing");
+    xlsx1.write("B2", 1);
+    xlsx1.write("D10", "Total");
+    xlsx1.addSheet("Hidden");
+    xlsx1.currentSheet()->setHidden(true);
+    xlsx1.addSheet("Empty");
+    xlsx1.defineName("Rate", "=Sheet1!$B$2", "The rate");
+    xlsx1.defineName("Local", "=Hidden!$A$1", QString(), "Hidden");
+
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device));
+
+    device.open(QIODevice::ReadOnly);
+    Document::ProbeInfo info = Document::probe(&device);
+    QVERIFY(info.isValid);
+    QCOMPARE(info.documentProperties.value("title"), QStringLiteral("Routing"));
+
+    QCOMPARE(info.sheets.size(), 3);
+    QCOMPARE(info.sheets[0].name, QStringLiteral("Sheet1"));
+    QCOMPARE(info.sheets[0].type, AbstractSheet::ST_WorkSheet);
+    QCOMPARE(info.sheets[0].state, AbstractSheet::SS_Visible);
+    QCOMPARE(info.sheets[0].dimension, CellRange("B2:D10"));
+    QCOMPARE(info.sheets[1].name, QStringLiteral("Hidden"));
+    QCOMPARE(info.sheets[1].state, AbstractSheet::SS_Hidden);
+    QCOMPARE(info.sheets[2].name, QStringLiteral("Empty"));
+
+    QCOMPARE(info.definedNames.size(), 2);
+    QCOMPARE(info.definedNames[0].name, QStringLiteral("Rate"));
+    QCOMPARE(info.definedNames[0].formula, QStringLiteral("Sheet1!$B$2"));
+    QCOMPARE(info.definedNames[0].comment, QStringLiteral("The rate"));
+    QVERIFY(info.definedNames[0].scope.isEmpty());
+    QCOMPARE(info.definedNames[1].scope, QStringLiteral("Hidden"));
+
+    QBuffer notXlsx;
+    notXlsx.setData("not a package");
+    notXlsx.open(QIODevice::ReadOnly);
+    QVERIFY(!Document::probe(&notXlsx).isValid);
+    QVERIFY(!Document::probe(QStringLiteral("no such file.xlsx")).isValid);
+}
+
 void DocumentTest::testCopyWorksheet()
 {
     Document xlsx1;
@@ -360,6 +611,201 @@ void DocumentTest::testDeleteWorksheet()
     QCOMPARE(xlsx1.sheetNames(), QStringList()<<"Sheet3");
 }
 
+void DocumentTest::testSaveManySheets()
+{
+    // The sheets are rendered concurrently, the package must not depend on it.
+    const int oldThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool::globalInstance()->setMaxThreadCount(4);
+
+    Document xlsx1;
+    for (int i = 1; i <= 12; ++i) {
+        xlsx1.addSheet(QStringLiteral("Data%1").arg(i));
+        for (int row = 1; row <= 200; ++row) {
+            xlsx1.write(row, 1, QStringLiteral("Text %1").arg(row % 17));
+            xlsx1.write(row, 2, row * i);
+        }
+    }
+    // Rendered straight into the package, between the pooled parts
+    QVERIFY(xlsx1.insertSheet(6, QStringLiteral("Streamed")));
+    QVERIFY(xlsx1.selectSheet(QStringLiteral("Streamed")));
+    QVERIFY(xlsx1.currentWorksheet()->setStreamingEnabled());
+    for (int row = 1; row <= 5000; ++row)
+        xlsx1.write(row, 1, row);
+
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device));
+    QThreadPool::globalInstance()->setMaxThreadCount(oldThreadCount);
+
+    device.open(QIODevice::ReadOnly);
+    Document xlsx2(&device);
+    QCOMPARE(xlsx2.sheetNames(), xlsx1.sheetNames());
+    for (int i = 1; i <= 12; ++i) {
+        xlsx2.selectSheet(QStringLiteral("Data%1").arg(i));
+        QCOMPARE(xlsx2.read(200, 1).toString(), QStringLiteral("Text %1").arg(200 % 17));
+        QCOMPARE(xlsx2.read(200, 2).toInt(), 200 * i);
+    }
+    xlsx2.selectSheet(QStringLiteral("Streamed"));
+    QCOMPARE(xlsx2.read(1, 1).toInt(), 1);
+    QCOMPARE(xlsx2.read(5000, 1).toInt(), 5000);
+}
+
+void DocumentTest::testLoadManySheets()
+{
+    Document xlsx1;
+    for (int i = 1; i <= 12; ++i) {
+        xlsx1.addSheet(QStringLiteral("Data%1").arg(i));
+        for (int row = 1; row <= 200; ++row) {
+            xlsx1.write(row, 1, QStringLiteral("Text %1").arg(row % 17));
+            xlsx1.write(row, 2, row * i);
+        }
+    }
+    xlsx1.insertSheet(3, "Chart", AbstractSheet::ST_ChartSheet);
+
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device));
+
+    // The sheets are parsed concurrently, the document must not depend on it.
+    const int oldThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool::globalInstance()->setMaxThreadCount(4);
+    device.open(QIODevice::ReadOnly);
+    Document xlsx2(&device);
+    QThreadPool::globalInstance()->setMaxThreadCount(oldThreadCount);
+
+    QCOMPARE(xlsx2.sheetNames(), xlsx1.sheetNames());
+    QCOMPARE(xlsx2.sheet("Chart")->sheetType(), AbstractSheet::ST_ChartSheet);
+    for (int i = 1; i <= 12; ++i) {
+        xlsx2.selectSheet(QStringLiteral("Data%1").arg(i));
+        QCOMPARE(xlsx2.read(200, 1).toString(), QStringLiteral("Text %1").arg(200 % 17));
+        QCOMPARE(xlsx2.read(200, 2).toInt(), 200 * i);
+    }
+
+    QBuffer device2;
+    device2.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx2.saveAs(&device2));
+    device2.open(QIODevice::ReadOnly);
+    Document xlsx3(&device2);
+    xlsx3.selectSheet("Data12");
+    QCOMPARE(xlsx3.read(16, 1).toString(), QStringLiteral("Text 16"));
+}
+
+void DocumentTest::testSaveOptions()
+{
+    Document xlsx1;
+    for (int row = 1; row <= 1000; ++row) {
+        xlsx1.write(row, 1, QStringLiteral("Text %1").arg(row));
+        xlsx1.write(row, 2, row);
+    }
+
+    Document::SaveOptions fast;
+    fast.compressionLevel = 1;
+    fast.uncompressedFiles << "*.rels" << "xl/worksheets/*";
+    fast.compressMedia = false;
+
+    Document::SaveOptions stored;
+    stored.compressionLevel = 0;
+
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device, stored));
+    const qint64 storedSize = device.size();
+
+    QBuffer device2;
+    device2.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device2, fast));
+    QVERIFY(device2.size() < storedSize);
+
+    QBuffer device3;
+    device3.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device3));
+    QVERIFY(device3.size() < device2.size());
+
+    device.open(QIODevice::ReadOnly);
+    Document xlsx2(&device);
+    QCOMPARE(xlsx2.read(1000, 1).toString(), QStringLiteral("Text 1000"));
+    QCOMPARE(xlsx2.read(1000, 2).toInt(), 1000);
+
+    device2.open(QIODevice::ReadOnly);
+    Document xlsx3(&device2);
+    QCOMPARE(xlsx3.read(1000, 1).toString(), QStringLiteral("Text 1000"));
+    QCOMPARE(xlsx3.read(1000, 2).toInt(), 1000);
+}
+
+void DocumentTest::testSaveOleObject()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString objectFile = dir.filePath("object.bin");
+    QFile object(objectFile);
+    QVERIFY(object.open(QIODevice::WriteOnly));
+    object.write("ole object contents");
+    object.close();
+    const QString previewFile = dir.filePath("preview.png");
+    QImage image(8, 8, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+    QVERIFY(image.save(previewFile));
+    QFile preview(previewFile);
+    QVERIFY(preview.open(QIODevice::ReadOnly));
+    const QByteArray previewData = preview.readAll();
+
+    Document xlsx1;
+    xlsx1.write("A1", 1);
+    QVERIFY(xlsx1.insertOleObject(2, 2, 3, 3, objectFile, previewFile,
+                                  "application/vnd.openxmlformats-officedocument.oleObject",
+                                  "image/png"));
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device));
+
+    // The preview of the object is saved where the sheet refers to it
+    device.open(QIODevice::ReadOnly);
+    {
+        ZipReader zip(&device);
+        const QString rels = QString::fromUtf8(zip.fileData("xl/worksheets/_rels/sheet1.xml.rels"));
+        const QRegularExpression target(QStringLiteral("Target=\"\\.\\./media/([^\"]+)\""));
+        QRegularExpressionMatchIterator it = target.globalMatch(rels);
+        QVERIFY(it.hasNext());
+        while (it.hasNext()) {
+            const QString path = QStringLiteral("xl/media/") + it.next().captured(1);
+            QVERIFY2(zip.filePaths().contains(path), qPrintable(path));
+            QCOMPARE(zip.fileData(path), previewData);
+        }
+    }
+    device.close();
+
+    device.open(QIODevice::ReadOnly);
+    Document xlsx2(&device);
+    const QList<QSharedPointer<OleObject>> objects = xlsx2.currentWorksheet()->oleObjectFiles();
+    QCOMPARE(objects.size(), 1);
+    QCOMPARE(objects[0]->contents(), QByteArray("ole object contents"));
+    QVERIFY(objects[0]->prMediaFile());
+    QCOMPARE(xlsx2.read("A1").toInt(), 1);
+}
+
+void DocumentTest::testSaveEmptyDocument()
+{
+    // The default sheet is added before the parts are collected
+    Document xlsx1;
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx1.saveAs(&device));
+    QCOMPARE(xlsx1.sheetNames(), QStringList() << "Sheet1");
+    device.close();
+
+    device.open(QIODevice::ReadOnly);
+    {
+        ZipReader zip(&device);
+        QVERIFY(zip.filePaths().contains(QStringLiteral("xl/worksheets/sheet1.xml")));
+        QVERIFY(QString::fromUtf8(zip.fileData("xl/workbook.xml")).contains("Sheet1"));
+    }
+    device.close();
+
+    device.open(QIODevice::ReadOnly);
+    Document xlsx2(&device);
+    QCOMPARE(xlsx2.sheetNames(), QStringList() << "Sheet1");
+}
+
 QTEST_APPLESS_MAIN(DocumentTest)
 
 #include "tst_documenttest.moc"
@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Project created by QtCreator 2013-08-30T11:16:26
+#
+#-------------------------------------------------
+
+QT       += testlib xlsx xlsx-private
+CONFIG += testcase
+DEFINES += XLSX_TEST
+
+TARGET = tst_formulaexpressiontest
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += tst_formulaexpressiontest.cpp
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
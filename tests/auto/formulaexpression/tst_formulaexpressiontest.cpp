@@ -0,0 +1,163 @@
+#include "private/xlsxformulaexpression_p.h"
+#include "xlsxcellrange.h"
+#include <QString>
+#include <QtTest>
+
+using namespace QXlsx;
+
+class FormulaExpressionTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    FormulaExpressionTest();
+
+private Q_SLOTS:
+    void test_toString_data();
+    void test_toString();
+    void test_invalid_data();
+    void test_invalid();
+    void test_tokens();
+    void test_references();
+    void benchmark_parse();
+};
+
+FormulaExpressionTest::FormulaExpressionTest()
+{
+}
+
+void FormulaExpressionTest::test_toString_data()
+{
+    QTest::addColumn<QString>("formula");
+    QTest::addColumn<QString>("result");
+    QTest::addColumn<int>("references");
+
+    QTest::newRow("cells") << "=A1+B2" << "A1+B2" << 2;
+    QTest::newRow("range") << "SUM(A1:B10)" << "SUM(A1:B10)" << 1;
+    QTest::newRow("lower case") << "sum(a1:b10)" << "sum(A1:B10)" << 1;
+    QTest::newRow("absolute") << "$A$1*B$2-$C3" << "$A$1*B$2-$C3" << 3;
+    QTest::newRow("sheets") << "Sheet1!A1+'My Sheet'!$B$2:C3" << "Sheet1!A1+'My Sheet'!$B$2:C3" << 2;
+    QTest::newRow("sheet quote") << "'It''s'!A1" << "'It''s'!A1" << 1;
+    QTest::newRow("3d") << "SUM(Sheet1:Sheet3!A1)" << "SUM(Sheet1:Sheet3!A1)" << 1;
+    QTest::newRow("external") << "[1]Sheet1!Name" << "[1]Sheet1!Name" << 0;
+    QTest::newRow("string") << "IF(A1>0,\"a\"\"b\",FALSE)" << "IF(A1>0,\"a\"\"b\",FALSE)" << 1;
+    QTest::newRow("missing") << "IF(A1,,1)" << "IF(A1,,1)" << 1;
+    QTest::newRow("no argument") << "NOW()" << "NOW()" << 0;
+    QTest::newRow("unary") << "-2^2+(+A1)" << "-2^2+(+A1)" << 1;
+    QTest::newRow("percent") << "(1+2)*3%" << "(1+2)*3%" << 0;
+    QTest::newRow("columns") << "SUM(A:A,$B:$C)" << "SUM(A:A,$B:$C)" << 2;
+    QTest::newRow("rows") << "SUM(1:1,Sheet1!$3:$5)" << "SUM(1:1,Sheet1!$3:$5)" << 2;
+    QTest::newRow("intersection") << "SUM(A1:C3 B2:D4)" << "SUM(A1:C3 B2:D4)" << 2;
+    QTest::newRow("union") << "SUM((A1,B1:B3))" << "SUM((A1,B1:B3))" << 2;
+    QTest::newRow("range operator") << "A1:INDEX(B:B,3)" << "A1:INDEX(B:B,3)" << 2;
+    QTest::newRow("names") << "TaxRate*Price" << "TaxRate*Price" << 0;
+    QTest::newRow("structured") << "Table1[Qty]+[@Qty]" << "Table1[Qty]+[@Qty]" << 0;
+    QTest::newRow("structured nested") << "SUM(Table1[[#This Row],[Qty]])"
+                                       << "SUM(Table1[[#This Row],[Qty]])" << 0;
+    QTest::newRow("array") << "SUM({1,2;3,4})" << "SUM({1,2;3,4})" << 0;
+    QTest::newRow("errors") << "IFERROR(1/0,#DIV/0!)+Sheet1!#REF!" << "IFERROR(1/0,#DIV/0!)+Sheet1!#REF!" << 0;
+    QTest::newRow("numbers") << "1.5E+3+.5" << "1.5E+3+.5" << 0;
+    QTest::newRow("comparisons") << "A1<>B1&\"x\"<=C1" << "A1<>B1&\"x\"<=C1" << 3;
+    QTest::newRow("prefixed") << "_xlfn.XLOOKUP(A1,B:B,C:C)" << "_xlfn.XLOOKUP(A1,B:B,C:C)" << 3;
+    QTest::newRow("function like a cell") << "LOG10(100)" << "LOG10(100)" << 0;
+    QTest::newRow("last cell") << "XFD1048576" << "XFD1048576" << 1;
+    QTest::newRow("beyond last column") << "XFE1" << "XFE1" << 0;
+}
+
+void FormulaExpressionTest::test_toString()
+{
+    QFETCH(QString, formula);
+    QFETCH(QString, result);
+    QFETCH(int, references);
+
+    const FormulaExpression expression = FormulaExpression::parse(formula);
+    QVERIFY2(expression.isValid(), qPrintable(expression.errorString()));
+    QCOMPARE(expression.toString(), result);
+    QCOMPARE(expression.references().size(), references);
+}
+
+void FormulaExpressionTest::test_invalid_data()
+{
+    QTest::addColumn<QString>("formula");
+
+    QTest::newRow("empty") << "";
+    QTest::newRow("open call") << "SUM(";
+    QTest::newRow("open string") << "\"abc";
+    QTest::newRow("open paren") << "(A1";
+    QTest::newRow("close paren") << "A1)";
+    QTest::newRow("operand expected") << "A1+";
+    QTest::newRow("number") << "1A";
+    QTest::newRow("error literal") << "#FOO";
+    QTest::newRow("character") << "A1 ~";
+}
+
+void FormulaExpressionTest::test_invalid()
+{
+    QFETCH(QString, formula);
+
+    const FormulaExpression expression = FormulaExpression::parse(formula);
+    QVERIFY(!expression.isValid());
+    QVERIFY(!expression.errorString().isEmpty());
+    QVERIFY(expression.tokens().isEmpty());
+}
+
+void FormulaExpressionTest::test_tokens()
+{
+    // A1 2 SUM(2) 3 *
+    const FormulaExpression expression = FormulaExpression::parse(u"SUM(A1,2)*3");
+    const QList<FormulaExpression::Token> &tokens = expression.tokens();
+    QCOMPARE(tokens.size(), 5);
+    QCOMPARE(int(tokens[0].type), int(FormulaExpression::T_Reference));
+    QCOMPARE(int(tokens[1].type), int(FormulaExpression::T_Number));
+    QCOMPARE(tokens[1].number, 2.0);
+    QCOMPARE(int(tokens[2].type), int(FormulaExpression::T_Function));
+    QCOMPARE(int(tokens[2].value), 2);
+    QCOMPARE(expression.text(tokens[2]), QStringLiteral("SUM"));
+    QCOMPARE(int(tokens[4].type), int(FormulaExpression::T_Operator));
+    QCOMPARE(int(tokens[4].value), int(FormulaExpression::Op_Multiply));
+
+    // '^' is left associative, and the unary '-' binds tighter
+    const FormulaExpression power = FormulaExpression::parse(u"-2^3^2");
+    QCOMPARE(power.tokens().size(), 6);
+    QCOMPARE(int(power.tokens()[1].value), int(FormulaExpression::Op_Negate));
+    QCOMPARE(int(power.tokens()[3].value), int(FormulaExpression::Op_Power));
+}
+
+void FormulaExpressionTest::test_references()
+{
+    const FormulaExpression expression =
+        FormulaExpression::parse(u"SUM('My Sheet'!$A$1:B3)+C:C+2:2");
+    const QList<FormulaExpression::Reference> refs = expression.references();
+    QCOMPARE(refs.size(), 3);
+    QCOMPARE(refs[0].sheet, QStringLiteral("My Sheet"));
+    QCOMPARE(refs[0].range, CellRange(1, 1, 3, 2));
+    QVERIFY(refs[1].sheet.isEmpty());
+    QCOMPARE(refs[1].range, CellRange(1, 3, 1048576, 3));
+    QCOMPARE(refs[2].range, CellRange(2, 1, 2, 16384));
+
+    const FormulaExpression::Token &token = expression.tokens()[0];
+    QCOMPARE(int(token.flags),
+             int(FormulaExpression::FirstColumnAbsolute | FormulaExpression::FirstRowAbsolute
+                 | FormulaExpression::IsRange | FormulaExpression::SheetQuoted));
+}
+
+void FormulaExpressionTest::benchmark_parse()
+{
+    QStringList formulas;
+    for (int row = 1; row <= 100000; ++row) {
+        formulas.append(QStringLiteral("IF(AND(A%1>0,B%1<>\"\"),A%1*$H$1+VLOOKUP(B%1,$J$1:$K$50,2,FALSE),C$1)")
+                            .arg(row));
+    }
+
+    int count = 0;
+    QBENCHMARK {
+        count = 0;
+        for (const QString &formula : formulas)
+            count += FormulaExpression::parse(formula).tokens().size();
+    }
+    QVERIFY(count > 0);
+}
+
+QTEST_APPLESS_MAIN(FormulaExpressionTest)
+
+#include "tst_formulaexpressiontest.moc"
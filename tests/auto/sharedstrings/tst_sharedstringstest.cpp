@@ -15,9 +15,13 @@ public:
 private Q_SLOTS:
     void testAddSharedString();
     void testRemoveSharedString();
+    void testIncRefByStringIndex();
 
     void testLoadXmlData();
     void testLoadRichStringXmlData();
+    void testLazyLoad_data();
+    void testLazyLoad();
+    void testLazyLoadModify();
 
 };
 
@@ -99,6 +103,27 @@ void SharedStringsTest::testRemoveSharedString()
     QCOMPARE(uniqueCount, 2);
 }
 
+void SharedStringsTest::testIncRefByStringIndex()
+{
+    QXlsx::SharedStrings sst(QXlsx::SharedStrings::F_NewFromScratch);
+    sst.addSharedString("Hello Qt!");
+    sst.addSharedString("Xlsx Writer");
+
+    QSharedPointer<QXlsx::SharedStrings> sst2(new QXlsx::SharedStrings(QXlsx::SharedStrings::F_LoadFromExists));
+    sst2->loadFromXmlData(sst.saveToXmlData());
+    QCOMPARE(sst2->count(), 0);
+
+    // References counted by the sheets are added in one go
+    sst2->incRefByStringIndex(1, 3);
+    sst2->incRefByStringIndex(0);
+    sst2->incRefByStringIndex(2, 5); // invalid index
+    QCOMPARE(sst2->count(), 4);
+    QCOMPARE(sst2->getSharedStringIndex("Xlsx Writer"), 1);
+
+    QCOMPARE(sst2->addSharedString("Xlsx Writer"), 1);
+    QCOMPARE(sst2->count(), 5);
+}
+
 void SharedStringsTest::testLoadXmlData()
 {
     QXlsx::SharedStrings sst(QXlsx::SharedStrings::F_NewFromScratch);
@@ -159,6 +184,78 @@ void SharedStringsTest::testLoadRichStringXmlData()
     QCOMPARE(format.fontSize(), 11);
 }
 
+void SharedStringsTest::testLazyLoad_data()
+{
+    QTest::addColumn<QByteArray>("xmlData");
+
+    const QByteArray head = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n"
+            "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" count=\"6\" uniqueCount=\"6\">";
+    const QByteArray strings = "<si><t>Hello Qt!</t></si>"
+            "<si><t xml:space=\"preserve\"> a &lt;b&gt; &amp; &#x4E2D;&#25991; \r\n</t></si>"
+            "<si/>"
+            "<si><t/></si>"
+            "<si><r><t>e=mc</t></r><r><rPr><vertAlign val=\"superscript\"/><sz val=\"11\"/></rPr><t>2</t></r></si>"
+            "<si><t>\xe4\xb8\xad\xe6\x96\x87</t><rPh sb=\"0\" eb=\"1\"><t>x</t></rPh></si>";
+
+    QTest::newRow("indexed") << QByteArray(head + strings + "</sst>");
+    QTest::newRow("comment") << QByteArray(head + "<!-- c -->" + strings + "</sst>");
+    QTest::newRow("cdata") << QByteArray(head + strings).replace("Hello Qt!", "<![CDATA[Hello Qt!]]>") + "</sst>";
+}
+
+void SharedStringsTest::testLazyLoad()
+{
+    QFETCH(QByteArray, xmlData);
+
+    QXlsx::SharedStrings eager(QXlsx::SharedStrings::F_LoadFromExists);
+    QVERIFY(eager.loadFromXmlData(xmlData));
+
+    QXlsx::SharedStrings lazy(QXlsx::SharedStrings::F_LoadFromExists);
+    lazy.setLazyLoad(true);
+    QVERIFY(lazy.loadFromXmlData(xmlData));
+
+    QCOMPARE(lazy.isEmpty(), false);
+    QCOMPARE(lazy.getSharedStrings().size(), 6);
+    for (int i = 0; i < 6; ++i)
+        QCOMPARE(lazy.getSharedString(i), eager.getSharedString(i));
+    QCOMPARE(lazy.getSharedString(6), QXlsx::RichString());
+    QCOMPARE(lazy.getSharedString(1).toPlainString(),
+             QString::fromUtf8(" a <b> & \xe4\xb8\xad\xe6\x96\x87 \n"));
+    QCOMPARE(lazy.getSharedStringIndex("Hello Qt!"), 0);
+    QCOMPARE(lazy.saveToXmlData(), eager.saveToXmlData());
+}
+
+void SharedStringsTest::testLazyLoadModify()
+{
+    QXlsx::SharedStrings sst(QXlsx::SharedStrings::F_NewFromScratch);
+    sst.addSharedString("Hello Qt!");
+    sst.addSharedString("Xlsx Writer");
+    sst.addSharedString("Hello Qt!");
+    QByteArray xmlData = sst.saveToXmlData();
+
+    QXlsx::SharedStrings eager(QXlsx::SharedStrings::F_LoadFromExists);
+    eager.loadFromXmlData(xmlData);
+    QXlsx::SharedStrings lazy(QXlsx::SharedStrings::F_LoadFromExists);
+    lazy.setLazyLoad(true);
+    lazy.loadFromXmlData(xmlData);
+
+    // As a worksheet does for the cells it loads
+    eager.incRefByStringIndex(0, 2);
+    eager.incRefByStringIndex(1);
+    lazy.incRefByStringIndex(0, 2);
+    lazy.incRefByStringIndex(1);
+    QCOMPARE(lazy.count(), eager.count());
+    QCOMPARE(lazy.saveToXmlData(), eager.saveToXmlData());
+
+    // The first change builds the table
+    QCOMPARE(lazy.addSharedString("Hello World"), 2);
+    QCOMPARE(lazy.addSharedString("Hello Qt!"), 0);
+    QCOMPARE(lazy.count(), 5);
+    QCOMPARE(lazy.getSharedString(1).toPlainString(), QStringLiteral("Xlsx Writer"));
+    lazy.removeSharedString("Xlsx Writer");
+    QCOMPARE(lazy.getSharedStringIndex("Xlsx Writer"), -1);
+    QCOMPARE(lazy.getSharedStringIndex("Hello World"), 1);
+}
+
 QTEST_APPLESS_MAIN(SharedStringsTest)
 
 #include "tst_sharedstringstest.moc"
@@ -16,6 +16,7 @@ private Q_SLOTS:
     void testEmptyStyle();
     void testAddXfFormat();
     void testAddXfFormat2();
+    void testIsDateTimeXf();
     void testSolidFillBackgroundColor();
 
     void testWriteBorders();
@@ -70,6 +71,34 @@ void StylesTest::testAddXfFormat2()
     QCOMPARE(format2.numberFormatIndex(), 176);
 }
 
+void StylesTest::testIsDateTimeXf()
+{
+    QXlsx::Styles styles(QXlsx::Styles::F_NewFromScratch);
+
+    QXlsx::Format bold;
+    bold.setFontBold(true);
+    styles.addXfFormat(bold);
+
+    QXlsx::Format date;
+    date.setNumberFormat("dd/mm/yyyy"); //custom
+    styles.addXfFormat(date);
+
+    QXlsx::Format time;
+    time.setNumberFormatIndex(19); //builtin h:mm:ss AM/PM
+    styles.addXfFormat(time);
+
+    QXlsx::Format number;
+    number.setNumberFormat("0.00");
+    styles.addXfFormat(number);
+
+    for (int idx = -1; idx <= 5; ++idx)
+        QCOMPARE(styles.isDateTimeXf(idx), styles.hasXfFormat(idx) && styles.xfFormat(idx).isDateTimeFormat());
+    QVERIFY(!styles.isDateTimeXf(bold.xfIndex()));
+    QVERIFY(styles.isDateTimeXf(date.xfIndex()));
+    QVERIFY(styles.isDateTimeXf(time.xfIndex()));
+    QVERIFY(!styles.isDateTimeXf(number.xfIndex()));
+}
+
 // For a solid fill, Excel reverses the role of foreground and background colours
 void StylesTest::testSolidFillBackgroundColor()
 {
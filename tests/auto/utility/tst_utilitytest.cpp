@@ -23,7 +23,9 @@
 **
 ****************************************************************************/
 #include "private/xlsxutility_p.h"
+#include "private/xlsxsharedformula_p.h"
 #include "xlsxcellreference.h"
+#include "xlsxcellrange.h"
 #include <QString>
 #include <QtTest>
 #include <QDateTime>
@@ -45,6 +47,12 @@ private Q_SLOTS:
     void test_datetimeFromNumber_data();
     void test_datetimeFromNumber();
 
+    void test_doubleToChars_data();
+    void test_doubleToChars();
+
+    void test_stringToDouble_data();
+    void test_stringToDouble();
+
     void test_createSafeSheetName_data();
     void test_createSafeSheetName();
 
@@ -53,6 +61,8 @@ private Q_SLOTS:
 
     void test_convertSharedFormula_data();
     void test_convertSharedFormula();
+    void test_sharedFormulaTemplate_data();
+    void test_sharedFormulaTemplate();
 };
 
 UtilityTest::UtilityTest()
@@ -129,6 +139,71 @@ void UtilityTest::test_datetimeFromNumber()
     QCOMPARE(QXlsx::datetimeFromNumber(num, is1904), dt);
 }
 
+void UtilityTest::test_doubleToChars_data()
+{
+    QTest::addColumn<double>("num");
+    QTest::addColumn<int>("precision");
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("0") << 0.0 << 15 << QString("0");
+    QTest::newRow("123") << 123.0 << 15 << QString("123");
+    QTest::newRow("-1.5") << -1.5 << 15 << QString("-1.5");
+    QTest::newRow("1e20") << 1e20 << 15 << QString("1e+20");
+    QTest::newRow("1e-5") << 1e-5 << 15 << QString("1e-05");
+    QTest::newRow("pi") << 3.14159265358979323 << 15 << QString("3.14159265358979");
+    QTest::newRow("0.1+0.2") << 0.1 + 0.2 << 15 << QString("0.3");
+    QTest::newRow("20.5 height") << 20.5 << 6 << QString("20.5");
+
+    QTest::newRow("exact 0.1") << 0.1 << 0 << QString("0.1");
+    QTest::newRow("exact 100000") << 100000.0 << 0 << QString("100000");
+    QTest::newRow("exact pi") << 3.14159265358979323 << 0 << QString("3.141592653589793");
+    QTest::newRow("exact 0.1+0.2") << 0.1 + 0.2 << 0 << QString("0.30000000000000004");
+}
+
+void UtilityTest::test_doubleToChars()
+{
+    QFETCH(double, num);
+    QFETCH(int, precision);
+    QFETCH(QString, text);
+
+    char buffer[32];
+    const int size = QXlsx::doubleToChars(buffer, num, precision);
+    QCOMPARE(QString::fromLatin1(buffer, size), text);
+    if (precision == 15 || precision == 6)
+        QCOMPARE(QString::fromLatin1(buffer, size), QString::number(num, 'g', precision));
+    if (precision == 0)
+        QCOMPARE(QXlsx::charsToDouble(buffer, buffer + size), num);
+}
+
+void UtilityTest::test_stringToDouble_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("ok");
+    QTest::addColumn<double>("num");
+
+    QTest::newRow("integer") << QString("42") << true << 42.0;
+    QTest::newRow("negative") << QString("-0.25") << true << -0.25;
+    QTest::newRow("exponent") << QString("1.5E-3") << true << 1.5e-3;
+    QTest::newRow("17 digits") << QString("0.30000000000000004") << true << 0.1 + 0.2;
+    QTest::newRow("plus sign") << QString("+7") << true << 7.0;
+    QTest::newRow("spaces") << QString(" 8 ") << true << 8.0;
+    QTest::newRow("empty") << QString() << false << 0.0;
+    QTest::newRow("text") << QString("abc") << false << 0.0;
+}
+
+void UtilityTest::test_stringToDouble()
+{
+    QFETCH(QString, text);
+    QFETCH(bool, ok);
+    QFETCH(double, num);
+
+    bool valid;
+    const double value = QXlsx::stringToDouble(text, &valid);
+    QCOMPARE(valid, ok);
+    QCOMPARE(value, num);
+    QCOMPARE(value, text.toDouble());
+}
+
 void UtilityTest::test_createSafeSheetName_data()
 {
     QTest::addColumn<QString>("original");
@@ -218,6 +293,34 @@ void UtilityTest::test_convertSharedFormula()
 
     QCOMPARE(QXlsx::convertSharedFormula(original, rootCell, cell), result);
 }
+void UtilityTest::test_sharedFormulaTemplate_data()
+{
+    test_convertSharedFormula_data();
+}
+
+void UtilityTest::test_sharedFormulaTemplate()
+{
+    QFETCH(QString, original);
+    QFETCH(QString, rootCell);
+    QFETCH(QString, cell);
+    QFETCH(QString, result);
+
+    QXlsx::SharedFormulaTemplate formula(original, rootCell);
+    QVERIFY(formula.isValid());
+    QCOMPARE(formula.formulaAt(QXlsx::CellReference(cell)), result);
+    QCOMPARE(formula.formulaAt(QXlsx::CellReference(rootCell)), original);
+
+    const QXlsx::CellRange range(QXlsx::CellReference(rootCell), QXlsx::CellReference(cell));
+    const QList<QString> formulas = formula.expand(range);
+    QCOMPARE(formulas.size(), range.rowCount() * range.columnCount());
+    for (int row = range.firstRow(); row <= range.lastRow(); ++row) {
+        for (int col = range.firstColumn(); col <= range.lastColumn(); ++col) {
+            const int index = (row - range.firstRow()) * range.columnCount() + col - range.firstColumn();
+            QCOMPARE(formulas[index], QXlsx::convertSharedFormula(original, rootCell, QXlsx::CellReference(row, col)));
+        }
+    }
+}
+
 QTEST_APPLESS_MAIN(UtilityTest)
 
 #include "tst_utilitytest.moc"
@@ -3,11 +3,13 @@
 #include <QXmlStreamReader>
 
 #include "xlsxworksheet.h"
+#include "xlsxworkbook.h"
 #include "xlsxcell.h"
 #include "xlsxcellrange.h"
 #include "xlsxdatavalidation.h"
 #include "private/xlsxworksheet_p.h"
 #include "private/xlsxsharedstrings_p.h"
+#include "private/xlsxsheetdatareader_p.h"
 #include "xlsxrichstring.h"
 #include "xlsxcellformula.h"
 
@@ -25,12 +27,23 @@ private Q_SLOTS:
     void testSetColumn();
 
     void testWriteCells();
+    void testWriteSparseCells();
+    void testWriteEscapedCells();
+    void testWriteBulk();
+    void testWriteStreaming();
+    void testWriteSharedFormulas();
     void testWriteHyperlinks();
     void testWriteDataValidations();
     void testMerge();
     void testUnMerge();
 
     void testReadSheetData();
+    void testSheetDataReader();
+    void testReadSheetDataFast_data();
+    void testReadSheetDataFast();
+    void testReadFormulas();
+    void testRecalculate();
+    void testRecalculateIncremental();
     void testReadColsInfo();
     void testReadRowsInfo();
     void testReadMergeCells();
@@ -121,6 +134,133 @@ void WorksheetTest::testWriteCells()
     QCOMPARE(sheet.d_func()->sharedStrings()->getSharedString(0).toPlainString(), QStringLiteral("Hello"));
 }
 
+void WorksheetTest::testWriteSparseCells()
+{
+    QXlsx::Worksheet sheet("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
+    sheet.write("A1", 1);
+    sheet.write("XFD1", 2);
+    sheet.write("C18", 3);
+    sheet.write("A1048576", 4);
+
+    QByteArray xmldata = sheet.saveToXmlData();
+
+    QVERIFY2(xmldata.contains("<row r=\"1\" spans=\"1:16384\"><c r=\"A1\"><v>1</v></c><c r=\"XFD1\"><v>2</v></c></row>"), "first block");
+    QVERIFY2(xmldata.contains("<row r=\"18\" spans=\"3:3\"><c r=\"C18\"><v>3</v></c></row>"), "second block");
+    QVERIFY2(xmldata.contains("<row r=\"1048576\" spans=\"1:1\"><c r=\"A1048576\"><v>4</v></c></row>"), "last row");
+    QCOMPARE(xmldata.count("<row "), 3);
+}
+
+void WorksheetTest::testWriteEscapedCells()
+{
+    QXlsx::Worksheet sheet("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
+    sheet.writeInlineString(2, 1, QString::fromUtf8(" <a&b> \xc3\xa9\xe4\xb8\xad"));
+    sheet.writeNumeric(2, 2, 0.1 + 0.2);
+    sheet.setRowHeight(2, 2, 20.5);
+    sheet.setRowHidden(2, 2, true);
+
+    QByteArray xmldata = sheet.saveToXmlData();
+
+    QVERIFY2(xmldata.contains("<row r=\"2\" spans=\"1:2\" ht=\"20.5\" customHeight=\"1\" hidden=\"1\">"
+                              "<c r=\"A2\" t=\"inlineStr\"><is><t xml:space=\"preserve\">"
+                              " &lt;a&amp;b&gt; \xc3\xa9\xe4\xb8\xad</t></is></c>"
+                              "<c r=\"B2\"><v>0.3</v></c></row>"), "row");
+}
+
+void WorksheetTest::testWriteBulk()
+{
+    QXlsx::Worksheet sheet("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
+    QXlsx::Format format;
+    format.setFontBold(true);
+
+    const double column[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18 };
+    QVERIFY(sheet.writeColumn(2, 3, column, 18));
+    QVERIFY(sheet.writeRow(1, 1, QStringList() << "a" << "b" << "a", format));
+    QVERIFY(sheet.writeBlock(QXlsx::CellRange("E20:F21"), QList<double>() << 1.5 << 2.5 << 3.5 << 4.5));
+
+    QCOMPARE(sheet.dimension(), QXlsx::CellRange("A1:F21"));
+    QCOMPARE(sheet.read("C2").toInt(), 1);
+    QCOMPARE(sheet.read("C19").toInt(), 18);
+    QCOMPARE(sheet.read("C1").toString(), QStringLiteral("a"));
+    QCOMPARE(sheet.cellAt("B1")->format(), format);
+    QCOMPARE(sheet.read("F21").toDouble(), 4.5);
+    QCOMPARE(sheet.d_func()->sharedStrings()->getSharedStrings().size(), 2);
+
+    // Existing cells keep their format without a valid one
+    QVERIFY(sheet.writeRow(1, 1, QList<double>() << 7));
+    QCOMPARE(sheet.read("A1").toInt(), 7);
+    QCOMPARE(sheet.cellAt("A1")->format(), format);
+
+    // Nothing is written when the block doesn't fit
+    QVERIFY(!sheet.writeColumn(1048570, 1, column, 18));
+    QVERIFY(!sheet.writeBlock(QXlsx::CellRange("A1:B2"), QList<double>() << 1));
+    QVERIFY(!sheet.cellAt(1048570, 1));
+    QCOMPARE(sheet.dimension(), QXlsx::CellRange("A1:F21"));
+
+    QByteArray xmldata = sheet.saveToXmlData();
+    QVERIFY2(xmldata.contains("<c r=\"E20\"><v>1.5</v></c><c r=\"F20\"><v>2.5</v></c>"), "block");
+}
+
+void WorksheetTest::testWriteStreaming()
+{
+    QXlsx::Worksheet sheet("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
+    QVERIFY(sheet.setStreamingEnabled());
+    QVERIFY(sheet.write("A1", 1));
+    QVERIFY(sheet.write("B1", "Hello"));
+    QVERIFY(sheet.write("A3", 3));
+    QVERIFY(sheet.write("C3", 4));
+
+    // Rows 1 and 2 are completed now
+    QVERIFY(!sheet.write("A2", 2));
+    QVERIFY(!sheet.write("C1", 2));
+    QVERIFY(!sheet.cellAt("A1"));
+    QCOMPARE(sheet.read("A3").toInt(), 3);
+    QVERIFY(!sheet.setStreamingEnabled(false));
+
+    QByteArray xmldata = sheet.saveToXmlData();
+
+    QVERIFY2(xmldata.contains("<dimension ref=\"A1:C3\"/>"), "dimension");
+    QVERIFY2(xmldata.contains("<sheetData><row r=\"1\" spans=\"1:2\"><c r=\"A1\"><v>1</v></c><c r=\"B1\" t=\"s\"><v>0</v></c></row>"
+                              "<row r=\"3\" spans=\"1:3\"><c r=\"A3\"><v>3</v></c><c r=\"C3\"><v>4</v></c></row></sheetData>"), "rows");
+}
+
+void WorksheetTest::testWriteSharedFormulas()
+{
+    QXlsx::Worksheet sheet("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
+    for (int row = 1; row <= 4; ++row)
+        sheet.writeFormula(row, 2, QXlsx::CellFormula(QStringLiteral("A%1*$D$1+E$1").arg(row)));
+    sheet.writeFormula(5, 2, QXlsx::CellFormula("SUM(A1:A5)"));
+    // Not moved the same way by the reader and by Excel
+    sheet.writeFormula(6, 2, QXlsx::CellFormula("a6*2"));
+    sheet.writeFormula(7, 2, QXlsx::CellFormula("a7*2"));
+    sheet.writeFormula(8, 2, QXlsx::CellFormula("LOG10(A8)"));
+    sheet.writeFormula(9, 2, QXlsx::CellFormula("LOG10(A9)"));
+    sheet.writeFormula(1, 3, QXlsx::CellFormula("SUM(1:1)"));
+    sheet.writeFormula(2, 3, QXlsx::CellFormula("SUM(2:2)"));
+    sheet.writeFormula(1, 4, QXlsx::CellFormula("SUM(A:A)*A1"));
+    sheet.writeFormula(2, 4, QXlsx::CellFormula("SUM(A:A)*A2"));
+
+    const QByteArray xmldata = sheet.saveToXmlData();
+    QVERIFY2(xmldata.contains("<c r=\"B1\"><f t=\"shared\" ref=\"B1:B4\" ca=\"1\" si=\"0\">A1*$D$1+E$1</f><v>0</v></c>"), "master");
+    QVERIFY2(xmldata.contains("<c r=\"B4\"><f t=\"shared\" ca=\"1\" si=\"0\"/><v>0</v></c>"), "child");
+    QVERIFY2(xmldata.contains("<c r=\"B5\"><f ca=\"1\">SUM(A1:A5)</f>"), "single");
+    QVERIFY2(xmldata.contains("<c r=\"B7\"><f ca=\"1\">a7*2</f>"), "lower case");
+    QVERIFY2(xmldata.contains("<c r=\"B9\"><f ca=\"1\">LOG10(A9)</f>"), "function like a cell");
+    QVERIFY2(xmldata.contains("<c r=\"C2\"><f ca=\"1\">SUM(2:2)</f>"), "whole rows");
+    QVERIFY2(xmldata.contains("<f t=\"shared\" ref=\"D1:D2\" ca=\"1\" si=\"1\">SUM(A:A)*A1</f>"), "whole columns");
+
+    // The cells keep their formulas, and read back the same
+    QCOMPARE(sheet.cellAt("B2")->formula(), QXlsx::CellFormula("A2*$D$1+E$1"));
+    const QXlsx::CellRange range("B1:D9");
+    QXlsx::Worksheet loaded("", 1, 0, QXlsx::Worksheet::F_LoadFromExists);
+    loaded.loadFromXmlData(xmldata);
+    QCOMPARE(loaded.readFormulas(range), sheet.readFormulas(range));
+
+    sheet.workbook()->setFormulaSharingEnabled(false);
+    const QByteArray normal = sheet.saveToXmlData();
+    QVERIFY(!normal.contains("t=\"shared\""));
+    QVERIFY2(normal.contains("<c r=\"B4\"><f ca=\"1\">A4*$D$1+E$1</f><v>0</v></c>"), "disabled");
+}
+
 void WorksheetTest::testWriteHyperlinks()
 {
     QXlsx::Worksheet sheet("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
@@ -202,7 +342,7 @@ void WorksheetTest::testReadSheetData()
     sheet.d_func()->sharedStrings()->addSharedString("Hello");
     sheet.d_func()->loadXmlSheetData(reader);
 
-    QCOMPARE(sheet.d_func()->cellTable.size(), 2);
+    QCOMPARE(sheet.d_func()->cellTable.rowCount(), 2);
 
     //A1
     QCOMPARE(sheet.cellAt("A1")->cellType(), QXlsx::Cell::SharedStringType);
@@ -231,6 +371,306 @@ void WorksheetTest::testReadSheetData()
     QCOMPARE(sheet.cellAt("E3")->value().toString(), QStringLiteral("#DIV/0!"));
 }
 
+class SheetDataCounter : public QXlsx::SheetDataReader::Handler
+{
+public:
+    SheetDataCounter() : rows(0), cells(0), maxRows(-1) {}
+    bool row(const QXlsx::SheetDataReader::Row &) override
+    {
+        if (rows == maxRows)
+            return false;
+        ++rows;
+        return true;
+    }
+    void cell(const QXlsx::SheetDataReader::Cell &cell) override
+    {
+        ++cells;
+        values.append(QByteArray(cell.value.data(), cell.value.size()));
+    }
+
+    int rows;
+    int cells;
+    int maxRows; // rows read before stopping, -1 for all
+    QList<QByteArray> values;
+};
+
+void WorksheetTest::testSheetDataReader()
+{
+    QByteArray xmlData = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+            "<worksheet><dimension ref=\"A1:B2\"/><sheetData>"
+            "<row r=\"1\"><c r=\"A1\"><v>1.5</v></c><c r=\"B1\" t=\"str\"><v>a&amp;b&#x41;</v></c></row>"
+            "<row r=\"2\"><c r=\"A2\" t=\"inlineStr\"><is><t>x\r\ny</t></is></c></row>"
+            "</sheetData><mergeCells count=\"0\"/></worksheet>";
+
+    // Read one byte at a time, so every element is split.
+    for (int chunk : {1, 7, 8192}) {
+        QBuffer source(&xmlData);
+        source.open(QIODevice::ReadOnly);
+        SheetDataCounter counter;
+        QXlsx::SheetDataReader reader(&source, &counter);
+        QByteArray passed;
+        char buffer[8192];
+        qint64 len;
+        while ((len = reader.read(buffer, chunk)) > 0)
+            passed.append(buffer, int(len));
+
+        QVERIFY(reader.isSheetDataRead());
+        QCOMPARE(counter.rows, 2);
+        QCOMPARE(counter.cells, 3);
+        QCOMPARE(counter.values, QList<QByteArray>() << "1.5" << "a&bA" << "x\ny");
+        QCOMPARE(passed, QByteArray("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+                                    "<worksheet><dimension ref=\"A1:B2\"/><sheetData>"
+                                    "</sheetData><mergeCells count=\"0\"/></worksheet>"));
+    }
+
+    // Unknown markup inside a row, the rest is passed through
+    // from a new <row> start tag.
+    QByteArray unusual = "<worksheet><sheetData>"
+            "<row r=\"1\"><c r=\"A1\"><v>1</v></c><c r=\"B1\"><v>2</v><extLst/></c></row>"
+            "</sheetData></worksheet>";
+    QBuffer source(&unusual);
+    source.open(QIODevice::ReadOnly);
+    SheetDataCounter counter;
+    QXlsx::SheetDataReader reader(&source, &counter);
+    QCOMPARE(reader.readAll(), QByteArray("<worksheet><sheetData>"
+                                          "<row><c r=\"B1\"><v>2</v><extLst/></c></row>"
+                                          "</sheetData></worksheet>"));
+    QVERIFY(!reader.isSheetDataRead());
+    QCOMPARE(counter.cells, 1);
+
+    // Stopped at the second row, the rest of <sheetData> is skipped unparsed
+    for (int chunk : {1, 7, 8192}) {
+        QBuffer input(&xmlData);
+        input.open(QIODevice::ReadOnly);
+        SheetDataCounter stopping;
+        stopping.maxRows = 1;
+        QXlsx::SheetDataReader stopped(&input, &stopping);
+        QByteArray passed;
+        char buffer[8192];
+        qint64 len;
+        while ((len = stopped.read(buffer, chunk)) > 0)
+            passed.append(buffer, int(len));
+
+        QVERIFY(stopped.isSheetDataRead());
+        QCOMPARE(stopping.rows, 1);
+        QCOMPARE(stopping.values, QList<QByteArray>() << "1.5" << "a&bA");
+        QCOMPARE(passed, QByteArray("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+                                    "<worksheet><dimension ref=\"A1:B2\"/><sheetData>"
+                                    "</sheetData><mergeCells count=\"0\"/></worksheet>"));
+    }
+}
+
+void WorksheetTest::testReadSheetDataFast_data()
+{
+    QTest::addColumn<QByteArray>("sheetData");
+
+    QTest::newRow("numbers") << QByteArray(
+            "<sheetData><row r=\"1\" spans=\"1:3\"><c r=\"A1\"><v>1</v></c><c r=\"B1\" s=\"1\"><v>-2.5E-3</v></c>"
+            "<c r=\"C1\"><v> 7 </v></c></row><row r=\"2\"><c r=\"A2\" s=\"1\"/><c r=\"$B$2\"><v>3</v></c>"
+            "<c r=\"C2\" t=\"b\"><v>1</v></c><c r=\"D2\"><v/></c><c><v>9</v></c></row></sheetData>");
+    QTest::newRow("strings") << QByteArray(
+            "<sheetData><row r=\"1\"><c r=\"A1\" t=\"s\"><v>0</v></c><c r=\"B1\" t=\"inlineStr\">"
+            "<is><t xml:space=\"preserve\"> a &lt;b&gt;\r\n&#233; </t></is></c><c r=\"C1\" t=\"e\"><v>#N/A</v></c>"
+            "<c r=\"D1\" t=\"str\"><v>&quot;q&apos;</v></c><c r=\"E1\" t=\"inlineStr\"><is/></c></row></sheetData>");
+    QTest::newRow("formulas") << QByteArray(
+            "<sheetData><row r=\"1\"><c r=\"A1\"><f t=\"shared\" ref=\"A1:A3\" si=\"0\">B1&amp;&quot;x&quot;</f><v>1</v></c></row>"
+            "<row r=\"2\"><c r=\"A2\"><f t=\"shared\" si=\"0\"/><v>2</v></c><c r=\"B2\" t=\"str\"><f>=IF(A1&gt;0,1,2)</f><v>1</v></c>"
+            "<c r=\"C2\"><f t=\"array\" ref=\"C2:C3\">SUM(A1:A2*B1:B2)</f><v>4</v></c><c r=\"D2\"><f/></c></row></sheetData>");
+    QTest::newRow("row info") << QByteArray(
+            "<sheetData><row r=\"1\" spans=\"1:6\" ht=\"40\" customHeight=\"1\"><c r=\"A1\"><v>1</v></c></row>"
+            "<row r=\"2\" hidden=\"1\" outlineLevel=\"2\" collapsed=\"1\"/><row r=\"3\" s=\"1\" customFormat=\"1\">"
+            "<c r=\"A3\"><v>3</v></c></row></sheetData>");
+    QTest::newRow("fallback") << QByteArray(
+            "<sheetData><row r=\"1\"><c r=\"A1\"><v>1</v></c><c r=\"B1\" t=\"inlineStr\"><is><r><t>rich</t></r></is></c>"
+            "<c r=\"C1\"><v>3</v></c></row><!-- comment --><row r=\"2\" ht=\"20\" customHeight=\"1\">"
+            "<c r=\"A2\"><v>4<![CDATA[2]]></v></c></row></sheetData>");
+}
+
+static void loadWorksheet(QXlsx::Worksheet &sheet, const QByteArray &sheetData, bool fast)
+{
+    const QByteArray xmlData = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+            "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+            + sheetData + "</worksheet>";
+    sheet.d_func()->sharedStrings()->addSharedString("Hello");
+    if (fast) {
+        sheet.loadFromXmlData(xmlData);
+        return;
+    }
+    QXmlStreamReader reader(xmlData);
+    while (reader.readNextStartElement() && reader.name() != QLatin1String("sheetData")) {
+    }
+    sheet.d_func()->loadXmlSheetData(reader);
+}
+
+void WorksheetTest::testReadSheetDataFast()
+{
+    QFETCH(QByteArray, sheetData);
+
+    QXlsx::Worksheet fast("", 1, 0, QXlsx::Worksheet::F_LoadFromExists);
+    loadWorksheet(fast, sheetData, true);
+    QXlsx::Worksheet generic("", 1, 0, QXlsx::Worksheet::F_LoadFromExists);
+    loadWorksheet(generic, sheetData, false);
+
+    QXlsx::WorksheetPrivate *fast_d = fast.d_func();
+    QXlsx::WorksheetPrivate *generic_d = generic.d_func();
+    const QXlsx::CellRange range = generic_d->cellTable.boundingRange();
+    QVERIFY(range.isValid());
+    QCOMPARE(fast_d->cellTable.boundingRange(), range);
+    for (int row = range.firstRow(); row <= range.lastRow(); ++row) {
+        for (int col = range.firstColumn(); col <= range.lastColumn(); ++col) {
+            QXlsx::Cell *expected = generic.cellAt(row, col);
+            QXlsx::Cell *actual = fast.cellAt(row, col);
+            QCOMPARE(!actual, !expected);
+            if (!expected)
+                continue;
+            QCOMPARE(actual->cellType(), expected->cellType());
+            QCOMPARE(actual->value(), expected->value());
+            QCOMPARE(actual->format(), expected->format());
+            QCOMPARE(actual->formula(), expected->formula());
+            QCOMPARE(actual->formula().reference(), expected->formula().reference());
+        }
+    }
+
+    QCOMPARE(fast_d->sharedFormulaMap.keys(), generic_d->sharedFormulaMap.keys());
+    QCOMPARE(fast.readFormulas(range), generic.readFormulas(range));
+    QCOMPARE(fast_d->rowsInfo.keys(), generic_d->rowsInfo.keys());
+    foreach (int row, generic_d->rowsInfo.keys()) {
+        QCOMPARE(fast_d->rowsInfo[row]->height, generic_d->rowsInfo[row]->height);
+        QCOMPARE(fast_d->rowsInfo[row]->hidden, generic_d->rowsInfo[row]->hidden);
+        QCOMPARE(fast_d->rowsInfo[row]->outlineLevel, generic_d->rowsInfo[row]->outlineLevel);
+        QCOMPARE(fast_d->rowsInfo[row]->collapsed, generic_d->rowsInfo[row]->collapsed);
+    }
+    QCOMPARE(fast_d->sharedStrings()->getSharedStrings().size(), 1);
+}
+
+void WorksheetTest::testReadFormulas()
+{
+    QXlsx::Worksheet sheet("", 1, 0, QXlsx::Worksheet::F_LoadFromExists);
+    loadWorksheet(sheet, QByteArray(
+            "<sheetData><row r=\"1\"><c r=\"B1\"><f t=\"shared\" ref=\"B1:C3\" si=\"0\">A1*$A1+A$1&amp;\"A1\"</f><v>1</v></c>"
+            "<c r=\"C1\"><f t=\"shared\" si=\"0\"/><v>1</v></c><c r=\"D1\"><f>SUM(B1:C1)</f><v>2</v></c></row>"
+            "<row r=\"3\"><c r=\"B3\"><f t=\"shared\" si=\"0\"/><v>1</v></c><c r=\"C3\"><f t=\"shared\" si=\"0\"/><v>1</v></c>"
+            "<c r=\"D3\"><v>5</v></c></row></sheetData>"), true);
+
+    QCOMPARE(sheet.readFormulas(QXlsx::CellRange("B1:D3")), QStringList()
+             << "A1*$A1+A$1&\"A1\"" << "B1*$A1+B$1&\"A1\"" << "SUM(B1:C1)"
+             << QString() << QString() << QString()
+             << "A3*$A3+A$1&\"A1\"" << "B3*$A3+B$1&\"A1\"" << QString());
+    QCOMPARE(sheet.read("C3").toString(), QStringLiteral("=B3*$A3+B$1&\"A1\""));
+    QVERIFY(sheet.readFormulas(QXlsx::CellRange()).isEmpty());
+
+    // Written shared formulas are expanded the same way
+    QXlsx::Worksheet written("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
+    written.writeFormula("E2", QXlsx::CellFormula("D2*2", "E2:E4", QXlsx::CellFormula::SharedType));
+    QCOMPARE(written.readFormulas(QXlsx::CellRange("E2:E4")),
+             QStringList() << "D2*2" << "D3*2" << "D4*2");
+}
+
+void WorksheetTest::testRecalculate()
+{
+    QXlsx::Worksheet sheet("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
+    sheet.write("A1", 2);
+    sheet.write("A2", 3);
+    sheet.write("A3", "=A1*A2");
+    sheet.write("A4", "=SUM(A1:A3)+AVERAGE(A1:A2)");
+    sheet.write("A5", "=IF(A4>10,\"big\",\"small\")");
+    sheet.write("B1", "x");
+    sheet.write("B2", "=B1&A1");
+    sheet.writeFormula("C1", QXlsx::CellFormula("A1*10", "C1:C3", QXlsx::CellFormula::SharedType));
+    sheet.write("D1", "=VLOOKUP(3,A1:C3,3,FALSE)");
+    sheet.write("D2", "=1/0");
+    sheet.write("D3", "=D4");
+    sheet.write("D4", "=D3+1");
+    sheet.write("D5", "=A1>1");
+    sheet.write("D6", "=COUNT(A:A)");
+    sheet.write("D7", "=NOSUCHFUNCTION(A1)");
+
+    // D3 and D4 refer to each other, they are left as they are
+    QCOMPARE(sheet.recalculate(), 12);
+    QCOMPARE(sheet.cellAt("A3")->value().toDouble(), 6.0);
+    QCOMPARE(sheet.cellAt("A4")->value().toDouble(), 13.5);
+    QCOMPARE(sheet.cellAt("A5")->value().toString(), QStringLiteral("big"));
+    QCOMPARE(sheet.cellAt("B2")->value().toString(), QStringLiteral("x2"));
+    QCOMPARE(sheet.cellAt("C2")->value().toDouble(), 30.0);
+    QCOMPARE(sheet.cellAt("C3")->value().toDouble(), 60.0);
+    QCOMPARE(sheet.cellAt("D1")->value().toDouble(), 30.0);
+    QCOMPARE(sheet.cellAt("D2")->value().toString(), QStringLiteral("#DIV/0!"));
+    QCOMPARE(sheet.cellAt("D3")->value().toDouble(), 0.0);
+    QCOMPARE(sheet.cellAt("D5")->value().toBool(), true);
+    QCOMPARE(sheet.cellAt("D6")->value().toDouble(), 4.0);
+    QCOMPARE(sheet.cellAt("D7")->value().toString(), QStringLiteral("#NAME?"));
+    QCOMPARE(sheet.read("A3").toString(), QStringLiteral("=A1*A2"));
+
+    const QByteArray xmldata = sheet.saveToXmlData();
+    QVERIFY2(xmldata.contains("<c r=\"A3\"><f ca=\"1\">A1*A2</f><v>6</v></c>"), "number");
+    QVERIFY2(xmldata.contains("<c r=\"A5\" t=\"str\">"), "string");
+    QVERIFY2(xmldata.contains("<c r=\"D2\" t=\"e\"><f ca=\"1\">1/0</f><v>#DIV/0!</v></c>"), "error");
+    QVERIFY2(xmldata.contains("<c r=\"D5\" t=\"b\"><f ca=\"1\">A1&gt;1</f><v>1</v></c>"), "boolean");
+
+    // Large levels are split between threads
+    QXlsx::Worksheet large("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
+    for (int row = 1; row <= 2000; ++row) {
+        large.writeNumeric(row, 1, row);
+        large.writeFormula(row, 2, QXlsx::CellFormula(QStringLiteral("A%1*2").arg(row)));
+    }
+    large.writeFormula(1, 3, QXlsx::CellFormula("SUM(B:B)"));
+    QCOMPARE(large.recalculate(), 2001);
+    QCOMPARE(large.cellAt(2000, 2)->value().toDouble(), 4000.0);
+    QCOMPARE(large.cellAt(1, 3)->value().toDouble(), 2001000.0 * 2);
+}
+
+void WorksheetTest::testRecalculateIncremental()
+{
+    QXlsx::Worksheet sheet("", 1, 0, QXlsx::Worksheet::F_NewFromScratch);
+    for (int row = 1; row <= 100; ++row) {
+        sheet.writeNumeric(row, 1, row);
+        sheet.writeFormula(row, 2, QXlsx::CellFormula(QStringLiteral("A%1*2").arg(row)));
+    }
+    sheet.writeFormula(1, 3, QXlsx::CellFormula("SUM(B1:B100)"));
+    sheet.writeFormula(2, 3, QXlsx::CellFormula("C1+1"));
+    sheet.writeFormula(3, 3, QXlsx::CellFormula("A1+A2"));
+
+    QCOMPARE(sheet.recalculate(), 103);
+    QXlsx::Worksheet::CalculationStats stats = sheet.calculationStats();
+    QVERIFY(stats.rebuilt);
+    QCOMPARE(stats.formulas, 103);
+    QCOMPARE(stats.dirty, 103);
+    QCOMPARE(stats.recomputed, 103);
+    QCOMPARE(stats.circular, 0);
+
+    QCOMPARE(sheet.recalculate(), 0);
+    QVERIFY(!sheet.calculationStats().rebuilt);
+
+    // A50 -> B50 -> C1 -> C2
+    sheet.writeNumeric(50, 1, 1000);
+    QCOMPARE(sheet.recalculate(), 3);
+    stats = sheet.calculationStats();
+    QCOMPARE(stats.dirty, 1);
+    QCOMPARE(stats.recomputed, 3);
+    QCOMPARE(sheet.cellAt(1, 3)->value().toDouble(), 12000.0);
+    QCOMPARE(sheet.cellAt(2, 3)->value().toDouble(), 12001.0);
+
+    // A new formula, and a formula overwritten by a value
+    sheet.writeFormula(4, 3, QXlsx::CellFormula("C2*2"));
+    sheet.writeNumeric(10, 2, 0);
+    QCOMPARE(sheet.recalculate(), 3);
+    stats = sheet.calculationStats();
+    QCOMPARE(stats.formulas, 103);
+    QCOMPARE(stats.dirty, 2);
+    QCOMPARE(sheet.cellAt(1, 3)->value().toDouble(), 11980.0);
+    QCOMPARE(sheet.cellAt(4, 3)->value().toDouble(), 23962.0);
+
+    // Bulk writes, and cells no formula refers to
+    sheet.writeColumn(1, 1, QList<double>() << 0 << 0);
+    sheet.writeString(200, 5, "x");
+    QCOMPARE(sheet.recalculate(), 6);
+    QCOMPARE(sheet.cellAt(3, 3)->value().toDouble(), 0.0);
+    QCOMPARE(sheet.cellAt(1, 3)->value().toDouble(), 11974.0);
+
+    sheet.writeString(201, 5, "y");
+    QCOMPARE(sheet.recalculate(), 0);
+}
+
 void WorksheetTest::testReadColsInfo()
 {
     const QByteArray xmlData = "<cols>"
@@ -1,7 +1,9 @@
 #include "private/xlsxzipreader_p.h"
+#include "private/xlsxzipwriter_p.h"
 #include <QString>
 #include <QtTest>
 #include <QBuffer>
+#include <QTemporaryFile>
 
 const char fileContent[] = "\x50\x4B\x03\x04\x0A\x00\x00\x00\x00\x00\x8F\x51\x25\x43\x82\x89\xD1\xF7\x05\x00\x00\x00\x05\x00\x00\x00\x09\x00\x00\x00\x68\x65\x6C\x6C\x6F\x2E\x74\x78\x74\x48\x65\x6C\x6C\x6F\x50\x4B\x03\x04\x0A\x00\x00\x00\x00\x00\xB8\x53\x25\x43\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x71\x74\x2F\x50\x4B\x03\x04\x0A\x00\x00\x00\x00\x00\x92\x51\x25\x43\x2E\x19\xFC\x34\x04\x00\x00\x00\x04\x00\x00\x00\x0B\x00\x00\x00\x71\x74\x2F\x78\x6C\x73\x78\x2E\x74\x78\x74\x58\x6C\x73\x78\x50\x4B\x01\x02\x14\x00\x0A\x00\x00\x00\x00\x00\x8F\x51\x25\x43\x82\x89\xD1\xF7\x05\x00\x00\x00\x05\x00\x00\x00\x09\x00\x00\x00\x00\x00\x00\x00\x01\x00\x20\x00\x00\x00\x00\x00\x00\x00\x68\x65\x6C\x6C\x6F\x2E\x74\x78\x74\x50\x4B\x01\x02\x14\x00\x0A\x00\x00\x00\x00\x00\xB8\x53\x25\x43\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00\x10\x00\x00\x00\x2C\x00\x00\x00\x71\x74\x2F\x50\x4B\x01\x02\x14\x00\x0A\x00\x00\x00\x00\x00\x92\x51\x25\x43\x2E\x19\xFC\x34\x04\x00\x00\x00\x04\x00\x00\x00\x0B\x00\x00\x00\x00\x00\x00\x00\x01\x00\x20\x00\x00\x00\x4D\x00\x00\x00\x71\x74\x2F\x78\x6C\x73\x78\x2E\x74\x78\x74\x50\x4B\x05\x06\x00\x00\x00\x00\x03\x00\x03\x00\xA1\x00\x00\x00\x7A\x00\x00\x00\x00\x00";
 
@@ -14,6 +16,14 @@ public:
     
 private Q_SLOTS:
     void testFileList();
+    void testOpenFile();
+    void testStoredView();
+    void testMappedFile();
+    void testCorruptPackage();
+
+private:
+    QByteArray sheetXml() const;
+    QByteArray package(const QByteArray &xml) const;
 };
 
 ZipReaderTest::ZipReaderTest()
@@ -33,6 +43,134 @@ void ZipReaderTest::testFileList()
     QVERIFY(files.contains("qt/xlsx.txt"));
     QCOMPARE(reader.fileData("hello.txt"), QByteArray("Hello"));
     QCOMPARE(reader.fileData("qt/xlsx.txt"), QByteArray("Xlsx"));
+
+    QVERIFY(reader.exists());
+    QCOMPARE(files.size(), 2);
+    QVERIFY(reader.contains("hello.txt"));
+    QVERIFY(!reader.contains("qt/"));
+    QVERIFY(!reader.contains("missing.txt"));
+    QCOMPARE(reader.fileSize("qt/xlsx.txt"), qint64(4));
+    QCOMPARE(reader.fileSize("missing.txt"), qint64(-1));
+    QCOMPARE(reader.fileData("missing.txt"), QByteArray());
+}
+
+QByteArray ZipReaderTest::sheetXml() const
+{
+    QByteArray xml;
+    for (int i = 1; i <= 50000; ++i)
+        xml.append(QStringLiteral("<row r=\"%1\"><c><v>%2</v></c></row>").arg(i).arg(i * 7).toUtf8());
+    return xml;
+}
+
+QByteArray ZipReaderTest::package(const QByteArray &xml) const
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QXlsx::ZipWriter writer(&buffer);
+    writer.addFile("xl/worksheets/sheet1.xml", xml);
+    writer.setCompressionLevel(0);
+    writer.addFile("xl/media/image1.png", QByteArray("not really a png"));
+    writer.close();
+    return buffer.buffer();
+}
+
+void ZipReaderTest::testOpenFile()
+{
+    const QByteArray xml = sheetXml();
+    QByteArray data = package(xml);
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader reader(&buffer);
+
+    QScopedPointer<QIODevice> device(reader.openFile("xl/worksheets/sheet1.xml"));
+    QVERIFY(device);
+    QVERIFY(device->isSequential());
+    QVERIFY(device->isReadable());
+    QCOMPARE(device->bytesAvailable(), qint64(xml.size()));
+
+    QByteArray result;
+    char chunk[1000];
+    qint64 len;
+    while ((len = device->read(chunk, sizeof(chunk))) > 0)
+        result.append(chunk, int(len));
+    QCOMPARE(len, qint64(0));
+    QVERIFY(device->atEnd());
+    QCOMPARE(result, xml);
+
+    QVERIFY(!reader.openFile("xl/worksheets/sheet2.xml"));
+}
+
+void ZipReaderTest::testStoredView()
+{
+    QByteArray data = package(sheetXml());
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader reader(&buffer);
+
+    // Stored entries are read in place from the package bytes.
+    QScopedPointer<QIODevice> device(reader.openFile("xl/media/image1.png"));
+    QBuffer *view = qobject_cast<QBuffer *>(device.data());
+    QVERIFY(view);
+    const char *begin = data.constData();
+    const char *end = begin + data.size();
+    QVERIFY(view->data().constData() >= begin && view->data().constData() < end);
+    QCOMPARE(device->readAll(), QByteArray("not really a png"));
+
+    // fileData() returns a copy which outlives the reader.
+    QCOMPARE(reader.fileData("xl/media/image1.png"), QByteArray("not really a png"));
+}
+
+void ZipReaderTest::testMappedFile()
+{
+    const QByteArray xml = sheetXml();
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(package(xml));
+    file.flush();
+
+    QXlsx::ZipReader byName(file.fileName());
+    QVERIFY(byName.exists());
+    QCOMPARE(byName.fileData("xl/worksheets/sheet1.xml"), xml);
+
+    // The device is not used any more once the reader is constructed.
+    QXlsx::ZipReader byDevice(&file);
+    file.close();
+    QVERIFY(byDevice.exists());
+    QCOMPARE(byDevice.filePaths(),
+             QStringList() << "xl/worksheets/sheet1.xml" << "xl/media/image1.png");
+    QScopedPointer<QIODevice> device(byDevice.openFile("xl/worksheets/sheet1.xml"));
+    QVERIFY(device);
+    QCOMPARE(device->readAll(), xml);
+
+    QXlsx::ZipReader missing(file.fileName() + ".missing");
+    QVERIFY(!missing.exists());
+    QVERIFY(missing.filePaths().isEmpty());
+}
+
+void ZipReaderTest::testCorruptPackage()
+{
+    const QByteArray xml = sheetXml();
+    const QByteArray data = package(xml);
+
+    QBuffer truncated;
+    truncated.setData(data.left(data.size() - 10));
+    truncated.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader noDirectory(&truncated);
+    QVERIFY(!noDirectory.exists());
+    QVERIFY(!noDirectory.contains("xl/worksheets/sheet1.xml"));
+
+    // Damage the deflate stream of the sheet, the directory is intact.
+    QByteArray damaged = data;
+    for (int i = 100; i < 200; ++i)
+        damaged[i] = char(0xff);
+    QBuffer buffer(&damaged);
+    buffer.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader reader(&buffer);
+    QVERIFY(reader.exists());
+    QCOMPARE(reader.fileData("xl/worksheets/sheet1.xml"), QByteArray());
+    QScopedPointer<QIODevice> device(reader.openFile("xl/worksheets/sheet1.xml"));
+    QVERIFY(device);
+    QVERIFY(device->readAll() != xml);
 }
 
 QTEST_APPLESS_MAIN(ZipReaderTest)
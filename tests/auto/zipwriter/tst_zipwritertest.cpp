@@ -0,0 +1,214 @@
+#include "private/xlsxzipwriter_p.h"
+#include "private/xlsxzipreader_p.h"
+#include <QString>
+#include <QtTest>
+#include <QBuffer>
+
+class ZipWriterTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ZipWriterTest();
+
+private Q_SLOTS:
+    void testAddFile();
+    void testOpenFile();
+    void testEntryBuffer();
+    void testParallelDeflate_data();
+    void testParallelDeflate();
+    void testCompressionLevel();
+    void testClosedDevice();
+};
+
+ZipWriterTest::ZipWriterTest()
+{
+}
+
+void ZipWriterTest::testAddFile()
+{
+    QByteArray media;
+    for (int i = 0; i < 4096; ++i)
+        media.append(char((i * 7919) >> 3));
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QXlsx::ZipWriter writer(&buffer);
+    writer.addFile("hello.txt", QByteArray("Hello"));
+    writer.addFile("empty.txt", QByteArray());
+    writer.addFile("xl/media/image1.png", media);
+    writer.close();
+    QVERIFY(!writer.error());
+    QVERIFY(!buffer.isOpen());
+
+    QBuffer input(&buffer.buffer());
+    input.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader reader(&input);
+    QCOMPARE(reader.filePaths(),
+             QStringList() << "hello.txt" << "empty.txt" << "xl/media/image1.png");
+    QCOMPARE(reader.fileData("hello.txt"), QByteArray("Hello"));
+    QCOMPARE(reader.fileData("empty.txt"), QByteArray());
+    QCOMPARE(reader.fileData("xl/media/image1.png"), media);
+}
+
+void ZipWriterTest::testOpenFile()
+{
+    QByteArray xml;
+    for (int i = 1; i <= 100000; ++i) {
+        const QString row = QStringLiteral("<row r=\"%1\"><c><v>%2</v></c></row>");
+        xml.append(row.arg(i).arg(i * 3).toUtf8());
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QXlsx::ZipWriter writer(&buffer);
+    QIODevice *entry = writer.openFile("xl/worksheets/sheet1.xml");
+    QVERIFY(entry->isWritable());
+    for (int pos = 0; pos < xml.size(); pos += 1000)
+        QVERIFY(entry->write(xml.mid(pos, 1000)) > 0);
+    QVERIFY(writer.closeFile());
+    QVERIFY(!entry->isOpen());
+
+    // A new entry implicitly finishes the previous one.
+    writer.openFile("xl/worksheets/sheet2.xml")->write("<worksheet/>");
+    writer.addFile("xl/sharedStrings.xml", QByteArray("<sst/>"));
+    writer.close();
+    QVERIFY(!writer.error());
+    QVERIFY(buffer.size() < xml.size() / 4);
+
+    QBuffer input(&buffer.buffer());
+    input.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader reader(&input);
+    QCOMPARE(reader.fileData("xl/worksheets/sheet1.xml"), xml);
+    QCOMPARE(reader.fileData("xl/worksheets/sheet2.xml"), QByteArray("<worksheet/>"));
+    QCOMPARE(reader.fileData("xl/sharedStrings.xml"), QByteArray("<sst/>"));
+}
+
+void ZipWriterTest::testEntryBuffer()
+{
+    QByteArray xml;
+    for (int i = 1; i <= 10000; ++i)
+        xml.append(QStringLiteral("<c r=\"A%1\"/>").arg(i).toUtf8());
+
+    QXlsx::ZipEntryBuffer entry;
+    QVERIFY(entry.isWritable());
+    entry.write(xml);
+    entry.close();
+    QVERIFY(!entry.error());
+    QCOMPARE(entry.uncompressedSize(), qint64(xml.size()));
+    QVERIFY(entry.compressedData().size() < xml.size());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QXlsx::ZipWriter writer(&buffer);
+    writer.addFile("xl/worksheets/sheet1.xml", entry);
+    writer.close();
+    QVERIFY(!writer.error());
+
+    QBuffer input(&buffer.buffer());
+    input.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader reader(&input);
+    QCOMPARE(reader.fileData("xl/worksheets/sheet1.xml"), xml);
+}
+
+void ZipWriterTest::testParallelDeflate_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("empty") << 0;
+    QTest::newRow("one block") << 1000;
+    QTest::newRow("block boundary") << 2 * 128 * 1024;
+    QTest::newRow("many blocks") << 3 * 1024 * 1024 + 17;
+}
+
+void ZipWriterTest::testParallelDeflate()
+{
+    QFETCH(int, size);
+
+    QByteArray xml;
+    for (int i = 1; xml.size() < size; ++i)
+        xml.append(QStringLiteral("<c r=\"B%1\"><v>%2</v></c>").arg(i).arg(i % 977).toUtf8());
+    xml.truncate(size);
+
+    QXlsx::ZipEntryBuffer entry;
+    entry.setParallelDeflate(true);
+    for (int pos = 0; pos < xml.size(); pos += 10000)
+        entry.write(xml.mid(pos, 10000));
+    entry.close();
+    QVERIFY(!entry.error());
+    QCOMPARE(entry.uncompressedSize(), qint64(xml.size()));
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QXlsx::ZipWriter writer(&buffer);
+    writer.addFile("buffered.xml", entry);
+    writer.setParallelDeflate(true);
+    writer.openFile("streamed.xml")->write(xml);
+    writer.close();
+    QVERIFY(!writer.error());
+
+    QBuffer input(&buffer.buffer());
+    input.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader reader(&input);
+    QCOMPARE(reader.fileData("buffered.xml"), xml);
+    QCOMPARE(reader.fileData("streamed.xml"), xml);
+}
+
+void ZipWriterTest::testCompressionLevel()
+{
+    QByteArray xml;
+    for (int i = 1; i <= 5000; ++i)
+        xml.append(QStringLiteral("<c r=\"C%1\" s=\"1\"/>").arg(i).toUtf8());
+
+    QXlsx::ZipEntryBuffer stored;
+    stored.setCompressionLevel(0);
+    stored.write(xml);
+    stored.close();
+    QVERIFY(stored.isStored());
+    QCOMPARE(stored.compressedData(), xml);
+
+    QXlsx::ZipEntryBuffer fast;
+    fast.setCompressionLevel(1);
+    fast.write(xml);
+    fast.close();
+    QXlsx::ZipEntryBuffer best;
+    best.setCompressionLevel(9);
+    best.write(xml);
+    best.close();
+    QVERIFY(!fast.isStored());
+    QVERIFY(best.compressedData().size() <= fast.compressedData().size());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QXlsx::ZipWriter writer(&buffer);
+    writer.addFile("stored.xml", stored);
+    writer.addFile("fast.xml", fast);
+    writer.addFile("best.xml", best);
+    writer.setCompressionLevel(0);
+    writer.addFile("data.bin", xml);
+    writer.openFile("streamed.xml")->write(xml);
+    writer.close();
+    QVERIFY(!writer.error());
+    QVERIFY(buffer.buffer().contains(xml));
+
+    QBuffer input(&buffer.buffer());
+    input.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader reader(&input);
+    QCOMPARE(reader.fileData("stored.xml"), xml);
+    QCOMPARE(reader.fileData("fast.xml"), xml);
+    QCOMPARE(reader.fileData("best.xml"), xml);
+    QCOMPARE(reader.fileData("data.bin"), xml);
+    QCOMPARE(reader.fileData("streamed.xml"), xml);
+}
+
+void ZipWriterTest::testClosedDevice()
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadOnly);
+    QXlsx::ZipWriter writer(&buffer);
+    QVERIFY(writer.error());
+}
+
+QTEST_APPLESS_MAIN(ZipWriterTest)
+
+#include "tst_zipwritertest.moc"
@@ -1,3 +1,20 @@
 TEMPLATE = subdirs
 SUBDIRS += \
-    xmlspace
+    xmlspace \
+    cellstorage \
+    sparsesheet \
+    parallelsave \
+    saveoptions \
+    sheetdata \
+    numericcodec \
+    bulkwrite \
+    lazyload \
+    parallelload \
+    zipreader \
+    sheetload \
+    projection \
+    sharedstrings \
+    styledread \
+    probe \
+    sharedformula \
+    recalculate
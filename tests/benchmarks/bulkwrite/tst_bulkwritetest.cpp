@@ -0,0 +1,111 @@
+#include <QtTest>
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+
+using namespace QXlsx;
+
+class BulkwriteTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    BulkwriteTest();
+
+private Q_SLOTS:
+    void writeNumbers_data();
+    void writeNumbers();
+    void writeStrings_data();
+    void writeStrings();
+
+private:
+    int m_rows;
+    int m_columns;
+};
+
+BulkwriteTest::BulkwriteTest()
+    : m_rows(100000)
+    , m_columns(10)
+{
+}
+
+void BulkwriteTest::writeNumbers_data()
+{
+    QTest::addColumn<QString>("method");
+
+    QTest::newRow("write(QVariant)") << QStringLiteral("variant");
+    QTest::newRow("writeNumeric") << QStringLiteral("numeric");
+    QTest::newRow("writeRow") << QStringLiteral("row");
+    QTest::newRow("writeColumn") << QStringLiteral("column");
+    QTest::newRow("writeBlock") << QStringLiteral("block");
+}
+
+void BulkwriteTest::writeNumbers()
+{
+    QFETCH(QString, method);
+
+    QList<double> values(qsizetype(m_rows) * m_columns);
+    for (int i = 0; i < values.size(); ++i)
+        values[i] = i * 0.5;
+
+    QBENCHMARK {
+        Document xlsx;
+        Worksheet *sheet = xlsx.currentWorksheet();
+        if (method == QLatin1String("variant") || method == QLatin1String("numeric")) {
+            const bool variant = method == QLatin1String("variant");
+            for (int row = 0; row < m_rows; ++row) {
+                for (int col = 0; col < m_columns; ++col) {
+                    const double value = values[row * m_columns + col];
+                    if (variant)
+                        sheet->write(row + 1, col + 1, value);
+                    else
+                        sheet->writeNumeric(row + 1, col + 1, value);
+                }
+            }
+        } else if (method == QLatin1String("row")) {
+            for (int row = 0; row < m_rows; ++row)
+                sheet->writeRow(row + 1, 1, values.constData() + row * m_columns, m_columns);
+        } else if (method == QLatin1String("column")) {
+            // values are used column after column here
+            for (int col = 0; col < m_columns; ++col)
+                sheet->writeColumn(1, col + 1, values.constData() + col * m_rows, m_rows);
+        } else {
+            sheet->writeBlock(CellRange(1, 1, m_rows, m_columns), values);
+        }
+        QCOMPARE(sheet->dimension(), CellRange(1, 1, m_rows, m_columns));
+    }
+}
+
+void BulkwriteTest::writeStrings_data()
+{
+    QTest::addColumn<bool>("bulk");
+
+    QTest::newRow("write(QVariant)") << false;
+    QTest::newRow("writeRow") << true;
+}
+
+void BulkwriteTest::writeStrings()
+{
+    QFETCH(bool, bulk);
+
+    QStringList strings;
+    for (int col = 0; col < m_columns; ++col)
+        strings << QStringLiteral("Column %1").arg(col);
+
+    QBENCHMARK {
+        Document xlsx;
+        Worksheet *sheet = xlsx.currentWorksheet();
+        for (int row = 1; row <= m_rows / 10; ++row) {
+            if (bulk) {
+                sheet->writeRow(row, 1, strings);
+            } else {
+                for (int col = 0; col < m_columns; ++col)
+                    sheet->write(row, col + 1, strings[col]);
+            }
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(BulkwriteTest)
+
+#include "tst_bulkwritetest.moc"
@@ -0,0 +1,179 @@
+#include <QtTest>
+#include <QMap>
+#include <QSharedPointer>
+#include <QVariant>
+
+#include "xlsxcelltable_p.h"
+#include "xlsxcellformula.h"
+#include "xlsxformat.h"
+#include "xlsxrichstring.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace QXlsx;
+
+// Same members as CellPrivate, used to mirror the former
+// QMap<int, QMap<int, QSharedPointer<Cell> > > cell table.
+struct LegacyCellPrivate
+{
+    QVariant value;
+    CellFormula formula;
+    int cellType;
+    Format format;
+    RichString richString;
+    void *parent;
+    void *q_ptr;
+};
+
+struct LegacyCell
+{
+    LegacyCell(double v) : d(new LegacyCellPrivate) { d->value = v; }
+    ~LegacyCell() { delete d; }
+    LegacyCellPrivate *d;
+};
+
+typedef QMap<int, QMap<int, QSharedPointer<LegacyCell>>> LegacyTable;
+
+static qint64 heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return qint64(mallinfo2().uordblks);
+#else
+    return -1;
+#endif
+}
+
+class CellstorageTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    CellstorageTest();
+
+private Q_SLOTS:
+    void bytesPerCell_data();
+    void bytesPerCell();
+    void writeNumbers_data();
+    void writeNumbers();
+    void readNumbers_data();
+    void readNumbers();
+
+private:
+    void fill(LegacyTable &table) const;
+    void fill(CellTable &table) const;
+
+    int m_rows;
+    int m_columns;
+};
+
+CellstorageTest::CellstorageTest()
+    : m_rows(10000)
+    , m_columns(50)
+{
+}
+
+void CellstorageTest::fill(LegacyTable &table) const
+{
+    for (int row = 1; row <= m_rows; ++row) {
+        for (int col = 1; col <= m_columns; ++col)
+            table[row][col] = QSharedPointer<LegacyCell>(new LegacyCell(row * col));
+    }
+}
+
+void CellstorageTest::fill(CellTable &table) const
+{
+    for (int row = 1; row <= m_rows; ++row) {
+        for (int col = 1; col <= m_columns; ++col)
+            table.setNumber(row, col, row * col, -1);
+    }
+}
+
+void CellstorageTest::bytesPerCell_data()
+{
+    QTest::addColumn<bool>("tiled");
+    QTest::newRow("QMap of Cell") << false;
+    QTest::newRow("CellTable") << true;
+}
+
+void CellstorageTest::bytesPerCell()
+{
+    QFETCH(bool, tiled);
+
+    const qint64 cells = qint64(m_rows) * m_columns;
+    const qint64 before = heapInUse();
+    qint64 bytes = 0;
+    if (tiled) {
+        CellTable table;
+        fill(table);
+        bytes = before < 0 ? table.memoryUsage() : heapInUse() - before;
+    } else {
+        if (before < 0)
+            QSKIP("Heap usage can not be measured on this platform");
+        LegacyTable table;
+        fill(table);
+        bytes = heapInUse() - before;
+    }
+
+    QTest::setBenchmarkResult(qreal(bytes) / cells, QTest::BytesAllocated);
+}
+
+void CellstorageTest::writeNumbers_data()
+{
+    bytesPerCell_data();
+}
+
+void CellstorageTest::writeNumbers()
+{
+    QFETCH(bool, tiled);
+
+    if (tiled) {
+        QBENCHMARK {
+            CellTable table;
+            fill(table);
+        }
+    } else {
+        QBENCHMARK {
+            LegacyTable table;
+            fill(table);
+        }
+    }
+}
+
+void CellstorageTest::readNumbers_data()
+{
+    bytesPerCell_data();
+}
+
+void CellstorageTest::readNumbers()
+{
+    QFETCH(bool, tiled);
+
+    double sum = 0;
+    if (tiled) {
+        CellTable table;
+        fill(table);
+        QBENCHMARK {
+            for (int row = 1; row <= m_rows; ++row) {
+                table.forEachInRow(row, [&sum](int, const CellTable::Entry &e) {
+                    sum += e.value.number;
+                });
+            }
+        }
+    } else {
+        LegacyTable table;
+        fill(table);
+        QBENCHMARK {
+            for (int row = 1; row <= m_rows; ++row) {
+                foreach (const QSharedPointer<LegacyCell> &cell, table[row])
+                    sum += cell->d->value.toDouble();
+            }
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
+QTEST_APPLESS_MAIN(CellstorageTest)
+
+#include "tst_cellstoragetest.moc"
@@ -0,0 +1,74 @@
+#include <QtTest>
+#include <QBuffer>
+
+#include "xlsxdocument.h"
+
+using namespace QXlsx;
+
+class LazyloadTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    LazyloadTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void openOneSheet_data();
+    void openOneSheet();
+
+private:
+    QByteArray m_package;
+    int m_sheets;
+    int m_rows;
+};
+
+LazyloadTest::LazyloadTest()
+    : m_sheets(50)
+    , m_rows(2000)
+{
+}
+
+void LazyloadTest::initTestCase()
+{
+    Document xlsx;
+    for (int i = 1; i <= m_sheets; ++i) {
+        if (i > 1)
+            xlsx.addSheet(QStringLiteral("Sheet%1").arg(i));
+        for (int row = 1; row <= m_rows; ++row) {
+            xlsx.write(row, 1, QStringLiteral("Item %1").arg(row));
+            for (int col = 2; col <= 10; ++col)
+                xlsx.write(row, col, row * col + i);
+        }
+    }
+
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx.saveAs(&buffer));
+}
+
+void LazyloadTest::openOneSheet_data()
+{
+    QTest::addColumn<bool>("lazy");
+    QTest::newRow("eager") << false;
+    QTest::newRow("lazySheets") << true;
+}
+
+void LazyloadTest::openOneSheet()
+{
+    QFETCH(bool, lazy);
+
+    Document::LoadOptions options;
+    options.lazySheets = lazy;
+    QBENCHMARK {
+        QBuffer buffer(&m_package);
+        buffer.open(QIODevice::ReadOnly);
+        Document xlsx(&buffer, options);
+        QVERIFY(xlsx.selectSheet(QStringLiteral("Sheet%1").arg(m_sheets)));
+        QCOMPARE(xlsx.read(m_rows, 10).toInt(), m_rows * 10 + m_sheets);
+    }
+}
+
+QTEST_APPLESS_MAIN(LazyloadTest)
+
+#include "tst_lazyloadtest.moc"
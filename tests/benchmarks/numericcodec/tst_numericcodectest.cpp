@@ -0,0 +1,108 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "xlsxutility_p.h"
+
+using namespace QXlsx;
+
+class NumericcodecTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    NumericcodecTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void format_data();
+    void format();
+    void parse_data();
+    void parse();
+
+private:
+    enum { PoolSize = 1 << 16, Count = 10000000 };
+
+    QList<double> m_values;
+    QList<QString> m_texts;
+};
+
+NumericcodecTest::NumericcodecTest()
+{
+}
+
+void NumericcodecTest::initTestCase()
+{
+    // Mix of the values found in sheets: integers, money and raw doubles
+    QRandomGenerator random(42);
+    for (int i = 0; i < PoolSize; ++i) {
+        double value;
+        switch (i % 3) {
+        case 0:
+            value = random.bounded(1000000);
+            break;
+        case 1:
+            value = random.bounded(10000000) / 100.0;
+            break;
+        default:
+            value = random.bounded(2.0e6) - 1.0e6;
+            break;
+        }
+        m_values.append(value);
+        m_texts.append(QString::number(value, 'g', 17));
+    }
+}
+
+void NumericcodecTest::format_data()
+{
+    QTest::addColumn<int>("method");
+
+    QTest::newRow("QString::number 15") << 0;
+    QTest::newRow("doubleToChars 15") << 1;
+    QTest::newRow("doubleToChars exact") << 2;
+}
+
+void NumericcodecTest::format()
+{
+    QFETCH(int, method);
+
+    qint64 size = 0;
+    QBENCHMARK {
+        size = 0;
+        char buffer[32];
+        for (int i = 0; i < Count; ++i) {
+            const double value = m_values.at(i & (PoolSize - 1));
+            if (method == 0)
+                size += QString::number(value, 'g', 15).toUtf8().size();
+            else
+                size += doubleToChars(buffer, value, method == 1 ? 15 : 0);
+        }
+    }
+    QVERIFY(size > 0);
+}
+
+void NumericcodecTest::parse_data()
+{
+    QTest::addColumn<int>("method");
+
+    QTest::newRow("QString::toDouble") << 0;
+    QTest::newRow("stringToDouble") << 1;
+}
+
+void NumericcodecTest::parse()
+{
+    QFETCH(int, method);
+
+    double sum = 0;
+    QBENCHMARK {
+        sum = 0;
+        for (int i = 0; i < Count; ++i) {
+            const QString &text = m_texts.at(i & (PoolSize - 1));
+            sum += method == 0 ? text.toDouble() : stringToDouble(text);
+        }
+    }
+    QVERIFY(sum != 0);
+}
+
+QTEST_APPLESS_MAIN(NumericcodecTest)
+
+#include "tst_numericcodectest.moc"
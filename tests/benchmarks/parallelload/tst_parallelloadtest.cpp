@@ -0,0 +1,82 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QThread>
+#include <QThreadPool>
+
+#include "xlsxdocument.h"
+
+using namespace QXlsx;
+
+class ParallelloadTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ParallelloadTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void loadWorkbook_data();
+    void loadWorkbook();
+
+private:
+    QByteArray m_package;
+    int m_threadCount;
+};
+
+ParallelloadTest::ParallelloadTest()
+    : m_threadCount(QThreadPool::globalInstance()->maxThreadCount())
+{
+}
+
+void ParallelloadTest::initTestCase()
+{
+    // 40 sheets of 20000 x 10 cells, mixed numbers and strings.
+    Document xlsx;
+    for (int i = 1; i <= 40; ++i) {
+        xlsx.addSheet(QStringLiteral("Sheet%1").arg(i));
+        for (int row = 1; row <= 20000; ++row) {
+            for (int col = 1; col <= 8; ++col)
+                xlsx.write(row, col, row * col + i * 0.25);
+            xlsx.write(row, 9, QStringLiteral("Item %1").arg(row % 500));
+            xlsx.write(row, 10, row % 2 == 0);
+        }
+    }
+
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx.saveAs(&buffer));
+}
+
+void ParallelloadTest::cleanupTestCase()
+{
+    QThreadPool::globalInstance()->setMaxThreadCount(m_threadCount);
+}
+
+void ParallelloadTest::loadWorkbook_data()
+{
+    QTest::addColumn<int>("threads");
+
+    const int ideal = QThread::idealThreadCount();
+    for (int threads = 1; threads < ideal; threads *= 2)
+        QTest::newRow(qPrintable(QStringLiteral("%1 threads").arg(threads))) << threads;
+    QTest::newRow(qPrintable(QStringLiteral("%1 threads").arg(ideal))) << ideal;
+}
+
+void ParallelloadTest::loadWorkbook()
+{
+    QFETCH(int, threads);
+
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    QBENCHMARK {
+        QBuffer buffer(&m_package);
+        buffer.open(QIODevice::ReadOnly);
+        Document xlsx(&buffer);
+        QCOMPARE(xlsx.sheetNames().size(), 41);
+    }
+}
+
+QTEST_APPLESS_MAIN(ParallelloadTest)
+
+#include "tst_parallelloadtest.moc"
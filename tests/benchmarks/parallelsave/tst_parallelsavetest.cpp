@@ -0,0 +1,102 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QThread>
+#include <QThreadPool>
+
+#include "xlsxdocument.h"
+
+using namespace QXlsx;
+
+class ParallelsaveTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ParallelsaveTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void saveWorkbook_data();
+    void saveWorkbook();
+    void saveLargeSheet_data();
+    void saveLargeSheet();
+
+private:
+    Document m_xlsx;
+    Document m_largeXlsx;
+    int m_threadCount;
+};
+
+ParallelsaveTest::ParallelsaveTest()
+    : m_threadCount(QThreadPool::globalInstance()->maxThreadCount())
+{
+}
+
+void ParallelsaveTest::initTestCase()
+{
+    // 40 sheets of 20000 x 10 cells, mixed numbers and strings.
+    for (int i = 1; i <= 40; ++i) {
+        m_xlsx.addSheet(QStringLiteral("Sheet%1").arg(i));
+        for (int row = 1; row <= 20000; ++row) {
+            for (int col = 1; col <= 8; ++col)
+                m_xlsx.write(row, col, row * col + i * 0.25);
+            m_xlsx.write(row, 9, QStringLiteral("Item %1").arg(row % 500));
+            m_xlsx.write(row, 10, row % 2 == 0);
+        }
+    }
+
+    // A single sheet of 500000 x 10 cells, which is deflated block-wise.
+    for (int row = 1; row <= 500000; ++row) {
+        for (int col = 1; col <= 10; ++col)
+            m_largeXlsx.write(row, col, row * col + 0.5);
+    }
+}
+
+void ParallelsaveTest::cleanupTestCase()
+{
+    QThreadPool::globalInstance()->setMaxThreadCount(m_threadCount);
+}
+
+void ParallelsaveTest::saveWorkbook_data()
+{
+    QTest::addColumn<int>("threads");
+
+    const int ideal = QThread::idealThreadCount();
+    for (int threads = 1; threads < ideal; threads *= 2)
+        QTest::newRow(qPrintable(QStringLiteral("%1 threads").arg(threads))) << threads;
+    QTest::newRow(qPrintable(QStringLiteral("%1 threads").arg(ideal))) << ideal;
+}
+
+void ParallelsaveTest::saveWorkbook()
+{
+    QFETCH(int, threads);
+
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(m_xlsx.saveAs(&buffer));
+    }
+}
+
+void ParallelsaveTest::saveLargeSheet_data()
+{
+    saveWorkbook_data();
+}
+
+void ParallelsaveTest::saveLargeSheet()
+{
+    QFETCH(int, threads);
+
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(m_largeXlsx.saveAs(&buffer));
+    }
+}
+
+QTEST_APPLESS_MAIN(ParallelsaveTest)
+
+#include "tst_parallelsavetest.moc"
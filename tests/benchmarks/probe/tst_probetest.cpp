@@ -0,0 +1,77 @@
+#include <QtTest>
+#include <QBuffer>
+
+#include "xlsxdocument.h"
+
+using namespace QXlsx;
+
+class ProbeTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProbeTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void sheetNames_data();
+    void sheetNames();
+
+private:
+    QByteArray m_package;
+};
+
+ProbeTest::ProbeTest()
+{
+}
+
+void ProbeTest::initTestCase()
+{
+    // Three sheets of 100000 rows, as routed by an ingest service.
+    Document xlsx;
+    for (int sheet = 1; sheet <= 3; ++sheet) {
+        if (sheet > 1)
+            xlsx.addSheet();
+        for (int row = 1; row <= 100000; ++row) {
+            xlsx.write(row, 1, QStringLiteral("Order %1").arg(row));
+            xlsx.write(row, 2, row * 0.25);
+            xlsx.write(row, 3, row % 7);
+        }
+    }
+    xlsx.defineName("Orders", "=Sheet1!$A$1:$C$100000");
+
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx.saveAs(&buffer));
+}
+
+void ProbeTest::sheetNames_data()
+{
+    QTest::addColumn<bool>("probe");
+    QTest::newRow("load") << false;
+    QTest::newRow("probe") << true;
+}
+
+void ProbeTest::sheetNames()
+{
+    QFETCH(bool, probe);
+
+    QBENCHMARK {
+        QBuffer buffer(&m_package);
+        buffer.open(QIODevice::ReadOnly);
+        if (probe) {
+            Document::ProbeInfo info = Document::probe(&buffer);
+            QCOMPARE(info.sheets.size(), 3);
+            QCOMPARE(info.sheets[2].dimension, CellRange("A1:C100000"));
+        } else {
+            Document xlsx(&buffer);
+            QCOMPARE(xlsx.sheetNames().size(), 3);
+            xlsx.selectSheet("Sheet3");
+            QCOMPARE(xlsx.dimension(), CellRange("A1:C100000"));
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(ProbeTest)
+
+#include "tst_probetest.moc"
@@ -0,0 +1,122 @@
+#include <QtTest>
+#include <QBuffer>
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+
+using namespace QXlsx;
+
+class ProjectionTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProjectionTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void loadColumns_data();
+    void loadColumns();
+    void loadRows_data();
+    void loadRows();
+
+private:
+    QByteArray m_package;
+    QByteArray m_tallPackage;
+    int m_rows;
+    int m_columns;
+    int m_tallRows;
+};
+
+ProjectionTest::ProjectionTest()
+    : m_rows(5000)
+    , m_columns(200)
+    , m_tallRows(500000)
+{
+}
+
+void ProjectionTest::initTestCase()
+{
+    // A wide vendor sheet: a text column every ten columns, numbers
+    // everywhere else.
+    Document xlsx;
+    for (int row = 1; row <= m_rows; ++row) {
+        for (int col = 1; col <= m_columns; ++col) {
+            if (col % 10 == 1)
+                xlsx.write(row, col, QStringLiteral("Item %1/%2").arg(row).arg(col));
+            else
+                xlsx.write(row, col, row * 0.5 + col);
+        }
+    }
+
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx.saveAs(&buffer));
+
+    // A tall log sheet, of which only the first rows are wanted.
+    Document tall;
+    QList<double> values;
+    values.reserve(m_tallRows);
+    for (int row = 1; row <= m_tallRows; ++row)
+        values.append(row * 0.5);
+    tall.currentWorksheet()->writeColumn(1, 1, values);
+    tall.currentWorksheet()->writeColumn(1, 2, values);
+
+    QBuffer tallBuffer(&m_tallPackage);
+    tallBuffer.open(QIODevice::WriteOnly);
+    QVERIFY(tall.saveAs(&tallBuffer));
+}
+
+void ProjectionTest::loadColumns_data()
+{
+    QTest::addColumn<QList<int>>("columns");
+    QTest::addColumn<int>("lastRow");
+    QTest::newRow("all") << QList<int>() << -1;
+    QTest::newRow("3 columns") << (QList<int>() << 1 << 2 << 150) << -1;
+    QTest::newRow("3 columns, 500 rows") << (QList<int>() << 1 << 2 << 150) << 500;
+}
+
+void ProjectionTest::loadColumns()
+{
+    QFETCH(QList<int>, columns);
+    QFETCH(int, lastRow);
+
+    Document::LoadOptions options;
+    for (int column : columns)
+        options.columns.insert(column);
+    options.lastRow = lastRow;
+    const int rows = lastRow < 0 ? m_rows : lastRow;
+    QBENCHMARK {
+        QBuffer buffer(&m_package);
+        buffer.open(QIODevice::ReadOnly);
+        Document xlsx(&buffer, options);
+        QCOMPARE(xlsx.read(rows, 150).toDouble(), rows * 0.5 + 150);
+    }
+}
+
+void ProjectionTest::loadRows_data()
+{
+    QTest::addColumn<int>("lastRow");
+    QTest::newRow("all") << -1;
+    QTest::newRow("500 rows") << 500;
+}
+
+void ProjectionTest::loadRows()
+{
+    QFETCH(int, lastRow);
+
+    Document::LoadOptions options;
+    options.lastRow = lastRow;
+    const int rows = lastRow < 0 ? m_tallRows : lastRow;
+    QBENCHMARK {
+        QBuffer buffer(&m_tallPackage);
+        buffer.open(QIODevice::ReadOnly);
+        Document xlsx(&buffer, options);
+        QCOMPARE(xlsx.read(rows, 2).toDouble(), rows * 0.5);
+        QVERIFY(!xlsx.read(rows + 1, 2).isValid());
+    }
+}
+
+QTEST_APPLESS_MAIN(ProjectionTest)
+
+#include "tst_projectiontest.moc"
@@ -0,0 +1,133 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QThreadPool>
+
+#include "xlsxdocument.h"
+#include "xlsxcellformula.h"
+#include "xlsxcell.h"
+#include "xlsxworksheet.h"
+
+using namespace QXlsx;
+
+class RecalculateTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    RecalculateTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void recalculate();
+    void recalculateSerial();
+    void recalculateIncremental();
+
+private:
+    void check(Document &xlsx);
+
+    QByteArray m_package;
+    int m_rows;
+};
+
+RecalculateTest::RecalculateTest()
+    : m_rows(100000)
+{
+}
+
+void RecalculateTest::initTestCase()
+{
+    // A filled down shared formula with a lookup, and totals over its
+    // column, as saved by Excel.
+    Document xlsx;
+    for (int row = 1; row <= m_rows; ++row) {
+        xlsx.write(row, 1, row);
+        xlsx.write(row, 2, QStringLiteral("Key %1").arg(row % 50));
+    }
+    for (int row = 1; row <= 50; ++row) {
+        xlsx.write(row, 10, QStringLiteral("Key %1").arg(row - 1));
+        xlsx.write(row, 11, row - 1);
+    }
+    xlsx.write(1, 8, 2);
+    Worksheet *sheet = xlsx.currentWorksheet();
+    sheet->writeFormula(1, 4,
+                        CellFormula(QStringLiteral("IF(AND(A1>0,B1<>\"\"),A1*$H$1+VLOOKUP(B1,$J$1:$K$50,2,FALSE),0)"),
+                                    CellRange(1, 4, m_rows, 4), CellFormula::SharedType));
+    sheet->writeFormula(1, 5, CellFormula("SUM(D:D)"));
+    sheet->writeFormula(2, 5, CellFormula("AVERAGE(D:D)"));
+    sheet->writeFormula(3, 5, CellFormula("MAX(D:D)-MIN(D:D)"));
+
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx.saveAs(&buffer));
+}
+
+void RecalculateTest::check(Document &xlsx)
+{
+    // Each row gives 2 * row + row % 50
+    const double rows = m_rows;
+    double expected = rows * (rows + 1);
+    for (int row = 1; row <= m_rows; ++row)
+        expected += row % 50;
+    QCOMPARE(xlsx.cellAt(m_rows, 4)->value().toDouble(), 2 * rows);
+    QCOMPARE(xlsx.cellAt(1, 5)->value().toDouble(), expected);
+}
+
+void RecalculateTest::recalculate()
+{
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::ReadOnly);
+    Document xlsx(&buffer);
+
+    int computed = 0;
+    QBENCHMARK {
+        computed = xlsx.recalculate();
+    }
+    QCOMPARE(computed, m_rows + 3);
+    check(xlsx);
+}
+
+void RecalculateTest::recalculateSerial()
+{
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::ReadOnly);
+    Document xlsx(&buffer);
+
+    const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool::globalInstance()->setMaxThreadCount(1);
+    int computed = 0;
+    QBENCHMARK {
+        computed = xlsx.recalculate();
+    }
+    QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+    QCOMPARE(computed, m_rows + 3);
+    check(xlsx);
+}
+
+void RecalculateTest::recalculateIncremental()
+{
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::ReadOnly);
+    Document xlsx(&buffer);
+    QCOMPARE(xlsx.recalculate(), m_rows + 3);
+
+    // Ten inputs edited, then only their dependents and the totals
+    // are computed again.
+    Worksheet *sheet = xlsx.currentWorksheet();
+    int value = 0;
+    int computed = 0;
+    QBENCHMARK {
+        ++value;
+        for (int i = 0; i < 10; ++i)
+            sheet->writeNumeric(1 + i * (m_rows / 10), 1, value);
+        computed = xlsx.recalculate();
+    }
+    QCOMPARE(computed, 13);
+    const Worksheet::CalculationStats stats = sheet->calculationStats();
+    QCOMPARE(stats.formulas, m_rows + 3);
+    QCOMPARE(stats.dirty, 10);
+    QVERIFY(!stats.rebuilt);
+}
+
+QTEST_APPLESS_MAIN(RecalculateTest)
+
+#include "tst_recalculatetest.moc"
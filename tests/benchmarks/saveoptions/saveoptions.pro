@@ -0,0 +1,13 @@
+QT       += testlib xlsx gui
+CONFIG += testcase
+DEFINES += XLSX_TEST
+
+TARGET = tst_saveoptionstest
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += tst_saveoptionstest.cpp
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
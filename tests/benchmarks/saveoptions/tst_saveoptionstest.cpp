@@ -0,0 +1,101 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QImage>
+
+#include "xlsxdocument.h"
+
+using namespace QXlsx;
+
+class SaveoptionsTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SaveoptionsTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void saveTime_data();
+    void saveTime();
+    void fileSize_data();
+    void fileSize();
+
+private:
+    Document m_xlsx;
+};
+
+SaveoptionsTest::SaveoptionsTest()
+{
+}
+
+void SaveoptionsTest::initTestCase()
+{
+    for (int row = 1; row <= 100000; ++row) {
+        for (int col = 1; col <= 8; ++col)
+            m_xlsx.write(row, col, row * col + 0.125);
+        m_xlsx.write(row, 9, QStringLiteral("Item %1").arg(row % 1000));
+    }
+
+    // A noisy image does not shrink under deflate, as real photos do not.
+    QImage image(512, 512, QImage::Format_RGB32);
+    quint32 seed = 1;
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            seed = seed * 1103515245 + 12345;
+            image.setPixel(x, y, seed >> 8);
+        }
+    }
+    m_xlsx.insertImage(2, 12, image);
+}
+
+void SaveoptionsTest::saveTime_data()
+{
+    QTest::addColumn<int>("level");
+    QTest::addColumn<bool>("compressMedia");
+
+    QTest::newRow("default") << -1 << true;
+    QTest::newRow("stored") << 0 << true;
+    QTest::newRow("level 1") << 1 << true;
+    QTest::newRow("level 1, media stored") << 1 << false;
+    QTest::newRow("level 6") << 6 << true;
+    QTest::newRow("level 9") << 9 << true;
+}
+
+void SaveoptionsTest::saveTime()
+{
+    QFETCH(int, level);
+    QFETCH(bool, compressMedia);
+
+    Document::SaveOptions options;
+    options.compressionLevel = level;
+    options.compressMedia = compressMedia;
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(m_xlsx.saveAs(&buffer, options));
+    }
+}
+
+void SaveoptionsTest::fileSize_data()
+{
+    saveTime_data();
+}
+
+void SaveoptionsTest::fileSize()
+{
+    QFETCH(int, level);
+    QFETCH(bool, compressMedia);
+
+    Document::SaveOptions options;
+    options.compressionLevel = level;
+    options.compressMedia = compressMedia;
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(m_xlsx.saveAs(&buffer, options));
+
+    QTest::setBenchmarkResult(buffer.size(), QTest::BytesAllocated);
+}
+
+QTEST_APPLESS_MAIN(SaveoptionsTest)
+
+#include "tst_saveoptionstest.moc"
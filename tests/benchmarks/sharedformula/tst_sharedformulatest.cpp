@@ -0,0 +1,145 @@
+#include <QtTest>
+#include <QBuffer>
+
+#include "xlsxdocument.h"
+#include "xlsxworkbook.h"
+#include "xlsxcellformula.h"
+#include "private/xlsxutility_p.h"
+
+using namespace QXlsx;
+
+class SharedformulaTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SharedformulaTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void convertSharedFormula();
+    void read();
+    void readFormulas();
+    void sheetSize_data();
+    void sheetSize();
+    void saveTime_data();
+    void saveTime();
+
+private:
+    QByteArray m_package;
+    Document m_written;
+    int m_rows;
+    QString m_formula;
+};
+
+SharedformulaTest::SharedformulaTest()
+    : m_rows(100000)
+    , m_formula(QStringLiteral("IF(AND(A1>0,B1<>\"\"),A1*$H$1+VLOOKUP(B1,$J$1:$K$50,2,FALSE),C$1)"))
+{
+}
+
+void SharedformulaTest::initTestCase()
+{
+    // One formula shared down a 100k row column, as Excel saves a
+    // filled down column.
+    Document xlsx;
+    for (int row = 1; row <= m_rows; ++row) {
+        xlsx.write(row, 1, row);
+        xlsx.write(row, 2, QStringLiteral("Key %1").arg(row % 50));
+    }
+    xlsx.currentWorksheet()->writeFormula(
+        1, 4, CellFormula(m_formula, CellRange(1, 4, m_rows, 4), CellFormula::SharedType));
+
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx.saveAs(&buffer));
+
+    // 500k normal formulas written one by one, each one the formula
+    // above it moved down.
+    for (int row = 1; row <= 500000; ++row) {
+        m_written.write(row, 1, row);
+        m_written.write(row, 2, 2);
+        m_written.currentWorksheet()->writeFormula(
+            row, 3, CellFormula(QStringLiteral("A%1*B%1").arg(row)));
+    }
+}
+
+void SharedformulaTest::convertSharedFormula()
+{
+    // What every read of a shared cell used to cost
+    QString formula;
+    QBENCHMARK {
+        for (int row = 1; row <= m_rows; ++row)
+            formula = QXlsx::convertSharedFormula(m_formula, CellReference(1, 4), CellReference(row, 4));
+    }
+    QVERIFY(formula.startsWith(QStringLiteral("IF(AND(A100000>0")));
+}
+
+void SharedformulaTest::read()
+{
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::ReadOnly);
+    Document xlsx(&buffer);
+
+    QString formula;
+    QBENCHMARK {
+        for (int row = 1; row <= m_rows; ++row)
+            formula = xlsx.read(row, 4).toString();
+    }
+    QVERIFY(formula.startsWith(QStringLiteral("=IF(AND(A100000>0")));
+}
+
+void SharedformulaTest::readFormulas()
+{
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::ReadOnly);
+    Document xlsx(&buffer);
+
+    QStringList formulas;
+    QBENCHMARK {
+        formulas = xlsx.currentWorksheet()->readFormulas(CellRange(1, 4, m_rows, 4));
+    }
+    QCOMPARE(formulas.size(), m_rows);
+    QVERIFY(formulas.last().startsWith(QStringLiteral("IF(AND(A100000>0")));
+}
+
+void SharedformulaTest::sheetSize_data()
+{
+    QTest::addColumn<bool>("sharing");
+
+    QTest::newRow("normal formulas") << false;
+    QTest::newRow("shared formulas") << true;
+}
+
+void SharedformulaTest::sheetSize()
+{
+    // Size of the uncompressed sheet XML
+    QFETCH(bool, sharing);
+
+    m_written.workbook()->setFormulaSharingEnabled(sharing);
+    const QByteArray xmlData = m_written.currentWorksheet()->saveToXmlData();
+    QVERIFY(xmlData.contains("t=\"shared\"") == sharing);
+
+    QTest::setBenchmarkResult(xmlData.size(), QTest::BytesAllocated);
+}
+
+void SharedformulaTest::saveTime_data()
+{
+    sheetSize_data();
+}
+
+void SharedformulaTest::saveTime()
+{
+    QFETCH(bool, sharing);
+
+    m_written.workbook()->setFormulaSharingEnabled(sharing);
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(m_written.saveAs(&buffer));
+    }
+}
+
+QTEST_APPLESS_MAIN(SharedformulaTest)
+
+#include "tst_sharedformulatest.moc"
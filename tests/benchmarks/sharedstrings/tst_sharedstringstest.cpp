@@ -0,0 +1,73 @@
+#include <QtTest>
+#include <QBuffer>
+
+#include "xlsxdocument.h"
+
+using namespace QXlsx;
+
+class SharedstringsTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SharedstringsTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void loadStrings_data();
+    void loadStrings();
+
+private:
+    QByteArray m_package;
+    int m_rows;
+};
+
+SharedstringsTest::SharedstringsTest()
+    : m_rows(200000)
+{
+}
+
+void SharedstringsTest::initTestCase()
+{
+    // A log export: a distinct message on every row, so the shared
+    // string table is as large as the sheet.
+    Document xlsx;
+    for (int row = 1; row <= m_rows; ++row)
+        xlsx.write(row, 1, QStringLiteral("Message %1 from host-%2 & <service>").arg(row).arg(row % 97));
+
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx.saveAs(&buffer));
+}
+
+void SharedstringsTest::loadStrings_data()
+{
+    QTest::addColumn<bool>("lazy");
+    QTest::addColumn<int>("reads");
+    QTest::newRow("eager, 100 reads") << false << 100;
+    QTest::newRow("lazy, 100 reads") << true << 100;
+    QTest::newRow("eager, all reads") << false << m_rows;
+    QTest::newRow("lazy, all reads") << true << m_rows;
+}
+
+void SharedstringsTest::loadStrings()
+{
+    QFETCH(bool, lazy);
+    QFETCH(int, reads);
+
+    Document::LoadOptions options;
+    options.lazySharedStrings = lazy;
+    QBENCHMARK {
+        QBuffer buffer(&m_package);
+        buffer.open(QIODevice::ReadOnly);
+        Document xlsx(&buffer, options);
+        for (int row = m_rows - reads + 1; row <= m_rows; ++row)
+            QVERIFY(!xlsx.read(row, 1).toString().isEmpty());
+        QCOMPARE(xlsx.read(m_rows, 1).toString(),
+                 QStringLiteral("Message %1 from host-%2 & <service>").arg(m_rows).arg(m_rows % 97));
+    }
+}
+
+QTEST_APPLESS_MAIN(SharedstringsTest)
+
+#include "tst_sharedstringstest.moc"
@@ -0,0 +1,68 @@
+#include <QtTest>
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+
+using namespace QXlsx;
+
+class SheetdataTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SheetdataTest();
+
+private Q_SLOTS:
+    void saveSheetData_data();
+    void saveSheetData();
+
+private:
+    int m_rows;
+    int m_columns;
+};
+
+SheetdataTest::SheetdataTest()
+    : m_rows(100000)
+    , m_columns(10)
+{
+}
+
+void SheetdataTest::saveSheetData_data()
+{
+    QTest::addColumn<QString>("type");
+
+    QTest::newRow("integers") << QStringLiteral("integers");
+    QTest::newRow("doubles") << QStringLiteral("doubles");
+    QTest::newRow("shared strings") << QStringLiteral("strings");
+    QTest::newRow("inline strings") << QStringLiteral("inline");
+}
+
+void SheetdataTest::saveSheetData()
+{
+    QFETCH(QString, type);
+
+    Document xlsx;
+    Worksheet *sheet = xlsx.currentWorksheet();
+    for (int row = 1; row <= m_rows; ++row) {
+        for (int col = 1; col <= m_columns; ++col) {
+            if (type == QLatin1String("integers"))
+                sheet->writeNumeric(row, col, row * col);
+            else if (type == QLatin1String("doubles"))
+                sheet->writeNumeric(row, col, row / double(col + 6));
+            else if (type == QLatin1String("strings"))
+                sheet->writeString(row, col, QString::number(row % 1000 * col));
+            else
+                sheet->writeInlineString(row, col, QString::number(row * col));
+        }
+    }
+
+    QByteArray xmldata;
+    QBENCHMARK {
+        xmldata = sheet->saveToXmlData();
+    }
+    QVERIFY(xmldata.contains("<c r=\"J100000\""));
+}
+
+QTEST_APPLESS_MAIN(SheetdataTest)
+
+#include "tst_sheetdatatest.moc"
@@ -0,0 +1,86 @@
+#include <QtTest>
+#include <QBuffer>
+
+#include "xlsxdocument.h"
+#include "private/xlsxzipreader_p.h"
+#include "private/xlsxzipwriter_p.h"
+
+using namespace QXlsx;
+
+class SheetloadTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SheetloadTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void loadSheet_data();
+    void loadSheet();
+
+private:
+    QByteArray m_package;
+    QByteArray m_genericPackage;
+};
+
+SheetloadTest::SheetloadTest()
+{
+}
+
+void SheetloadTest::initTestCase()
+{
+    Document xlsx;
+    Format format;
+    format.setNumberFormat(QStringLiteral("0.00"));
+    for (int row = 1; row <= 250000; ++row) {
+        xlsx.write(row, 1, row);
+        xlsx.write(row, 2, row * 0.25, format);
+        xlsx.write(row, 3, row % 997);
+        xlsx.write(row, 4, row * 1.5e-3);
+    }
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx.saveAs(&buffer));
+    buffer.close();
+
+    // The same package, with a comment ahead of <sheetData>. The
+    // SheetDataReader passes such parts through untouched, so they
+    // are read by QXmlStreamReader only.
+    QBuffer source(&m_package);
+    source.open(QIODevice::ReadOnly);
+    ZipReader reader(&source);
+    QBuffer generic(&m_genericPackage);
+    generic.open(QIODevice::WriteOnly);
+    ZipWriter writer(&generic);
+    foreach (const QString &name, reader.filePaths()) {
+        QByteArray data = reader.fileData(name);
+        if (name == QLatin1String("xl/worksheets/sheet1.xml"))
+            data.insert(data.indexOf("?>") + 2, "<!-- generic -->");
+        writer.addFile(name, data);
+    }
+    writer.close();
+}
+
+void SheetloadTest::loadSheet_data()
+{
+    QTest::addColumn<bool>("fast");
+    QTest::newRow("QXmlStreamReader") << false;
+    QTest::newRow("SheetDataReader") << true;
+}
+
+void SheetloadTest::loadSheet()
+{
+    QFETCH(bool, fast);
+
+    QBENCHMARK {
+        QBuffer buffer(fast ? &m_package : &m_genericPackage);
+        buffer.open(QIODevice::ReadOnly);
+        Document xlsx(&buffer);
+        QCOMPARE(xlsx.dimension().lastRow(), 250000);
+    }
+}
+
+QTEST_APPLESS_MAIN(SheetloadTest)
+
+#include "tst_sheetloadtest.moc"
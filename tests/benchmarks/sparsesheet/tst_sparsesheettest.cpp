@@ -0,0 +1,57 @@
+#include <QtTest>
+#include <QBuffer>
+
+#include "xlsxdocument.h"
+#include "xlsxcellreference.h"
+
+using namespace QXlsx;
+
+class SparsesheetTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SparsesheetTest();
+
+private Q_SLOTS:
+    void saveSparseSheet_data();
+    void saveSparseSheet();
+};
+
+SparsesheetTest::SparsesheetTest()
+{
+}
+
+void SparsesheetTest::saveSparseSheet_data()
+{
+    QTest::addColumn<QStringList>("cells");
+
+    QTest::newRow("corners") << (QStringList() << "A1" << "XFD1" << "A1048576" << "XFD1048576");
+    QTest::newRow("wide row") << (QStringList() << "A1" << "XFD1");
+    QTest::newRow("tall column") << (QStringList() << "A1" << "A1048576");
+
+    // A diagonal, every row and column block is touched once.
+    QStringList diagonal;
+    for (int i = 1; i <= 16384; i += 97)
+        diagonal << CellReference(i * 64, i).toString();
+    QTest::newRow("diagonal") << diagonal;
+}
+
+void SparsesheetTest::saveSparseSheet()
+{
+    QFETCH(QStringList, cells);
+
+    Document xlsx;
+    for (int i = 0; i < cells.size(); ++i)
+        xlsx.write(cells[i], i);
+
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(xlsx.saveAs(&buffer));
+    }
+}
+
+QTEST_APPLESS_MAIN(SparsesheetTest)
+
+#include "tst_sparsesheettest.moc"
@@ -0,0 +1,86 @@
+#include <QtTest>
+#include <QBuffer>
+
+#include "xlsxdocument.h"
+
+using namespace QXlsx;
+
+class StyledreadTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    StyledreadTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void read();
+    void cellValue();
+
+private:
+    QByteArray m_package;
+    int m_rows;
+};
+
+StyledreadTest::StyledreadTest()
+    : m_rows(100000)
+{
+}
+
+void StyledreadTest::initTestCase()
+{
+    // A ledger: amounts with a custom number format, and dates.
+    Format amount;
+    amount.setNumberFormat("#,##0.00 [$EUR];[Red]-#,##0.00 [$EUR]");
+    amount.setFontColor(Qt::darkBlue);
+    Format date;
+    date.setNumberFormat("yyyy-mm-dd hh:mm");
+
+    Document xlsx;
+    for (int row = 1; row <= m_rows; ++row) {
+        xlsx.write(row, 1, row * 1.25, amount);
+        xlsx.write(row, 2, 40000.5 + row, date);
+    }
+
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(xlsx.saveAs(&buffer));
+}
+
+void StyledreadTest::read()
+{
+    QBuffer buffer(&m_package);
+    buffer.open(QIODevice::ReadOnly);
+    Document xlsx(&buffer);
+
+    int dates = 0;
+    QBENCHMARK {
+        dates = 0;
+        for (int row = 1; row <= m_rows; ++row) {
+            QVERIFY(xlsx.read(row, 1).userType() == QMetaType::Double);
+            if (xlsx.read(row, 2).userType() == QMetaType::QDateTime)
+                ++dates;
+        }
+    }
+    QCOMPARE(dates, m_rows);
+}
+
+void StyledreadTest::cellValue()
+{
+    // Load and create every Cell, the values are read without looking
+    // at their format.
+    double sum = 0;
+    QBENCHMARK {
+        QBuffer buffer(&m_package);
+        buffer.open(QIODevice::ReadOnly);
+        Document xlsx(&buffer);
+        sum = 0;
+        for (int row = 1; row <= m_rows; ++row)
+            sum += xlsx.cellAt(row, 1)->value().toDouble() + xlsx.cellAt(row, 2)->value().toDouble();
+    }
+    QCOMPARE(sum, 1.25 * m_rows * (m_rows + 1) / 2 + 40000.5 * m_rows + m_rows * (m_rows + 1) / 2.0);
+}
+
+QTEST_APPLESS_MAIN(StyledreadTest)
+
+#include "tst_styledreadtest.moc"
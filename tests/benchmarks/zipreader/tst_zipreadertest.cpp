@@ -0,0 +1,130 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QXmlStreamReader>
+
+#include "private/xlsxzipreader_p.h"
+#include "private/xlsxzipwriter_p.h"
+
+using namespace QXlsx;
+
+class ZipreaderTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ZipreaderTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void lookup_data();
+    void lookup();
+    void parseSheet_data();
+    void parseSheet();
+
+private:
+    QByteArray m_manyParts;
+    QStringList m_partNames;
+    QByteArray m_bigSheet;
+};
+
+ZipreaderTest::ZipreaderTest()
+{
+}
+
+void ZipreaderTest::initTestCase()
+{
+    // A package with as many parts as a workbook of 500 sheets with
+    // drawings: sheets, their rels, drawings and the drawing rels.
+    QBuffer buffer(&m_manyParts);
+    buffer.open(QIODevice::WriteOnly);
+    ZipWriter writer(&buffer);
+    for (int i = 1; i <= 500; ++i) {
+        m_partNames << QStringLiteral("xl/worksheets/sheet%1.xml").arg(i)
+                    << QStringLiteral("xl/worksheets/_rels/sheet%1.xml.rels").arg(i)
+                    << QStringLiteral("xl/drawings/drawing%1.xml").arg(i)
+                    << QStringLiteral("xl/drawings/_rels/drawing%1.xml.rels").arg(i);
+    }
+    foreach (const QString &name, m_partNames)
+        writer.addFile(name, QByteArray("<x/>"));
+    writer.close();
+
+    QByteArray xml("<worksheet><sheetData>");
+    for (int row = 1; row <= 200000; ++row) {
+        xml.append(QStringLiteral("<row r=\"%1\"><c r=\"A%1\"><v>%2</v></c><c r=\"B%1\"><v>%3</v></c></row>")
+                       .arg(row).arg(row * 3).arg(row % 101).toUtf8());
+    }
+    xml.append("</sheetData></worksheet>");
+    QBuffer sheet(&m_bigSheet);
+    sheet.open(QIODevice::WriteOnly);
+    ZipWriter sheetWriter(&sheet);
+    sheetWriter.addFile(QStringLiteral("xl/worksheets/sheet1.xml"), xml);
+    sheetWriter.close();
+}
+
+void ZipreaderTest::lookup_data()
+{
+    QTest::addColumn<bool>("indexed");
+    QTest::newRow("filePaths().contains") << false;
+    QTest::newRow("contains") << true;
+}
+
+void ZipreaderTest::lookup()
+{
+    QFETCH(bool, indexed);
+
+    QBuffer buffer(&m_manyParts);
+    buffer.open(QIODevice::ReadOnly);
+    ZipReader reader(&buffer);
+
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        foreach (const QString &name, m_partNames) {
+            if (indexed ? reader.contains(name) : reader.filePaths().contains(name))
+                ++found;
+        }
+    }
+    QCOMPARE(found, m_partNames.size());
+}
+
+void ZipreaderTest::parseSheet_data()
+{
+    QTest::addColumn<bool>("streamed");
+    QTest::newRow("fileData") << false;
+    QTest::newRow("openFile") << true;
+}
+
+void ZipreaderTest::parseSheet()
+{
+    QFETCH(bool, streamed);
+
+    QBuffer buffer(&m_bigSheet);
+    buffer.open(QIODevice::ReadOnly);
+    ZipReader reader(&buffer);
+    const QString name = QStringLiteral("xl/worksheets/sheet1.xml");
+
+    int cells = 0;
+    QBENCHMARK {
+        cells = 0;
+        QScopedPointer<QIODevice> device;
+        QByteArray data;
+        QBuffer dataDevice(&data);
+        if (streamed) {
+            device.reset(reader.openFile(name));
+        } else {
+            data = reader.fileData(name);
+            dataDevice.open(QIODevice::ReadOnly);
+        }
+        QXmlStreamReader xml(streamed ? device.data() : &dataDevice);
+        while (!xml.atEnd()) {
+            if (xml.readNext() == QXmlStreamReader::StartElement && xml.name() == QLatin1String("c"))
+                ++cells;
+        }
+        QVERIFY(!xml.hasError());
+    }
+    QCOMPARE(cells, 400000);
+}
+
+QTEST_APPLESS_MAIN(ZipreaderTest)
+
+#include "tst_zipreadertest.moc"